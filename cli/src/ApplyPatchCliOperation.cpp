@@ -17,7 +17,10 @@ ApplyPatchCliOperation::ApplyPatchCliOperation() :
 	m_nextResourcesBasePathsArgumentId( "--next-resources-base-path" ),
 	m_nextResourcesSourceTypeArgumentId( "--next-resources-source-type" ),
 	m_resourcesToPatchDestinationPathArgumentId( "--output-base-path" ),
-	m_resourcesToPatchDestinationTypeArgumentId( "--output-destination-type" )
+	m_resourcesToPatchDestinationTypeArgumentId( "--output-destination-type" ),
+	m_applyThreadCountArgumentId( "--apply-threads" ),
+	m_applyMemoryBudgetArgumentId( "--apply-memory-budget" ),
+	m_journalPathArgumentId( "--journal-path" )
 {
 	AddRequiredPositionalArgument( m_patchResourceGroupPathArgumentId, "The path to the PatchResourceGroup.yaml file." );
 
@@ -38,6 +41,12 @@ ApplyPatchCliOperation::ApplyPatchCliOperation() :
 	AddArgument( m_resourcesToPatchDestinationPathArgumentId, "The path in which to place the patched version of the files.", false, false, "ApplyPatchOut" );
 
 	AddArgument( m_resourcesToPatchDestinationTypeArgumentId, "The type of repository in which to place the patched version of the files.", false, false, DestinationTypeToString( defaultParams.resourcesToPatchDestinationSettings.destinationType ), ResourceDestinationTypeChoicesAsString() );
+
+	AddArgument( m_applyThreadCountArgumentId, "Number of resources to patch at the same time, 0 uses one per hardware thread. Each resource is only written once its checksum is verified.", false, false, std::to_string( defaultParams.applyThreadCount ) );
+
+	AddArgument( m_applyMemoryBudgetArgumentId, "Maximum memory in bytes used by resources patched at the same time, fewer are patched at once if they would not fit.", false, false, SizeToString( defaultParams.applyMemoryBudget ) );
+
+	AddArgument( m_journalPathArgumentId, "Optional file recording patched resources, so running again after an interruption skips them.", false, false, defaultParams.journalFilePath.string() );
 }
 
 bool ApplyPatchCliOperation::Execute( std::string& returnErrorMessage ) const
@@ -127,6 +136,44 @@ bool ApplyPatchCliOperation::Execute( std::string& returnErrorMessage ) const
 
 	patchApplyParams.temporaryFilePath = "tempFile.resource";
 
+	try
+	{
+		unsigned long threadCount = std::stoul( m_argumentParser->get( m_applyThreadCountArgumentId ) );
+		if( threadCount > std::numeric_limits<unsigned int>::max() )
+		{
+			returnErrorMessage = "Invalid apply thread count";
+			return false;
+		}
+		patchApplyParams.applyThreadCount = static_cast<unsigned int>( threadCount );
+	}
+	catch( std::invalid_argument& )
+	{
+		returnErrorMessage = "Invalid apply thread count";
+		return false;
+	}
+	catch( std::out_of_range& )
+	{
+		returnErrorMessage = "Invalid apply thread count";
+		return false;
+	}
+
+	try
+	{
+		patchApplyParams.applyMemoryBudget = std::stoull( m_argumentParser->get( m_applyMemoryBudgetArgumentId ) );
+	}
+	catch( std::invalid_argument& )
+	{
+		returnErrorMessage = "Invalid apply memory budget";
+		return false;
+	}
+	catch( std::out_of_range& )
+	{
+		returnErrorMessage = "Invalid apply memory budget";
+		return false;
+	}
+
+	patchApplyParams.journalFilePath = m_argumentParser->get( m_journalPathArgumentId );
+
 	PrintStartBanner( importParamsPrevious, patchApplyParams );
 
 	return ApplyPatch( importParamsPrevious, patchApplyParams );
@@ -154,6 +201,9 @@ void ApplyPatchCliOperation::PrintStartBanner( const CarbonResources::ResourceGr
 	std::cout << "Next Resources Source Type: " << SourceTypeToString( patchApplyParams.nextBuildResourcesSourceSettings.sourceType ) << std::endl;
 	std::cout << "Output Path Base Path: " << patchApplyParams.resourcesToPatchDestinationSettings.basePath << std::endl;
 	std::cout << "Output Path Destination Type: " << DestinationTypeToString( patchApplyParams.resourcesToPatchDestinationSettings.destinationType ) << std::endl;
+	std::cout << "Apply Threads: " << patchApplyParams.applyThreadCount << std::endl;
+	std::cout << "Apply Memory Budget: " << SizeToString( patchApplyParams.applyMemoryBudget ) << std::endl;
+	std::cout << "Journal Path: " << patchApplyParams.journalFilePath << std::endl;
 
 	std::cout << "----------------------------\n"
 			  << std::endl;
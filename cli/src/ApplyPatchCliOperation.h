@@ -26,4 +26,7 @@ private:
 	std::string m_nextResourcesSourceTypeArgumentId;
 	std::string m_resourcesToPatchDestinationPathArgumentId;
 	std::string m_resourcesToPatchDestinationTypeArgumentId;
+	std::string m_applyThreadCountArgumentId;
+	std::string m_applyMemoryBudgetArgumentId;
+	std::string m_journalPathArgumentId;
 };
@@ -367,6 +367,23 @@ std::string CliOperation::PathListToString( std::vector<std::filesystem::path>&
 	return ss.str();
 }
 
+bool CliOperation::StringToDiffEngineType( const std::string& stringRepresentation, CarbonResources::DiffEngineType& out ) const
+{
+	if( stringRepresentation == "BSDIFF" )
+	{
+		out = CarbonResources::DiffEngineType::BSDIFF;
+	}
+	else if( stringRepresentation == "ZSTD" )
+	{
+		out = CarbonResources::DiffEngineType::ZSTD;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
 std::string CliOperation::SourceTypeToString( CarbonResources::ResourceSourceType type ) const
 {
 	switch( type )
@@ -422,6 +439,11 @@ std::string CliOperation::ResourceDestinationTypeChoicesAsString() const
 	return "LOCAL_RELATIVE, LOCAL_CDN, REMOTE_CDN";
 }
 
+std::string CliOperation::DiffEngineTypeChoicesAsString() const
+{
+	return "BSDIFF, ZSTD";
+}
+
 std::string CliOperation::DestinationTypeToString( CarbonResources::ResourceDestinationType type ) const
 {
 	switch( type )
@@ -440,6 +462,21 @@ std::string CliOperation::DestinationTypeToString( CarbonResources::ResourceDest
 	}
 }
 
+std::string CliOperation::DiffEngineTypeToString( CarbonResources::DiffEngineType type ) const
+{
+	switch( type )
+	{
+	case CarbonResources::DiffEngineType::BSDIFF:
+		return "BSDIFF";
+
+	case CarbonResources::DiffEngineType::ZSTD:
+		return "ZSTD";
+
+	default:
+		return "Unrecognised diff engine";
+	}
+}
+
 std::string PathsToString( const std::vector<std::filesystem::path>& v )
 {
 	std::string result;
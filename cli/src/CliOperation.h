@@ -15,6 +15,7 @@ namespace CarbonResources
 {
 enum class ResourceSourceType;
 enum class ResourceDestinationType;
+enum class DiffEngineType;
 }
 
 namespace argparse
@@ -64,12 +65,16 @@ protected:
 
 	bool StringToResourceDestinationType( const std::string& stringRepresentation, CarbonResources::ResourceDestinationType& out ) const;
 
+	bool StringToDiffEngineType( const std::string& stringRepresentation, CarbonResources::DiffEngineType& out ) const;
+
 	std::string PathListToString( std::vector<std::filesystem::path>& paths ) const;
 
 	std::string SourceTypeToString( CarbonResources::ResourceSourceType type ) const;
 
 	std::string DestinationTypeToString( CarbonResources::ResourceDestinationType type ) const;
 
+	std::string DiffEngineTypeToString( CarbonResources::DiffEngineType type ) const;
+
 	std::string SizeToString( uintmax_t size ) const;
 
 	std::string SecondsToString( std::chrono::seconds seconds ) const;
@@ -80,6 +85,8 @@ protected:
 
 	std::string ResourceDestinationTypeChoicesAsString() const;
 
+	std::string DiffEngineTypeChoicesAsString() const;
+
 	bool ParseDocumentVersion( const std::string& version, CarbonResources::Version& documentVersion ) const;
 
 private:
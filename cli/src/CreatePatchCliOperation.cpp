@@ -2,10 +2,21 @@
 
 #include "CreatePatchCliOperation.h"
 
+#include <memory>
+#include <sstream>
 #include <string>
 #include <argparse/argparse.hpp>
 #include <ResourceGroup.h>
 
+namespace
+{
+// Output relative path of the nth additional previous build, such as ResourceGroup_1.yaml
+std::filesystem::path AdditionalPreviousBuildRelativePath( const std::filesystem::path& relativePath, size_t n )
+{
+	return relativePath.parent_path() / ( relativePath.stem().string() + "_" + std::to_string( n ) + relativePath.extension().string() );
+}
+}
+
 CreatePatchCliOperation::CreatePatchCliOperation() :
 	CliOperation( "create-patch", "Creates a patch binaries and a Patch Resource Group from two supplied ResourceGroups and two resource source directories, one for previous build and one for next." ),
 	m_previousResourceGroupPathArgumentId( "previous-resourcegroup-path" ),
@@ -24,6 +35,21 @@ CreatePatchCliOperation::CreatePatchCliOperation() :
 	m_maxInputChunkSizeArgumentId( "--chunk-size" ),
 	m_downloadRetrySecondsArgumentId( "--download-retry" ),
 	m_indexFolderArgumentId( "--index-folder" ),
+	m_indexCacheFolderArgumentId( "--index-cache-folder" ),
+	m_indexCacheMaxSizeArgumentId( "--index-cache-max-size" ),
+	m_indexThreadCountArgumentId( "--index-threads" ),
+	m_indexBlockHashesArgumentId( "--index-block-hashes" ),
+	m_indexMemoryBudgetArgumentId( "--index-memory-budget" ),
+	m_patchThreadCountArgumentId( "--patch-threads" ),
+	m_patchMemoryBudgetArgumentId( "--patch-memory-budget" ),
+	m_diffThreadCountArgumentId( "--diff-threads" ),
+	m_contentDefinedChunkingArgumentId( "--content-defined-chunking" ),
+	m_crossResourceMatchingArgumentId( "--cross-resource-matching" ),
+	m_detectResourceCopiesArgumentId( "--detect-resource-copies" ),
+	m_diffEngineArgumentId( "--diff-engine" ),
+	m_patchCacheFolderArgumentId( "--patch-cache-folder" ),
+	m_patchCacheMaxSizeArgumentId( "--patch-cache-max-size" ),
+	m_additionalPreviousBuildArgumentId( "--additional-previous-build" ),
 	m_skipCompressionCalculation( "--skip-compression" )
 {
 
@@ -64,7 +90,41 @@ CreatePatchCliOperation::CreatePatchCliOperation() :
 
 	AddArgument( m_indexFolderArgumentId, "The folder in which to place indexes generated for patch files.", false, false, defaultParams.indexFolder.string() );
 
+	AddArgument( m_indexCacheFolderArgumentId, "Optional folder in which to keep indexes of previous resources between runs, so patching against the same previous build again skips index generation.", false, false, defaultParams.indexCacheFolder.string() );
+
+	AddArgument( m_indexCacheMaxSizeArgumentId, "Maximum size in bytes of the index cache folder, least recently used indexes are evicted past this size.", false, false, SizeToString( defaultParams.indexCacheMaxSize ) );
+
+	AddArgument( m_indexThreadCountArgumentId, "Number of threads used to generate the index of each previous resource, 0 uses one per hardware thread.", false, false, std::to_string( defaultParams.indexThreadCount ) );
+
+	AddArgumentFlag( m_indexBlockHashesArgumentId, "Store a hash of every chunk sized block in the index, so matches are verified without reading previous resources again." );
+
+	AddArgument( m_indexMemoryBudgetArgumentId, "Maximum memory in bytes used to sort the index of a previous resource, larger indexes are sorted on disk in the index folder.", false, false, SizeToString( defaultParams.indexMemoryBudget ) );
+
+	AddArgument( m_patchThreadCountArgumentId, "Number of resources to create patches for at the same time, 0 uses one per hardware thread. The output does not depend on it.", false, false, std::to_string( defaultParams.patchThreadCount ) );
+
+	AddArgument( m_patchMemoryBudgetArgumentId, "Maximum size in bytes of patch data held in memory while waiting for patches of earlier resources to be saved.", false, false, SizeToString( defaultParams.patchMemoryBudget ) );
+
+	AddArgument( m_diffThreadCountArgumentId, "Number of chunks of a resource to diff at the same time, 0 uses one per hardware thread. The output does not depend on it.", false, false, std::to_string( defaultParams.diffThreadCount ) );
+
+	AddArgumentFlag( m_contentDefinedChunkingArgumentId, "Split resources into chunks at boundaries chosen by their content, so unchanged data is found by hash after insertions without indexing previous resources." );
+
+	AddArgumentFlag( m_crossResourceMatchingArgumentId, "Create new resources from the data of unchanged or removed previous resources, so moved or renamed content is patched rather than shipped again." );
+
+	AddArgumentFlag( m_detectResourceCopiesArgumentId, "Make new resources identical to an unchanged or removed previous resource by copying it, with no patch data." );
+
+	AddArgument( m_diffEngineArgumentId, "Algorithm patch data is created with. Patches not made with BSDIFF can only be applied by clients which know the engine.", false, false, DiffEngineTypeToString( defaultParams.diffEngine ), DiffEngineTypeChoicesAsString() );
+
+	AddArgument( m_patchCacheFolderArgumentId, "Optional folder in which to keep the patches of changed resources between runs, so patching the same resource versions again reuses them.", false, false, defaultParams.patchCacheFolder.string() );
+
+	AddArgument( m_patchCacheMaxSizeArgumentId, "Maximum size in bytes of the patch cache folder, least recently used entries are evicted past this size.", false, false, SizeToString( defaultParams.patchCacheMaxSize ) );
+
     AddArgumentFlag( m_skipCompressionCalculation, "Set skip compression calculations on patches." );
+
+	// Two values per build and no default, which AddArgument does not cater for
+	m_argumentParser->add_argument( m_additionalPreviousBuildArgumentId )
+		.help( "Filename to the resourceGroup of another previous build followed by the base path to source its resources, patched from in the same run so resources changed the same way are patched once. Its output resourceGroup and PatchResourceGroup relative paths get _1, _2 ... appended. [Accepts multiple]" )
+		.nargs( 2 )
+		.append();
 }
 
 bool CreatePatchCliOperation::Execute( std::string& returnErrorMessage ) const
@@ -180,6 +240,150 @@ bool CreatePatchCliOperation::Execute( std::string& returnErrorMessage ) const
 
 	createPatchParams.indexFolder = m_argumentParser->get( m_indexFolderArgumentId );
 
+	createPatchParams.indexCacheFolder = m_argumentParser->get( m_indexCacheFolderArgumentId );
+
+	try
+	{
+		createPatchParams.indexCacheMaxSize = std::stoull( m_argumentParser->get( m_indexCacheMaxSizeArgumentId ) );
+	}
+	catch( std::invalid_argument& )
+	{
+		returnErrorMessage = "Invalid index cache max size";
+		return false;
+	}
+	catch( std::out_of_range& )
+	{
+		returnErrorMessage = "Invalid index cache max size";
+		return false;
+	}
+
+	try
+	{
+		unsigned long threadCount = std::stoul( m_argumentParser->get( m_indexThreadCountArgumentId ) );
+		if( threadCount > std::numeric_limits<unsigned int>::max() )
+		{
+			returnErrorMessage = "Invalid index thread count";
+			return false;
+		}
+		createPatchParams.indexThreadCount = static_cast<unsigned int>( threadCount );
+	}
+	catch( std::invalid_argument& )
+	{
+		returnErrorMessage = "Invalid index thread count";
+		return false;
+	}
+	catch( std::out_of_range& )
+	{
+		returnErrorMessage = "Invalid index thread count";
+		return false;
+	}
+
+	createPatchParams.indexBlockHashes = m_argumentParser->get<bool>( m_indexBlockHashesArgumentId );
+
+	try
+	{
+		createPatchParams.indexMemoryBudget = std::stoull( m_argumentParser->get( m_indexMemoryBudgetArgumentId ) );
+	}
+	catch( std::invalid_argument& )
+	{
+		returnErrorMessage = "Invalid index memory budget";
+		return false;
+	}
+	catch( std::out_of_range& )
+	{
+		returnErrorMessage = "Invalid index memory budget";
+		return false;
+	}
+
+	try
+	{
+		unsigned long threadCount = std::stoul( m_argumentParser->get( m_patchThreadCountArgumentId ) );
+		if( threadCount > std::numeric_limits<unsigned int>::max() )
+		{
+			returnErrorMessage = "Invalid patch thread count";
+			return false;
+		}
+		createPatchParams.patchThreadCount = static_cast<unsigned int>( threadCount );
+	}
+	catch( std::invalid_argument& )
+	{
+		returnErrorMessage = "Invalid patch thread count";
+		return false;
+	}
+	catch( std::out_of_range& )
+	{
+		returnErrorMessage = "Invalid patch thread count";
+		return false;
+	}
+
+	try
+	{
+		createPatchParams.patchMemoryBudget = std::stoull( m_argumentParser->get( m_patchMemoryBudgetArgumentId ) );
+	}
+	catch( std::invalid_argument& )
+	{
+		returnErrorMessage = "Invalid patch memory budget";
+		return false;
+	}
+	catch( std::out_of_range& )
+	{
+		returnErrorMessage = "Invalid patch memory budget";
+		return false;
+	}
+
+	try
+	{
+		unsigned long threadCount = std::stoul( m_argumentParser->get( m_diffThreadCountArgumentId ) );
+		if( threadCount > std::numeric_limits<unsigned int>::max() )
+		{
+			returnErrorMessage = "Invalid diff thread count";
+			return false;
+		}
+		createPatchParams.diffThreadCount = static_cast<unsigned int>( threadCount );
+	}
+	catch( std::invalid_argument& )
+	{
+		returnErrorMessage = "Invalid diff thread count";
+		return false;
+	}
+	catch( std::out_of_range& )
+	{
+		returnErrorMessage = "Invalid diff thread count";
+		return false;
+	}
+
+	createPatchParams.contentDefinedChunking = m_argumentParser->get<bool>( m_contentDefinedChunkingArgumentId );
+
+	createPatchParams.crossResourceMatching = m_argumentParser->get<bool>( m_crossResourceMatchingArgumentId );
+
+	createPatchParams.detectResourceCopies = m_argumentParser->get<bool>( m_detectResourceCopiesArgumentId );
+
+	std::string diffEngine = m_argumentParser->get<std::string>( m_diffEngineArgumentId );
+
+	if( !StringToDiffEngineType( diffEngine, createPatchParams.diffEngine ) )
+	{
+		returnErrorMessage = "Invalid diff engine";
+
+		return false;
+	}
+
+	createPatchParams.patchCacheFolder = m_argumentParser->get( m_patchCacheFolderArgumentId );
+
+	try
+	{
+		createPatchParams.patchCacheMaxSize = std::stoull( m_argumentParser->get( m_patchCacheMaxSizeArgumentId ) );
+	}
+	catch( std::invalid_argument& )
+	{
+		returnErrorMessage = "Invalid patch cache max size";
+		return false;
+	}
+	catch( std::out_of_range& )
+	{
+		returnErrorMessage = "Invalid patch cache max size";
+		return false;
+	}
+
     bool skipCompressionCalculation = m_argumentParser->get<bool>( m_skipCompressionCalculation );
 
     if (skipCompressionCalculation && createPatchParams.resourcePatchBinaryDestinationSettings.destinationType == CarbonResources::ResourceDestinationType::REMOTE_CDN)
@@ -191,12 +395,48 @@ bool CreatePatchCliOperation::Execute( std::string& returnErrorMessage ) const
 
     createPatchParams.calculateCompressions = !skipCompressionCalculation;
 
+	std::vector<CarbonResources::ResourceGroupImportFromFileParams> additionalPreviousResourceGroupParams;
+
+	auto additionalPreviousBuilds = m_argumentParser->present<std::vector<std::string>>( m_additionalPreviousBuildArgumentId );
+
+	if( additionalPreviousBuilds.has_value() )
+	{
+		if( additionalPreviousBuilds->size() % 2 != 0 )
+		{
+			returnErrorMessage = "Invalid additional previous build";
+
+			return false;
+		}
+
+		for( size_t i = 0; i < additionalPreviousBuilds->size(); i += 2 )
+		{
+			CarbonResources::ResourceGroupImportFromFileParams resourceGroupParams;
+
+			resourceGroupParams.filename = ( *additionalPreviousBuilds )[i];
+
+			additionalPreviousResourceGroupParams.push_back( resourceGroupParams );
+
+			// The resource group is set once imported
+			CarbonResources::PatchBaseParams previousBuild;
+
+			previousBuild.resourceSourceSettingsPrevious.sourceType = createPatchParams.resourceSourceSettingsPrevious.sourceType;
+
+			previousBuild.resourceSourceSettingsPrevious.basePaths = { ( *additionalPreviousBuilds )[i + 1] };
+
+			previousBuild.resourceGroupRelativePath = AdditionalPreviousBuildRelativePath( createPatchParams.resourceGroupRelativePath, createPatchParams.additionalPreviousBuilds.size() + 1 );
+
+			previousBuild.resourceGroupPatchRelativePath = AdditionalPreviousBuildRelativePath( createPatchParams.resourceGroupPatchRelativePath, createPatchParams.additionalPreviousBuilds.size() + 1 );
+
+			createPatchParams.additionalPreviousBuilds.push_back( previousBuild );
+		}
+	}
+
 	if( s_verbosityLevel != CarbonResources::StatusLevel::OFF )
 	{
 		PrintStartBanner( previousResourceGroupParams, nextResourceGroupParams, createPatchParams );
 	}
 
-	return CreatePatch( previousResourceGroupParams, nextResourceGroupParams, createPatchParams );
+	return CreatePatch( previousResourceGroupParams, nextResourceGroupParams, additionalPreviousResourceGroupParams, createPatchParams );
 }
 
 void CreatePatchCliOperation::PrintStartBanner( const CarbonResources::ResourceGroupImportFromFileParams& previousResourceGroupParams, const CarbonResources::ResourceGroupImportFromFileParams& nextResourceGroupParams, CarbonResources::PatchCreateParams& createPatchParams ) const
@@ -243,6 +483,49 @@ void CreatePatchCliOperation::PrintStartBanner( const CarbonResources::ResourceG
 
 	std::cout << "Index File Folder: " << createPatchParams.indexFolder << std::endl;
 
+	if( !createPatchParams.indexCacheFolder.empty() )
+	{
+		std::cout << "Index Cache Folder: " << createPatchParams.indexCacheFolder << std::endl;
+
+		std::cout << "Index Cache Max Size: " << createPatchParams.indexCacheMaxSize << std::endl;
+	}
+
+	std::cout << "Index Thread Count: " << createPatchParams.indexThreadCount << std::endl;
+
+	std::cout << "Index Block Hashes: " << ( createPatchParams.indexBlockHashes ? "On" : "Off" ) << std::endl;
+
+	std::cout << "Index Memory Budget: " << createPatchParams.indexMemoryBudget << std::endl;
+
+	std::cout << "Patch Thread Count: " << createPatchParams.patchThreadCount << std::endl;
+
+	std::cout << "Patch Memory Budget: " << createPatchParams.patchMemoryBudget << std::endl;
+
+	std::cout << "Diff Thread Count: " << createPatchParams.diffThreadCount << std::endl;
+
+	std::cout << "Content Defined Chunking: " << ( createPatchParams.contentDefinedChunking ? "On" : "Off" ) << std::endl;
+
+	std::cout << "Cross Resource Matching: " << ( createPatchParams.crossResourceMatching ? "On" : "Off" ) << std::endl;
+
+	std::cout << "Detect Resource Copies: " << ( createPatchParams.detectResourceCopies ? "On" : "Off" ) << std::endl;
+
+	std::cout << "Diff Engine: " << DiffEngineTypeToString( createPatchParams.diffEngine ) << std::endl;
+
+	if( !createPatchParams.patchCacheFolder.empty() )
+	{
+		std::cout << "Patch Cache Folder: " << createPatchParams.patchCacheFolder << std::endl;
+
+		std::cout << "Patch Cache Max Size: " << createPatchParams.patchCacheMaxSize << std::endl;
+	}
+
+	for( size_t i = 0; i < createPatchParams.additionalPreviousBuilds.size(); i++ )
+	{
+		const CarbonResources::PatchBaseParams& previousBuild = createPatchParams.additionalPreviousBuilds[i];
+
+		std::cout << "Additional Previous Build " << i + 1 << " Resource Source Base Path: " << previousBuild.resourceSourceSettingsPrevious.basePaths.front() << std::endl;
+
+		std::cout << "Additional Previous Build " << i + 1 << " Resource Group Patch Relative Path: " << previousBuild.resourceGroupPatchRelativePath << std::endl;
+	}
+
     if( createPatchParams.calculateCompressions )
 	{
 		std::cout << "Calculate Compression: Off" << std::endl;
@@ -256,7 +539,7 @@ void CreatePatchCliOperation::PrintStartBanner( const CarbonResources::ResourceG
 			  << std::endl;
 }
 
-bool CreatePatchCliOperation::CreatePatch( CarbonResources::ResourceGroupImportFromFileParams& previousResourceGroupParams, CarbonResources::ResourceGroupImportFromFileParams& nextResourceGroupParams, CarbonResources::PatchCreateParams& createPatchParams ) const
+bool CreatePatchCliOperation::CreatePatch( CarbonResources::ResourceGroupImportFromFileParams& previousResourceGroupParams, CarbonResources::ResourceGroupImportFromFileParams& nextResourceGroupParams, std::vector<CarbonResources::ResourceGroupImportFromFileParams>& additionalPreviousResourceGroupParams, CarbonResources::PatchCreateParams& createPatchParams ) const
 {
 	CarbonResources::StatusCallback statusCallback = GetStatusCallback();
 
@@ -303,12 +586,41 @@ bool CreatePatchCliOperation::CreatePatch( CarbonResources::ResourceGroupImportF
 
 	createPatchParams.previousResourceGroup = &resourceGroupPrevious;
 
+	// Additional previous ResourceGroups
+	std::vector<std::unique_ptr<CarbonResources::ResourceGroup>> additionalResourceGroupsPrevious;
+
+	for( size_t i = 0; i < additionalPreviousResourceGroupParams.size(); i++ )
+	{
+		additionalResourceGroupsPrevious.push_back( std::make_unique<CarbonResources::ResourceGroup>() );
+
+		additionalPreviousResourceGroupParams[i].statusCallback = statusCallback;
+
+		CarbonResources::Result importAdditionalFromFileResult = additionalResourceGroupsPrevious.back()->ImportFromFile( additionalPreviousResourceGroupParams[i] );
+
+		if( importAdditionalFromFileResult.type != CarbonResources::ResultType::SUCCESS )
+		{
+			PrintCarbonResourcesError( importAdditionalFromFileResult );
+
+			return false;
+		}
+
+		createPatchParams.additionalPreviousBuilds[i].previousResourceGroup = additionalResourceGroupsPrevious.back().get();
+	}
+
 	// Create Patch
 	if( createPatchParams.statusCallback )
 	{
 		createPatchParams.statusCallback( CarbonResources::StatusLevel::OVERVIEW, CarbonResources::StatusProgressType::PERCENTAGE, 75, "Creating Patch." );
 	}
 
+	uintmax_t patchCacheHits{ 0 };
+
+	uintmax_t patchCacheMisses{ 0 };
+
+	createPatchParams.patchCacheHits = &patchCacheHits;
+
+	createPatchParams.patchCacheMisses = &patchCacheMisses;
+
 	CarbonResources::Result createPatchResult = resourceGroupLatest.CreatePatch( createPatchParams );
 
 	if( createPatchResult.type != CarbonResources::ResultType::SUCCESS )
@@ -318,6 +630,13 @@ bool CreatePatchCliOperation::CreatePatch( CarbonResources::ResourceGroupImportF
 		return false;
 	}
 
+	if( !createPatchParams.patchCacheFolder.empty() && createPatchParams.statusCallback )
+	{
+		std::stringstream ss;
+		ss << "Patch cache hits: " << patchCacheHits << ", misses: " << patchCacheMisses;
+		createPatchParams.statusCallback( CarbonResources::StatusLevel::OVERVIEW, CarbonResources::StatusProgressType::PERCENTAGE, 100, ss.str() );
+	}
+
 	if( createPatchParams.statusCallback )
 	{
 		createPatchParams.statusCallback( CarbonResources::StatusLevel::OVERVIEW, CarbonResources::StatusProgressType::PERCENTAGE, 100, "Patch created succesfully." );
@@ -6,6 +6,7 @@
 
 
 #include <filesystem>
+#include <vector>
 
 #include "CliOperation.h"
 
@@ -21,7 +22,7 @@ public:
 private:
 	void PrintStartBanner( const CarbonResources::ResourceGroupImportFromFileParams& previousResourceGroupParams, const CarbonResources::ResourceGroupImportFromFileParams& nextResourceGroupParams, CarbonResources::PatchCreateParams& createPatchParams ) const;
 
-	bool CreatePatch( CarbonResources::ResourceGroupImportFromFileParams& previousResourceGroupParams, CarbonResources::ResourceGroupImportFromFileParams& nextResourceGroupParams, CarbonResources::PatchCreateParams& createPatchParams ) const;
+	bool CreatePatch( CarbonResources::ResourceGroupImportFromFileParams& previousResourceGroupParams, CarbonResources::ResourceGroupImportFromFileParams& nextResourceGroupParams, std::vector<CarbonResources::ResourceGroupImportFromFileParams>& additionalPreviousResourceGroupParams, CarbonResources::PatchCreateParams& createPatchParams ) const;
 
 private:
 	std::string m_previousResourceGroupPathArgumentId;
@@ -56,6 +57,36 @@ private:
 
 	std::string m_indexFolderArgumentId;
 
+	std::string m_indexCacheFolderArgumentId;
+
+	std::string m_indexCacheMaxSizeArgumentId;
+
+	std::string m_indexThreadCountArgumentId;
+
+	std::string m_indexBlockHashesArgumentId;
+
+	std::string m_indexMemoryBudgetArgumentId;
+
+	std::string m_patchThreadCountArgumentId;
+
+	std::string m_patchMemoryBudgetArgumentId;
+
+	std::string m_diffThreadCountArgumentId;
+
+	std::string m_contentDefinedChunkingArgumentId;
+
+	std::string m_crossResourceMatchingArgumentId;
+
+	std::string m_detectResourceCopiesArgumentId;
+
+	std::string m_diffEngineArgumentId;
+
+	std::string m_patchCacheFolderArgumentId;
+
+	std::string m_patchCacheMaxSizeArgumentId;
+
+	std::string m_additionalPreviousBuildArgumentId;
+
     std::string m_skipCompressionCalculation;
 };
 
@@ -10,13 +10,16 @@ DiffResourceGroupCliOperation::DiffResourceGroupCliOperation() :
 	CliOperation( "diff-group", "Outputs a list of additions and subtractions between the two provided ResourceGroups." ),
 	m_baseResourceGroupPathArgumentId( "base-resource-group-path" ),
 	m_diffResourceGroupPathArgumentId( "diff-resource-group-path" ),
-	m_diffOutputPath( "--diff-output-path" )
+	m_diffOutputPath( "--diff-output-path" ),
+	m_detectMovesArgumentId( "--detect-moves" )
 {
 	AddRequiredPositionalArgument( m_baseResourceGroupPathArgumentId, "The path to the Resource Group to act as a base for the diff." );
 
 	AddRequiredPositionalArgument( m_diffResourceGroupPathArgumentId, "The path to the Resource Group to act as a target for the diff." );
 
 	AddArgument( m_diffOutputPath, "The path in which to place diff output.", false, false, "Diff.txt" );
+
+	AddArgumentFlag( m_detectMovesArgumentId, "Report resources with unchanged data under a new path as moves (> old -> new) and copies (= old -> new) rather than additions and subtractions." );
 }
 
 bool DiffResourceGroupCliOperation::Execute( std::string& returnErrorMessage ) const
@@ -47,14 +50,16 @@ bool DiffResourceGroupCliOperation::Execute( std::string& returnErrorMessage ) c
 	std::filesystem::path outputPath = m_argumentParser->get( m_diffOutputPath );
 
 
-	PrintStartBanner( importParamsBase, importParamsDiff, outputPath );
+	bool detectMoves = m_argumentParser->get<bool>( m_detectMovesArgumentId );
+
+	PrintStartBanner( importParamsBase, importParamsDiff, outputPath, detectMoves );
 
-	return Diff( importParamsBase, importParamsDiff, outputPath );
+	return Diff( importParamsBase, importParamsDiff, outputPath, detectMoves );
 }
 
 
 
-void DiffResourceGroupCliOperation::PrintStartBanner( const CarbonResources::ResourceGroupImportFromFileParams& importParamsBase, const CarbonResources::ResourceGroupImportFromFileParams& importParamsDiff, std::filesystem::path& outputPath ) const
+void DiffResourceGroupCliOperation::PrintStartBanner( const CarbonResources::ResourceGroupImportFromFileParams& importParamsBase, const CarbonResources::ResourceGroupImportFromFileParams& importParamsDiff, std::filesystem::path& outputPath, bool detectMoves ) const
 {
 	if( s_verbosityLevel == CarbonResources::StatusLevel::OFF )
 	{
@@ -68,12 +73,13 @@ void DiffResourceGroupCliOperation::PrintStartBanner( const CarbonResources::Res
 	std::cout << "Base Resource Group: " << importParamsBase.filename << std::endl;
 	std::cout << "Diff Resource Group: " << importParamsDiff.filename << std::endl;
 	std::cout << "Diff Output path: " << outputPath.string() << std::endl;
+	std::cout << "Detect Moves: " << ( detectMoves ? "On" : "Off" ) << std::endl;
 
 	std::cout << "----------------------------\n"
 			  << std::endl;
 }
 
-bool DiffResourceGroupCliOperation::Diff( const CarbonResources::ResourceGroupImportFromFileParams& importParamsBase, const CarbonResources::ResourceGroupImportFromFileParams& importParamsDiff, std::filesystem::path& outputPath ) const
+bool DiffResourceGroupCliOperation::Diff( const CarbonResources::ResourceGroupImportFromFileParams& importParamsBase, const CarbonResources::ResourceGroupImportFromFileParams& importParamsDiff, std::filesystem::path& outputPath, bool detectMoves ) const
 {
 	CarbonResources::StatusCallback statusCallback = GetStatusCallback();
 
@@ -119,6 +125,17 @@ bool DiffResourceGroupCliOperation::Diff( const CarbonResources::ResourceGroupIm
 
 	diffParams.subtractions = &subtractions;
 
+	std::vector<std::pair<std::filesystem::path, std::filesystem::path>> moves;
+
+	std::vector<std::pair<std::filesystem::path, std::filesystem::path>> copies;
+
+	if( detectMoves )
+	{
+		diffParams.moves = &moves;
+
+		diffParams.copies = &copies;
+	}
+
 	CarbonResources::Result diffResult = diffResourceGroup.DiffAgainstGroup( diffParams );
 
 	if( diffResult.type != CarbonResources::ResultType::SUCCESS )
@@ -152,6 +169,16 @@ bool DiffResourceGroupCliOperation::Diff( const CarbonResources::ResourceGroupIm
 		out << "- " << subtraction.string() << "\n";
 	}
 
+	for( auto move : moves )
+	{
+		out << "> " << move.first.string() << " -> " << move.second.string() << "\n";
+	}
+
+	for( auto copy : copies )
+	{
+		out << "= " << copy.first.string() << " -> " << copy.second.string() << "\n";
+	}
+
 	out.close();
 
 
@@ -13,11 +13,12 @@ public:
 	bool Execute( std::string& returnErrorMessage ) const final;
 
 private:
-	void PrintStartBanner( const CarbonResources::ResourceGroupImportFromFileParams& importParamsBase, const CarbonResources::ResourceGroupImportFromFileParams& importParamsDiff, std::filesystem::path& outputPath ) const;
+	void PrintStartBanner( const CarbonResources::ResourceGroupImportFromFileParams& importParamsBase, const CarbonResources::ResourceGroupImportFromFileParams& importParamsDiff, std::filesystem::path& outputPath, bool detectMoves ) const;
 
-	bool Diff( const CarbonResources::ResourceGroupImportFromFileParams& importParamsBase, const CarbonResources::ResourceGroupImportFromFileParams& importParamsDiff, std::filesystem::path& outputPath ) const;
+	bool Diff( const CarbonResources::ResourceGroupImportFromFileParams& importParamsBase, const CarbonResources::ResourceGroupImportFromFileParams& importParamsDiff, std::filesystem::path& outputPath, bool detectMoves ) const;
 
 	std::string m_baseResourceGroupPathArgumentId;
 	std::string m_diffResourceGroupPathArgumentId;
 	std::string m_diffOutputPath;
+	std::string m_detectMovesArgumentId;
 };
@@ -0,0 +1,375 @@
+// Copyright © 2025 CCP ehf.
+
+#include "SquashPatchesCliOperation.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <argparse/argparse.hpp>
+#include <ResourceGroup.h>
+
+SquashPatchesCliOperation::SquashPatchesCliOperation() :
+	CliOperation( "squash-patches", "Combines a chain of Patch Resource Groups, each patching the next build of the one before, into a single patch from the first previous build to the last next build." ),
+	m_previousResourceGroupPathArgumentId( "previous-resourcegroup-path" ),
+	m_patchResourceGroupPathsArgumentId( "--patch-resourcegroup-path" ),
+	m_patchBinariesSourceBasePathsArgumentId( "--patch-binaries-base-path" ),
+	m_patchBinariesSourceTypeArgumentId( "--patch-binaries-source-type" ),
+	m_resourceGroupRelativePathArgumentId( "--resourcegroup-relative-path" ),
+	m_patchResourceGroupRelativePathArgumentId( "--patchResourcegroup-relative-path" ),
+	m_resourceSourceTypePreviousArgumentId( "--resource-source-type-previous" ),
+	m_resourceSourceBasePathPreviousArgumentId( "--resource-source-base-path-previous" ),
+	m_resourceSourceTypeNextArgumentId( "--resource-source-type-next" ),
+	m_resourceSourceBasePathNextArgumentId( "--resource-source-base-path-next" ),
+	m_patchBinaryDestinationTypeArgumentId( "--patch-destination-type" ),
+	m_patchBinaryDestinationBasePathArgumentId( "--patch-destination-base-path" ),
+	m_patchResourceGroupDestinationTypeArgumentId( "--patch-resourcegroup-destination-type" ),
+	m_patchResourceGroupDestinationBasePathArgumentId( "--patch-resourcegroup-destination-path" ),
+	m_patchFileRelativePathPrefixArgumentId( "--patch-prefix" ),
+	m_maxInputChunkSizeArgumentId( "--chunk-size" ),
+	m_indexFolderArgumentId( "--index-folder" ),
+	m_patchThreadCountArgumentId( "--patch-threads" ),
+	m_diffEngineArgumentId( "--diff-engine" )
+{
+	AddRequiredPositionalArgument( m_previousResourceGroupPathArgumentId, "Filename to the resourceGroup of the previous build of the first patch." );
+
+	// Struct is inspected to ascertain default values
+	// This keeps default value settings in one place
+	// Lib defaults matches CLI
+	CarbonResources::PatchSquashParams defaultParams;
+
+	AddArgument( m_patchResourceGroupPathsArgumentId, "Filenames to the PatchResourceGroups to squash, in the order they are applied.", true, true );
+
+	AddArgument( m_patchBinariesSourceBasePathsArgumentId, "The paths to the folders containing the patch binaries of every patch to squash.", true, true, PathsToString( defaultParams.patchBinarySourceSettings.basePaths ) );
+
+	AddArgument( m_patchBinariesSourceTypeArgumentId, "The type of repository the patch binaries are sourced from.", false, false, SourceTypeToString( defaultParams.patchBinarySourceSettings.sourceType ), ResourceSourceTypeChoicesAsString() );
+
+	AddArgument( m_resourceSourceBasePathPreviousArgumentId, "Represents the base path to source resources of the previous build of the first patch.", true, true, PathListToString( defaultParams.patchCreateParams.resourceSourceSettingsPrevious.basePaths ) );
+
+	AddArgument( m_resourceSourceBasePathNextArgumentId, "Represents the base path to source resources of the next build of the last patch.", true, true, PathListToString( defaultParams.patchCreateParams.resourceSourceSettingsNext.basePaths ) );
+
+	AddArgument( m_resourceSourceTypePreviousArgumentId, "Represents the type of repository to source resources for previous.", false, false, SourceTypeToString( defaultParams.patchCreateParams.resourceSourceSettingsPrevious.sourceType ), ResourceSourceTypeChoicesAsString() );
+
+	AddArgument( m_resourceSourceTypeNextArgumentId, "Represents the type of repository to source resources for next.", false, false, SourceTypeToString( defaultParams.patchCreateParams.resourceSourceSettingsNext.sourceType ), ResourceSourceTypeChoicesAsString() );
+
+	AddArgument( m_resourceGroupRelativePathArgumentId, "Relative path for output resourceGroup which will contain the resources changed by the squashed patch.", false, false, defaultParams.patchCreateParams.resourceGroupRelativePath.string() );
+
+	AddArgument( m_patchResourceGroupRelativePathArgumentId, "Relative path for output PatchResourceGroup which will contain all the patches produced.", false, false, defaultParams.patchCreateParams.resourceGroupPatchRelativePath.string() );
+
+	AddArgument( m_patchBinaryDestinationTypeArgumentId, "Represents the type of repository where binary patches will be saved.", false, false, DestinationTypeToString( defaultParams.patchCreateParams.resourcePatchBinaryDestinationSettings.destinationType ), ResourceDestinationTypeChoicesAsString() );
+
+	AddArgument( m_patchBinaryDestinationBasePathArgumentId, "Represents the base path where binary patches will be saved.", false, false, defaultParams.patchCreateParams.resourcePatchBinaryDestinationSettings.basePath.string() );
+
+	AddArgument( m_patchResourceGroupDestinationTypeArgumentId, "Represents the type of repository where the patch ResourceGroup will be saved.", false, false, DestinationTypeToString( defaultParams.patchCreateParams.resourcePatchResourceGroupDestinationSettings.destinationType ), ResourceDestinationTypeChoicesAsString() );
+
+	AddArgument( m_patchResourceGroupDestinationBasePathArgumentId, "Represents the base path where the patch ResourceGroup will be saved.", false, false, defaultParams.patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath.string() );
+
+	AddArgument( m_patchFileRelativePathPrefixArgumentId, "Relative path prefix for produced patch binaries. Default is 'Patches/Patch' which will produce patches such as Patches/Patch.1 ...", false, false, defaultParams.patchCreateParams.patchFileRelativePathPrefix.string() );
+
+	AddArgument( m_maxInputChunkSizeArgumentId, "Files are processed in chunks, maxInputFileChunkSize indicate the size of this chunk. Patches created with another chunk size are created again.", false, false, SizeToString( defaultParams.patchCreateParams.maxInputFileChunkSize ) );
+
+	AddArgument( m_indexFolderArgumentId, "The folder in which to place indexes generated for patch files.", false, false, defaultParams.patchCreateParams.indexFolder.string() );
+
+	AddArgument( m_patchThreadCountArgumentId, "Number of resources to create patches for at the same time, 0 uses one per hardware thread. The output does not depend on it.", false, false, std::to_string( defaultParams.patchCreateParams.patchThreadCount ) );
+
+	AddArgument( m_diffEngineArgumentId, "Algorithm patch data of resources diffed again is created with.", false, false, DiffEngineTypeToString( defaultParams.patchCreateParams.diffEngine ), DiffEngineTypeChoicesAsString() );
+}
+
+bool SquashPatchesCliOperation::Execute( std::string& returnErrorMessage ) const
+{
+	CarbonResources::ResourceGroupImportFromFileParams previousResourceGroupParams;
+
+	previousResourceGroupParams.filename = m_argumentParser->get<std::string>( m_previousResourceGroupPathArgumentId );
+
+	std::vector<std::filesystem::path> patchResourceGroupPaths;
+
+	for( std::string path : m_argumentParser->get<std::vector<std::string>>( m_patchResourceGroupPathsArgumentId ) )
+	{
+		patchResourceGroupPaths.push_back( path );
+	}
+
+	if( patchResourceGroupPaths.empty() )
+	{
+		returnErrorMessage = "No patch resource groups to squash";
+
+		return false;
+	}
+
+	CarbonResources::PatchSquashParams squashParams;
+
+	CarbonResources::PatchCreateParams& createPatchParams = squashParams.patchCreateParams;
+
+	for( std::string basePath : m_argumentParser->get<std::vector<std::string>>( m_patchBinariesSourceBasePathsArgumentId ) )
+	{
+		squashParams.patchBinarySourceSettings.basePaths.push_back( basePath );
+	}
+
+	std::string patchBinariesType = m_argumentParser->get<std::string>( m_patchBinariesSourceTypeArgumentId );
+
+	if( !StringToResourceSourceType( patchBinariesType, squashParams.patchBinarySourceSettings.sourceType ) )
+	{
+		returnErrorMessage = "Invalid patch binary source type";
+
+		return false;
+	}
+
+	createPatchParams.resourceGroupRelativePath = m_argumentParser->get<std::string>( m_resourceGroupRelativePathArgumentId );
+
+	createPatchParams.resourceGroupPatchRelativePath = m_argumentParser->get<std::string>( m_patchResourceGroupRelativePathArgumentId );
+
+	std::string resourceSourceTypePrevious = m_argumentParser->get<std::string>( m_resourceSourceTypePreviousArgumentId );
+
+	if( !StringToResourceSourceType( resourceSourceTypePrevious, createPatchParams.resourceSourceSettingsPrevious.sourceType ) )
+	{
+		returnErrorMessage = "Invalid resource source previous type";
+
+		return false;
+	}
+
+	for( std::string basePath : m_argumentParser->get<std::vector<std::string>>( m_resourceSourceBasePathPreviousArgumentId ) )
+	{
+		createPatchParams.resourceSourceSettingsPrevious.basePaths.push_back( basePath );
+	}
+
+	std::string resourceSourceTypeNext = m_argumentParser->get<std::string>( m_resourceSourceTypeNextArgumentId );
+
+	if( !StringToResourceSourceType( resourceSourceTypeNext, createPatchParams.resourceSourceSettingsNext.sourceType ) )
+	{
+		returnErrorMessage = "Invalid resource source next type";
+
+		return false;
+	}
+
+	for( std::string basePath : m_argumentParser->get<std::vector<std::string>>( m_resourceSourceBasePathNextArgumentId ) )
+	{
+		createPatchParams.resourceSourceSettingsNext.basePaths.push_back( basePath );
+	}
+
+	std::string patchBinaryDestinationType = m_argumentParser->get<std::string>( m_patchBinaryDestinationTypeArgumentId );
+
+	if( !StringToResourceDestinationType( patchBinaryDestinationType, createPatchParams.resourcePatchBinaryDestinationSettings.destinationType ) )
+	{
+		returnErrorMessage = "Invalid patch binary destination type";
+
+		return false;
+	}
+
+	createPatchParams.resourcePatchBinaryDestinationSettings.basePath = m_argumentParser->get<std::string>( m_patchBinaryDestinationBasePathArgumentId );
+
+	std::string patchResourceGroupDestinationType = m_argumentParser->get<std::string>( m_patchResourceGroupDestinationTypeArgumentId );
+
+	if( !StringToResourceDestinationType( patchResourceGroupDestinationType, createPatchParams.resourcePatchResourceGroupDestinationSettings.destinationType ) )
+	{
+		returnErrorMessage = "Invalid resource group destination type";
+
+		return false;
+	}
+
+	createPatchParams.resourcePatchResourceGroupDestinationSettings.basePath = m_argumentParser->get<std::string>( m_patchResourceGroupDestinationBasePathArgumentId );
+
+	createPatchParams.patchFileRelativePathPrefix = m_argumentParser->get<std::string>( m_patchFileRelativePathPrefixArgumentId );
+
+	try
+	{
+		unsigned long in = std::stoul( m_argumentParser->get( m_maxInputChunkSizeArgumentId ) );
+		if( in > std::numeric_limits<uint32_t>::max() )
+		{
+			returnErrorMessage = "Invalid chunk size";
+			return false;
+		}
+		createPatchParams.maxInputFileChunkSize = static_cast<uint32_t>( in );
+	}
+	catch( std::invalid_argument& )
+	{
+		returnErrorMessage = "Invalid chunk size";
+		return false;
+	}
+	catch( std::out_of_range& )
+	{
+		returnErrorMessage = "Invalid chunk size";
+		return false;
+	}
+
+	createPatchParams.indexFolder = m_argumentParser->get( m_indexFolderArgumentId );
+
+	try
+	{
+		unsigned long threadCount = std::stoul( m_argumentParser->get( m_patchThreadCountArgumentId ) );
+		if( threadCount > std::numeric_limits<unsigned int>::max() )
+		{
+			returnErrorMessage = "Invalid patch thread count";
+			return false;
+		}
+		createPatchParams.patchThreadCount = static_cast<unsigned int>( threadCount );
+	}
+	catch( std::invalid_argument& )
+	{
+		returnErrorMessage = "Invalid patch thread count";
+		return false;
+	}
+	catch( std::out_of_range& )
+	{
+		returnErrorMessage = "Invalid patch thread count";
+		return false;
+	}
+
+	std::string diffEngine = m_argumentParser->get<std::string>( m_diffEngineArgumentId );
+
+	if( !StringToDiffEngineType( diffEngine, createPatchParams.diffEngine ) )
+	{
+		returnErrorMessage = "Invalid diff engine";
+
+		return false;
+	}
+
+	if( s_verbosityLevel != CarbonResources::StatusLevel::OFF )
+	{
+		PrintStartBanner( previousResourceGroupParams, patchResourceGroupPaths, squashParams );
+	}
+
+	return SquashPatches( previousResourceGroupParams, patchResourceGroupPaths, squashParams );
+}
+
+void SquashPatchesCliOperation::PrintStartBanner( const CarbonResources::ResourceGroupImportFromFileParams& previousResourceGroupParams, const std::vector<std::filesystem::path>& patchResourceGroupPaths, const CarbonResources::PatchSquashParams& squashParams ) const
+{
+	const CarbonResources::PatchCreateParams& createPatchParams = squashParams.patchCreateParams;
+
+	std::cout << "---Squashing Patches---" << std::endl;
+
+	PrintCommonOperationHeaderInformation();
+
+	std::cout << "Previous Resource Group: " << previousResourceGroupParams.filename << std::endl;
+
+	for( const std::filesystem::path& path : patchResourceGroupPaths )
+	{
+		std::cout << "Patch Resource Group: " << path << std::endl;
+	}
+
+	std::cout << "Patch Binaries Base Paths: " << PathsToString( squashParams.patchBinarySourceSettings.basePaths ) << std::endl;
+
+	std::cout << "Patch Binaries Source Type: " << SourceTypeToString( squashParams.patchBinarySourceSettings.sourceType ) << std::endl;
+
+	std::cout << "Max Input File Chunk Size: " << createPatchParams.maxInputFileChunkSize << std::endl;
+
+	std::cout << "Resource Group Relative Path: " << createPatchParams.resourceGroupRelativePath << std::endl;
+
+	std::cout << "Resource Group Patch Relative Path: " << createPatchParams.resourceGroupPatchRelativePath << std::endl;
+
+	std::cout << "Patch File Relative Path Prefix: " << createPatchParams.patchFileRelativePathPrefix << std::endl;
+
+	for( std::filesystem::path basePath : createPatchParams.resourceSourceSettingsPrevious.basePaths )
+	{
+		std::cout << "Resource Source Settings From Base Path: " << basePath << std::endl;
+	}
+
+	std::cout << "Resource Source Settings From Source Type: " << SourceTypeToString( createPatchParams.resourceSourceSettingsPrevious.sourceType ) << std::endl;
+
+	for( std::filesystem::path basePath : createPatchParams.resourceSourceSettingsNext.basePaths )
+	{
+		std::cout << "Resource Source Settings To Base Path: " << basePath << std::endl;
+	}
+
+	std::cout << "Resource Source Settings To Source Type: " << SourceTypeToString( createPatchParams.resourceSourceSettingsNext.sourceType ) << std::endl;
+
+	std::cout << "Resource Patch Binary Destination Settings Base Path: " << createPatchParams.resourcePatchBinaryDestinationSettings.basePath << std::endl;
+
+	std::cout << "Resource Patch Binary Destination Settings Destination Type: " << DestinationTypeToString( createPatchParams.resourcePatchBinaryDestinationSettings.destinationType ) << std::endl;
+
+	std::cout << "Resource Patch Resource Group Destination Settings Base Path: " << createPatchParams.resourcePatchResourceGroupDestinationSettings.basePath << std::endl;
+
+	std::cout << "Resource Patch Resource Group Destination Settings Destination Type: " << DestinationTypeToString( createPatchParams.resourcePatchResourceGroupDestinationSettings.destinationType ) << std::endl;
+
+	std::cout << "Index File Folder: " << createPatchParams.indexFolder << std::endl;
+
+	std::cout << "Patch Thread Count: " << createPatchParams.patchThreadCount << std::endl;
+
+	std::cout << "Diff Engine: " << DiffEngineTypeToString( createPatchParams.diffEngine ) << std::endl;
+
+	std::cout << "----------------------------\n"
+			  << std::endl;
+}
+
+bool SquashPatchesCliOperation::SquashPatches( CarbonResources::ResourceGroupImportFromFileParams& previousResourceGroupParams, const std::vector<std::filesystem::path>& patchResourceGroupPaths, CarbonResources::PatchSquashParams& squashParams ) const
+{
+	CarbonResources::StatusCallback statusCallback = GetStatusCallback();
+
+	CarbonResources::PatchCreateParams& createPatchParams = squashParams.patchCreateParams;
+
+	// Get status callback relevant to verbosity level
+	createPatchParams.statusCallback = statusCallback;
+
+	if( statusCallback )
+	{
+		statusCallback( CarbonResources::StatusLevel::OVERVIEW, CarbonResources::StatusProgressType::PERCENTAGE, 0, "Loading previous resource group." );
+	}
+
+	CarbonResources::ResourceGroup resourceGroupPrevious;
+
+	previousResourceGroupParams.statusCallback = statusCallback;
+
+	CarbonResources::Result importPreviousFromFileResult = resourceGroupPrevious.ImportFromFile( previousResourceGroupParams );
+
+	if( importPreviousFromFileResult.type != CarbonResources::ResultType::SUCCESS )
+	{
+		PrintCarbonResourcesError( importPreviousFromFileResult );
+
+		return false;
+	}
+
+	createPatchParams.previousResourceGroup = &resourceGroupPrevious;
+
+	if( statusCallback )
+	{
+		statusCallback( CarbonResources::StatusLevel::OVERVIEW, CarbonResources::StatusProgressType::PERCENTAGE, 25, "Loading patch resource groups." );
+	}
+
+	std::vector<std::unique_ptr<CarbonResources::PatchResourceGroup>> patchResourceGroups;
+
+	for( const std::filesystem::path& path : patchResourceGroupPaths )
+	{
+		auto patchResourceGroup = std::make_unique<CarbonResources::PatchResourceGroup>();
+
+		CarbonResources::ResourceGroupImportFromFileParams importParams;
+
+		importParams.filename = path;
+
+		importParams.statusCallback = statusCallback;
+
+		CarbonResources::Result importResult = patchResourceGroup->ImportFromFile( importParams );
+
+		if( importResult.type != CarbonResources::ResultType::SUCCESS )
+		{
+			PrintCarbonResourcesError( importResult );
+
+			return false;
+		}
+
+		// The chain starts with the first patch, which is squashed with the rest
+		if( !patchResourceGroups.empty() )
+		{
+			squashParams.nextPatchResourceGroups.push_back( patchResourceGroup.get() );
+		}
+
+		patchResourceGroups.push_back( std::move( patchResourceGroup ) );
+	}
+
+	if( statusCallback )
+	{
+		statusCallback( CarbonResources::StatusLevel::OVERVIEW, CarbonResources::StatusProgressType::PERCENTAGE, 50, "Squashing patches." );
+	}
+
+	CarbonResources::Result squashResult = patchResourceGroups.front()->Squash( squashParams );
+
+	if( squashResult.type != CarbonResources::ResultType::SUCCESS )
+	{
+		PrintCarbonResourcesError( squashResult );
+
+		return false;
+	}
+
+	if( statusCallback )
+	{
+		statusCallback( CarbonResources::StatusLevel::OVERVIEW, CarbonResources::StatusProgressType::PERCENTAGE, 100, "Patches squashed succesfully." );
+	}
+
+	return true;
+}
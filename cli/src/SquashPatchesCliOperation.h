@@ -0,0 +1,66 @@
+// Copyright © 2025 CCP ehf.
+
+#pragma once
+#ifndef SquashPatchesCliOperation_H
+#define SquashPatchesCliOperation_H
+
+#include <filesystem>
+#include <vector>
+
+#include "CliOperation.h"
+
+#include <PatchResourceGroup.h>
+
+class SquashPatchesCliOperation : public CliOperation
+{
+public:
+	SquashPatchesCliOperation();
+
+	virtual bool Execute( std::string& returnErrorMessage ) const override;
+
+private:
+	void PrintStartBanner( const CarbonResources::ResourceGroupImportFromFileParams& previousResourceGroupParams, const std::vector<std::filesystem::path>& patchResourceGroupPaths, const CarbonResources::PatchSquashParams& squashParams ) const;
+
+	bool SquashPatches( CarbonResources::ResourceGroupImportFromFileParams& previousResourceGroupParams, const std::vector<std::filesystem::path>& patchResourceGroupPaths, CarbonResources::PatchSquashParams& squashParams ) const;
+
+private:
+	std::string m_previousResourceGroupPathArgumentId;
+
+	std::string m_patchResourceGroupPathsArgumentId;
+
+	std::string m_patchBinariesSourceBasePathsArgumentId;
+
+	std::string m_patchBinariesSourceTypeArgumentId;
+
+	std::string m_resourceGroupRelativePathArgumentId;
+
+	std::string m_patchResourceGroupRelativePathArgumentId;
+
+	std::string m_resourceSourceTypePreviousArgumentId;
+
+	std::string m_resourceSourceBasePathPreviousArgumentId;
+
+	std::string m_resourceSourceTypeNextArgumentId;
+
+	std::string m_resourceSourceBasePathNextArgumentId;
+
+	std::string m_patchBinaryDestinationTypeArgumentId;
+
+	std::string m_patchBinaryDestinationBasePathArgumentId;
+
+	std::string m_patchResourceGroupDestinationTypeArgumentId;
+
+	std::string m_patchResourceGroupDestinationBasePathArgumentId;
+
+	std::string m_patchFileRelativePathPrefixArgumentId;
+
+	std::string m_maxInputChunkSizeArgumentId;
+
+	std::string m_indexFolderArgumentId;
+
+	std::string m_patchThreadCountArgumentId;
+
+	std::string m_diffEngineArgumentId;
+};
+
+#endif // SquashPatchesCliOperation_H
@@ -16,6 +16,7 @@
 #include "MergeResourceGroupCliOperation.h"
 #include "DiffResourceGroupCliOperation.h"
 #include "RemoveResourcesCliOperation.h"
+#include "SquashPatchesCliOperation.h"
 #include "Defines.h"
 
 std::string CalculateVersionString()
@@ -43,6 +44,10 @@ int main( int argc, char** argv )
 
 	cli.AddOperation( &createPatchOperation );
 
+	SquashPatchesCliOperation squashPatchesOperation;
+
+	cli.AddOperation( &squashPatchesOperation );
+
 	CreateBundleCliOperation createBundleOperation;
 
 	cli.AddOperation( &createBundleOperation );
@@ -6,6 +6,7 @@
 
 #include "Exports.h"
 #include "ResourceGroup.h"
+#include "PatchResourceGroup.h"
 #include "Enums.h"
 #include <memory>
 #include <string>
@@ -31,6 +32,20 @@ struct BundleUnpackParams final
 	StatusCallback statusCallback = nullptr;
 };
 
+/** @struct BundleApplyPatchParams
+    *  @brief Function Parameters required for CarbonResources::BundleResourceGroup::ApplyPatch
+    *  @var BundleApplyPatchParams::chunkSourceSettings
+    *  Location where chunks can be sourced.
+    *  @var BundleApplyPatchParams::patchApplyParams
+    *  Parameters of applying the bundled patch. Patch binaries and the ResourceGroup the patch produces are taken from the bundle, so PatchApplyParams::patchBinarySourceSettings is unused. Resources are patched one at a time in bundle order, so PatchApplyParams::applyThreadCount is unused.
+    */
+struct BundleApplyPatchParams final
+{
+	ResourceSourceSettings chunkSourceSettings;
+
+	PatchApplyParams patchApplyParams;
+};
+
 /** @class BundleResourceGroup
     *  @brief Contains a collection of Chunk Resources
     */
@@ -51,6 +66,13 @@ public:
 	/// @return Result see CarbonResources::Result for more details.
 	Result Unpack( const BundleUnpackParams& params );
 
+	/// @brief Applies the PatchResourceGroup in the bundle, feeding patches to the patcher as chunks arrive instead of unpacking them to disk first.
+	/// @param params input parameters, See BundleApplyPatchParams for more details.
+	/// @see ResourceGroup::CreateBundle for information regarding bundle creation.
+	/// @see PatchResourceGroup::Apply for information regarding patch application.
+	/// @return Result see CarbonResources::Result for more details.
+	Result ApplyPatch( const BundleApplyPatchParams& params );
+
 private:
 	BundleResourceGroupImpl* m_impl;
 };
@@ -232,6 +232,20 @@ enum class ResourceDestinationType
 	//Note: If altering this enum, ensure that Enums::resourceDestinationTypeChoicesAsString reflects update.
 };
 
+/** @enum DiffEngineType
+    *  @brief Algorithm binary patches are created with.
+    *  @var DiffEngineType::BSDIFF
+    *  bsdiff. Small patches, but sorting the previous data needs several times its size in memory.
+    *  @var DiffEngineType::ZSTD
+    *  zstd compression of the latest data with the previous data as prefix, as zstd --patch-from. Uses less memory and long distance matching finds data moved anywhere within the previous data.
+    */
+enum class DiffEngineType
+{
+	BSDIFF,
+	ZSTD,
+	//Note: If altering this enum, ensure that CliOperation::DiffEngineTypeChoicesAsString reflects update.
+};
+
 /** @struct Version
     *  @brief Represents Version information. Version follows semantic versioning paradigm.
     *  @var Version::major
@@ -10,6 +10,7 @@
 #include <memory>
 #include <string>
 #include <filesystem>
+#include <vector>
 
 namespace CarbonResources
 {
@@ -28,6 +29,12 @@ namespace CarbonResources
     *  Name of a temporary filename to use when patching large files. This file will be cleaned up on process completion. 
     *  @var PatchApplyParams::statusCallback
     *  Optional status function callback. Callback is triggered at key status update events.
+    *  @var PatchApplyParams::applyThreadCount
+    *  Number of resources patched at the same time, 0 uses one per hardware thread. Each worker stages resources in its own temporary file, PatchApplyParams::temporaryFilePath with the worker number appended. A resource is only written to PatchApplyParams::resourcesToPatchDestinationSettings once its checksum is verified. After a failure no further resources are started, and the failure of the first resource in order is returned. Default is 1
+    *  @var PatchApplyParams::applyMemoryBudget
+    *  Maximum memory in bytes used by the workers of PatchApplyParams::applyThreadCount. Each holds a few chunks of the patch's maximum input chunk size, fewer workers are used if they would not fit. Default is 1073741824
+    *  @var PatchApplyParams::journalFilePath
+    *  Optional file recording the target checksum and size of each resource once it is patched. If Apply is interrupted, running it again with the same journal skips resources already patched after checking their size, and removes temporary files left behind. Each resource is recorded and synced to disk before it is replaced, so the journal survives the process being killed or the machine going down. Tests interrupt Apply at the points it reports status: before a resource is patched and on either side of replacing it. Only resources written to local destinations are recorded. The journal is removed once the patch is applied. Default is empty, no journal is kept
     */
 struct PatchApplyParams final
 {
@@ -42,6 +49,32 @@ struct PatchApplyParams final
 	std::filesystem::path temporaryFilePath = "tempFile.resource";
 
 	StatusCallback statusCallback = nullptr;
+
+	unsigned int applyThreadCount = 1;
+
+	uintmax_t applyMemoryBudget = 1073741824;
+
+	std::filesystem::path journalFilePath;
+};
+
+class PatchResourceGroup;
+
+/** @struct PatchSquashParams
+    *  @brief Function Parameters required for CarbonResources::PatchResourceGroup::Squash
+    *  @var PatchSquashParams::nextPatchResourceGroups
+    *  Patches which follow the squashed PatchResourceGroup, in the order they are applied. Each patches the next build of the one before it.
+    *  @var PatchSquashParams::patchBinarySourceSettings
+    *  Location where the patch binaries and ResourceGroups of every patch in the chain can be sourced.
+    *  @var PatchSquashParams::patchCreateParams
+    *  Parameters of the produced patch. PatchCreateParams::previousResourceGroup is the previous build of the squashed PatchResourceGroup, with its resources sourced from PatchCreateParams::resourceSourceSettingsPrevious. Resources of the last next build are sourced from PatchCreateParams::resourceSourceSettingsNext. Resources changed by more than one patch are diffed again from the first previous build to the last next build. Resources changed by only one patch keep its patches, unless that patch was created with a different PatchCreateParams::maxInputFileChunkSize or takes data from a resource changed earlier in the chain.
+    */
+struct PatchSquashParams final
+{
+	std::vector<const PatchResourceGroup*> nextPatchResourceGroups;
+
+	ResourceSourceSettings patchBinarySourceSettings{};
+
+	PatchCreateParams patchCreateParams;
 };
 
 /** @class PatchResourceGroup
@@ -65,6 +98,12 @@ public:
 	/// @return Result see CarbonResources::Result for more details.
 	Result Apply( const PatchApplyParams& params );
 
+	/// @brief Combines a chain of patches starting with this PatchResourceGroup into a single patch from its previous build to the next build of the last.
+	/// @param params input parameters, See PatchSquashParams for more details.
+	/// @note Applying the produced patch reads and writes every changed resource once, rather than once per patch in the chain.
+	/// @return Result see CarbonResources::Result for more details.
+	Result Squash( const PatchSquashParams& params ) const;
+
 private:
 	PatchResourceGroupImpl* m_impl;
 };
@@ -10,6 +10,7 @@
 #include <string>
 #include <filesystem>
 #include <functional>
+#include <vector>
 
 
 namespace CarbonResources
@@ -94,6 +95,28 @@ struct BundleCreateParams
     bool calculateCompressions = true;
 };
 
+/** @struct PatchBaseParams
+    *  @brief Another previous build to create a patch from in the same CarbonResources::ResourceGroup::CreatePatch, see PatchCreateParams::additionalPreviousBuilds
+    *  @var PatchBaseParams::previousResourceGroup
+    *  ResourceGroup containing resources from this previous build.
+    *  @var PatchBaseParams::resourceSourceSettingsPrevious
+    *  Where resources for this previous build will be sourced.
+    *  @var PatchBaseParams::resourceGroupRelativePath
+    *  Relative path for output resourceGroup which will contain the diff between PatchBaseParams::previousResourceGroup and this ResourceGroup. Must differ from that of every other previous build.
+    *  @var PatchBaseParams::resourceGroupPatchRelativePath
+    *  Relative path for output PatchResourceGroup which will contain the patches from this previous build. Must differ from that of every other previous build.
+    */
+struct PatchBaseParams
+{
+	ResourceGroup* previousResourceGroup = nullptr;
+
+	ResourceSourceSettings resourceSourceSettingsPrevious = { CarbonResources::ResourceSourceType::LOCAL_RELATIVE };
+
+	std::filesystem::path resourceGroupRelativePath;
+
+	std::filesystem::path resourceGroupPatchRelativePath;
+};
+
 /** @struct PatchCreateParams
     *  @brief Function Parameters required for CarbonResources::ResourceGroup::CreatePatch
     *  @var PatchCreateParams::maxInputFileChunkSize
@@ -120,6 +143,40 @@ struct BundleCreateParams
     *  Delay before a failed download is retried (seconds)
     *  @var PatchCreateParams::indexFolder
     *  Directory to store index calculation files during patch creation.
+    *  @var PatchCreateParams::indexCacheFolder
+    *  Optional directory to keep indexes of previous build resources in between patch creations, keyed by resource checksum and maxInputFileChunkSize. Cached indexes are not filtered against the next build so take more space. Empty disables the cache, which is the default.
+    *  @var PatchCreateParams::indexCacheMaxSize
+    *  Maximum size in bytes of PatchCreateParams::indexCacheFolder, least recently used indexes are evicted past this size. Default is 10000000000
+    *  @var PatchCreateParams::indexThreadCount
+    *  Number of threads used to generate the index of each previous build resource, 0 uses one per hardware thread. The generated index does not depend on it. Default is 1
+    *  @var PatchCreateParams::indexBlockHashes
+    *  Store a strong hash of every maxInputFileChunkSize aligned block of previous build resources in their index, so chunk matches at those offsets are verified without reading the resource again. Default is false
+    *  @var PatchCreateParams::indexMemoryBudget
+    *  Maximum memory in bytes used to sort index entries of a previous build resource, larger indexes are sorted in runs in PatchCreateParams::indexFolder and merged. Default is 536870912
+    *  @var PatchCreateParams::patchThreadCount
+    *  Number of resources patches are created for at the same time, 0 uses one per hardware thread. Patches are numbered in resource order so the produced PatchResourceGroup does not depend on it. Default is 1
+    *  @var PatchCreateParams::patchMemoryBudget
+    *  Maximum size in bytes of patch data held in memory while waiting for patches of earlier resources to be saved, when PatchCreateParams::patchThreadCount is not 1. Default is 1073741824
+    *  @var PatchCreateParams::diffThreadCount
+    *  Number of chunks of a resource diffed at the same time, 0 uses one per hardware thread. Chunks are still matched against the previous resource in order, so the produced patches do not depend on it. Each patched resource uses its own threads, see PatchCreateParams::patchThreadCount. Default is 1
+    *  @var PatchCreateParams::contentDefinedChunking
+    *  Split resources into chunks of at most maxInputFileChunkSize at boundaries chosen by their content rather than at fixed offsets. Boundaries line up again shortly after an insertion or removal, so unchanged chunks are found by hash without generating an index of the previous resource. Index parameters are ignored. Default is false
+    *  @var PatchCreateParams::crossResourceMatching
+    *  Create patches for new resources from the data of previous resources which are left unchanged or removed, so moved or renamed content is not shipped again. Previous resources are split as with PatchCreateParams::contentDefinedChunking and every one of them is read. Default is false
+    *  @var PatchCreateParams::detectResourceCopies
+    *  Find new resources with the same checksum as a previous resource which is left unchanged or removed. These are made by copying the previous resource when the patch is applied, with no patch data. Default is false
+    *  @var PatchCreateParams::patchCacheFolder
+    *  Optional folder in which to keep the patches of changed resources between runs. A resource whose previous and next checksums were patched before with the same PatchCreateParams::maxInputFileChunkSize, PatchCreateParams::diffEngine and PatchCreateParams::contentDefinedChunking reuses those patches rather than creating them again. New resources patched from other resources are not cached. Empty disables the cache, which is the default.
+    *  @var PatchCreateParams::patchCacheMaxSize
+    *  Maximum size in bytes of PatchCreateParams::patchCacheFolder, least recently used entries are evicted past this size. Default is 10000000000
+    *  @var PatchCreateParams::patchCacheHits
+    *  Optional output of the number of resources whose patches were found in PatchCreateParams::patchCacheFolder
+    *  @var PatchCreateParams::patchCacheMisses
+    *  Optional output of the number of resources whose patches were not found in PatchCreateParams::patchCacheFolder and were created
+    *  @var PatchCreateParams::diffEngine
+    *  Algorithm patch data is created with. Patches made with an engine other than bsdiff record it, so applying them needs a client which knows the engine. Default is DiffEngineType::BSDIFF
+    *  @var PatchCreateParams::additionalPreviousBuilds
+    *  Further previous builds to create patches from, each getting its own PatchResourceGroup. Patch binaries are numbered across all previous builds, and a resource whose previous and next versions were already patched for an earlier previous build reuses those patch binaries rather than creating them again. Empty by default.
     *  @var BundleCreateParams::calculateCompressions
     *  Specifies if compression will be calculated for the generated bundle chunks
     */
@@ -149,6 +206,40 @@ struct PatchCreateParams
 
 	std::filesystem::path indexFolder = std::filesystem::temp_directory_path() / "carbonResources" / "chunkIndexes";
 
+	std::filesystem::path indexCacheFolder = "";
+
+	uintmax_t indexCacheMaxSize = 10000000000;
+
+	unsigned int indexThreadCount = 1;
+
+	bool indexBlockHashes = false;
+
+	uintmax_t indexMemoryBudget = 536870912;
+
+	unsigned int patchThreadCount = 1;
+
+	uintmax_t patchMemoryBudget = 1073741824;
+
+	unsigned int diffThreadCount = 1;
+
+	bool contentDefinedChunking = false;
+
+	bool crossResourceMatching = false;
+
+	bool detectResourceCopies = false;
+
+	DiffEngineType diffEngine = DiffEngineType::BSDIFF;
+
+	std::filesystem::path patchCacheFolder = "";
+
+	uintmax_t patchCacheMaxSize = 10000000000;
+
+	uintmax_t* patchCacheHits = nullptr;
+
+	uintmax_t* patchCacheMisses = nullptr;
+
+	std::vector<PatchBaseParams> additionalPreviousBuilds;
+
     bool calculateCompressions = true;
 };
 
@@ -250,6 +341,10 @@ struct ResourceGroupRemoveResourcesParams
     *  Output list of relative paths that have been added or modified on second group.
     *  @var ResourceGroupDiffAgainstGroupParams::subtractions
     *  Output list of relative paths that have been removed on second group.
+    *  @var ResourceGroupDiffAgainstGroupParams::moves
+    *  Optional output list of resources moved on second group, as the previous and new relative path. Only detected when ResourceGroupDiffAgainstGroupParams::copies is also set. Moved resources have identical data and are listed in neither additions nor subtractions.
+    *  @var ResourceGroupDiffAgainstGroupParams::copies
+    *  Optional output list of resources copied on second group, as the relative path of the unchanged or removed resource copied and the new relative path. Only detected when ResourceGroupDiffAgainstGroupParams::moves is also set. Copies are not listed in additions.
     */
 struct ResourceGroupDiffAgainstGroupParams
 {
@@ -258,6 +353,10 @@ struct ResourceGroupDiffAgainstGroupParams
 	std::vector<std::filesystem::path>* additions = nullptr;
 
 	std::vector<std::filesystem::path>* subtractions = nullptr;
+
+	std::vector<std::pair<std::filesystem::path, std::filesystem::path>>* moves = nullptr;
+
+	std::vector<std::pair<std::filesystem::path, std::filesystem::path>>* copies = nullptr;
 };
 
 /** @class ResourceGroup
@@ -21,4 +21,9 @@ Result BundleResourceGroup::Unpack( const BundleUnpackParams& params )
 	return m_impl->Unpack( params );
 }
 
+Result BundleResourceGroup::ApplyPatch( const BundleApplyPatchParams& params )
+{
+	return m_impl->ApplyPatch( params );
+}
+
 }
\ No newline at end of file
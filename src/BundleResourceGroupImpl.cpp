@@ -16,9 +16,306 @@
 
 #include "PatchResourceGroupImpl.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace CarbonResources
 {
 
+namespace
+{
+// Reads the data of bundled resources from the chunks of a bundle, fetching chunks only as they are needed
+class BundledResourceReader
+{
+public:
+	BundledResourceReader( const std::vector<ResourceInfo*>& chunks, const ResourceSourceSettings& chunkSourceSettings, uintmax_t chunkSize ) :
+		m_chunks( chunks ),
+		m_chunkSourceSettings( chunkSourceSettings ),
+		m_bundleStream( chunkSize )
+	{
+	}
+
+	// Resources in the order they were bundled, resources without data are not in the chunks
+	Result Initialize( const std::vector<ResourceInfo*>& bundledResources )
+	{
+		uintmax_t offset = 0;
+
+		for( ResourceInfo* resource : bundledResources )
+		{
+			std::string location;
+
+			Result getLocationResult = resource->GetLocation( location );
+
+			if( getLocationResult.type != ResultType::SUCCESS )
+			{
+				return getLocationResult;
+			}
+
+			if( location.empty() )
+			{
+				continue;
+			}
+
+			uintmax_t uncompressedSize;
+
+			Result getUncompressedSizeResult = resource->GetUncompressedSize( uncompressedSize );
+
+			if( getUncompressedSizeResult.type != ResultType::SUCCESS )
+			{
+				return getUncompressedSizeResult;
+			}
+
+			m_bundledResources.push_back( { resource, offset, uncompressedSize } );
+
+			offset += uncompressedSize;
+		}
+
+		return Result{ ResultType::SUCCESS };
+	}
+
+	// Reads on through the bundle to resource, keeping the data of resources passed on the way until they are read
+	// unless they are skipped
+	Result Read( const ResourceInfo* resource, std::string& data )
+	{
+		auto passedResourceIter = m_passedResources.find( resource );
+
+		if( passedResourceIter != m_passedResources.end() )
+		{
+			data = std::move( passedResourceIter->second );
+
+			m_passedResources.erase( passedResourceIter );
+
+			return Result{ ResultType::SUCCESS };
+		}
+
+		while( m_nextResource < m_bundledResources.size() )
+		{
+			const BundledResource& bundledResource = m_bundledResources[m_nextResource];
+
+			std::string bundledResourceData;
+
+			Result readNextResult = ReadNext( bundledResourceData );
+
+			if( readNextResult.type != ResultType::SUCCESS )
+			{
+				return readNextResult;
+			}
+
+			if( bundledResource.resource == resource )
+			{
+				data = std::move( bundledResourceData );
+
+				return Result{ ResultType::SUCCESS };
+			}
+
+			if( m_skippedResources.erase( bundledResource.resource ) == 0 )
+			{
+				m_passedResources.emplace( bundledResource.resource, std::move( bundledResourceData ) );
+			}
+		}
+
+		return Result{ ResultType::RESOURCE_NOT_FOUND };
+	}
+
+	// Resource will not be read, drop its data if it has been passed and don't keep it when it is
+	void Skip( const ResourceInfo* resource )
+	{
+		if( m_passedResources.erase( resource ) > 0 )
+		{
+			return;
+		}
+
+		for( size_t i = m_nextResource; i < m_bundledResources.size(); i++ )
+		{
+			if( m_bundledResources[i].resource == resource )
+			{
+				m_skippedResources.insert( resource );
+
+				return;
+			}
+		}
+	}
+
+	// Reads resource from just the chunks holding it, leaving the position in the bundle as it is
+	Result ReadOutOfOrder( const ResourceInfo* resource, std::string& data ) const
+	{
+		auto bundledResourceIter = std::find_if( m_bundledResources.begin(), m_bundledResources.end(), [resource]( const BundledResource& bundledResource ) {
+			return bundledResource.resource == resource;
+		} );
+
+		if( bundledResourceIter == m_bundledResources.end() )
+		{
+			return Result{ ResultType::RESOURCE_NOT_FOUND };
+		}
+
+		uintmax_t resourceEnd = bundledResourceIter->offset + bundledResourceIter->size;
+
+		uintmax_t chunkStart = 0;
+
+		uintmax_t firstChunkStart = 0;
+
+		std::string chunksData;
+
+		for( const ResourceInfo* chunk : m_chunks )
+		{
+			if( chunkStart >= resourceEnd && !chunksData.empty() )
+			{
+				break;
+			}
+
+			uintmax_t chunkUncompressedSize;
+
+			Result getChunkUncompressedSizeResult = chunk->GetUncompressedSize( chunkUncompressedSize );
+
+			if( getChunkUncompressedSizeResult.type != ResultType::SUCCESS )
+			{
+				return getChunkUncompressedSizeResult;
+			}
+
+			if( chunkStart + chunkUncompressedSize > bundledResourceIter->offset )
+			{
+				if( chunksData.empty() )
+				{
+					firstChunkStart = chunkStart;
+				}
+
+				std::string chunkData;
+
+				Result getChunkDataResult = GetChunkData( chunk, chunkData );
+
+				if( getChunkDataResult.type != ResultType::SUCCESS )
+				{
+					return getChunkDataResult;
+				}
+
+				chunksData.append( chunkData );
+			}
+
+			chunkStart += chunkUncompressedSize;
+		}
+
+		if( firstChunkStart + chunksData.size() < resourceEnd )
+		{
+			return Result{ ResultType::UNEXPECTED_END_OF_CHUNKS };
+		}
+
+		data = chunksData.substr( bundledResourceIter->offset - firstChunkStart, bundledResourceIter->size );
+
+		return VerifyData( resource, data );
+	}
+
+private:
+	struct BundledResource
+	{
+		const ResourceInfo* resource;
+
+		// Position in the uncompressed data of all chunks
+		uintmax_t offset;
+
+		uintmax_t size;
+	};
+
+	Result ReadNext( std::string& data )
+	{
+		const BundledResource& bundledResource = m_bundledResources[m_nextResource];
+
+		while( m_bundleStream.GetCacheSize() < bundledResource.size )
+		{
+			if( m_nextChunk == m_chunks.size() )
+			{
+				return Result{ ResultType::UNEXPECTED_END_OF_CHUNKS };
+			}
+
+			std::string chunkData;
+
+			Result getChunkDataResult = GetChunkData( m_chunks[m_nextChunk], chunkData );
+
+			if( getChunkDataResult.type != ResultType::SUCCESS )
+			{
+				return getChunkDataResult;
+			}
+
+			if( !( m_bundleStream << chunkData ) )
+			{
+				return Result{ ResultType::FAIL };
+			}
+
+			m_nextChunk++;
+		}
+
+		if( !m_bundleStream.ReadBytes( bundledResource.size, data ) )
+		{
+			return Result{ ResultType::FAILED_TO_RETRIEVE_CHUNK_DATA };
+		}
+
+		m_nextResource++;
+
+		return VerifyData( bundledResource.resource, data );
+	}
+
+	Result GetChunkData( const ResourceInfo* chunk, std::string& chunkData ) const
+	{
+		ResourceGetDataParams resourceGetDataParams;
+
+		resourceGetDataParams.resourceSourceSettings = m_chunkSourceSettings;
+
+		resourceGetDataParams.data = &chunkData;
+
+		Result getChunkChecksumResult = chunk->GetChecksum( resourceGetDataParams.expectedChecksum );
+
+		if( getChunkChecksumResult.type != ResultType::SUCCESS )
+		{
+			return getChunkChecksumResult;
+		}
+
+		return chunk->GetData( resourceGetDataParams );
+	}
+
+	static Result VerifyData( const ResourceInfo* resource, const std::string& data )
+	{
+		std::string dataChecksum;
+
+		if( !ResourceTools::GenerateMd5Checksum( data, dataChecksum ) )
+		{
+			return Result{ ResultType::FAILED_TO_GENERATE_CHECKSUM };
+		}
+
+		std::string resourceChecksum;
+
+		Result getChecksumResult = resource->GetChecksum( resourceChecksum );
+
+		if( getChecksumResult.type != ResultType::SUCCESS )
+		{
+			return getChecksumResult;
+		}
+
+		if( dataChecksum != resourceChecksum )
+		{
+			return Result{ ResultType::UNEXPECTED_CHUNK_CHECKSUM_RESULT };
+		}
+
+		return Result{ ResultType::SUCCESS };
+	}
+
+	const std::vector<ResourceInfo*>& m_chunks;
+
+	const ResourceSourceSettings& m_chunkSourceSettings;
+
+	ResourceTools::BundleStreamIn m_bundleStream;
+
+	std::vector<BundledResource> m_bundledResources;
+
+	size_t m_nextResource = 0;
+
+	size_t m_nextChunk = 0;
+
+	std::unordered_map<const ResourceInfo*, std::string> m_passedResources;
+
+	std::unordered_set<const ResourceInfo*> m_skippedResources;
+};
+}
+
 BundleResourceGroup::BundleResourceGroupImpl::BundleResourceGroupImpl() :
 	ResourceGroup::ResourceGroupImpl()
 {
@@ -63,40 +360,13 @@ Result BundleResourceGroup::BundleResourceGroupImpl::Unpack( const BundleUnpackP
 
 
 	// Load the resourceGroup from the resourceGroupResource
-	std::string resourceGroupData;
-
-	ResourceGetDataParams resourceGroupDataParams;
-
-	resourceGroupDataParams.resourceSourceSettings = params.chunkSourceSettings;
-
-	resourceGroupDataParams.data = &resourceGroupData;
-
-	Result getChecksumResult = resourceGroupResource->GetChecksum( resourceGroupDataParams.expectedChecksum );
-
-	if( getChecksumResult.type != ResultType::SUCCESS )
-	{
-		return getChecksumResult;
-	}
+	std::shared_ptr<ResourceGroupImpl> resourceGroup;
 
-	Result resourceGroupGetDataResult = m_resourceGroupParameter.GetValue()->GetData( resourceGroupDataParams );
+	Result loadBundledResourceGroupResult = LoadBundledResourceGroup( params.chunkSourceSettings, resourceGroup );
 
-	if( resourceGroupGetDataResult.type != ResultType::SUCCESS )
+	if( loadBundledResourceGroupResult.type != ResultType::SUCCESS )
 	{
-		return resourceGroupGetDataResult;
-	}
-
-	std::shared_ptr<ResourceGroupImpl> resourceGroup;
-	Result createResult = CreateResourceGroupFromYamlString( resourceGroupData, resourceGroup );
-	if( createResult.type != ResultType::SUCCESS )
-	{
-		std::stringstream ss;
-		ss << "Failed to import resource group data from the following paths:";
-		for( auto path : resourceGroupDataParams.resourceSourceSettings.basePaths )
-		{
-			ss << " \"" << path.string() << "\"";
-		}
-		createResult.info = ss.str();
-		return createResult;
+		return loadBundledResourceGroupResult;
 	}
 
 	// Create stream
@@ -314,6 +584,131 @@ Result BundleResourceGroup::BundleResourceGroupImpl::Unpack( const BundleUnpackP
 	return Result{ ResultType::SUCCESS };
 }
 
+Result BundleResourceGroup::BundleResourceGroupImpl::ApplyPatch( const BundleApplyPatchParams& params )
+{
+	if( params.patchApplyParams.statusCallback )
+	{
+		params.patchApplyParams.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 0, "Applying Bundled Patch." );
+	}
+
+	// Load the patch from the resourceGroupResource
+	std::shared_ptr<ResourceGroupImpl> resourceGroup;
+
+	Result loadBundledResourceGroupResult = LoadBundledResourceGroup( params.chunkSourceSettings, resourceGroup );
+
+	if( loadBundledResourceGroupResult.type != ResultType::SUCCESS )
+	{
+		return loadBundledResourceGroupResult;
+	}
+
+	std::shared_ptr<PatchResourceGroup::PatchResourceGroupImpl> patchResourceGroup = std::dynamic_pointer_cast<PatchResourceGroup::PatchResourceGroupImpl>( resourceGroup );
+
+	if( !patchResourceGroup )
+	{
+		return Result{ ResultType::FILE_TYPE_MISMATCH };
+	}
+
+	// Bundled in the same order as when the bundle was created
+	std::vector<ResourceInfo*> toBundle;
+
+	std::copy( patchResourceGroup->begin(), patchResourceGroup->end(), std::back_inserter( toBundle ) );
+
+	Result getGroupSpecificResourcesToBundleResult = patchResourceGroup->GetGroupSpecificResourcesToBundle( toBundle );
+
+	if( getGroupSpecificResourcesToBundleResult.type != ResultType::SUCCESS )
+	{
+		return getGroupSpecificResourcesToBundleResult;
+	}
+
+	// The ResourceGroup the patch produces is the only resource bundled after the patches
+	if( toBundle.size() != patchResourceGroup->GetSize() + 1 )
+	{
+		return Result{ ResultType::MALFORMED_RESOURCE_GROUP };
+	}
+
+	BundledResourceReader bundledResourceReader( *m_resourcesParameter.GetValue(), params.chunkSourceSettings, m_chunkSize.GetValue() );
+
+	Result initializeResult = bundledResourceReader.Initialize( toBundle );
+
+	if( initializeResult.type != ResultType::SUCCESS )
+	{
+		return initializeResult;
+	}
+
+	// Needed before any patch, so read ahead to the end of the bundle for it
+	std::string nextResourceGroupData;
+
+	Result readNextResourceGroupResult = bundledResourceReader.ReadOutOfOrder( toBundle.back(), nextResourceGroupData );
+
+	if( readNextResourceGroupResult.type != ResultType::SUCCESS )
+	{
+		return readNextResourceGroupResult;
+	}
+
+	ResourceGroupImpl nextResourceGroup;
+
+	Result importNextResourceGroupResult = nextResourceGroup.ImportFromData( nextResourceGroupData );
+
+	if( importNextResourceGroupResult.type != ResultType::SUCCESS )
+	{
+		return importNextResourceGroupResult;
+	}
+
+	// Patches are created in the order of the resources they target, so are requested in the order they were bundled
+	PatchDataSource patchDataSource;
+
+	patchDataSource.read = [&bundledResourceReader]( const PatchResourceInfo* patch, std::string& patchData ) {
+		return bundledResourceReader.Read( patch, patchData );
+	};
+
+	// Resources already patched by an interrupted Apply don't read their patches, which would otherwise be kept until the end
+	patchDataSource.skip = [&bundledResourceReader]( const PatchResourceInfo* patch ) {
+		bundledResourceReader.Skip( patch );
+	};
+
+	return patchResourceGroup->ApplyResourceGroup( params.patchApplyParams, nextResourceGroup, &patchDataSource );
+}
+
+Result BundleResourceGroup::BundleResourceGroupImpl::LoadBundledResourceGroup( const ResourceSourceSettings& chunkSourceSettings, std::shared_ptr<ResourceGroupImpl>& resourceGroup ) const
+{
+	std::string resourceGroupData;
+
+	ResourceGetDataParams resourceGroupDataParams;
+
+	resourceGroupDataParams.resourceSourceSettings = chunkSourceSettings;
+
+	resourceGroupDataParams.data = &resourceGroupData;
+
+	Result getChecksumResult = m_resourceGroupParameter.GetValue()->GetChecksum( resourceGroupDataParams.expectedChecksum );
+
+	if( getChecksumResult.type != ResultType::SUCCESS )
+	{
+		return getChecksumResult;
+	}
+
+	Result resourceGroupGetDataResult = m_resourceGroupParameter.GetValue()->GetData( resourceGroupDataParams );
+
+	if( resourceGroupGetDataResult.type != ResultType::SUCCESS )
+	{
+		return resourceGroupGetDataResult;
+	}
+
+	Result createResult = CreateResourceGroupFromYamlString( resourceGroupData, resourceGroup );
+	if( createResult.type != ResultType::SUCCESS )
+	{
+		std::stringstream ss;
+		ss << "Failed to import resource group data from the following paths:";
+		for( auto path : resourceGroupDataParams.resourceSourceSettings.basePaths )
+		{
+			ss << " \"" << path.string() << "\"";
+		}
+		createResult.info = ss.str();
+		return createResult;
+	}
+
+	return Result{ ResultType::SUCCESS };
+}
+
 std::string BundleResourceGroup::BundleResourceGroupImpl::GetType() const
 {
 	return TypeId();
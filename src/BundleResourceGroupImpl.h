@@ -28,6 +28,8 @@ public:
 
 	Result Unpack( const BundleUnpackParams& params );
 
+	Result ApplyPatch( const BundleApplyPatchParams& params );
+
 	virtual std::string GetType() const override;
 
 	static std::string TypeId();
@@ -35,6 +37,9 @@ public:
 	Result SetChunkSize( uintmax_t size );
 
 private:
+	// Import the ResourceGroup the bundle was created from
+	Result LoadBundledResourceGroup( const ResourceSourceSettings& chunkSourceSettings, std::shared_ptr<ResourceGroupImpl>& resourceGroup ) const;
+
 	virtual Result CreateResourceFromYaml( YAML::Node& resource, ResourceInfo*& resourceOut ) override;
 
 	virtual Result ImportGroupSpecialisedYaml( YAML::Node& resourceGroupFile ) override;
@@ -40,6 +40,8 @@ ParameterInfo PARAMETER_UNCOMPRESSED_SIZE( Parameter::UNCOMPRESSED_SIZE, "Uncomp
 ParameterInfo PARAMETER_BINARY_OPERATION( Parameter::BINARY_OPERATION, "BinaryOperation", { { CONTEXT_RESOURCE, VERSION_0_0_0, VERSION_MAX } }, true );
 ParameterInfo PARAMETER_PREFIX( Parameter::PREFIX, "Prefix", { { CONTEXT_RESOURCE, VERSION_0_0_0, VERSION_MAX } }, true );
 ParameterInfo PARAMETER_REMOVED_RESOURCE_RELATIVE_PATHS( Parameter::REMOVED_RESOURCE_RELATIVE_PATHS, "RemovedResourceRelativePaths", { { CONTEXT_PATCH_GROUP, VERSION_0_1_0, VERSION_MAX } } );
+ParameterInfo PARAMETER_SOURCE_RESOURCE_RELATIVE_PATH( Parameter::SOURCE_RESOURCE_RELATIVE_PATH, "SourceResourceRelativePath", { { CONTEXT_BINARY_PATCH, VERSION_0_1_0, VERSION_MAX } }, true );
+ParameterInfo PARAMETER_DIFF_ENGINE( Parameter::DIFF_ENGINE, "DiffEngine", { { CONTEXT_BINARY_PATCH, VERSION_0_1_0, VERSION_MAX } }, true );
 
 ParameterInfo::ParameterInfo( CarbonResources::Parameter id, std::string tag, std::vector<ParameterContext> context, bool isOptional ) :
 	m_id( id ),
@@ -39,7 +39,9 @@ enum Parameter
 	UNCOMPRESSED_SIZE,
 	BINARY_OPERATION,
 	PREFIX,
-	REMOVED_RESOURCE_RELATIVE_PATHS
+	REMOVED_RESOURCE_RELATIVE_PATHS,
+	SOURCE_RESOURCE_RELATIVE_PATH,
+	DIFF_ENGINE
 };
 
 class ParameterContext
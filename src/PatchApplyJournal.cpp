@@ -0,0 +1,283 @@
+// Copyright © 2025 CCP ehf.
+
+#include "PatchApplyJournal.h"
+
+#include <sstream>
+
+#include <ResourceTools.h>
+
+constexpr char PATCH_APPLY_JOURNAL_MOVING = 'M';
+
+constexpr char PATCH_APPLY_JOURNAL_COMPLETE = 'C';
+
+constexpr char PATCH_APPLY_JOURNAL_TEMPORARY_FILE = 'T';
+
+namespace CarbonResources
+{
+
+PatchApplyJournal::PatchApplyJournal( const std::filesystem::path& journalPath ) :
+	m_journalPath( journalPath )
+{
+}
+
+Result PatchApplyJournal::Open()
+{
+	if( m_journalPath.empty() )
+	{
+		return Result{ ResultType::SUCCESS };
+	}
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	m_entries.clear();
+
+	m_temporaryFiles.clear();
+
+	// Each line is: type checksum size relativePath, or for temporary files: type path
+	std::ifstream in( m_journalPath, std::ios::binary );
+
+	std::string line;
+
+	while( std::getline( in, line ) )
+	{
+		// The last line is only whole if it ends with a newline
+		if( in.eof() )
+		{
+			break;
+		}
+
+		if( line.size() > 2 && line[0] == PATCH_APPLY_JOURNAL_TEMPORARY_FILE && line[1] == ' ' )
+		{
+			m_temporaryFiles.insert( line.substr( 2 ) );
+
+			continue;
+		}
+
+		std::istringstream lineStream( line );
+
+		char entryType;
+
+		Entry entry;
+
+		std::string relativePath;
+
+		if( !( lineStream >> entryType >> entry.checksum >> entry.size ) || lineStream.get() != ' ' || !std::getline( lineStream, relativePath ) || relativePath.empty() )
+		{
+			continue;
+		}
+
+		if( entryType != PATCH_APPLY_JOURNAL_MOVING && entryType != PATCH_APPLY_JOURNAL_COMPLETE )
+		{
+			continue;
+		}
+
+		entry.complete = entryType == PATCH_APPLY_JOURNAL_COMPLETE;
+
+		m_entries[relativePath] = entry;
+	}
+
+	in.close();
+
+	// Rewrite the journal with just the entries read, so a cut short line is not followed by more
+	std::filesystem::path rewrittenJournalPath = m_journalPath;
+
+	rewrittenJournalPath += ".tmp";
+
+	std::error_code ec;
+
+	if( !m_journalPath.parent_path().empty() )
+	{
+		std::filesystem::create_directories( m_journalPath.parent_path(), ec );
+	}
+
+	std::ofstream rewrittenJournal( rewrittenJournalPath, std::ios::binary | std::ios::trunc );
+
+	for( const auto& temporaryFile : m_temporaryFiles )
+	{
+		rewrittenJournal << PATCH_APPLY_JOURNAL_TEMPORARY_FILE << ' ' << temporaryFile.generic_string() << '\n';
+	}
+
+	for( const auto& entry : m_entries )
+	{
+		rewrittenJournal << ( entry.second.complete ? PATCH_APPLY_JOURNAL_COMPLETE : PATCH_APPLY_JOURNAL_MOVING ) << ' ' << entry.second.checksum << ' ' << entry.second.size << ' ' << entry.first << '\n';
+	}
+
+	rewrittenJournal.close();
+
+	if( !rewrittenJournal || !ResourceTools::SyncFile( rewrittenJournalPath ) || !ResourceTools::MoveFileIntoPlace( rewrittenJournalPath, m_journalPath ) )
+	{
+		return Result{ ResultType::FAILED_TO_SAVE_FILE };
+	}
+
+	m_out.open( m_journalPath, std::ios::binary | std::ios::app );
+
+	if( !m_out )
+	{
+		return Result{ ResultType::FAILED_TO_OPEN_FILE };
+	}
+
+	return Result{ ResultType::SUCCESS };
+}
+
+bool PatchApplyJournal::IsComplete( const std::filesystem::path& relativePath, const std::string& checksum, uintmax_t size, const std::filesystem::path& destinationPath )
+{
+	if( m_journalPath.empty() )
+	{
+		return false;
+	}
+
+	bool complete;
+
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+
+		auto entryIter = m_entries.find( relativePath.generic_string() );
+
+		if( entryIter == m_entries.end() || entryIter->second.checksum != checksum || entryIter->second.size != size )
+		{
+			return false;
+		}
+
+		complete = entryIter->second.complete;
+	}
+
+	std::error_code ec;
+
+	uintmax_t destinationSize = std::filesystem::file_size( destinationPath, ec );
+
+	if( ec || destinationSize != size )
+	{
+		return false;
+	}
+
+	if( complete )
+	{
+		return true;
+	}
+
+	// Interrupted while moving, the destination is either the old or the patched file
+	std::string destinationChecksum;
+
+	if( !ResourceTools::GenerateMd5Checksum( destinationPath, destinationChecksum ) || destinationChecksum != checksum )
+	{
+		return false;
+	}
+
+	return RecordComplete( relativePath, checksum, size ).type == ResultType::SUCCESS;
+}
+
+Result PatchApplyJournal::RecordMoving( const std::filesystem::path& relativePath, const std::string& checksum, uintmax_t size )
+{
+	return Record( PATCH_APPLY_JOURNAL_MOVING, relativePath, checksum, size );
+}
+
+Result PatchApplyJournal::RecordComplete( const std::filesystem::path& relativePath, const std::string& checksum, uintmax_t size )
+{
+	return Record( PATCH_APPLY_JOURNAL_COMPLETE, relativePath, checksum, size );
+}
+
+Result PatchApplyJournal::RecordTemporaryFile( const std::filesystem::path& temporaryFilePath )
+{
+	if( m_journalPath.empty() )
+	{
+		return Result{ ResultType::SUCCESS };
+	}
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	if( !m_temporaryFiles.insert( temporaryFilePath ).second )
+	{
+		return Result{ ResultType::SUCCESS };
+	}
+
+	// Not synced, a temporary file missing from the journal is only left behind
+	m_out << PATCH_APPLY_JOURNAL_TEMPORARY_FILE << ' ' << temporaryFilePath.generic_string() << '\n';
+
+	m_out.flush();
+
+	if( !m_out )
+	{
+		return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
+	}
+
+	return Result{ ResultType::SUCCESS };
+}
+
+void PatchApplyJournal::RemoveTemporaryFiles()
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	for( const auto& temporaryFile : m_temporaryFiles )
+	{
+		std::error_code ec;
+
+		std::filesystem::remove( temporaryFile, ec );
+	}
+}
+
+Result PatchApplyJournal::Remove()
+{
+	if( m_journalPath.empty() )
+	{
+		return Result{ ResultType::SUCCESS };
+	}
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	m_out.close();
+
+	m_entries.clear();
+
+	m_temporaryFiles.clear();
+
+	std::error_code ec;
+
+	std::filesystem::remove( m_journalPath, ec );
+
+	if( ec )
+	{
+		return Result{ ResultType::FAILED_TO_SAVE_FILE };
+	}
+
+	return Result{ ResultType::SUCCESS };
+}
+
+Result PatchApplyJournal::Record( char entryType, const std::filesystem::path& relativePath, const std::string& checksum, uintmax_t size )
+{
+	if( m_journalPath.empty() )
+	{
+		return Result{ ResultType::SUCCESS };
+	}
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	Entry& entry = m_entries[relativePath.generic_string()];
+
+	entry.checksum = checksum;
+
+	entry.size = size;
+
+	entry.complete = entryType == PATCH_APPLY_JOURNAL_COMPLETE;
+
+	// Flushed at once so the entry survives the process being killed
+	m_out << entryType << ' ' << checksum << ' ' << size << ' ' << relativePath.generic_string() << '\n';
+
+	m_out.flush();
+
+	if( !m_out )
+	{
+		return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
+	}
+
+	// A moving entry must reach the disk before the resource is replaced, or after the machine going down
+	// the patched resource could be left with no entry and be patched again. Losing a complete entry only
+	// means the resource is checked by checksum.
+	if( entryType == PATCH_APPLY_JOURNAL_MOVING && !ResourceTools::SyncFile( m_journalPath ) )
+	{
+		return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
+	}
+
+	return Result{ ResultType::SUCCESS };
+}
+
+}
@@ -0,0 +1,75 @@
+// Copyright © 2025 CCP ehf.
+
+#pragma once
+#ifndef PatchApplyJournal_H
+#define PatchApplyJournal_H
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "ResourceGroup.h"
+
+namespace CarbonResources
+{
+
+// Resources patched by an Apply, see PatchApplyParams::journalFilePath.
+// Each resource is recorded as moving just before its patched file replaces the old one, and as complete after.
+// Moving entries are synced to disk before they are returned from, so they survive the machine going down as well as the process.
+// Entries are only ever appended, a line cut short by an interruption is ignored. May be used from several threads at once.
+class PatchApplyJournal
+{
+public:
+	// An empty journalPath disables the journal, nothing is skipped or recorded
+	explicit PatchApplyJournal( const std::filesystem::path& journalPath );
+
+	// Read the entries of an interrupted Apply and open the journal to record more
+	Result Open();
+
+	// True if the resource is already at the target checksum and size in the destination.
+	// Complete resources are checked by size, those interrupted while moving by checksum.
+	bool IsComplete( const std::filesystem::path& relativePath, const std::string& checksum, uintmax_t size, const std::filesystem::path& destinationPath );
+
+	Result RecordMoving( const std::filesystem::path& relativePath, const std::string& checksum, uintmax_t size );
+
+	Result RecordComplete( const std::filesystem::path& relativePath, const std::string& checksum, uintmax_t size );
+
+	// Record a file resources are staged in, so it can be removed if Apply is interrupted
+	Result RecordTemporaryFile( const std::filesystem::path& temporaryFilePath );
+
+	// Remove the temporary files recorded by an interrupted Apply
+	void RemoveTemporaryFiles();
+
+	// Once every resource is applied the journal is no longer needed
+	Result Remove();
+
+private:
+	struct Entry
+	{
+		std::string checksum;
+
+		uintmax_t size = 0;
+
+		bool complete = false;
+	};
+
+	Result Record( char entryType, const std::filesystem::path& relativePath, const std::string& checksum, uintmax_t size );
+
+	std::filesystem::path m_journalPath;
+
+	std::unordered_map<std::string, Entry> m_entries;
+
+	std::set<std::filesystem::path> m_temporaryFiles;
+
+	std::ofstream m_out;
+
+	std::mutex m_mutex;
+};
+
+}
+
+#endif // PatchApplyJournal_H
@@ -0,0 +1,306 @@
+// Copyright © 2025 CCP ehf.
+
+#include "PatchCache.h"
+
+#include <cstring>
+
+#include <ResourceTools.h>
+
+#include "ResourceGroupImpl.h"
+#include "ResourceInfo/PatchResourceInfo.h"
+
+constexpr const char* PATCH_CACHE_ENTRY_EXTENSION = ".patches";
+
+// Written at the start of every entry, entries of another layout are treated as missing
+constexpr char PATCH_CACHE_ENTRY_MAGIC[8] = { 'P', 'A', 'T', 'C', 'H', 'C', '0', '1' };
+
+namespace CarbonResources
+{
+namespace
+{
+// A patch as stored in an entry. Patches without data take their data from the previous resource,
+// only their checksum and size are kept. Patches with data have the rest recalculated from it.
+struct CachedPatch
+{
+	uint64_t dataOffset = 0;
+
+	uint64_t sourceOffset = 0;
+
+	uint64_t uncompressedSize = 0;
+
+	std::string checksum;
+
+	std::string diffEngine;
+
+	std::string data;
+};
+
+void WriteValue( std::ofstream& out, uint64_t value )
+{
+	out.write( reinterpret_cast<const char*>( &value ), sizeof( value ) );
+}
+
+void WriteString( std::ofstream& out, const std::string& value )
+{
+	WriteValue( out, value.size() );
+	out.write( value.data(), value.size() );
+}
+
+bool ReadValue( std::ifstream& in, uint64_t& value )
+{
+	return static_cast<bool>( in.read( reinterpret_cast<char*>( &value ), sizeof( value ) ) );
+}
+
+// remaining guards against allocating for the length of a damaged entry
+bool ReadString( std::ifstream& in, uintmax_t remaining, std::string& value )
+{
+	uint64_t size;
+	if( !ReadValue( in, size ) || size > remaining )
+	{
+		return false;
+	}
+	value.resize( size );
+	return static_cast<bool>( in.read( value.data(), size ) );
+}
+
+// Returns false with end set at the end of the entry, or with it clear if the entry is truncated or damaged
+bool ReadCachedPatch( std::ifstream& in, uintmax_t entrySize, CachedPatch& patch, bool& end )
+{
+	end = false;
+	if( !ReadValue( in, patch.dataOffset ) )
+	{
+		end = in.eof() && in.gcount() == 0;
+		return false;
+	}
+	return ReadValue( in, patch.sourceOffset ) &&
+		ReadValue( in, patch.uncompressedSize ) &&
+		ReadString( in, entrySize, patch.checksum ) &&
+		ReadString( in, entrySize, patch.diffEngine ) &&
+		ReadString( in, entrySize, patch.data );
+}
+}
+
+PatchCache::EntryWriter::EntryWriter( PatchCache& patchCache, const std::string& key ) :
+	m_patchCache( patchCache ),
+	m_key( key ),
+	m_temporaryPath( patchCache.m_entries.GetTemporaryPath( key ) ),
+	m_failed( false ),
+	m_committed( false )
+{
+	std::error_code ec;
+	std::filesystem::create_directories( m_temporaryPath.parent_path(), ec );
+
+	m_out.open( m_temporaryPath, std::ios::binary | std::ios::trunc );
+	m_out.write( PATCH_CACHE_ENTRY_MAGIC, sizeof( PATCH_CACHE_ENTRY_MAGIC ) );
+	m_failed = !m_out;
+}
+
+PatchCache::EntryWriter::~EntryWriter()
+{
+	if( !m_committed )
+	{
+		m_out.close();
+		std::error_code ec;
+		std::filesystem::remove( m_temporaryPath, ec );
+	}
+}
+
+void PatchCache::EntryWriter::Write( const PendingPatch& pendingPatch )
+{
+	if( m_failed )
+	{
+		return;
+	}
+
+	const PatchResourceInfo* patchResource = pendingPatch.patchResource.get();
+
+	CachedPatch patch;
+
+	m_failed = patchResource->GetDataOffset( patch.dataOffset ).type != ResultType::SUCCESS ||
+		patchResource->GetSourceOffset( patch.sourceOffset ).type != ResultType::SUCCESS ||
+		patchResource->GetUncompressedSize( patch.uncompressedSize ).type != ResultType::SUCCESS ||
+		patchResource->GetChecksum( patch.checksum ).type != ResultType::SUCCESS;
+
+	// Patches taking data from another previous resource depend on more than the transition
+	std::filesystem::path sourceResourceRelativePath;
+	if( patchResource->GetSourceResourceRelativePath( sourceResourceRelativePath ).type != ResultType::RESOURCE_VALUE_NOT_SET )
+	{
+		m_failed = true;
+	}
+
+	if( m_failed )
+	{
+		return;
+	}
+
+	// Not set for bsdiff
+	patchResource->GetDiffEngine( patch.diffEngine );
+
+	WriteValue( m_out, patch.dataOffset );
+	WriteValue( m_out, patch.sourceOffset );
+	WriteValue( m_out, patch.uncompressedSize );
+	WriteString( m_out, patch.checksum );
+	WriteString( m_out, patch.diffEngine );
+	WriteString( m_out, pendingPatch.patchData );
+
+	m_failed = !m_out;
+}
+
+void PatchCache::EntryWriter::Commit()
+{
+	m_out.close();
+
+	if( m_failed || !m_out )
+	{
+		return;
+	}
+
+	// Add moves the file into the cache, or removes it on failure
+	m_committed = true;
+
+	m_patchCache.m_entries.Add( m_key, m_temporaryPath );
+}
+
+PatchCache::PatchCache( const std::filesystem::path& cacheFolder, uintmax_t maxSize, ResourceTools::StatusCallback statusCallback ) :
+	m_entries( cacheFolder, maxSize, statusCallback, PATCH_CACHE_ENTRY_EXTENSION ),
+	m_hits( 0 ),
+	m_misses( 0 )
+{
+}
+
+Result PatchCache::Load( const PatchCreateParams& params, const std::string& key, const ResourceInfo* resourceNext, const std::function<Result( PendingPatch& )>& onPatch, bool& found )
+{
+	found = false;
+
+	// The whole entry is read before any patch is passed on, once one is the transition can no longer be patched afresh
+	std::vector<PendingPatch> patches;
+
+	if( m_entries.Touch( key ) )
+	{
+		if( ReadEntry( params, m_entries.GetEntryPath( key ), resourceNext, patches ).type == ResultType::SUCCESS )
+		{
+			found = true;
+		}
+		else
+		{
+			m_entries.Remove( key );
+		}
+	}
+
+	if( !found )
+	{
+		m_misses++;
+
+		return Result{ ResultType::SUCCESS };
+	}
+
+	m_hits++;
+
+	for( PendingPatch& pendingPatch : patches )
+	{
+		Result onPatchResult = onPatch( pendingPatch );
+
+		if( onPatchResult.type != ResultType::SUCCESS )
+		{
+			return onPatchResult;
+		}
+	}
+
+	return Result{ ResultType::SUCCESS };
+}
+
+uintmax_t PatchCache::GetHits() const
+{
+	return m_hits;
+}
+
+uintmax_t PatchCache::GetMisses() const
+{
+	return m_misses;
+}
+
+Result PatchCache::ReadEntry( const PatchCreateParams& params, const std::filesystem::path& entryPath, const ResourceInfo* resourceNext, std::vector<PendingPatch>& patches ) const
+{
+	std::error_code ec;
+	uintmax_t entrySize = std::filesystem::file_size( entryPath, ec );
+
+	std::ifstream in( entryPath, std::ios::binary );
+
+	char magic[sizeof( PATCH_CACHE_ENTRY_MAGIC )];
+
+	if( ec || !in.read( magic, sizeof( magic ) ) || std::memcmp( magic, PATCH_CACHE_ENTRY_MAGIC, sizeof( magic ) ) != 0 )
+	{
+		return Result{ ResultType::FAILED_TO_OPEN_FILE };
+	}
+
+	std::filesystem::path targetResourceRelativePath;
+
+	Result getRelativePathResult = resourceNext->GetRelativePath( targetResourceRelativePath );
+
+	if( getRelativePathResult.type != ResultType::SUCCESS )
+	{
+		return getRelativePathResult;
+	}
+
+	CachedPatch patch;
+
+	bool end = false;
+
+	while( ReadCachedPatch( in, entrySize, patch, end ) )
+	{
+		// Patch data is the only part that cannot be checked against the patches it makes
+		std::string checksum;
+
+		if( !patch.data.empty() && ( !ResourceTools::GenerateMd5Checksum( patch.data, checksum ) || checksum != patch.checksum ) )
+		{
+			return Result{ ResultType::UNEXPECTED_CHUNK_CHECKSUM_RESULT };
+		}
+
+		PatchResourceInfoParams patchResourceInfoParams;
+
+		// Numbered when committed
+		patchResourceInfoParams.relativePath = params.patchFileRelativePathPrefix.string() + ".0";
+
+		patchResourceInfoParams.targetResourceRelativePath = targetResourceRelativePath;
+
+		patchResourceInfoParams.dataOffset = patch.dataOffset;
+
+		patchResourceInfoParams.sourceOffset = patch.sourceOffset;
+
+		patchResourceInfoParams.diffEngine = patch.diffEngine;
+
+		if( patch.data.empty() )
+		{
+			patchResourceInfoParams.checksum = patch.checksum;
+
+			patchResourceInfoParams.uncompressedSize = patch.uncompressedSize;
+		}
+
+		PendingPatch pendingPatch;
+
+		pendingPatch.patchResource = std::make_unique<PatchResourceInfo>( patchResourceInfoParams );
+
+		if( !patch.data.empty() )
+		{
+			Result setParametersFromDataResult = pendingPatch.patchResource->SetParametersFromData( patch.data, params.calculateCompressions );
+
+			if( setParametersFromDataResult.type != ResultType::SUCCESS )
+			{
+				return setParametersFromDataResult;
+			}
+
+			pendingPatch.patchData = std::move( patch.data );
+		}
+
+		patches.push_back( std::move( pendingPatch ) );
+	}
+
+	if( !end )
+	{
+		return Result{ ResultType::FAILED_TO_READ_FROM_STREAM };
+	}
+
+	return Result{ ResultType::SUCCESS };
+}
+
+}
@@ -0,0 +1,81 @@
+// Copyright © 2025 CCP ehf.
+
+#pragma once
+#ifndef PatchCache_H
+#define PatchCache_H
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <ChunkIndexCache.h>
+
+#include "ResourceGroup.h"
+
+namespace CarbonResources
+{
+struct PendingPatch;
+
+class ResourceInfo;
+
+// Patches of resources kept between runs, see PatchCreateParams::patchCacheFolder.
+// An entry holds every patch created for one resource transition, keyed by the checksums of
+// both resources and the parameters the patches depend on. Entries may be used from several threads at once.
+class PatchCache
+{
+public:
+	// Records the patches of one transition as they are created, the entry is only added by Commit.
+	class EntryWriter
+	{
+	public:
+		EntryWriter( PatchCache& patchCache, const std::string& key );
+
+		~EntryWriter();
+
+		// Failures are not reported, the entry is just not added
+		void Write( const PendingPatch& pendingPatch );
+
+		void Commit();
+
+	private:
+		PatchCache& m_patchCache;
+
+		std::string m_key;
+
+		std::filesystem::path m_temporaryPath;
+
+		std::ofstream m_out;
+
+		bool m_failed;
+
+		bool m_committed;
+	};
+
+	PatchCache( const std::filesystem::path& cacheFolder, uintmax_t maxSize, ResourceTools::StatusCallback statusCallback );
+
+	// Pass the patches stored for key to onPatch in the order they were created.
+	// found is false when there is no usable entry, nothing is passed to onPatch then.
+	// Entries which cannot be read in full are removed and treated as missing, so the transition is diffed instead.
+	Result Load( const PatchCreateParams& params, const std::string& key, const ResourceInfo* resourceNext, const std::function<Result( PendingPatch& )>& onPatch, bool& found );
+
+	uintmax_t GetHits() const;
+
+	uintmax_t GetMisses() const;
+
+private:
+	// Read and check every patch of the entry, any failure leaves the entry unusable.
+	Result ReadEntry( const PatchCreateParams& params, const std::filesystem::path& entryPath, const ResourceInfo* resourceNext, std::vector<PendingPatch>& patches ) const;
+
+	ResourceTools::ChunkIndexCache m_entries;
+
+	std::atomic<uintmax_t> m_hits;
+
+	std::atomic<uintmax_t> m_misses;
+};
+
+}
+
+#endif // PatchCache_H
@@ -21,4 +21,9 @@ Result PatchResourceGroup::Apply( const PatchApplyParams& params )
 	return m_impl->Apply( params );
 }
 
+Result PatchResourceGroup::Squash( const PatchSquashParams& params ) const
+{
+	return m_impl->Squash( params );
+}
+
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 #include "Patching.h"
 
+#include "DiffEngine.h"
+
 #include "BundleResourceGroupImpl.h"
 
 #include <yaml-cpp/yaml.h>
@@ -18,8 +20,26 @@
 
 #include <Md5ChecksumStream.h>
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Chunks of PatchResourceGroupImpl::m_maxInputChunkSize held by each worker applying a resource: previous data, patch data, patched data and stream buffers
+constexpr uintmax_t APPLY_WORKER_CHUNK_COUNT{ 4 };
+
 namespace CarbonResources
 {
+
+namespace
+{
+// Each worker stages its resources in its own temporary file, next to PatchApplyParams::temporaryFilePath
+std::filesystem::path WorkerTemporaryFilePath( const std::filesystem::path& temporaryFilePath, unsigned int workerIndex )
+{
+	return temporaryFilePath.string() + "." + std::to_string( workerIndex );
+}
+}
+
 PatchResourceGroup::PatchResourceGroupImpl::PatchResourceGroupImpl() :
 	ResourceGroupImpl()
 {
@@ -211,16 +231,11 @@ Result PatchResourceGroup::PatchResourceGroupImpl::ExportGroupSpecialisedYaml( Y
 }
 
 
-Result PatchResourceGroup::PatchResourceGroupImpl::GetTargetResourcePatches( const ResourceInfo* resource, std::vector<const PatchResourceInfo*>& patches ) const
+Result PatchResourceGroup::PatchResourceGroupImpl::IndexTargetResourcePatches() const
 {
-	std::filesystem::path resourceRelativePath;
+	m_targetResourcePatches.clear();
 
-	Result resourceRelativePathResult = resource->GetRelativePath( resourceRelativePath );
-
-	if( resourceRelativePathResult.type != ResultType::SUCCESS )
-	{
-		return resourceRelativePathResult;
-	}
+	m_targetResourcePatchesIndexed = false;
 
 	for( ResourceInfo* patchResource : m_resourcesParameter )
 	{
@@ -235,12 +250,46 @@ Result PatchResourceGroup::PatchResourceGroupImpl::GetTargetResourcePatches( con
 			return getPatchTargetResource;
 		}
 
-		if( resourceRelativePath == patchTargetResource )
+		m_targetResourcePatches[patchTargetResource.generic_string()].push_back( patch );
+	}
+
+	m_targetResourcePatchesIndexedCount = m_resourcesParameter.GetSize();
+
+	m_targetResourcePatchesIndexed = true;
+
+	return Result{ ResultType::SUCCESS };
+}
+
+Result PatchResourceGroup::PatchResourceGroupImpl::GetTargetResourcePatches( const ResourceInfo* resource, std::vector<const PatchResourceInfo*>& patches ) const
+{
+	std::filesystem::path resourceRelativePath;
+
+	Result resourceRelativePathResult = resource->GetRelativePath( resourceRelativePath );
+
+	if( resourceRelativePathResult.type != ResultType::SUCCESS )
+	{
+		return resourceRelativePathResult;
+	}
+
+	std::lock_guard<std::mutex> lock( m_targetResourcePatchesMutex );
+
+	if( !m_targetResourcePatchesIndexed || m_targetResourcePatchesIndexedCount != m_resourcesParameter.GetSize() )
+	{
+		Result indexTargetResourcePatchesResult = IndexTargetResourcePatches();
+
+		if( indexTargetResourcePatchesResult.type != ResultType::SUCCESS )
 		{
-			patches.push_back( patch );
+			return indexTargetResourcePatchesResult;
 		}
 	}
 
+	auto targetResourcePatchesIter = m_targetResourcePatches.find( resourceRelativePath.generic_string() );
+
+	if( targetResourcePatchesIter != m_targetResourcePatches.end() )
+	{
+		patches.insert( patches.end(), targetResourcePatchesIter->second.begin(), targetResourcePatchesIter->second.end() );
+	}
+
 	return Result{ ResultType::SUCCESS };
 }
 
@@ -251,91 +300,226 @@ Result PatchResourceGroup::PatchResourceGroupImpl::Apply( const PatchApplyParams
 		params.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 0, "Applying Patch." );
 	}
 
-	// Will be removed when falls out of scope
-	ResourceTools::ScopedFile temporaryFileScope( params.temporaryFilePath );
-
-	ResourceGroupInfo* resourceGroupResource = m_resourceGroupParameter.GetValue();
+	// Load the resourceGroup from the resourceGroupResource
+	ResourceGroupImpl resourceGroup;
 
+	Result loadResourceGroupResult = LoadResourceGroup( params.patchBinarySourceSettings, resourceGroup );
 
-	// Load the resourceGroup from the resourceGroupResource
-	std::string resourceGroupData;
+	if( loadResourceGroupResult.type != ResultType::SUCCESS )
+	{
+		return loadResourceGroupResult;
+	}
 
-	ResourceGetDataParams resourceGroupDataParams;
+	return ApplyResourceGroup( params, resourceGroup );
+}
 
-	resourceGroupDataParams.resourceSourceSettings = params.patchBinarySourceSettings;
+Result PatchResourceGroup::PatchResourceGroupImpl::ApplyResourceGroup( const PatchApplyParams& params, const ResourceGroupImpl& resourceGroup, const PatchDataSource* patchDataSource /* = nullptr */ ) const
+{
+	size_t resourceCount = resourceGroup.GetSize();
 
-	resourceGroupDataParams.data = &resourceGroupData;
+	// Resumes an interrupted Apply when there is a journal from it
+	PatchApplyJournal journal( params.journalFilePath );
 
-	Result resourceGroupGetDataResult = m_resourceGroupParameter.GetValue()->GetData( resourceGroupDataParams );
+	Result openJournalResult = journal.Open();
 
-	if( resourceGroupGetDataResult.type != ResultType::SUCCESS )
+	if( openJournalResult.type != ResultType::SUCCESS )
 	{
-		return resourceGroupGetDataResult;
+		return openJournalResult;
 	}
 
-	ResourceGroupImpl resourceGroup;
+	// Only the temporary files the interrupted Apply recorded are removed, others next to them may not be ours
+	journal.RemoveTemporaryFiles();
 
+	unsigned int applyThreadCount = params.applyThreadCount ? params.applyThreadCount : std::max( std::thread::hardware_concurrency(), 1u );
 
+	// Each worker holds a few chunks at once, fit the workers to the memory budget
+	uintmax_t workerMemory = std::max<uintmax_t>( m_maxInputChunkSize.GetValue() * APPLY_WORKER_CHUNK_COUNT, 1 );
 
-	Result resourceGroupImportFromDataResult = resourceGroup.ImportFromData( resourceGroupData );
+	applyThreadCount = static_cast<unsigned int>( std::max<uintmax_t>( std::min<uintmax_t>( applyThreadCount, params.applyMemoryBudget / workerMemory ), 1 ) );
 
-	if( resourceGroupImportFromDataResult.type != ResultType::SUCCESS )
+	if( applyThreadCount > 1 && resourceCount > 1 && !patchDataSource )
 	{
-		return resourceGroupImportFromDataResult;
+		Result applyResourcesResult = ApplyResourcesConcurrently( params, resourceGroup, applyThreadCount, journal );
+
+		if( applyResourcesResult.type != ResultType::SUCCESS )
+		{
+			return applyResourcesResult;
+		}
 	}
+	else
+	{
+		Result recordTemporaryFileResult = journal.RecordTemporaryFile( params.temporaryFilePath );
+
+		if( recordTemporaryFileResult.type != ResultType::SUCCESS )
+		{
+			return recordTemporaryFileResult;
+		}
+
+		// Will be removed when falls out of scope
+		ResourceTools::ScopedFile temporaryFileScope( params.temporaryFilePath );
+
+		size_t numProcessed = 0;
+
+		for( ResourceInfo* resource : resourceGroup )
+		{
+			auto percentage = static_cast<unsigned int>( ( 100 * numProcessed ) / resourceCount );
 
-	auto numResources = resourceGroup.GetSize();
-	int numProcessed = 0;
+			numProcessed++;
+
+			Result applyResourceResult = ApplyResource( params, percentage, resource, params.temporaryFilePath, journal, patchDataSource );
+
+			if( applyResourceResult.type != ResultType::SUCCESS )
+			{
+				return applyResourceResult;
+			}
+		}
+	}
 
-	for( ResourceInfo* resource : resourceGroup )
+	for( const auto& path : *m_removedResources.GetValue() )
 	{
-		if( params.statusCallback )
+		auto toRemove = std::filesystem::absolute( params.resourcesToPatchDestinationSettings.basePath / path );
+		std::error_code ec;
+		if( std::filesystem::exists( toRemove ) )
 		{
-			std::filesystem::path relativePath;
+			bool removed = std::filesystem::remove( toRemove, ec );
+			if( !removed && params.statusCallback )
+			{
+				params.statusCallback( StatusLevel::DETAIL, StatusProgressType::UNBOUNDED, 0, "Failed to remove file " + toRemove.string() );
+			}
+		}
 
-			if( resource->GetRelativePath( relativePath ).type != ResultType::SUCCESS )
+		// Remove any empty directories left over
+		toRemove = toRemove.parent_path();
+		while( std::filesystem::is_directory( toRemove ) && std::filesystem::is_empty( toRemove ) )
+		{
+			bool removed = std::filesystem::remove( toRemove, ec );
+			if( !removed && params.statusCallback )
 			{
-				return Result{ ResultType::FAIL };
+				params.statusCallback( StatusLevel::DETAIL, StatusProgressType::UNBOUNDED, 0, "Failed to remove empty directory " + toRemove.string() );
 			}
+		}
+	}
 
-			auto percentage = static_cast<unsigned int>( ( 100 * numProcessed ) / numResources );
+	Result removeJournalResult = journal.Remove();
 
-			std::string message = "Patching: " + relativePath.string();
+	if( removeJournalResult.type != ResultType::SUCCESS )
+	{
+		return removeJournalResult;
+	}
 
-			params.statusCallback( CarbonResources::StatusLevel::DETAIL, CarbonResources::StatusProgressType::PERCENTAGE, percentage, message );
+	if( params.statusCallback )
+	{
+		params.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 100, "Patches applied" );
+	}
 
-			numProcessed++;
-		}
+	return Result{ ResultType::SUCCESS };
+}
+
+Result PatchResourceGroup::PatchResourceGroupImpl::ApplyResource( const PatchApplyParams& params, unsigned int percentageComplete, const ResourceInfo* resource, const std::filesystem::path& temporaryFilePath, PatchApplyJournal& journal, const PatchDataSource* patchDataSource /* = nullptr */ ) const
+{
+	std::filesystem::path relativePath;
+
+	if( resource->GetRelativePath( relativePath ).type != ResultType::SUCCESS )
+	{
+		return Result{ ResultType::FAIL };
+	}
+
+	std::string resourceChecksum;
+
+	Result getResourceChecksumResult = resource->GetChecksum( resourceChecksum );
+
+	if( getResourceChecksumResult.type != ResultType::SUCCESS )
+	{
+		return getResourceChecksumResult;
+	}
 
-		// See if there is a patch available for resource
-		std::vector<const PatchResourceInfo*> patchesForResource;
+	uintmax_t resourceSize;
 
-		Result getTargetResourcePatchesResult = GetTargetResourcePatches( resource, patchesForResource );
+	Result getResourceSizeResult = resource->GetUncompressedSize( resourceSize );
 
-		if( getTargetResourcePatchesResult.type != ResultType::SUCCESS )
+	if( getResourceSizeResult.type != ResultType::SUCCESS )
+	{
+		return getResourceSizeResult;
+	}
+
+	// Skip resources patched before an interruption, their previous version is gone
+	std::filesystem::path destinationPath;
+
+	bool hasDestinationPath = resource->GetDestinationPath( params.resourcesToPatchDestinationSettings, destinationPath ).type == ResultType::SUCCESS;
+
+	if( hasDestinationPath && journal.IsComplete( relativePath, resourceChecksum, resourceSize, destinationPath ) )
+	{
+		if( params.statusCallback )
 		{
-			return getTargetResourcePatchesResult;
+			params.statusCallback( CarbonResources::StatusLevel::DETAIL, CarbonResources::StatusProgressType::PERCENTAGE, percentageComplete, "Already patched: " + relativePath.string() );
 		}
 
+		// Let the source drop the data of the patches which won't be read
+		if( patchDataSource && patchDataSource->skip )
+		{
+			std::vector<const PatchResourceInfo*> skippedPatches;
 
-		// Open a stream to write a temp file of the patched resource
-		ResourceTools::FileDataStreamOut temporaryResourceDataStreamOut;
+			Result getSkippedPatchesResult = GetTargetResourcePatches( resource, skippedPatches );
 
-		if( !temporaryResourceDataStreamOut.StartWrite( params.temporaryFilePath ) )
-		{
-			return Result{ ResultType::FAILED_TO_OPEN_FILE };
+			if( getSkippedPatchesResult.type != ResultType::SUCCESS )
+			{
+				return getSkippedPatchesResult;
+			}
+
+			for( const PatchResourceInfo* patch : skippedPatches )
+			{
+				patchDataSource->skip( patch );
+			}
 		}
 
-		// Incrementally calculate checksum for temporary patch file
-		ResourceTools::Md5ChecksumStream patchedFileChecksumStream;
+		return Result{ ResultType::SUCCESS };
+	}
 
+	if( params.statusCallback )
+	{
+		std::string message = "Patching: " + relativePath.string();
 
+		params.statusCallback( CarbonResources::StatusLevel::DETAIL, CarbonResources::StatusProgressType::PERCENTAGE, percentageComplete, message );
+	}
 
-		if( patchesForResource.size() > 0 )
-		{
-			// Open stream for resource
-			auto resourceDataStreamIn = std::make_shared<ResourceTools::FileDataStreamIn>( m_maxInputChunkSize.GetValue() );
+	// See if there is a patch available for resource
+	std::vector<const PatchResourceInfo*> patchesForResource;
+
+	Result getTargetResourcePatchesResult = GetTargetResourcePatches( resource, patchesForResource );
 
+	if( getTargetResourcePatchesResult.type != ResultType::SUCCESS )
+	{
+		return getTargetResourcePatchesResult;
+	}
+
+
+	// Open a stream to write a temp file of the patched resource
+	ResourceTools::FileDataStreamOut temporaryResourceDataStreamOut;
+
+	if( !temporaryResourceDataStreamOut.StartWrite( temporaryFilePath ) )
+	{
+		return Result{ ResultType::FAILED_TO_OPEN_FILE };
+	}
+
+	// Incrementally calculate checksum for temporary patch file
+	ResourceTools::Md5ChecksumStream patchedFileChecksumStream;
+
+
+
+	if( patchesForResource.size() > 0 )
+	{
+		// Patches sourcing their data from another previous resource don't read the previous version of this one,
+		// which doesn't exist when the resource is new
+		bool usesPreviousResource = std::any_of( patchesForResource.begin(), patchesForResource.end(), []( const PatchResourceInfo* patch ) {
+			std::filesystem::path sourceResourceRelativePath;
+			return patch->GetSourceResourceRelativePath( sourceResourceRelativePath ).type != ResultType::SUCCESS;
+		} );
+
+		// Open stream for resource
+		auto resourceDataStreamIn = std::make_shared<ResourceTools::FileDataStreamIn>( m_maxInputChunkSize.GetValue() );
+
+		if( usesPreviousResource )
+		{
 			ResourceGetDataStreamParams resourceDataStreamParams;
 
 			resourceDataStreamParams.resourceSourceSettings = params.resourcesToPatchSourceSettings;
@@ -348,370 +532,516 @@ Result PatchResourceGroup::PatchResourceGroupImpl::Apply( const PatchApplyParams
 			{
 				return getResourceDataStream;
 			}
+		}
 
 
-			for( auto patchIter = patchesForResource.begin(); patchIter != patchesForResource.end(); patchIter++ )
-			{
+		for( auto patchIter = patchesForResource.begin(); patchIter != patchesForResource.end(); patchIter++ )
+		{
 
-				const PatchResourceInfo* patch = ( *patchIter );
+			const PatchResourceInfo* patch = ( *patchIter );
 
-				// Patch found, Retreive and apply
-				std::string patchData;
+			// Patch found, Retreive and apply
+			std::string patchData;
 
-				ResourceGetDataParams patchGetDataParams;
+			ResourceGetDataParams patchGetDataParams;
 
-				patchGetDataParams.resourceSourceSettings = params.patchBinarySourceSettings;
+			patchGetDataParams.resourceSourceSettings = params.patchBinarySourceSettings;
 
-				patchGetDataParams.data = &patchData;
+			patchGetDataParams.data = &patchData;
+
+			std::string location;
+			Result patchGetLocationResult = patch->GetLocation( location );
+			if( patchGetLocationResult.type != ResultType::SUCCESS )
+			{
+				return patchGetLocationResult;
+			}
+			bool hasPatchFile{ !location.empty() };
 
-				std::string location;
-				Result patchGetLocationResult = patch->GetLocation( location );
-				if( patchGetLocationResult.type != ResultType::SUCCESS )
+			if( hasPatchFile )
+			{
+				Result getPatchDataResult = patchDataSource ? patchDataSource->read( patch, patchData ) : patch->GetData( patchGetDataParams );
+
+				if( getPatchDataResult.type != ResultType::SUCCESS )
 				{
-					return patchGetLocationResult;
+					return getPatchDataResult;
 				}
-				bool hasPatchFile{ !location.empty() };
+			}
 
-				if( hasPatchFile )
-				{
-					Result getPatchDataResult = patch->GetData( patchGetDataParams );
+			// Patches that do not name a diff engine were created with bsdiff
+			std::string diffEngineName = ResourceTools::DIFF_ENGINE_BSDIFF;
 
-					if( getPatchDataResult.type != ResultType::SUCCESS )
-					{
-						return getPatchDataResult;
-					}
-				}
+			Result getDiffEngineResult = patch->GetDiffEngine( diffEngineName );
 
-				// Get previous data
-				uintmax_t dataOffset;
-				uintmax_t sourceOffset;
-				Result getPatchDataOffset = patch->GetDataOffset( dataOffset );
+			if( getDiffEngineResult.type != ResultType::SUCCESS && getDiffEngineResult.type != ResultType::RESOURCE_VALUE_NOT_SET )
+			{
+				return getDiffEngineResult;
+			}
 
-				if( getPatchDataOffset.type != ResultType::SUCCESS )
-				{
-					return getPatchDataOffset;
-				}
+			const ResourceTools::DiffEngine* diffEngine = ResourceTools::GetDiffEngine( diffEngineName );
 
-				Result getPatchSourceOffset = patch->GetSourceOffset( sourceOffset );
-				if( getPatchSourceOffset.type != ResultType::SUCCESS )
-				{
-					return getPatchSourceOffset;
-				}
+			if( !diffEngine )
+			{
+				return Result{ ResultType::FAILED_TO_APPLY_PATCH };
+			}
+
+			// Get previous data
+			uintmax_t dataOffset;
+			uintmax_t sourceOffset;
+			Result getPatchDataOffset = patch->GetDataOffset( dataOffset );
+
+			if( getPatchDataOffset.type != ResultType::SUCCESS )
+			{
+				return getPatchDataOffset;
+			}
 
-				std::string previousResourceData;
+			Result getPatchSourceOffset = patch->GetSourceOffset( sourceOffset );
+			if( getPatchSourceOffset.type != ResultType::SUCCESS )
+			{
+				return getPatchSourceOffset;
+			}
 
-				// Get previous size of resource
-				uintmax_t previousUncompressedSize;
+			// Source data comes from the previous version of this resource unless the patch names another previous resource
+			std::filesystem::path sourceResourceRelativePath;
 
-				Result getPreviousUncompressedSize = resource->GetUncompressedSize( previousUncompressedSize );
+			Result getSourceResourceRelativePathResult = patch->GetSourceResourceRelativePath( sourceResourceRelativePath );
 
-				if( getPreviousUncompressedSize.type != ResultType::SUCCESS )
-				{
-					return getPreviousUncompressedSize;
-				}
+			bool hasSourceResource = getSourceResourceRelativePathResult.type == ResultType::SUCCESS;
+
+			if( !hasSourceResource && getSourceResourceRelativePathResult.type != ResultType::RESOURCE_VALUE_NOT_SET )
+			{
+				return getSourceResourceRelativePathResult;
+			}
+
+			ResourceInfoParams sourceResourceParams;
+
+			sourceResourceParams.relativePath = sourceResourceRelativePath;
+
+			ResourceInfo otherSourceResource( sourceResourceParams );
+
+			const ResourceInfo* sourceResource = hasSourceResource ? &otherSourceResource : resource;
+
+			std::string previousResourceData;
+
+			// Get previous size of resource
+			uintmax_t previousUncompressedSize;
+
+			Result getPreviousUncompressedSize = resource->GetUncompressedSize( previousUncompressedSize );
 
-				if( dataOffset < previousUncompressedSize )
+			if( getPreviousUncompressedSize.type != ResultType::SUCCESS )
+			{
+				return getPreviousUncompressedSize;
+			}
+
+			if( dataOffset < previousUncompressedSize && usesPreviousResource )
+			{
+				int64_t previousSourcePosition = resourceDataStreamIn->GetCurrentPosition();
+				// Get to location of patch
+				while( temporaryResourceDataStreamOut.GetFileSize() < dataOffset )
 				{
-					int64_t previousSourcePosition = resourceDataStreamIn->GetCurrentPosition();
-					// Get to location of patch
-					while( temporaryResourceDataStreamOut.GetFileSize() < dataOffset )
+					std::string dataChunk;
+					uint64_t remaining = dataOffset - temporaryResourceDataStreamOut.GetFileSize();
+					if( remaining < m_maxInputChunkSize.GetValue() )
 					{
-						std::string dataChunk;
-						uint64_t remaining = dataOffset - temporaryResourceDataStreamOut.GetFileSize();
-						if( remaining < m_maxInputChunkSize.GetValue() )
-						{
-							if( !resourceDataStreamIn->ReadBytes( remaining, dataChunk ) )
-							{
-								return Result{ ResultType::FAILED_TO_READ_FROM_STREAM };
-							}
-						}
-						else if( !( *resourceDataStreamIn >> dataChunk ) )
+						if( !resourceDataStreamIn->ReadBytes( remaining, dataChunk ) )
 						{
 							return Result{ ResultType::FAILED_TO_READ_FROM_STREAM };
 						}
+					}
+					else if( !( *resourceDataStreamIn >> dataChunk ) )
+					{
+						return Result{ ResultType::FAILED_TO_READ_FROM_STREAM };
+					}
 
-						if( !( temporaryResourceDataStreamOut << dataChunk ) )
-						{
-							return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
-						}
-
-						// Add to incremental checksum calculation
-						if( !( patchedFileChecksumStream << dataChunk ) )
-						{
-							return Result{ ResultType::FAILED_TO_GENERATE_CHECKSUM };
-						}
-						previousSourcePosition += dataChunk.size();
+					if( !( temporaryResourceDataStreamOut << dataChunk ) )
+					{
+						return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
 					}
-					if( resourceDataStreamIn->IsFinished() )
+
+					// Add to incremental checksum calculation
+					if( !( patchedFileChecksumStream << dataChunk ) )
 					{
-						resourceDataStreamIn->StartRead( resourceDataStreamIn->GetPath() );
+						return Result{ ResultType::FAILED_TO_GENERATE_CHECKSUM };
 					}
-					resourceDataStreamIn->Seek( previousSourcePosition );
+					previousSourcePosition += dataChunk.size();
+				}
+				if( resourceDataStreamIn->IsFinished() )
+				{
+					resourceDataStreamIn->StartRead( resourceDataStreamIn->GetPath() );
+				}
+				resourceDataStreamIn->Seek( previousSourcePosition );
+			}
 
+			if( dataOffset < previousUncompressedSize )
+			{
+				// Apply the patch to the previous data
+				std::string patchedResourceData;
 
-					// Apply the patch to the previous data
-					std::string patchedResourceData;
+				if( hasPatchFile )
+				{
+					// Apply patch to data
+					std::shared_ptr<ResourceTools::FileDataStreamIn> patchSourceDataStreamIn = resourceDataStreamIn;
 
-					if( hasPatchFile )
+					if( hasSourceResource )
 					{
-						// Apply patch to data
-						resourceDataStreamIn->Seek( sourceOffset );
-						if( !( *resourceDataStreamIn >> previousResourceData ) )
-						{
-							return Result{ ResultType::FAILED_TO_READ_FROM_STREAM };
-						}
-						if( !ResourceTools::ApplyPatch( previousResourceData, patchData, patchedResourceData ) )
-						{
-							return Result{ ResultType::FAILED_TO_APPLY_PATCH };
-						}
-						// Write the patch result to file
-						if( !( temporaryResourceDataStreamOut << patchedResourceData ) )
-						{
-							return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
-						}
+						patchSourceDataStreamIn = std::make_shared<ResourceTools::FileDataStreamIn>( m_maxInputChunkSize.GetValue() );
 
-						// Add to incremental checksum calculation
-						if( !( patchedFileChecksumStream << patchedResourceData ) )
+						ResourceGetDataStreamParams patchSourceDataStreamParams;
+
+						patchSourceDataStreamParams.resourceSourceSettings = params.resourcesToPatchSourceSettings;
+
+						patchSourceDataStreamParams.dataStream = patchSourceDataStreamIn;
+
+						Result getPatchSourceDataStreamResult = sourceResource->GetDataStream( patchSourceDataStreamParams );
+
+						if( getPatchSourceDataStreamResult.type != ResultType::SUCCESS )
 						{
-							return Result{ ResultType::FAILED_TO_GENERATE_CHECKSUM };
+							return getPatchSourceDataStreamResult;
 						}
 					}
-					else
+
+					patchSourceDataStreamIn->Seek( sourceOffset );
+					if( !( *patchSourceDataStreamIn >> previousResourceData ) )
+					{
+						return Result{ ResultType::FAILED_TO_READ_FROM_STREAM };
+					}
+					if( !diffEngine->ApplyPatch( previousResourceData, patchData, patchedResourceData ) )
+					{
+						return Result{ ResultType::FAILED_TO_APPLY_PATCH };
+					}
+					// Write the patch result to file
+					if( !( temporaryResourceDataStreamOut << patchedResourceData ) )
 					{
+						return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
+					}
 
-						auto sourceDataStreamIn = std::make_shared<ResourceTools::FileDataStreamIn>( m_maxInputChunkSize.GetValue() );
+					// Add to incremental checksum calculation
+					if( !( patchedFileChecksumStream << patchedResourceData ) )
+					{
+						return Result{ ResultType::FAILED_TO_GENERATE_CHECKSUM };
+					}
+				}
+				else
+				{
 
-						ResourceGetDataStreamParams getDataStreamParams;
+					auto sourceDataStreamIn = std::make_shared<ResourceTools::FileDataStreamIn>( m_maxInputChunkSize.GetValue() );
 
-						getDataStreamParams.dataStream = sourceDataStreamIn;
+					ResourceGetDataStreamParams getDataStreamParams;
 
-						getDataStreamParams.resourceSourceSettings = params.resourcesToPatchSourceSettings;
+					getDataStreamParams.dataStream = sourceDataStreamIn;
 
-						Result getDataStreamResult = resource->GetDataStream( getDataStreamParams );
+					getDataStreamParams.resourceSourceSettings = params.resourcesToPatchSourceSettings;
 
-						if( getDataStreamResult.type != ResultType::SUCCESS )
+					Result getDataStreamResult = sourceResource->GetDataStream( getDataStreamParams );
+
+					if( getDataStreamResult.type != ResultType::SUCCESS )
+					{
+						return getDataStreamResult;
+					}
+
+					uintmax_t sourceOffset{ 0 };
+					Result getSourceOffsetResult = patch->GetSourceOffset( sourceOffset );
+					if( getSourceOffsetResult.type != ResultType::SUCCESS )
+					{
+						return getSourceOffsetResult;
+					}
+					uintmax_t unCompressedSize{ 0 };
+					Result getUncompressedSizeResult = patch->GetUncompressedSize( unCompressedSize );
+					if( getUncompressedSizeResult.type != ResultType::SUCCESS )
+					{
+						return getUncompressedSizeResult;
+					}
+					sourceDataStreamIn->Seek( sourceOffset );
+					while( unCompressedSize )
+					{
+						std::string sourceData;
+						if( unCompressedSize >= m_maxInputChunkSize.GetValue() )
 						{
-							return getDataStreamResult;
+							*sourceDataStreamIn >> sourceData;
+						}
+						else
+						{
+							sourceDataStreamIn->ReadBytes( unCompressedSize, sourceData );
 						}
 
-						uintmax_t sourceOffset{ 0 };
-						Result getSourceOffsetResult = patch->GetSourceOffset( sourceOffset );
-						if( getSourceOffsetResult.type != ResultType::SUCCESS )
+						if( sourceData.empty() )
 						{
-							return getSourceOffsetResult;
+							return Result{ ResultType::FAILED_TO_READ_FROM_STREAM };
 						}
-						uintmax_t unCompressedSize{ 0 };
-						Result getUncompressedSizeResult = patch->GetUncompressedSize( unCompressedSize );
-						if( getUncompressedSizeResult.type != ResultType::SUCCESS )
+						*resourceDataStreamIn >> previousResourceData;
+						if( sourceData.size() > unCompressedSize )
 						{
-							return getUncompressedSizeResult;
+							sourceData = sourceData.substr( unCompressedSize );
 						}
-						sourceDataStreamIn->Seek( sourceOffset );
-						while( unCompressedSize )
+						unCompressedSize -= std::min( sourceData.size(), unCompressedSize );
+
+						// Write the data from the source file
+						if( !( temporaryResourceDataStreamOut << sourceData ) )
 						{
-							std::string sourceData;
-							if( unCompressedSize >= m_maxInputChunkSize.GetValue() )
-							{
-								*sourceDataStreamIn >> sourceData;
-							}
-							else
-							{
-								sourceDataStreamIn->ReadBytes( unCompressedSize, sourceData );
-							}
-
-							if( sourceData.empty() )
-							{
-								return Result{ ResultType::FAILED_TO_READ_FROM_STREAM };
-							}
-							*resourceDataStreamIn >> previousResourceData;
-							if( sourceData.size() > unCompressedSize )
-							{
-								sourceData = sourceData.substr( unCompressedSize );
-							}
-							unCompressedSize -= std::min( sourceData.size(), unCompressedSize );
-
-							// Write the data from the source file
-							if( !( temporaryResourceDataStreamOut << sourceData ) )
-							{
-								return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
-							}
-
-							// Add to incremental checksum calculation
-							if( !( patchedFileChecksumStream << sourceData ) )
-							{
-								return Result{ ResultType::FAILED_TO_GENERATE_CHECKSUM };
-							}
+							return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
+						}
+
+						// Add to incremental checksum calculation
+						if( !( patchedFileChecksumStream << sourceData ) )
+						{
+							return Result{ ResultType::FAILED_TO_GENERATE_CHECKSUM };
 						}
 					}
 				}
-				else
+			}
+			else
+			{
+				// New data, append on to end
+				if( !( temporaryResourceDataStreamOut << previousResourceData ) )
 				{
-					// New data, append on to end
-					if( !( temporaryResourceDataStreamOut << previousResourceData ) )
-					{
-						return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
-					}
+					return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
+				}
 
-					// Add to incremental checksum calculation
-					if( !( patchedFileChecksumStream << previousResourceData ) )
-					{
-						return Result{ ResultType::FAILED_TO_GENERATE_CHECKSUM };
-					}
+				// Add to incremental checksum calculation
+				if( !( patchedFileChecksumStream << previousResourceData ) )
+				{
+					return Result{ ResultType::FAILED_TO_GENERATE_CHECKSUM };
 				}
 			}
+		}
 
-			// Stream out the remaining expected data
-			uintmax_t expectedResourceSize = 0;
+		// Stream out the remaining expected data
+		uintmax_t expectedResourceSize = 0;
 
-			Result getResourceUncompressedSizeResult = resource->GetUncompressedSize( expectedResourceSize );
+		Result getResourceUncompressedSizeResult = resource->GetUncompressedSize( expectedResourceSize );
 
-			if( getResourceUncompressedSizeResult.type != ResultType::SUCCESS )
-			{
-				return getResourceUncompressedSizeResult;
-			}
-
-			temporaryResourceDataStreamOut.Finish();
-		}
-		else
+		if( getResourceUncompressedSizeResult.type != ResultType::SUCCESS )
 		{
-			// No Patch found, indicates this is just a new file
-			// Just replace file directly
-			auto resourceStreamIn = std::make_shared<ResourceTools::FileDataStreamIn>( m_maxInputChunkSize.GetValue() );
+			return getResourceUncompressedSizeResult;
+		}
+
+		temporaryResourceDataStreamOut.Finish();
+	}
+	else
+	{
+		// No Patch found, indicates this is just a new file
+		// Just replace file directly
+		auto resourceStreamIn = std::make_shared<ResourceTools::FileDataStreamIn>( m_maxInputChunkSize.GetValue() );
+
+		ResourceGetDataStreamParams resourceGetDataParams;
 
-			ResourceGetDataStreamParams resourceGetDataParams;
+		resourceGetDataParams.resourceSourceSettings = params.nextBuildResourcesSourceSettings;
 
-			resourceGetDataParams.resourceSourceSettings = params.nextBuildResourcesSourceSettings;
+		resourceGetDataParams.dataStream = resourceStreamIn;
 
-			resourceGetDataParams.dataStream = resourceStreamIn;
+		Result resourceGetDataResult = resource->GetDataStream( resourceGetDataParams );
 
-			Result resourceGetDataResult = resource->GetDataStream( resourceGetDataParams );
+		if( resourceGetDataResult.type != ResultType::SUCCESS )
+		{
+			return resourceGetDataResult;
+		}
+
+		while( !resourceStreamIn->IsFinished() )
+		{
+			std::string resourceData;
 
-			if( resourceGetDataResult.type != ResultType::SUCCESS )
+			if( !( *resourceStreamIn >> resourceData ) )
 			{
-				return resourceGetDataResult;
+				return Result{ ResultType::FAILED_TO_READ_FROM_STREAM };
 			}
 
-			while( !resourceStreamIn->IsFinished() )
+			if( !( temporaryResourceDataStreamOut << resourceData ) )
 			{
-				std::string resourceData;
+				return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
+			}
 
-				if( !( *resourceStreamIn >> resourceData ) )
-				{
-					return Result{ ResultType::FAILED_TO_READ_FROM_STREAM };
-				}
+			// Add to incremental checksum calculation
+			if( !( patchedFileChecksumStream << resourceData ) )
+			{
+				return Result{ ResultType::FAILED_TO_GENERATE_CHECKSUM };
+			}
+		}
 
-				if( !( temporaryResourceDataStreamOut << resourceData ) )
-				{
-					return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
-				}
+		temporaryResourceDataStreamOut.Finish();
+	}
 
-				// Add to incremental checksum calculation
-				if( !( patchedFileChecksumStream << resourceData ) )
-				{
-					return Result{ ResultType::FAILED_TO_GENERATE_CHECKSUM };
-				}
-			}
 
-			temporaryResourceDataStreamOut.Finish();
-		}
+	// Test checksum against expected
+	std::string destinationExpectedChecksum;
+
+	Result getChecksumResult = resource->GetChecksum( destinationExpectedChecksum );
+
+	if( getChecksumResult.type != ResultType::SUCCESS )
+	{
+		return getChecksumResult;
+	}
+
+	std::string patchedFileChecksum;
+
+	if( !patchedFileChecksumStream.FinishAndRetrieve( patchedFileChecksum ) )
+	{
+		return Result{ ResultType::FAILED_TO_GENERATE_CHECKSUM };
+	}
+
+	if( patchedFileChecksum != destinationExpectedChecksum )
+	{
+		return Result{ ResultType::UNEXPECTED_PATCH_CHECKSUM_RESULT };
+	}
+
 
+	// Move the verified temp file into place, replacing the old resource file
+	ResourceDestinationType destinationType = params.resourcesToPatchDestinationSettings.destinationType;
 
-		// Test checksum against expected
-		std::string destinationExpectedChecksum;
+	if( destinationType == ResourceDestinationType::LOCAL_RELATIVE || destinationType == ResourceDestinationType::LOCAL_CDN )
+	{
+		ResourcePutFileParams patchedResourcePutFileParams;
+
+		patchedResourcePutFileParams.resourceDestinationSettings = params.resourcesToPatchDestinationSettings;
 
-		Result getChecksumResult = resource->GetChecksum( destinationExpectedChecksum );
+		patchedResourcePutFileParams.filePath = temporaryFilePath;
 
-		if( getChecksumResult.type != ResultType::SUCCESS )
+		Result recordMovingResult = journal.RecordMoving( relativePath, resourceChecksum, resourceSize );
+
+		if( recordMovingResult.type != ResultType::SUCCESS )
+		{
+			return recordMovingResult;
+		}
+
+		if( params.statusCallback )
 		{
-			return getChecksumResult;
+			params.statusCallback( CarbonResources::StatusLevel::DETAIL, CarbonResources::StatusProgressType::PERCENTAGE, percentageComplete, "Moving into place: " + relativePath.string() );
 		}
 
-		std::string patchedFileChecksum;
+		Result putFileResult = resource->PutFile( patchedResourcePutFileParams );
 
-		if( !patchedFileChecksumStream.FinishAndRetrieve( patchedFileChecksum ) )
+		if( putFileResult.type != ResultType::SUCCESS )
 		{
-			return Result{ ResultType::FAILED_TO_GENERATE_CHECKSUM };
+			return putFileResult;
 		}
 
-		if( patchedFileChecksum != destinationExpectedChecksum )
+		if( params.statusCallback )
 		{
-			return Result{ ResultType::UNEXPECTED_PATCH_CHECKSUM_RESULT };
+			params.statusCallback( CarbonResources::StatusLevel::DETAIL, CarbonResources::StatusProgressType::PERCENTAGE, percentageComplete, "Moved into place: " + relativePath.string() );
 		}
 
+		return journal.RecordComplete( relativePath, resourceChecksum, resourceSize );
+	}
 
-		// Copy temp file to replace the old resource file
+	// Other destinations are written through a stream
+	// Open output stream
+	ResourceTools::FileDataStreamOut resourceStreamOut;
 
-		// Open output stream
-		ResourceTools::FileDataStreamOut resourceStreamOut;
+	ResourcePutDataStreamParams patchedResourceResourcePutDataStreamParams;
 
-		ResourcePutDataStreamParams patchedResourceResourcePutDataStreamParams;
+	patchedResourceResourcePutDataStreamParams.resourceDestinationSettings = params.resourcesToPatchDestinationSettings;
 
-		patchedResourceResourcePutDataStreamParams.resourceDestinationSettings = params.resourcesToPatchDestinationSettings;
+	patchedResourceResourcePutDataStreamParams.dataStream = &resourceStreamOut;
 
-		patchedResourceResourcePutDataStreamParams.dataStream = &resourceStreamOut;
+	Result putResourceDataStreamResult = resource->PutDataStream( patchedResourceResourcePutDataStreamParams );
 
-		Result putResourceDataStreamResult = resource->PutDataStream( patchedResourceResourcePutDataStreamParams );
+	if( putResourceDataStreamResult.type != ResultType::SUCCESS )
+	{
+		return putResourceDataStreamResult;
+	}
 
-		if( putResourceDataStreamResult.type != ResultType::SUCCESS )
-		{
-			return putResourceDataStreamResult;
-		}
 
+	// Open input stream
+	ResourceTools::FileDataStreamIn tempPatchedResourceIn( m_maxInputChunkSize.GetValue() );
+
+	if( !tempPatchedResourceIn.StartRead( temporaryFilePath ) )
+	{
+		return Result{ ResultType::FAILED_TO_READ_FROM_STREAM };
+	}
 
-		// Open input stream
-		ResourceTools::FileDataStreamIn tempPatchedResourceIn( m_maxInputChunkSize.GetValue() );
+	while( !tempPatchedResourceIn.IsFinished() )
+	{
+		std::string data;
 
-		if( !tempPatchedResourceIn.StartRead( params.temporaryFilePath ) )
+		if( !( tempPatchedResourceIn >> data ) )
 		{
 			return Result{ ResultType::FAILED_TO_READ_FROM_STREAM };
 		}
 
-		while( !tempPatchedResourceIn.IsFinished() )
+		if( !( resourceStreamOut << data ) )
 		{
-			std::string data;
+			return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
+		}
+	}
 
-			if( !( tempPatchedResourceIn >> data ) )
-			{
-				return Result{ ResultType::FAILED_TO_READ_FROM_STREAM };
-			}
+	resourceStreamOut.Finish();
 
-			if( !( resourceStreamOut << data ) )
-			{
-				return Result{ ResultType::FAILED_TO_WRITE_TO_STREAM };
-			}
-		}
+	return Result{ ResultType::SUCCESS };
+}
 
-		resourceStreamOut.Finish();
+Result PatchResourceGroup::PatchResourceGroupImpl::ApplyResourcesConcurrently( const PatchApplyParams& params, const ResourceGroupImpl& resourceGroup, unsigned int threadCount, PatchApplyJournal& journal ) const
+{
+	std::vector<const ResourceInfo*> resources( resourceGroup.begin(), resourceGroup.end() );
+
+	size_t resourceCount = resources.size();
+
+	std::vector<Result> results( resourceCount, Result{ ResultType::SUCCESS } );
+
+	std::atomic<size_t> nextResource{ 0 };
+
+	std::atomic<bool> failed{ false };
+
+	// Status updates arrive from every worker
+	PatchApplyParams workerParams = params;
+
+	std::mutex statusMutex;
+
+	if( params.statusCallback )
+	{
+		workerParams.statusCallback = [&params, &statusMutex]( StatusLevel statusLevel, StatusProgressType statusProgressType, unsigned int progress, const std::string& info ) {
+			std::lock_guard<std::mutex> lock( statusMutex );
+			params.statusCallback( statusLevel, statusProgressType, progress, info );
+		};
 	}
 
-	for( const auto& path : *m_removedResources.GetValue() )
+	threadCount = static_cast<unsigned int>( std::min<size_t>( threadCount, resourceCount ) );
+
+	for( unsigned int workerIndex = 0; workerIndex < threadCount; workerIndex++ )
 	{
-		auto toRemove = std::filesystem::absolute( params.resourcesToPatchDestinationSettings.basePath / path );
-		std::error_code ec;
-		if( std::filesystem::exists( toRemove ) )
+		Result recordTemporaryFileResult = journal.RecordTemporaryFile( WorkerTemporaryFilePath( params.temporaryFilePath, workerIndex ) );
+
+		if( recordTemporaryFileResult.type != ResultType::SUCCESS )
 		{
-			bool removed = std::filesystem::remove( toRemove, ec );
-			if( !removed && params.statusCallback )
-			{
-				params.statusCallback( StatusLevel::DETAIL, StatusProgressType::UNBOUNDED, 0, "Failed to remove file " + toRemove.string() );
-			}
+			return recordTemporaryFileResult;
 		}
+	}
 
-		// Remove any empty directories left over
-		toRemove = toRemove.parent_path();
-		while( std::filesystem::is_directory( toRemove ) && std::filesystem::is_empty( toRemove ) )
+	auto worker = [&]( unsigned int workerIndex ) {
+		std::filesystem::path workerTemporaryFilePath = WorkerTemporaryFilePath( params.temporaryFilePath, workerIndex );
+
+		ResourceTools::ScopedFile temporaryFileScope( workerTemporaryFilePath );
+
+		// Resources are claimed in order, so after a failure every resource before it has been applied
+		for( size_t i = nextResource++; i < resourceCount && !failed; i = nextResource++ )
 		{
-			bool removed = std::filesystem::remove( toRemove, ec );
-			if( !removed && params.statusCallback )
+			auto percentageComplete = static_cast<unsigned int>( ( 100 * i ) / resourceCount );
+
+			results[i] = ApplyResource( workerParams, percentageComplete, resources[i], workerTemporaryFilePath, journal );
+
+			if( results[i].type != ResultType::SUCCESS )
 			{
-				params.statusCallback( StatusLevel::DETAIL, StatusProgressType::UNBOUNDED, 0, "Failed to remove empty directory " + toRemove.string() );
+				failed = true;
 			}
 		}
+	};
+
+	std::vector<std::thread> workers;
+
+	for( unsigned int workerIndex = 0; workerIndex < threadCount; workerIndex++ )
+	{
+		workers.emplace_back( worker, workerIndex );
 	}
 
-	if( params.statusCallback )
+	for( auto& workerThread : workers )
 	{
-		params.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 100, "Patches applied" );
+		workerThread.join();
+	}
+
+	// Report the first failed resource in order, whichever worker failed first
+	for( const Result& result : results )
+	{
+		if( result.type != ResultType::SUCCESS )
+		{
+			return result;
+		}
 	}
 
 	return Result{ ResultType::SUCCESS };
@@ -726,6 +1056,63 @@ Result PatchResourceGroup::PatchResourceGroupImpl::SetRemovedResourceRelativePat
 	return Result{ ResultType::SUCCESS };
 }
 
+Result PatchResourceGroup::PatchResourceGroupImpl::GetRemovedResourceRelativePaths( std::vector<std::filesystem::path>& paths ) const
+{
+	paths = *m_removedResources.GetValue();
+
+	return Result{ ResultType::SUCCESS };
+}
+
+Result PatchResourceGroup::PatchResourceGroupImpl::GetMaxInputChunkSize( uintmax_t& maxInputChunkSize ) const
+{
+	if( !m_maxInputChunkSize.HasValue() )
+	{
+		return Result{ ResultType::RESOURCE_VALUE_NOT_SET };
+	}
+
+	maxInputChunkSize = m_maxInputChunkSize.GetValue();
+
+	return Result{ ResultType::SUCCESS };
+}
+
+Result PatchResourceGroup::PatchResourceGroupImpl::LoadResourceGroup( const ResourceSourceSettings& patchBinarySourceSettings, ResourceGroupImpl& resourceGroup ) const
+{
+	std::string resourceGroupData;
+
+	ResourceGetDataParams resourceGroupDataParams;
+
+	resourceGroupDataParams.resourceSourceSettings = patchBinarySourceSettings;
+
+	resourceGroupDataParams.data = &resourceGroupData;
+
+	Result resourceGroupGetDataResult = m_resourceGroupParameter.GetValue()->GetData( resourceGroupDataParams );
+
+	if( resourceGroupGetDataResult.type != ResultType::SUCCESS )
+	{
+		return resourceGroupGetDataResult;
+	}
+
+	return resourceGroup.ImportFromData( resourceGroupData );
+}
+
+Result PatchResourceGroup::PatchResourceGroupImpl::Squash( const PatchSquashParams& params ) const
+{
+	// The chain starts with this patch
+	std::vector<const PatchResourceGroupImpl*> patchResourceGroups = { this };
+
+	for( const PatchResourceGroup* patchResourceGroup : params.nextPatchResourceGroups )
+	{
+		if( !patchResourceGroup )
+		{
+			return Result{ ResultType::RESOURCE_GROUP_NOT_SET };
+		}
+
+		patchResourceGroups.push_back( patchResourceGroup->m_impl );
+	}
+
+	return SquashPatches( params, patchResourceGroups );
+}
+
 Result PatchResourceGroup::PatchResourceGroupImpl::GetGroupSpecificResourcesToBundle( std::vector<ResourceInfo*>& toBundle ) const
 {
 	if( m_resourceGroupParameter.HasValue() )
@@ -12,9 +12,26 @@
 
 #include "ResourceInfo/PatchResourceInfo.h"
 
+#include "PatchApplyJournal.h"
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace CarbonResources
 {
 
+// Supplies the data of patches in place of fetching them from PatchApplyParams::patchBinarySourceSettings
+struct PatchDataSource
+{
+	std::function<Result( const PatchResourceInfo* patch, std::string& patchData )> read;
+
+	// Told of the patches of resources which are already patched, their data is never read
+	std::function<void( const PatchResourceInfo* patch )> skip;
+};
+
 class PatchResourceGroup::PatchResourceGroupImpl : public ResourceGroup::ResourceGroupImpl
 {
 public:
@@ -28,29 +45,62 @@ public:
 
 	Result Apply( const PatchApplyParams& params );
 
+	// Patch the resources of resourceGroup, the ResourceGroup of the resources this patch produces.
+	// With a patchDataSource resources are patched one at a time, requesting patches in the order they are applied.
+	Result ApplyResourceGroup( const PatchApplyParams& params, const ResourceGroupImpl& resourceGroup, const PatchDataSource* patchDataSource = nullptr ) const;
+
 	virtual std::string GetType() const override;
 
 	static std::string TypeId();
 
 	Result SetRemovedResourceRelativePaths( const std::vector<std::filesystem::path>& paths );
 
+	Result GetRemovedResourceRelativePaths( std::vector<std::filesystem::path>& paths ) const;
+
+	Result GetMaxInputChunkSize( uintmax_t& maxInputChunkSize ) const;
+
+	// Import the ResourceGroup of the resources this patch produces
+	Result LoadResourceGroup( const ResourceSourceSettings& patchBinarySourceSettings, ResourceGroupImpl& resourceGroup ) const;
+
+	Result GetTargetResourcePatches( const ResourceInfo* targetResource, std::vector<const PatchResourceInfo*>& patches ) const;
+
+	Result Squash( const PatchSquashParams& params ) const;
+
 	virtual Result GetGroupSpecificResourcesToBundle( std::vector<ResourceInfo*>& toBundle ) const final;
 
 private:
+	// Patch a single resource into temporaryFilePath, only writing it to its destination once its checksum is verified
+	// Resources the journal records as already patched are skipped
+	Result ApplyResource( const PatchApplyParams& params, unsigned int percentageComplete, const ResourceInfo* resource, const std::filesystem::path& temporaryFilePath, PatchApplyJournal& journal, const PatchDataSource* patchDataSource = nullptr ) const;
+
+	Result ApplyResourcesConcurrently( const PatchApplyParams& params, const ResourceGroupImpl& resourceGroup, unsigned int threadCount, PatchApplyJournal& journal ) const;
+
+	// Caller must hold m_targetResourcePatchesMutex
+	Result IndexTargetResourcePatches() const;
+
 	virtual Result CreateResourceFromYaml( YAML::Node& resource, ResourceInfo*& resourceOut ) override;
 
 	virtual Result ImportGroupSpecialisedYaml( YAML::Node& resourceGroupFile ) override;
 
 	virtual Result ExportGroupSpecialisedYaml( YAML::Emitter& out, VersionInternal outputDocumentVersion ) const override;
 
-	Result GetTargetResourcePatches( const ResourceInfo* targetResource, std::vector<const PatchResourceInfo*>& patches ) const;
-
 protected:
 	DocumentParameter<uintmax_t> m_maxInputChunkSize = DocumentParameter<uintmax_t>( MAX_INPUT_CHUNK_SIZE, TypeId() );
 
 	DocumentParameter<ResourceGroupInfo*> m_resourceGroupParameter = DocumentParameter<ResourceGroupInfo*>( RESOURCE_GROUP_RESOURCE, TypeId() );
 
 	DocumentParameterCollection<std::filesystem::path> m_removedResources = DocumentParameterCollection<std::filesystem::path>( REMOVED_RESOURCE_RELATIVE_PATHS, TypeId() );
+
+private:
+	// Patches in document order by the relative path of the resource they target, built on first lookup
+	mutable std::unordered_map<std::string, std::vector<const PatchResourceInfo*>> m_targetResourcePatches;
+
+	// Number of patches in the group when the index was built, patches are only added so a change means it is stale
+	mutable size_t m_targetResourcePatchesIndexedCount = 0;
+
+	mutable bool m_targetResourcePatchesIndexed = false;
+
+	mutable std::mutex m_targetResourcePatchesMutex;
 };
 
 }
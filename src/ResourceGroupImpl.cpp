@@ -2,7 +2,17 @@
 
 #include "ResourceGroupImpl.h"
 
+#include <atomic>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <map>
+#include <set>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
 #include <yaml-cpp/yaml.h>
 #include <ResourceTools.h>
 #include <BundleStreamOut.h>
@@ -14,14 +24,372 @@
 #include "ResourceInfo/ResourceGroupInfo.h"
 #include "ResourceInfo/PatchResourceInfo.h"
 #include "Patching.h"
+#include "DiffEngine.h"
 #include "PatchResourceGroupImpl.h"
 #include "BundleResourceGroupImpl.h"
 #include "ChunkIndex.h"
+#include "ChunkIndexCache.h"
+#include "PatchCache.h"
+#include "ContentDefinedChunking.h"
 #include "ResourceGroupFactory.h"
 
 namespace CarbonResources
 {
 
+namespace
+{
+// Hands the patches of a resource on in order, while the diffs completing them run on up to threadCount threads.
+class ChunkPatchQueue
+{
+public:
+	ChunkPatchQueue( unsigned int threadCount, const std::function<Result( PendingPatch& )>& onPatch ) :
+		m_threadCount( threadCount ? threadCount : std::max( std::thread::hardware_concurrency(), 1u ) ),
+		m_onPatch( onPatch )
+	{
+	}
+
+	// Queue a patch which is already complete.
+	Result Add( PendingPatch& pendingPatch )
+	{
+		m_entries.emplace_back().pendingPatch = std::move( pendingPatch );
+
+		return FlushTo( m_threadCount - 1 );
+	}
+
+	// Queue a patch completed by create, which runs on another thread if there is more than one.
+	Result Add( PendingPatch& pendingPatch, std::function<Result( PendingPatch& )>&& create )
+	{
+		// References to deque elements stay valid while others are added and removed
+		Entry& entry = m_entries.emplace_back();
+
+		entry.pendingPatch = std::move( pendingPatch );
+
+		std::launch launchPolicy = m_threadCount > 1 ? std::launch::async : std::launch::deferred;
+
+		entry.created = std::async( launchPolicy, [&entry, create = std::move( create )]() { return create( entry.pendingPatch ); } );
+
+		return FlushTo( m_threadCount - 1 );
+	}
+
+	// Hand on every queued patch.
+	Result Flush()
+	{
+		return FlushTo( 0 );
+	}
+
+private:
+	struct Entry
+	{
+		PendingPatch pendingPatch;
+
+		// Destroyed first, waiting for the patch to no longer be in use
+		std::future<Result> created;
+	};
+
+	Result FlushTo( size_t maxPending )
+	{
+		while( m_entries.size() > maxPending )
+		{
+			Entry& entry = m_entries.front();
+
+			if( entry.created.valid() )
+			{
+				Result createResult = entry.created.get();
+
+				if( createResult.type != ResultType::SUCCESS )
+				{
+					return createResult;
+				}
+			}
+
+			Result addPatchResult = m_onPatch( entry.pendingPatch );
+
+			if( addPatchResult.type != ResultType::SUCCESS )
+			{
+				return addPatchResult;
+			}
+
+			m_entries.pop_front();
+		}
+
+		return Result{ ResultType::SUCCESS };
+	}
+
+	unsigned int m_threadCount;
+
+	const std::function<Result( PendingPatch& )>& m_onPatch;
+
+	std::deque<Entry> m_entries;
+};
+
+// The diff buffers kept between resources are only needed for the length of one patch run
+class PatchBufferRelease
+{
+public:
+	PatchBufferRelease() = default;
+
+	PatchBufferRelease( const PatchBufferRelease& ) = delete;
+
+	PatchBufferRelease& operator=( const PatchBufferRelease& ) = delete;
+
+	~PatchBufferRelease()
+	{
+		ResourceTools::ReleasePatchBuffers();
+	}
+};
+
+// Content defined chunks are looked up by the start of their hash
+uint64_t ContentDefinedChunkKey( const ResourceTools::BlockHash& hash )
+{
+	uint64_t key;
+	std::memcpy( &key, hash.bytes, sizeof( key ) );
+	return key;
+}
+
+bool ContentDefinedChunksMatch( const ResourceTools::ContentDefinedChunk& a, const ResourceTools::ContentDefinedChunk& b )
+{
+	return a.size == b.size && a.hash == b.hash;
+}
+
+const char* DiffEngineName( DiffEngineType diffEngine )
+{
+	switch( diffEngine )
+	{
+	case DiffEngineType::BSDIFF:
+		return ResourceTools::DIFF_ENGINE_BSDIFF;
+	case DiffEngineType::ZSTD:
+		return ResourceTools::DIFF_ENGINE_ZSTD;
+	}
+	return "";
+}
+
+// Patches depend on the data of both resources and on the parameters which change how they are chunked and diffed
+std::string PatchCacheKey( const PatchCreateParams& params, const std::string& previousChecksum, const std::string& nextChecksum )
+{
+	std::stringstream ss;
+	ss << previousChecksum << "_" << nextChecksum << "_" << params.maxInputFileChunkSize << "_" << DiffEngineName( params.diffEngine );
+	if( params.contentDefinedChunking )
+	{
+		ss << "_cdc";
+	}
+	return ss.str();
+}
+
+// What a chain of patches does to one resource
+struct SquashedResource
+{
+	// Indices in the chain of the patches changing the resource
+	std::vector<size_t> changedBy;
+
+	// Indices in the chain of the patches removing the resource
+	std::vector<size_t> removedBy;
+
+	// The resource as left by the last patch, null if it removes the resource
+	ResourceInfo* resourceNext = nullptr;
+};
+
+// Copy a patch of another PatchResourceGroup, numbered when committed
+Result CopyPatch( const PatchCreateParams& params, const PatchResourceInfo& patch, const ResourceSourceSettings& patchBinarySourceSettings, PendingPatch& pendingPatch )
+{
+	PatchResourceInfoParams patchResourceInfoParams;
+
+	patchResourceInfoParams.relativePath = params.patchFileRelativePathPrefix.string() + ".0";
+
+	Result getTargetResourceRelativePathResult = patch.GetTargetResourceRelativePath( patchResourceInfoParams.targetResourceRelativePath );
+
+	if( getTargetResourceRelativePathResult.type != ResultType::SUCCESS )
+	{
+		return getTargetResourceRelativePathResult;
+	}
+
+	Result getDataOffsetResult = patch.GetDataOffset( patchResourceInfoParams.dataOffset );
+
+	if( getDataOffsetResult.type != ResultType::SUCCESS )
+	{
+		return getDataOffsetResult;
+	}
+
+	Result getSourceOffsetResult = patch.GetSourceOffset( patchResourceInfoParams.sourceOffset );
+
+	if( getSourceOffsetResult.type != ResultType::SUCCESS )
+	{
+		return getSourceOffsetResult;
+	}
+
+	Result getSourceResourceRelativePathResult = patch.GetSourceResourceRelativePath( patchResourceInfoParams.sourceResourceRelativePath );
+
+	if( getSourceResourceRelativePathResult.type != ResultType::SUCCESS && getSourceResourceRelativePathResult.type != ResultType::RESOURCE_VALUE_NOT_SET )
+	{
+		return getSourceResourceRelativePathResult;
+	}
+
+	Result getDiffEngineResult = patch.GetDiffEngine( patchResourceInfoParams.diffEngine );
+
+	if( getDiffEngineResult.type != ResultType::SUCCESS && getDiffEngineResult.type != ResultType::RESOURCE_VALUE_NOT_SET )
+	{
+		return getDiffEngineResult;
+	}
+
+	std::string location;
+
+	Result getLocationResult = patch.GetLocation( location );
+
+	if( getLocationResult.type != ResultType::SUCCESS )
+	{
+		return getLocationResult;
+	}
+
+	// Patches without data take it from the previous resource, their checksum and size describe that
+	if( location.empty() )
+	{
+		Result getChecksumResult = patch.GetChecksum( patchResourceInfoParams.checksum );
+
+		if( getChecksumResult.type != ResultType::SUCCESS )
+		{
+			return getChecksumResult;
+		}
+
+		Result getUncompressedSizeResult = patch.GetUncompressedSize( patchResourceInfoParams.uncompressedSize );
+
+		if( getUncompressedSizeResult.type != ResultType::SUCCESS )
+		{
+			return getUncompressedSizeResult;
+		}
+	}
+
+	pendingPatch.patchResource = std::make_unique<PatchResourceInfo>( patchResourceInfoParams );
+
+	if( !location.empty() )
+	{
+		ResourceGetDataParams patchGetDataParams;
+
+		patchGetDataParams.resourceSourceSettings = patchBinarySourceSettings;
+
+		patchGetDataParams.downloadRetrySeconds = params.downloadRetrySeconds;
+
+		patchGetDataParams.data = &pendingPatch.patchData;
+
+		Result getPatchDataResult = patch.GetData( patchGetDataParams );
+
+		if( getPatchDataResult.type != ResultType::SUCCESS )
+		{
+			return getPatchDataResult;
+		}
+
+		Result setParametersFromDataResult = pendingPatch.patchResource->SetParametersFromData( pendingPatch.patchData, params.calculateCompressions );
+
+		if( setParametersFromDataResult.type != ResultType::SUCCESS )
+		{
+			return setParametersFromDataResult;
+		}
+	}
+
+	return Result{ ResultType::SUCCESS };
+}
+// Key of a resource in PatchedTransitions, left empty for new resources which have no previous version to patch
+Result PatchedTransitionKey( const ResourceInfo& resourcePrevious, const ResourceInfo& resourceNext, std::string& key )
+{
+	key.clear();
+
+	uintmax_t previousUncompressedSize;
+
+	Result getPreviousUncompressedSizeResult = resourcePrevious.GetUncompressedSize( previousUncompressedSize );
+
+	if( getPreviousUncompressedSizeResult.type != ResultType::SUCCESS )
+	{
+		return getPreviousUncompressedSizeResult;
+	}
+
+	if( previousUncompressedSize == 0 )
+	{
+		return Result{ ResultType::SUCCESS };
+	}
+
+	std::filesystem::path relativePath;
+
+	Result getRelativePathResult = resourceNext.GetRelativePath( relativePath );
+
+	if( getRelativePathResult.type != ResultType::SUCCESS )
+	{
+		return getRelativePathResult;
+	}
+
+	std::string previousChecksum;
+
+	Result getPreviousChecksumResult = resourcePrevious.GetChecksum( previousChecksum );
+
+	if( getPreviousChecksumResult.type != ResultType::SUCCESS )
+	{
+		return getPreviousChecksumResult;
+	}
+
+	std::string nextChecksum;
+
+	Result getNextChecksumResult = resourceNext.GetChecksum( nextChecksum );
+
+	if( getNextChecksumResult.type != ResultType::SUCCESS )
+	{
+		return getNextChecksumResult;
+	}
+
+	key = relativePath.generic_string() + ":" + previousChecksum + ":" + nextChecksum;
+
+	return Result{ ResultType::SUCCESS };
+}
+}
+
+std::shared_ptr<const ResourceTools::TargetChunkChecksums> NextResourceChunks::GetTargetChunkChecksums( const std::string& checksum, const std::filesystem::path& nextFilePath, uint32_t chunkSize )
+{
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+
+		auto targetChunkChecksums = m_targetChunkChecksums.find( checksum );
+
+		if( targetChunkChecksums != m_targetChunkChecksums.end() )
+		{
+			return targetChunkChecksums->second;
+		}
+	}
+
+	// Generated without holding the lock, so other resources are not held up
+	auto targetChunkChecksums = std::make_shared<ResourceTools::TargetChunkChecksums>();
+
+	if( !ResourceTools::GenerateTargetChunkChecksums( nextFilePath, chunkSize, *targetChunkChecksums ) )
+	{
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	return m_targetChunkChecksums.emplace( checksum, std::move( targetChunkChecksums ) ).first->second;
+}
+
+std::shared_ptr<const std::vector<ResourceTools::ContentDefinedChunk>> NextResourceChunks::GetContentDefinedChunks( const std::string& checksum, const std::filesystem::path& nextFilePath, const ResourceTools::ContentDefinedChunkSizes& chunkSizes )
+{
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+
+		auto contentDefinedChunks = m_contentDefinedChunks.find( checksum );
+
+		if( contentDefinedChunks != m_contentDefinedChunks.end() )
+		{
+			return contentDefinedChunks->second;
+		}
+	}
+
+	// Generated without holding the lock, so other resources are not held up
+	auto contentDefinedChunks = std::make_shared<std::vector<ResourceTools::ContentDefinedChunk>>();
+
+	if( !ResourceTools::GenerateContentDefinedChunks( nextFilePath, chunkSizes, *contentDefinedChunks ) )
+	{
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	return m_contentDefinedChunks.emplace( checksum, std::move( contentDefinedChunks ) ).first->second;
+}
+
 
 ResourceGroup::ResourceGroupImpl::ResourceGroupImpl()
 {
@@ -1265,93 +1633,1346 @@ Result ResourceGroup::ResourceGroupImpl::CreateBundle( const BundleCreateParams&
 	return Result{ ResultType::SUCCESS };
 }
 
-Result ResourceGroup::ResourceGroupImpl::ConstructPatchResourceInfo( const PatchCreateParams& params, int patchId, uintmax_t dataOffset, uint64_t patchSourceOffset, ResourceInfo* resourceNext, PatchResourceInfo*& patchResource ) const
+Result ResourceGroup::ResourceGroupImpl::CommitPatch( const PatchCreateParams& params, int patchId, PendingPatch& pendingPatch, PatchResourceGroup::PatchResourceGroupImpl& patchResourceGroup ) const
 {
-	// Create a resource from patch data
-	std::filesystem::path resourceLatestRelativePath;
-	Result getResourceLatestRelativePathResult = resourceNext->GetRelativePath( resourceLatestRelativePath );
-	if( getResourceLatestRelativePathResult.type != ResultType::SUCCESS )
-	{
-		return getResourceLatestRelativePathResult;
-	}
-
-	PatchResourceInfoParams patchResourceInfoParams;
-	std::string patchFilename = params.patchFileRelativePathPrefix.string() + "." + std::to_string( patchId );
-	patchResourceInfoParams.relativePath = patchFilename;
-	patchResourceInfoParams.targetResourceRelativePath = resourceLatestRelativePath;
-	patchResourceInfoParams.dataOffset = dataOffset;
-	patchResourceInfoParams.sourceOffset = patchSourceOffset;
-	patchResource = new PatchResourceInfo( patchResourceInfoParams );
+	PatchResourceInfo* patchResource = pendingPatch.patchResource.get();
 
-	return Result{ ResultType::SUCCESS };
-}
+	patchResource->SetRelativePath( params.patchFileRelativePathPrefix.string() + "." + std::to_string( patchId ) );
 
-Result ResourceGroup::ResourceGroupImpl::CreatePatch( const PatchCreateParams& params ) const
-{
-	// Update status
-	if( params.statusCallback )
+	if( !pendingPatch.patchData.empty() )
 	{
-		params.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 0, "Creating Patch" );
-	}
+		// Location depends on the relative path, which is only known now
+		std::string checksum;
 
-	std::string previousGroupType = params.previousResourceGroup->m_impl->GetType();
+		Result getChecksumResult = patchResource->GetChecksum( checksum );
 
-	std::string nextGroupType = GetType();
+		if( getChecksumResult.type != ResultType::SUCCESS )
+		{
+			return getChecksumResult;
+		}
 
-	if( params.previousResourceGroup->m_impl->GetType() != GetType() )
-	{
-		return Result{ ResultType::PATCH_RESOURCE_LIST_MISSMATCH };
-	}
+		patchResource->SetDataChecksum( checksum );
 
-	PatchResourceGroup::PatchResourceGroupImpl patchResourceGroup;
+		// Export patch file
+		ResourcePutDataParams resourcePutDataParams;
 
-	Result setMaxInputChunkSizeResult = patchResourceGroup.SetMaxInputChunkSize( params.maxInputFileChunkSize );
+		resourcePutDataParams.resourceDestinationSettings = params.resourcePatchBinaryDestinationSettings;
 
-	if( setMaxInputChunkSizeResult.type != ResultType::SUCCESS )
-	{
-		return setMaxInputChunkSizeResult;
-	}
+		resourcePutDataParams.data = &pendingPatch.patchData;
 
-	// Created resource groups
+		Result putPatchDataResult = patchResource->PutData( resourcePutDataParams );
 
-	std::shared_ptr<ResourceGroupImpl> resourceGroupSubtractionPrevious;
+		if( putPatchDataResult.type != ResultType::SUCCESS )
+		{
+			return putPatchDataResult;
+		}
+	}
 
-	Result createPreviousResourceGroupResult = CreateResourceGroupFromString( previousGroupType, resourceGroupSubtractionPrevious );
+	// Add the patch resource to the patchResourceGroup
+	Result addResourceResult = patchResourceGroup.AddResource( patchResource );
 
-	if( createPreviousResourceGroupResult.type != ResultType::SUCCESS )
+	if( addResourceResult.type != ResultType::SUCCESS )
 	{
-		return createPreviousResourceGroupResult;
+		return addResourceResult;
 	}
 
-	std::shared_ptr<ResourceGroupImpl> resourceGroupSubtractionNext;
+	pendingPatch.patchResource.release();
 
-	Result createNextResourceGroupResult = CreateResourceGroupFromString( nextGroupType, resourceGroupSubtractionNext );
+	return Result{ ResultType::SUCCESS };
+}
 
-	if( createNextResourceGroupResult.type != ResultType::SUCCESS )
+Result ResourceGroup::ResourceGroupImpl::CreateResourcePatchesConcurrently( const PatchCreateParams& params, ResourceGroupImpl& resourceGroupPrevious, ResourceGroupImpl& resourceGroupNext, ResourceTools::ChunkIndexCache* indexCache, PatchCache* patchCache, const CrossResourceSources* crossResourceSources, NextResourceChunks* nextResourceChunks, unsigned int threadCount, const std::function<Result( PendingPatch& )>& commitPatch ) const
+{
+	struct ResourcePatchJob
 	{
-		return createNextResourceGroupResult;
-	}
+		std::deque<PendingPatch> patches;
 
+		bool finished = false;
 
-	ResourceGroupSubtractionParams resourceGroupSubtractionParams;
+		Result result{ ResultType::SUCCESS };
+	};
 
-	resourceGroupSubtractionParams.subtractResourceGroup = params.previousResourceGroup->m_impl;
+	size_t resourceCount = resourceGroupNext.m_resourcesParameter.GetSize();
 
-	resourceGroupSubtractionParams.result1 = resourceGroupSubtractionPrevious.get();
+	std::vector<ResourcePatchJob> jobs( resourceCount );
 
-	resourceGroupSubtractionParams.result2 = resourceGroupSubtractionNext.get();
+	std::mutex jobsMutex;
 
-	resourceGroupSubtractionParams.statusCallback = params.statusCallback;
+	std::condition_variable jobsChanged;
 
-	// Update status
-	if( params.statusCallback )
-	{
-		params.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 20, "Calculaing resourceGroups delta." );
-	}
+	size_t committingResource{ 0 };
 
-	Result subtractionResult = Diff( resourceGroupSubtractionParams );
+	uintmax_t pendingBytes{ 0 };
 
-	if( subtractionResult.type != ResultType::SUCCESS )
+	bool aborted{ false };
+
+	std::atomic<size_t> nextResource{ 0 };
+
+	// Status updates arrive from every worker
+	PatchCreateParams workerParams = params;
+
+	std::mutex statusMutex;
+
+	if( params.statusCallback )
+	{
+		workerParams.statusCallback = [&params, &statusMutex]( StatusLevel statusLevel, StatusProgressType statusProgressType, unsigned int progress, const std::string& info ) {
+			std::lock_guard<std::mutex> lock( statusMutex );
+			params.statusCallback( statusLevel, statusProgressType, progress, info );
+		};
+	}
+
+	threadCount = static_cast<unsigned int>( std::min<size_t>( threadCount, resourceCount ) );
+
+	auto worker = [&]( unsigned int workerIndex ) {
+		// Index files are named after the indexed file, each worker needs its own folder
+		std::filesystem::path workerIndexFolder = params.indexFolder / ( "worker" + std::to_string( workerIndex ) );
+
+		for( size_t i = nextResource++; i < resourceCount; i = nextResource++ )
+		{
+			{
+				std::lock_guard<std::mutex> lock( jobsMutex );
+
+				if( aborted )
+				{
+					break;
+				}
+			}
+
+			std::function<Result( PendingPatch& )> queuePatch = [&, i]( PendingPatch& pendingPatch ) {
+				std::unique_lock<std::mutex> lock( jobsMutex );
+
+				// The resource being committed never waits, so the budget can always be freed
+				jobsChanged.wait( lock, [&] { return aborted || i == committingResource || pendingBytes < params.patchMemoryBudget; } );
+
+				if( aborted )
+				{
+					return Result{ ResultType::FAILED_TO_CREATE_PATCH };
+				}
+
+				pendingBytes += pendingPatch.patchData.size();
+
+				jobs[i].patches.push_back( std::move( pendingPatch ) );
+
+				jobsChanged.notify_all();
+
+				return Result{ ResultType::SUCCESS };
+			};
+
+			auto percentageComplete = static_cast<unsigned int>( ( 100 * i ) / resourceCount );
+
+			Result createResourcePatchesResult = CreateResourcePatchesUsingCache( workerParams, percentageComplete, resourceGroupPrevious.m_resourcesParameter.At( i ), resourceGroupNext.m_resourcesParameter.At( i ), indexCache, patchCache, crossResourceSources, nextResourceChunks, workerIndexFolder, queuePatch );
+
+			std::lock_guard<std::mutex> lock( jobsMutex );
+
+			jobs[i].result = createResourcePatchesResult;
+
+			jobs[i].finished = true;
+
+			jobsChanged.notify_all();
+		}
+
+		std::error_code ec;
+
+		std::filesystem::remove( workerIndexFolder, ec );
+	};
+
+	std::vector<std::thread> workers;
+
+	for( unsigned int workerIndex = 0; workerIndex < threadCount; workerIndex++ )
+	{
+		workers.emplace_back( worker, workerIndex );
+	}
+
+	// Commit the patches of each resource in order as they become available
+	Result result{ ResultType::SUCCESS };
+
+	for( size_t i = 0; i < resourceCount && result.type == ResultType::SUCCESS; i++ )
+	{
+		std::unique_lock<std::mutex> lock( jobsMutex );
+
+		while( true )
+		{
+			jobsChanged.wait( lock, [&] { return !jobs[i].patches.empty() || jobs[i].finished; } );
+
+			if( jobs[i].patches.empty() )
+			{
+				result = jobs[i].result;
+
+				break;
+			}
+
+			PendingPatch pendingPatch = std::move( jobs[i].patches.front() );
+
+			jobs[i].patches.pop_front();
+
+			size_t patchDataSize = pendingPatch.patchData.size();
+
+			lock.unlock();
+
+			result = commitPatch( pendingPatch );
+
+			lock.lock();
+
+			pendingBytes -= patchDataSize;
+
+			jobsChanged.notify_all();
+
+			if( result.type != ResultType::SUCCESS )
+			{
+				break;
+			}
+		}
+
+		committingResource = i + 1;
+
+		jobsChanged.notify_all();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( jobsMutex );
+
+		aborted = true;
+
+		jobsChanged.notify_all();
+	}
+
+	for( auto& workerThread : workers )
+	{
+		workerThread.join();
+	}
+
+	return result;
+}
+
+Result ResourceGroup::ResourceGroupImpl::CreateResourcePatchesUsingCache( const PatchCreateParams& params, unsigned int percentageComplete, ResourceInfo* resourcePrevious, ResourceInfo* resourceNext, ResourceTools::ChunkIndexCache* indexCache, PatchCache* patchCache, const CrossResourceSources* crossResourceSources, NextResourceChunks* nextResourceChunks, const std::filesystem::path& indexFolder, const std::function<Result( PendingPatch& )>& onPatch ) const
+{
+	uintmax_t previousUncompressedSize;
+
+	Result getPreviousUncompressedSizeResult = resourcePrevious->GetUncompressedSize( previousUncompressedSize );
+
+	if( getPreviousUncompressedSizeResult.type != ResultType::SUCCESS )
+	{
+		return getPreviousUncompressedSizeResult;
+	}
+
+	// New resources have no previous checksum to key them by
+	if( !patchCache || previousUncompressedSize == 0 )
+	{
+		return CreateResourcePatches( params, percentageComplete, resourcePrevious, resourceNext, indexCache, crossResourceSources, nextResourceChunks, indexFolder, onPatch );
+	}
+
+	std::string previousChecksum;
+
+	Result getPreviousChecksumResult = resourcePrevious->GetChecksum( previousChecksum );
+
+	if( getPreviousChecksumResult.type != ResultType::SUCCESS )
+	{
+		return getPreviousChecksumResult;
+	}
+
+	std::string nextChecksum;
+
+	Result getNextChecksumResult = resourceNext->GetChecksum( nextChecksum );
+
+	if( getNextChecksumResult.type != ResultType::SUCCESS )
+	{
+		return getNextChecksumResult;
+	}
+
+	std::string key = PatchCacheKey( params, previousChecksum, nextChecksum );
+
+	bool found{ false };
+
+	Result loadResult = patchCache->Load( params, key, resourceNext, onPatch, found );
+
+	if( loadResult.type != ResultType::SUCCESS || found )
+	{
+		return loadResult;
+	}
+
+	PatchCache::EntryWriter entryWriter( *patchCache, key );
+
+	std::function<Result( PendingPatch& )> recordPatch = [&entryWriter, &onPatch]( PendingPatch& pendingPatch ) {
+		entryWriter.Write( pendingPatch );
+
+		return onPatch( pendingPatch );
+	};
+
+	Result createResourcePatchesResult = CreateResourcePatches( params, percentageComplete, resourcePrevious, resourceNext, indexCache, crossResourceSources, nextResourceChunks, indexFolder, recordPatch );
+
+	if( createResourcePatchesResult.type == ResultType::SUCCESS )
+	{
+		entryWriter.Commit();
+	}
+
+	return createResourcePatchesResult;
+}
+
+Result ResourceGroup::ResourceGroupImpl::CreateResourcePatches( const PatchCreateParams& params, unsigned int percentageComplete, ResourceInfo* resourcePrevious, ResourceInfo* resourceNext, ResourceTools::ChunkIndexCache* indexCache, const CrossResourceSources* crossResourceSources, NextResourceChunks* nextResourceChunks, const std::filesystem::path& indexFolder, const std::function<Result( PendingPatch& )>& onPatch ) const
+{
+	if( params.statusCallback )
+	{
+		std::filesystem::path relativePath;
+
+		Result getRelativePathResult = resourcePrevious->GetRelativePath( relativePath );
+
+		if( getRelativePathResult.type != ResultType::SUCCESS )
+		{
+			return getRelativePathResult;
+		}
+
+		std::string message = "Creating patch for: " + relativePath.string();
+
+		params.statusCallback( CarbonResources::StatusLevel::DETAIL, CarbonResources::StatusProgressType::PERCENTAGE, percentageComplete, message );
+	}
+
+	size_t patchSourceOffset{ 0 };
+	uint64_t patchSourceOffsetDelta{ 0 };
+
+	// Check to see if previous entry contains dummy information
+	// Suggesting that this is a new entry in latest
+	// In which case there is no reason to create a patch
+	// The new entry will be stored with the ResourceGroup related to the PatchResourceGroup
+	uintmax_t previousUncompressedSize;
+
+	Result getResourcePreviousCompressedSizeResult = resourcePrevious->GetUncompressedSize( previousUncompressedSize );
+
+	if( getResourcePreviousCompressedSizeResult.type != ResultType::SUCCESS )
+	{
+		return getResourcePreviousCompressedSizeResult;
+	}
+
+
+
+	uintmax_t nextUncompressedSize;
+
+	Result getResourceNextCompressedSizeResult = resourceNext->GetUncompressedSize( nextUncompressedSize );
+
+	if( getResourceNextCompressedSizeResult.type != ResultType::SUCCESS )
+	{
+		return getResourceNextCompressedSizeResult;
+	}
+
+
+	// A new resource may still be made from data found in other previous resources
+	if( previousUncompressedSize == 0 && crossResourceSources )
+	{
+		return CreateCrossResourcePatches( params, resourceNext, *crossResourceSources, onPatch );
+	}
+
+	// If previous size is 0 this suggests that this is a new entry in latest
+	// In which case there is no reason to create a patch
+	if( previousUncompressedSize != 0 )
+	{
+		// Get resource data previous
+		auto previousFileDataStream = std::make_shared<ResourceTools::FileDataStreamIn>( params.maxInputFileChunkSize );
+
+		ResourceGetDataStreamParams previousResourceGetDataStreamParams;
+
+		previousResourceGetDataStreamParams.resourceSourceSettings = params.resourceSourceSettingsPrevious;
+
+		previousResourceGetDataStreamParams.downloadRetrySeconds = params.downloadRetrySeconds;
+
+		previousResourceGetDataStreamParams.dataStream = previousFileDataStream;
+
+		Result getPreviousDataStreamResult = resourcePrevious->GetDataStream( previousResourceGetDataStreamParams );
+
+		if( getPreviousDataStreamResult.type != ResultType::SUCCESS )
+		{
+			return getPreviousDataStreamResult;
+		}
+
+		// Get resource data next
+		auto nextFileDataStream = std::make_shared<ResourceTools::FileDataStreamIn>( params.maxInputFileChunkSize );
+
+		ResourceGetDataStreamParams nextResourceGetDataStreamParams;
+
+		nextResourceGetDataStreamParams.resourceSourceSettings = params.resourceSourceSettingsNext;
+
+		nextResourceGetDataStreamParams.dataStream = nextFileDataStream;
+
+		Result getNextDataStreamResult = resourceNext->GetDataStream( nextResourceGetDataStreamParams );
+
+		if( getNextDataStreamResult.type != ResultType::SUCCESS )
+		{
+			return getNextDataStreamResult;
+		}
+
+		std::filesystem::path relativePath;
+		Result getRelativePathResult = resourcePrevious->GetRelativePath( relativePath );
+		if( getRelativePathResult.type != ResultType::SUCCESS )
+		{
+			return getRelativePathResult;
+		}
+
+		if( params.contentDefinedChunking )
+		{
+			return CreateContentDefinedPatches( params, relativePath, resourceNext, nextResourceChunks, *previousFileDataStream, *nextFileDataStream, onPatch );
+		}
+
+		std::function<void( unsigned int, const std::string& )> callback = [params]( unsigned int percent, const std::string& msg ) {
+			if( params.statusCallback )
+			{
+				params.statusCallback( StatusLevel::DETAIL, StatusProgressType::PERCENTAGE, percent, msg );
+			}
+		};
+		ResourceTools::ChunkIndex index( previousFileDataStream->GetPath(), params.maxInputFileChunkSize, indexFolder, callback, params.indexThreadCount, params.indexBlockHashes, static_cast<size_t>( params.indexMemoryBudget ) );
+		if( params.statusCallback )
+		{
+			std::string message = "Generating index for " + relativePath.string();
+			params.statusCallback( StatusLevel::DETAIL, StatusProgressType::PERCENTAGE, 0, message );
+		}
+		// The target chunk checksums also let all chunk lookups be resolved in one pass over the index.
+		if( nextResourceChunks )
+		{
+			std::string nextChecksum;
+			Result getNextChecksumResult = resourceNext->GetChecksum( nextChecksum );
+			if( getNextChecksumResult.type != ResultType::SUCCESS )
+			{
+				return getNextChecksumResult;
+			}
+			std::shared_ptr<const ResourceTools::TargetChunkChecksums> targetChunkChecksums = nextResourceChunks->GetTargetChunkChecksums( nextChecksum, nextFileDataStream->GetPath(), params.maxInputFileChunkSize );
+			if( targetChunkChecksums )
+			{
+				index.SetChecksumFilter( *targetChunkChecksums );
+			}
+		}
+		else
+		{
+			index.GenerateChecksumFilter( nextFileDataStream->GetPath() );
+		}
+		bool indexGenerated{ false };
+		if( indexCache )
+		{
+			std::string previousChecksum;
+			Result getPreviousChecksumResult = resourcePrevious->GetChecksum( previousChecksum );
+			if( getPreviousChecksumResult.type != ResultType::SUCCESS )
+			{
+				return getPreviousChecksumResult;
+			}
+			indexGenerated = index.Generate( *indexCache, previousChecksum );
+		}
+		else
+		{
+			indexGenerated = index.Generate();
+		}
+		if( !indexGenerated )
+		{
+			std::string message = "Index generation failed for " + relativePath.string();
+			params.statusCallback( StatusLevel::DETAIL, StatusProgressType::PERCENTAGE, 0, message );
+		}
+
+		// Which source window each chunk is diffed against is decided here one chunk at a time,
+		// the diffs themselves are independent and run on up to diffThreadCount threads.
+		ChunkPatchQueue chunkPatches( params.diffThreadCount, onPatch );
+
+		// Process one chunk at a time
+		for( uintmax_t dataOffset = 0; dataOffset < nextUncompressedSize; dataOffset += params.maxInputFileChunkSize )
+		{
+			std::string previousFileData = "";
+
+			if( previousFileDataStream->IsFinished() )
+			{
+				if( previousFileDataStream->Size() > nextFileDataStream->GetCurrentPosition() )
+				{
+					// We ran out of data because we found a chunk match later in the file,
+					// but we can rewind back to where the read stream is in hopes
+					// of getting a good diff, rather than just treating it as new data.
+					previousFileDataStream->StartRead( previousFileDataStream->GetPath() );
+				}
+			}
+
+			// Handling if previous file is smaller than next file
+			// If so then previousFileData will be nothing and
+			// All next data will be used for the patch
+			if( !previousFileDataStream->IsFinished() )
+			{
+				if( !( *previousFileDataStream >> previousFileData ) )
+				{
+					return Result{ ResultType::FAILED_TO_RETRIEVE_CHUNK_DATA };
+				}
+			}
+
+			size_t nextStreamPosition = nextFileDataStream->GetCurrentPosition();
+			// Note: in the case that the next file is smaller than previous
+			// nothing is stored, application of the patch will chop off the extra file data
+			std::string nextFileData;
+
+			if( !nextFileDataStream->IsFinished() )
+			{
+				if( !( *nextFileDataStream >> nextFileData ) )
+				{
+					return Result{ ResultType::FAILED_TO_RETRIEVE_CHUNK_DATA };
+				}
+			}
+
+			bool chunkMatchFound{ false };
+			size_t matchCount{ 0 };
+
+
+			if( previousFileData != "" )
+			{
+				// Here's how this should work:
+				// We find a matching chunk if it exists. If the chunk exists we make a patch with no data, because we'll get
+				// the data from the source file using the patch info. Consecutive patches should be collapsed into one big one.
+				// If we can't find a matching chunk, we will base the current diff off the chunk in the source starting after the final byte
+				// in the chunk from the source file that we last used.
+				// These should keep our patches pretty minimal, even if lots of data gets added early in the file causing offsets.
+				// It should also handle small changes in moved parts of the file pretty well.
+				if( params.statusCallback )
+				{
+					unsigned int progress = static_cast<uint32_t>( ( dataOffset * 100 ) / nextUncompressedSize );
+					std::stringstream ss;
+					ss << "Generating patch files: " << relativePath.string();
+					params.statusCallback( StatusLevel::DETAIL, StatusProgressType::PERCENTAGE, progress, ss.str() );
+				}
+
+				chunkMatchFound = index.FindMatchingChunk( nextFileData, patchSourceOffset );
+
+				if( chunkMatchFound )
+				{
+					matchCount = 1;
+					matchCount += ResourceTools::CountMatchingChunks(
+						nextFileDataStream->GetPath(),
+						nextFileDataStream->GetCurrentPosition(),
+						previousFileDataStream->GetPath(),
+						patchSourceOffset + params.maxInputFileChunkSize,
+						params.maxInputFileChunkSize );
+
+					size_t matchSize = std::min( params.maxInputFileChunkSize * matchCount, previousFileDataStream->Size() - patchSourceOffset );
+
+					PendingPatch pendingPatch;
+
+					PatchResourceInfo* patchResource{ nullptr };
+
+					ConstructPatchResourceInfo( params, 0, dataOffset, patchSourceOffset, resourceNext, patchResource );
+
+					pendingPatch.patchResource.reset( patchResource );
+
+					if( previousFileDataStream->IsFinished() )
+					{
+						previousFileDataStream->StartRead( previousFileDataStream->GetPath() );
+					}
+
+					previousFileDataStream->Seek( patchSourceOffset );
+
+					patchResource->SetParametersFromSourceStream( *previousFileDataStream, matchSize );
+
+					// Advance the first stream by the size of the matching data,
+					// but move the point we generate patches from for the previous
+					// file data stream to the end of the match.
+					// It's hard to tell if it would be smarter to simply advance
+					// the destination data by the same amount of the source data,
+					// or perhaps even not to move it at all.
+					nextFileDataStream->Seek( std::min( nextFileDataStream->Size(), nextStreamPosition + matchSize ) );
+
+					previousFileDataStream->Seek( std::min( previousFileDataStream->Size(), patchSourceOffset + matchSize ) );
+
+					dataOffset += matchSize - params.maxInputFileChunkSize;
+
+					patchSourceOffset += matchSize;
+
+					if( nextStreamPosition == 0 && patchSourceOffset == 0 )
+					{
+						// This is the beginning of the file and it matches.
+						// There is no need to write patch data.
+						continue;
+					}
+
+					Result addPatchResult = chunkPatches.Add( pendingPatch );
+
+					if( addPatchResult.type != ResultType::SUCCESS )
+					{
+						return addPatchResult;
+					}
+
+					continue;
+				}
+				else
+				{
+					// Previous and next data chunk are different, create a patch
+					patchSourceOffsetDelta = previousFileData.size();
+				}
+			}
+			else
+			{
+				// If there is no previous data then just store the data straight from the file
+				// All this data is new
+				patchSourceOffsetDelta = nextFileData.size();
+			}
+
+			PendingPatch pendingPatch;
+			PatchResourceInfo* patchResource{ nullptr };
+			ConstructPatchResourceInfo( params, 0, dataOffset, patchSourceOffset, resourceNext, patchResource );
+			pendingPatch.patchResource.reset( patchResource );
+			patchSourceOffset += patchSourceOffsetDelta;
+			Result addPatchResult = chunkPatches.Add( pendingPatch, [this, &params, previousData = std::move( previousFileData ), nextData = std::move( nextFileData )]( PendingPatch& patch ) {
+				return CreateChunkPatch( params, previousData, nextData, patch );
+			} );
+
+			if( addPatchResult.type != ResultType::SUCCESS )
+			{
+				return addPatchResult;
+			}
+		}
+
+		Result flushChunkPatchesResult = chunkPatches.Flush();
+
+		if( flushChunkPatchesResult.type != ResultType::SUCCESS )
+		{
+			return flushChunkPatchesResult;
+		}
+	}
+	return Result{ ResultType::SUCCESS };
+}
+
+Result ResourceGroup::ResourceGroupImpl::CreateContentDefinedPatches( const PatchCreateParams& params, const std::filesystem::path& relativePath, ResourceInfo* resourceNext, NextResourceChunks* nextResourceChunks, ResourceTools::FileDataStreamIn& previousFileDataStream, ResourceTools::FileDataStreamIn& nextFileDataStream, const std::function<Result( PendingPatch& )>& onPatch ) const
+{
+	// Both resources are split at content defined boundaries, which line up again shortly after an edit.
+	// Unchanged chunks are then found by hash, with no index of every offset in the previous resource.
+	ResourceTools::ContentDefinedChunkSizes chunkSizes = ResourceTools::GetContentDefinedChunkSizes( params.maxInputFileChunkSize );
+
+	if( params.statusCallback )
+	{
+		std::string message = "Chunking " + relativePath.string();
+		params.statusCallback( StatusLevel::DETAIL, StatusProgressType::PERCENTAGE, 0, message );
+	}
+
+	std::vector<ResourceTools::ContentDefinedChunk> previousChunks;
+	if( !ResourceTools::GenerateContentDefinedChunks( previousFileDataStream.GetPath(), chunkSizes, previousChunks ) )
+	{
+		return Result{ ResultType::FAILED_TO_OPEN_FILE };
+	}
+
+	std::shared_ptr<const std::vector<ResourceTools::ContentDefinedChunk>> nextChunksShared;
+	if( nextResourceChunks )
+	{
+		std::string nextChecksum;
+		Result getNextChecksumResult = resourceNext->GetChecksum( nextChecksum );
+		if( getNextChecksumResult.type != ResultType::SUCCESS )
+		{
+			return getNextChecksumResult;
+		}
+		nextChunksShared = nextResourceChunks->GetContentDefinedChunks( nextChecksum, nextFileDataStream.GetPath(), chunkSizes );
+	}
+	else
+	{
+		auto generatedChunks = std::make_shared<std::vector<ResourceTools::ContentDefinedChunk>>();
+		if( ResourceTools::GenerateContentDefinedChunks( nextFileDataStream.GetPath(), chunkSizes, *generatedChunks ) )
+		{
+			nextChunksShared = std::move( generatedChunks );
+		}
+	}
+	if( !nextChunksShared )
+	{
+		return Result{ ResultType::FAILED_TO_OPEN_FILE };
+	}
+	const std::vector<ResourceTools::ContentDefinedChunk>& nextChunks = *nextChunksShared;
+
+	// Previous chunks keyed by the start of their hash, the first of identical chunks is used
+	std::unordered_map<uint64_t, size_t> previousChunkIndices;
+	previousChunkIndices.reserve( previousChunks.size() );
+	for( size_t i = 0; i < previousChunks.size(); ++i )
+	{
+		previousChunkIndices.emplace( ContentDefinedChunkKey( previousChunks[i].hash ), i );
+	}
+
+	ChunkPatchQueue chunkPatches( params.diffThreadCount, onPatch );
+
+	uint64_t patchSourceOffset{ 0 };
+
+	for( size_t i = 0; i < nextChunks.size(); )
+	{
+		const ResourceTools::ContentDefinedChunk& nextChunk = nextChunks[i];
+
+		if( params.statusCallback )
+		{
+			unsigned int progress = static_cast<uint32_t>( ( nextChunk.offset * 100 ) / nextFileDataStream.Size() );
+			std::stringstream ss;
+			ss << "Generating patch files: " << relativePath.string();
+			params.statusCallback( StatusLevel::DETAIL, StatusProgressType::PERCENTAGE, progress, ss.str() );
+		}
+
+		auto previousChunkIndex = previousChunkIndices.find( ContentDefinedChunkKey( nextChunk.hash ) );
+
+		if( previousChunkIndex != previousChunkIndices.end() && ContentDefinedChunksMatch( previousChunks[previousChunkIndex->second], nextChunk ) )
+		{
+			// Extend the match over the chunks following on in both resources
+			size_t previousIndex = previousChunkIndex->second;
+			size_t matchCount = 1;
+			uint64_t matchSize = nextChunk.size;
+			while( i + matchCount < nextChunks.size() && previousIndex + matchCount < previousChunks.size() && ContentDefinedChunksMatch( previousChunks[previousIndex + matchCount], nextChunks[i + matchCount] ) )
+			{
+				matchSize += nextChunks[i + matchCount].size;
+				matchCount++;
+			}
+
+			uint64_t sourceOffset = previousChunks[previousIndex].offset;
+
+			PendingPatch pendingPatch;
+
+			PatchResourceInfo* patchResource{ nullptr };
+
+			ConstructPatchResourceInfo( params, 0, nextChunk.offset, sourceOffset, resourceNext, patchResource );
+
+			pendingPatch.patchResource.reset( patchResource );
+
+			if( previousFileDataStream.IsFinished() )
+			{
+				previousFileDataStream.StartRead( previousFileDataStream.GetPath() );
+			}
+
+			previousFileDataStream.Seek( sourceOffset );
+
+			Result setParametersFromSourceStreamResult = patchResource->SetParametersFromSourceStream( previousFileDataStream, matchSize );
+
+			if( setParametersFromSourceStreamResult.type != ResultType::SUCCESS )
+			{
+				return setParametersFromSourceStreamResult;
+			}
+
+			Result addPatchResult = chunkPatches.Add( pendingPatch );
+
+			if( addPatchResult.type != ResultType::SUCCESS )
+			{
+				return addPatchResult;
+			}
+
+			patchSourceOffset = sourceOffset + matchSize;
+
+			i += matchCount;
+
+			continue;
+		}
+
+		// As with fixed size chunks, a changed chunk is diffed against the previous data following the last data used.
+		// Applying the patch reads the same maxInputFileChunkSize window.
+		std::string previousFileData;
+
+		if( patchSourceOffset < previousFileDataStream.Size() )
+		{
+			if( previousFileDataStream.IsFinished() )
+			{
+				previousFileDataStream.StartRead( previousFileDataStream.GetPath() );
+			}
+
+			previousFileDataStream.Seek( patchSourceOffset );
+
+			if( !( previousFileDataStream >> previousFileData ) )
+			{
+				return Result{ ResultType::FAILED_TO_RETRIEVE_CHUNK_DATA };
+			}
+		}
+
+		std::string nextFileData;
+
+		if( nextFileDataStream.IsFinished() )
+		{
+			nextFileDataStream.StartRead( nextFileDataStream.GetPath() );
+		}
+
+		nextFileDataStream.Seek( nextChunk.offset );
+
+		if( !nextFileDataStream.ReadBytes( nextChunk.size, nextFileData ) )
+		{
+			return Result{ ResultType::FAILED_TO_RETRIEVE_CHUNK_DATA };
+		}
+
+		PendingPatch pendingPatch;
+
+		PatchResourceInfo* patchResource{ nullptr };
+
+		ConstructPatchResourceInfo( params, 0, nextChunk.offset, patchSourceOffset, resourceNext, patchResource );
+
+		pendingPatch.patchResource.reset( patchResource );
+
+		patchSourceOffset += nextChunk.size;
+
+		Result addPatchResult = chunkPatches.Add( pendingPatch, [this, &params, previousData = std::move( previousFileData ), nextData = std::move( nextFileData )]( PendingPatch& patch ) {
+			return CreateChunkPatch( params, previousData, nextData, patch );
+		} );
+
+		if( addPatchResult.type != ResultType::SUCCESS )
+		{
+			return addPatchResult;
+		}
+
+		i++;
+	}
+
+	return chunkPatches.Flush();
+}
+
+Result ResourceGroup::ResourceGroupImpl::IndexCrossResourceSources( const PatchCreateParams& params, const ResourceGroupImpl& resourceGroupNext, CrossResourceSources& crossResourceSources ) const
+{
+	// Previous resources that are patched get rewritten while the patch is applied, so only the others are sources.
+	// Removed resources are deleted once every resource has been patched, so they can be sourced from too.
+	std::set<std::filesystem::path> patchedRelativePaths;
+
+	for( const ResourceInfo* resource : resourceGroupNext )
+	{
+		std::filesystem::path relativePath;
+
+		Result getRelativePathResult = resource->GetRelativePath( relativePath );
+
+		if( getRelativePathResult.type != ResultType::SUCCESS )
+		{
+			return getRelativePathResult;
+		}
+
+		patchedRelativePaths.insert( relativePath );
+	}
+
+	ResourceTools::ContentDefinedChunkSizes chunkSizes = ResourceTools::GetContentDefinedChunkSizes( params.maxInputFileChunkSize );
+
+	for( const ResourceInfo* resource : *params.previousResourceGroup->m_impl )
+	{
+		std::filesystem::path relativePath;
+
+		Result getRelativePathResult = resource->GetRelativePath( relativePath );
+
+		if( getRelativePathResult.type != ResultType::SUCCESS )
+		{
+			return getRelativePathResult;
+		}
+
+		uintmax_t uncompressedSize;
+
+		Result getUncompressedSizeResult = resource->GetUncompressedSize( uncompressedSize );
+
+		if( getUncompressedSizeResult.type != ResultType::SUCCESS )
+		{
+			return getUncompressedSizeResult;
+		}
+
+		if( uncompressedSize == 0 || patchedRelativePaths.find( relativePath ) != patchedRelativePaths.end() )
+		{
+			continue;
+		}
+
+		if( params.statusCallback )
+		{
+			std::string message = "Chunking cross resource source: " + relativePath.string();
+			params.statusCallback( StatusLevel::DETAIL, StatusProgressType::UNBOUNDED, 0, message );
+		}
+
+		auto dataStream = std::make_shared<ResourceTools::FileDataStreamIn>( params.maxInputFileChunkSize );
+
+		ResourceGetDataStreamParams getDataStreamParams;
+
+		getDataStreamParams.resourceSourceSettings = params.resourceSourceSettingsPrevious;
+
+		getDataStreamParams.downloadRetrySeconds = params.downloadRetrySeconds;
+
+		getDataStreamParams.dataStream = dataStream;
+
+		Result getDataStreamResult = resource->GetDataStream( getDataStreamParams );
+
+		if( getDataStreamResult.type != ResultType::SUCCESS )
+		{
+			return getDataStreamResult;
+		}
+
+		std::vector<ResourceTools::ContentDefinedChunk> chunks;
+
+		if( !ResourceTools::GenerateContentDefinedChunks( dataStream->GetPath(), chunkSizes, chunks ) )
+		{
+			return Result{ ResultType::FAILED_TO_OPEN_FILE };
+		}
+
+		size_t sourceIndex = crossResourceSources.relativePaths.size();
+
+		for( size_t i = 0; i < chunks.size(); ++i )
+		{
+			crossResourceSources.chunkLocations.emplace( ContentDefinedChunkKey( chunks[i].hash ), std::make_pair( sourceIndex, i ) );
+		}
+
+		crossResourceSources.relativePaths.push_back( relativePath );
+
+		crossResourceSources.filePaths.push_back( dataStream->GetPath() );
+
+		crossResourceSources.chunks.push_back( std::move( chunks ) );
+	}
+
+	return Result{ ResultType::SUCCESS };
+}
+
+Result ResourceGroup::ResourceGroupImpl::CreateCrossResourcePatches( const PatchCreateParams& params, ResourceInfo* resourceNext, const CrossResourceSources& crossResourceSources, const std::function<Result( PendingPatch& )>& onPatch ) const
+{
+	std::filesystem::path relativePath;
+
+	Result getRelativePathResult = resourceNext->GetRelativePath( relativePath );
+
+	if( getRelativePathResult.type != ResultType::SUCCESS )
+	{
+		return getRelativePathResult;
+	}
+
+	auto nextFileDataStream = std::make_shared<ResourceTools::FileDataStreamIn>( params.maxInputFileChunkSize );
+
+	ResourceGetDataStreamParams nextResourceGetDataStreamParams;
+
+	nextResourceGetDataStreamParams.resourceSourceSettings = params.resourceSourceSettingsNext;
+
+	nextResourceGetDataStreamParams.dataStream = nextFileDataStream;
+
+	Result getNextDataStreamResult = resourceNext->GetDataStream( nextResourceGetDataStreamParams );
+
+	if( getNextDataStreamResult.type != ResultType::SUCCESS )
+	{
+		return getNextDataStreamResult;
+	}
+
+	std::vector<ResourceTools::ContentDefinedChunk> nextChunks;
+	if( !ResourceTools::GenerateContentDefinedChunks( nextFileDataStream->GetPath(), ResourceTools::GetContentDefinedChunkSizes( params.maxInputFileChunkSize ), nextChunks ) )
+	{
+		return Result{ ResultType::FAILED_TO_OPEN_FILE };
+	}
+
+	// Runs of chunks following on from each other in both the new resource and a source
+	struct SourceMatch
+	{
+		size_t firstChunk;
+		size_t chunkCount;
+		size_t sourceIndex;
+		uint64_t sourceOffset;
+		uint64_t size;
+	};
+
+	std::vector<SourceMatch> matches;
+
+	for( size_t i = 0; i < nextChunks.size(); )
+	{
+		auto location = crossResourceSources.chunkLocations.find( ContentDefinedChunkKey( nextChunks[i].hash ) );
+
+		if( location == crossResourceSources.chunkLocations.end() || !ContentDefinedChunksMatch( crossResourceSources.chunks[location->second.first][location->second.second], nextChunks[i] ) )
+		{
+			i++;
+			continue;
+		}
+
+		const std::vector<ResourceTools::ContentDefinedChunk>& sourceChunks = crossResourceSources.chunks[location->second.first];
+		size_t sourceChunkIndex = location->second.second;
+
+		SourceMatch match{ i, 1, location->second.first, sourceChunks[sourceChunkIndex].offset, nextChunks[i].size };
+		while( i + match.chunkCount < nextChunks.size() && sourceChunkIndex + match.chunkCount < sourceChunks.size() && ContentDefinedChunksMatch( sourceChunks[sourceChunkIndex + match.chunkCount], nextChunks[i + match.chunkCount] ) )
+		{
+			match.size += nextChunks[i + match.chunkCount].size;
+			match.chunkCount++;
+		}
+
+		matches.push_back( match );
+
+		i += match.chunkCount;
+	}
+
+	// Nothing in common with any previous resource, the new resource is shipped whole
+	if( matches.empty() )
+	{
+		return Result{ ResultType::SUCCESS };
+	}
+
+	if( params.statusCallback )
+	{
+		std::string message = "Sourcing " + relativePath.string() + " from " + crossResourceSources.relativePaths[matches.front().sourceIndex].string();
+		params.statusCallback( StatusLevel::DETAIL, StatusProgressType::UNBOUNDED, 0, message );
+	}
+
+	auto startSourceRead = [&crossResourceSources]( size_t sourceIndex, uint64_t offset, ResourceTools::FileDataStreamIn& sourceFileDataStream ) {
+		if( !sourceFileDataStream.StartRead( crossResourceSources.filePaths[sourceIndex] ) )
+		{
+			return false;
+		}
+
+		sourceFileDataStream.Seek( offset );
+
+		return true;
+	};
+
+	ChunkPatchQueue chunkPatches( params.diffThreadCount, onPatch );
+
+	// Changed chunks are diffed against the source of the surrounding matches, lined up with the data ahead of the first match
+	size_t sourceIndex = matches.front().sourceIndex;
+
+	uint64_t patchSourceOffset = matches.front().sourceOffset - std::min( matches.front().sourceOffset, nextChunks[matches.front().firstChunk].offset );
+
+	auto match = matches.begin();
+
+	for( size_t i = 0; i < nextChunks.size(); )
+	{
+		const ResourceTools::ContentDefinedChunk& nextChunk = nextChunks[i];
+
+		PendingPatch pendingPatch;
+
+		PatchResourceInfo* patchResource{ nullptr };
+
+		if( match != matches.end() && match->firstChunk == i )
+		{
+			ConstructPatchResourceInfo( params, 0, nextChunk.offset, match->sourceOffset, resourceNext, patchResource );
+
+			pendingPatch.patchResource.reset( patchResource );
+
+			patchResource->SetSourceResourceRelativePath( crossResourceSources.relativePaths[match->sourceIndex] );
+
+			ResourceTools::FileDataStreamIn sourceFileDataStream( params.maxInputFileChunkSize );
+
+			if( !startSourceRead( match->sourceIndex, match->sourceOffset, sourceFileDataStream ) )
+			{
+				return Result{ ResultType::FAILED_TO_OPEN_FILE };
+			}
+
+			Result setParametersFromSourceStreamResult = patchResource->SetParametersFromSourceStream( sourceFileDataStream, match->size );
+
+			if( setParametersFromSourceStreamResult.type != ResultType::SUCCESS )
+			{
+				return setParametersFromSourceStreamResult;
+			}
+
+			Result addPatchResult = chunkPatches.Add( pendingPatch );
+
+			if( addPatchResult.type != ResultType::SUCCESS )
+			{
+				return addPatchResult;
+			}
+
+			sourceIndex = match->sourceIndex;
+
+			patchSourceOffset = match->sourceOffset + match->size;
+
+			i += match->chunkCount;
+
+			match++;
+
+			continue;
+		}
+
+		// Applying the patch reads the same maxInputFileChunkSize window of the source
+		std::string sourceFileData;
+
+		ResourceTools::FileDataStreamIn sourceFileDataStream( params.maxInputFileChunkSize );
+
+		if( !startSourceRead( sourceIndex, patchSourceOffset, sourceFileDataStream ) )
+		{
+			return Result{ ResultType::FAILED_TO_OPEN_FILE };
+		}
+
+		if( patchSourceOffset < sourceFileDataStream.Size() && !( sourceFileDataStream >> sourceFileData ) )
+		{
+			return Result{ ResultType::FAILED_TO_RETRIEVE_CHUNK_DATA };
+		}
+
+		std::string nextFileData;
+
+		if( nextFileDataStream->IsFinished() )
+		{
+			nextFileDataStream->StartRead( nextFileDataStream->GetPath() );
+		}
+
+		nextFileDataStream->Seek( nextChunk.offset );
+
+		if( !nextFileDataStream->ReadBytes( nextChunk.size, nextFileData ) )
+		{
+			return Result{ ResultType::FAILED_TO_RETRIEVE_CHUNK_DATA };
+		}
+
+		ConstructPatchResourceInfo( params, 0, nextChunk.offset, patchSourceOffset, resourceNext, patchResource );
+
+		pendingPatch.patchResource.reset( patchResource );
+
+		patchResource->SetSourceResourceRelativePath( crossResourceSources.relativePaths[sourceIndex] );
+
+		patchSourceOffset += nextChunk.size;
+
+		Result addPatchResult = chunkPatches.Add( pendingPatch, [this, &params, sourceData = std::move( sourceFileData ), nextData = std::move( nextFileData )]( PendingPatch& patch ) {
+			return CreateChunkPatch( params, sourceData, nextData, patch );
+		} );
+
+		if( addPatchResult.type != ResultType::SUCCESS )
+		{
+			return addPatchResult;
+		}
+
+		i++;
+	}
+
+	return chunkPatches.Flush();
+}
+
+Result ResourceGroup::ResourceGroupImpl::CreateChunkPatch( const PatchCreateParams& params, const std::string& previousData, const std::string& nextData, PendingPatch& pendingPatch ) const
+{
+	std::string patchData;
+
+	const ResourceTools::DiffEngine* diffEngine = ResourceTools::GetDiffEngine( DiffEngineName( params.diffEngine ) );
+
+	if( !diffEngine )
+	{
+		return Result{ ResultType::FAILED_TO_CREATE_PATCH };
+	}
+
+	if( !diffEngine->CreatePatch( previousData, nextData, patchData ) )
+	{
+		return Result{ ResultType::FAILED_TO_CREATE_PATCH };
+	}
+
+	if( !patchData.empty() )
+	{
+		// bsdiff is assumed when no engine is recorded, keeping patches readable by older clients
+		if( params.diffEngine != DiffEngineType::BSDIFF )
+		{
+			pendingPatch.patchResource->SetDiffEngine( diffEngine->GetName() );
+		}
+
+		Result setParametersFromDataResult = pendingPatch.patchResource->SetParametersFromData( patchData, params.calculateCompressions );
+
+		if( setParametersFromDataResult.type != ResultType::SUCCESS )
+		{
+			return setParametersFromDataResult;
+		}
+
+		pendingPatch.patchData = std::move( patchData );
+	}
+
+	return Result{ ResultType::SUCCESS };
+}
+
+Result ResourceGroup::ResourceGroupImpl::ConstructPatchResourceInfo( const PatchCreateParams& params, int patchId, uintmax_t dataOffset, uint64_t patchSourceOffset, ResourceInfo* resourceNext, PatchResourceInfo*& patchResource ) const
+{
+	// Create a resource from patch data
+	std::filesystem::path resourceLatestRelativePath;
+	Result getResourceLatestRelativePathResult = resourceNext->GetRelativePath( resourceLatestRelativePath );
+	if( getResourceLatestRelativePathResult.type != ResultType::SUCCESS )
+	{
+		return getResourceLatestRelativePathResult;
+	}
+
+	PatchResourceInfoParams patchResourceInfoParams;
+	std::string patchFilename = params.patchFileRelativePathPrefix.string() + "." + std::to_string( patchId );
+	patchResourceInfoParams.relativePath = patchFilename;
+	patchResourceInfoParams.targetResourceRelativePath = resourceLatestRelativePath;
+	patchResourceInfoParams.dataOffset = dataOffset;
+	patchResourceInfoParams.sourceOffset = patchSourceOffset;
+	patchResource = new PatchResourceInfo( patchResourceInfoParams );
+
+	return Result{ ResultType::SUCCESS };
+}
+
+void ResourceGroup::ResourceGroupImpl::CreatePatchCaches( const PatchCreateParams& params, std::unique_ptr<ResourceTools::ChunkIndexCache>& indexCache, std::unique_ptr<PatchCache>& patchCache ) const
+{
+	if( !params.indexCacheFolder.empty() )
+	{
+		std::function<void( unsigned int, const std::string& )> cacheCallback = [params]( unsigned int percent, const std::string& msg ) {
+			if( params.statusCallback )
+			{
+				params.statusCallback( StatusLevel::DETAIL, StatusProgressType::PERCENTAGE, percent, msg );
+			}
+		};
+
+		indexCache = std::make_unique<ResourceTools::ChunkIndexCache>( params.indexCacheFolder, params.indexCacheMaxSize, cacheCallback );
+	}
+
+	if( !params.patchCacheFolder.empty() )
+	{
+		std::function<void( unsigned int, const std::string& )> cacheCallback = [params]( unsigned int percent, const std::string& msg ) {
+			if( params.statusCallback )
+			{
+				params.statusCallback( StatusLevel::DETAIL, StatusProgressType::PERCENTAGE, percent, msg );
+			}
+		};
+
+		patchCache = std::make_unique<PatchCache>( params.patchCacheFolder, params.patchCacheMaxSize, cacheCallback );
+	}
+}
+
+Result ResourceGroup::ResourceGroupImpl::CreateResourceGroupPatches( const PatchCreateParams& params, ResourceGroupImpl& resourceGroupPrevious, ResourceGroupImpl& resourceGroupNext, ResourceTools::ChunkIndexCache* indexCache, PatchCache* patchCache, const CrossResourceSources* crossResourceSources, NextResourceChunks* nextResourceChunks, const std::function<Result( PendingPatch& )>& commitPatch ) const
+{
+	size_t resourceCount = resourceGroupNext.m_resourcesParameter.GetSize();
+
+	unsigned int patchThreadCount = params.patchThreadCount ? params.patchThreadCount : std::max( std::thread::hardware_concurrency(), 1u );
+
+	if( patchThreadCount > 1 && resourceCount > 1 )
+	{
+		Result createResourcePatchesResult = CreateResourcePatchesConcurrently( params, resourceGroupPrevious, resourceGroupNext, indexCache, patchCache, crossResourceSources, nextResourceChunks, patchThreadCount, commitPatch );
+
+		if( createResourcePatchesResult.type != ResultType::SUCCESS )
+		{
+			return createResourcePatchesResult;
+		}
+	}
+	else
+	{
+		for( size_t i = 0; i < resourceCount; i++ )
+		{
+			ResourceInfo* resourcePrevious = resourceGroupPrevious.m_resourcesParameter.At( i );
+
+			ResourceInfo* resourceNext = resourceGroupNext.m_resourcesParameter.At( i );
+
+			auto percentageComplete = static_cast<unsigned int>( ( 100 * i ) / resourceCount );
+
+			Result createResourcePatchesResult = CreateResourcePatchesUsingCache( params, percentageComplete, resourcePrevious, resourceNext, indexCache, patchCache, crossResourceSources, nextResourceChunks, params.indexFolder, commitPatch );
+
+			if( createResourcePatchesResult.type != ResultType::SUCCESS )
+			{
+				return createResourcePatchesResult;
+			}
+		}
+	}
+
+	if( patchCache )
+	{
+		if( params.patchCacheHits )
+		{
+			*params.patchCacheHits = patchCache->GetHits();
+		}
+
+		if( params.patchCacheMisses )
+		{
+			*params.patchCacheMisses = patchCache->GetMisses();
+		}
+	}
+
+	return Result{ ResultType::SUCCESS };
+}
+
+Result ResourceGroup::ResourceGroupImpl::ExportPatch( const PatchCreateParams& params, const ResourceGroupImpl& resourceGroupNext, PatchResourceGroup::PatchResourceGroupImpl& patchResourceGroup ) const
+{
+	// Export the subtraction ResourceGroup
+	std::string resourceGroupData;
+
+	Result exportResourceGroupSubtractionLatestResult = resourceGroupNext.ExportToData( resourceGroupData );
+
+	if( exportResourceGroupSubtractionLatestResult.type != ResultType::SUCCESS )
+	{
+		return exportResourceGroupSubtractionLatestResult;
+	}
+
+	ResourceGroupInfo subtractionResourceGroupInfo( { params.resourceGroupRelativePath } );
+
+	Result setParametersFromDataResult = subtractionResourceGroupInfo.SetParametersFromData( resourceGroupData );
+
+	if( setParametersFromDataResult.type != ResultType::SUCCESS )
+	{
+		return setParametersFromDataResult;
+	}
+
+	ResourcePutDataParams putDataParams;
+
+	putDataParams.resourceDestinationSettings = params.resourcePatchBinaryDestinationSettings;
+
+	putDataParams.data = &resourceGroupData;
+
+	Result subtractionResourcePutResult = subtractionResourceGroupInfo.PutData( putDataParams );
+
+	if( subtractionResourcePutResult.type != ResultType::SUCCESS )
+	{
+		return subtractionResourcePutResult;
+	}
+
+
+
+	// Export the patchGroup
+	Result setResourceGroupResult = patchResourceGroup.SetResourceGroup( subtractionResourceGroupInfo );
+
+	if( setResourceGroupResult.type != ResultType::SUCCESS )
+	{
+		return setResourceGroupResult;
+	}
+
+	std::string patchResourceGroupData;
+
+	Result exportToDataResult = patchResourceGroup.ExportToData( patchResourceGroupData );
+
+	if( exportToDataResult.type != ResultType::SUCCESS )
+	{
+		return exportToDataResult;
+	}
+
+	PatchResourceGroupInfo patchResourceGroupInfo( { params.resourceGroupPatchRelativePath } );
+
+	Result setPatchParametersFromDataResult = patchResourceGroupInfo.SetParametersFromData( patchResourceGroupData );
+
+	if( setPatchParametersFromDataResult.type != ResultType::SUCCESS )
+	{
+		return setPatchParametersFromDataResult;
+	}
+
+	ResourcePutDataParams patchPutDataParams;
+
+	patchPutDataParams.resourceDestinationSettings = params.resourcePatchResourceGroupDestinationSettings;
+
+	patchPutDataParams.data = &patchResourceGroupData;
+
+	Result patchResourceGroupPutResult = patchResourceGroupInfo.PutData( patchPutDataParams );
+
+	if( patchResourceGroupPutResult.type != ResultType::SUCCESS )
+	{
+		return patchResourceGroupPutResult;
+	}
+
+	return Result{ ResultType::SUCCESS };
+}
+
+Result ResourceGroup::ResourceGroupImpl::CreatePatchFromPreviousBuild( const PatchCreateParams& params, ResourceTools::ChunkIndexCache* indexCache, PatchCache* patchCache, int& patchId, PatchedTransitions* patchedTransitions, NextResourceChunks* nextResourceChunks ) const
+{
+	std::string previousGroupType = params.previousResourceGroup->m_impl->GetType();
+
+	std::string nextGroupType = GetType();
+
+	if( params.previousResourceGroup->m_impl->GetType() != GetType() )
+	{
+		return Result{ ResultType::PATCH_RESOURCE_LIST_MISSMATCH };
+	}
+
+	PatchResourceGroup::PatchResourceGroupImpl patchResourceGroup;
+
+	Result setMaxInputChunkSizeResult = patchResourceGroup.SetMaxInputChunkSize( params.maxInputFileChunkSize );
+
+	if( setMaxInputChunkSizeResult.type != ResultType::SUCCESS )
+	{
+		return setMaxInputChunkSizeResult;
+	}
+
+	// Created resource groups
+
+	std::shared_ptr<ResourceGroupImpl> resourceGroupSubtractionPrevious;
+
+	Result createPreviousResourceGroupResult = CreateResourceGroupFromString( previousGroupType, resourceGroupSubtractionPrevious );
+
+	if( createPreviousResourceGroupResult.type != ResultType::SUCCESS )
+	{
+		return createPreviousResourceGroupResult;
+	}
+
+	std::shared_ptr<ResourceGroupImpl> resourceGroupSubtractionNext;
+
+	Result createNextResourceGroupResult = CreateResourceGroupFromString( nextGroupType, resourceGroupSubtractionNext );
+
+	if( createNextResourceGroupResult.type != ResultType::SUCCESS )
+	{
+		return createNextResourceGroupResult;
+	}
+
+
+	ResourceGroupSubtractionParams resourceGroupSubtractionParams;
+
+	resourceGroupSubtractionParams.subtractResourceGroup = params.previousResourceGroup->m_impl;
+
+	resourceGroupSubtractionParams.result1 = resourceGroupSubtractionPrevious.get();
+
+	resourceGroupSubtractionParams.result2 = resourceGroupSubtractionNext.get();
+
+	resourceGroupSubtractionParams.detectCopies = params.detectResourceCopies;
+
+	resourceGroupSubtractionParams.statusCallback = params.statusCallback;
+
+	// Update status
+	if( params.statusCallback )
+	{
+		params.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 20, "Calculaing resourceGroups delta." );
+	}
+
+	Result subtractionResult = Diff( resourceGroupSubtractionParams );
+
+	if( subtractionResult.type != ResultType::SUCCESS )
 	{
 		return subtractionResult;
 	}
@@ -1362,7 +2983,19 @@ Result ResourceGroup::ResourceGroupImpl::CreatePatch( const PatchCreateParams& p
 		return Result{ ResultType::UNEXPECTED_PATCH_DIFF_ENCOUNTERED };
 	}
 
-	int patchId = 0;
+	std::unique_ptr<CrossResourceSources> crossResourceSources;
+
+	if( params.crossResourceMatching )
+	{
+		crossResourceSources = std::make_unique<CrossResourceSources>();
+
+		Result indexCrossResourceSourcesResult = IndexCrossResourceSources( params, *resourceGroupSubtractionNext, *crossResourceSources );
+
+		if( indexCrossResourceSourcesResult.type != ResultType::SUCCESS )
+		{
+			return indexCrossResourceSourcesResult;
+		}
+	}
 
 	// Update status
 	if( params.statusCallback )
@@ -1370,406 +3003,691 @@ Result ResourceGroup::ResourceGroupImpl::CreatePatch( const PatchCreateParams& p
 		params.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 40, "Generating Patches" );
 	}
 
-	for( int i = 0; i < resourceGroupSubtractionNext->m_resourcesParameter.GetSize(); i++ )
+	// Resources already patched for an earlier previous build reuse those patches, the rest are patched here
+	std::shared_ptr<ResourceGroupImpl> resourceGroupPatchPrevious = resourceGroupSubtractionPrevious;
+
+	std::shared_ptr<ResourceGroupImpl> resourceGroupPatchNext = resourceGroupSubtractionNext;
+
+	// Target relative path to PatchedTransitions key of the resources patched here
+	std::unordered_map<std::string, std::string> transitionKeys;
+
+	if( patchedTransitions )
+	{
+		Result createPatchPreviousResult = CreateResourceGroupFromString( previousGroupType, resourceGroupPatchPrevious );
+
+		if( createPatchPreviousResult.type != ResultType::SUCCESS )
+		{
+			return createPatchPreviousResult;
+		}
+
+		Result createPatchNextResult = CreateResourceGroupFromString( nextGroupType, resourceGroupPatchNext );
+
+		if( createPatchNextResult.type != ResultType::SUCCESS )
+		{
+			return createPatchNextResult;
+		}
+
+		for( size_t i = 0; i < resourceGroupSubtractionNext->m_resourcesParameter.GetSize(); i++ )
+		{
+			ResourceInfo* resourcePrevious = resourceGroupSubtractionPrevious->m_resourcesParameter.At( i );
+
+			ResourceInfo* resourceNext = resourceGroupSubtractionNext->m_resourcesParameter.At( i );
+
+			std::string key;
+
+			Result patchedTransitionKeyResult = PatchedTransitionKey( *resourcePrevious, *resourceNext, key );
+
+			if( patchedTransitionKeyResult.type != ResultType::SUCCESS )
+			{
+				return patchedTransitionKeyResult;
+			}
+
+			std::filesystem::path relativePath;
+
+			Result getRelativePathResult = resourceNext->GetRelativePath( relativePath );
+
+			if( getRelativePathResult.type != ResultType::SUCCESS )
+			{
+				return getRelativePathResult;
+			}
+
+			auto patchedTransition = key.empty() ? patchedTransitions->end() : patchedTransitions->find( key );
+
+			if( patchedTransition != patchedTransitions->end() )
+			{
+				if( params.statusCallback )
+				{
+					std::string message = "Reusing patches for: " + relativePath.string();
+
+					params.statusCallback( CarbonResources::StatusLevel::DETAIL, CarbonResources::StatusProgressType::UNBOUNDED, 0, message );
+				}
+
+				// Reused patches keep their relative path and location, so refer to the patch binaries already saved
+				for( const std::unique_ptr<ResourceInfo>& patch : patchedTransition->second )
+				{
+					ResourceInfo* patchCopy = nullptr;
+
+					Result createPatchCopyResult = CreateResourceFromResource( *patch, patchCopy );
+
+					if( createPatchCopyResult.type != ResultType::SUCCESS )
+					{
+						return createPatchCopyResult;
+					}
+
+					Result addResourceResult = patchResourceGroup.AddResource( patchCopy );
+
+					if( addResourceResult.type != ResultType::SUCCESS )
+					{
+						return addResourceResult;
+					}
+				}
+
+				continue;
+			}
+
+			if( !key.empty() )
+			{
+				transitionKeys[relativePath.generic_string()] = key;
+			}
+
+			ResourceInfo* resourcePatchPrevious = nullptr;
+
+			Result createResourcePatchPreviousResult = CreateResourceFromResource( *resourcePrevious, resourcePatchPrevious );
+
+			if( createResourcePatchPreviousResult.type != ResultType::SUCCESS )
+			{
+				return createResourcePatchPreviousResult;
+			}
+
+			resourceGroupPatchPrevious->AddResource( resourcePatchPrevious );
+
+			ResourceInfo* resourcePatchNext = nullptr;
+
+			Result createResourcePatchNextResult = CreateResourceFromResource( *resourceNext, resourcePatchNext );
+
+			if( createResourcePatchNextResult.type != ResultType::SUCCESS )
+			{
+				return createResourcePatchNextResult;
+			}
+
+			resourceGroupPatchNext->AddResource( resourcePatchNext );
+		}
+	}
+
+	// Patches are numbered and stored in resource order, whichever thread created them
+	std::function<Result( PendingPatch& )> commitPatch = [this, &params, &patchId, &patchResourceGroup, patchedTransitions, &transitionKeys]( PendingPatch& pendingPatch ) {
+		// Owned by patchResourceGroup once committed
+		PatchResourceInfo* patchResource = pendingPatch.patchResource.get();
+
+		Result commitPatchResult = CommitPatch( params, patchId, pendingPatch, patchResourceGroup );
+
+		if( commitPatchResult.type != ResultType::SUCCESS )
+		{
+			return commitPatchResult;
+		}
+
+		patchId++;
+
+		if( !patchedTransitions )
+		{
+			return commitPatchResult;
+		}
+
+		std::filesystem::path targetResourceRelativePath;
+
+		Result getTargetResourceRelativePathResult = patchResource->GetTargetResourceRelativePath( targetResourceRelativePath );
+
+		if( getTargetResourceRelativePathResult.type != ResultType::SUCCESS )
+		{
+			return getTargetResourceRelativePathResult;
+		}
+
+		auto transitionKey = transitionKeys.find( targetResourceRelativePath.generic_string() );
+
+		if( transitionKey == transitionKeys.end() )
+		{
+			return commitPatchResult;
+		}
+
+		ResourceInfo* patchCopy = nullptr;
+
+		Result createPatchCopyResult = CreateResourceFromResource( *patchResource, patchCopy );
+
+		if( createPatchCopyResult.type != ResultType::SUCCESS )
+		{
+			return createPatchCopyResult;
+		}
+
+		( *patchedTransitions )[transitionKey->second].emplace_back( patchCopy );
+
+		return commitPatchResult;
+	};
+
+	Result createResourceGroupPatchesResult = CreateResourceGroupPatches( params, *resourceGroupPatchPrevious, *resourceGroupPatchNext, indexCache, patchCache, crossResourceSources.get(), nextResourceChunks, commitPatch );
+
+	if( createResourceGroupPatchesResult.type != ResultType::SUCCESS )
+	{
+		return createResourceGroupPatchesResult;
+	}
+
+	// Copies are made from the source resource by a single match patch, with no patch data
+	for( const ResourceCopy& resourceCopy : resourceGroupSubtractionParams.copiedResources )
+	{
+		ResourceInfo* resourceNext = nullptr;
+
+		Result createResourceFromResourceResult = CreateResourceFromResource( *resourceCopy.resource, resourceNext );
+
+		if( createResourceFromResourceResult.type != ResultType::SUCCESS )
+		{
+			return createResourceFromResourceResult;
+		}
+
+		resourceGroupSubtractionNext->AddResource( resourceNext );
+
+		PatchResourceInfoParams copyPatchParams;
+
+		Result getRelativePathResult = resourceNext->GetRelativePath( copyPatchParams.targetResourceRelativePath );
+
+		if( getRelativePathResult.type != ResultType::SUCCESS )
+		{
+			return getRelativePathResult;
+		}
+
+		Result getChecksumResult = resourceNext->GetChecksum( copyPatchParams.checksum );
+
+		if( getChecksumResult.type != ResultType::SUCCESS )
+		{
+			return getChecksumResult;
+		}
+
+		Result getUncompressedSizeResult = resourceNext->GetUncompressedSize( copyPatchParams.uncompressedSize );
+
+		if( getUncompressedSizeResult.type != ResultType::SUCCESS )
+		{
+			return getUncompressedSizeResult;
+		}
+
+		copyPatchParams.sourceResourceRelativePath = resourceCopy.sourceRelativePath;
+
+		if( params.statusCallback )
+		{
+			std::string message = ( resourceCopy.isMove ? "Moving " : "Copying " ) + resourceCopy.sourceRelativePath.string() + " to " + copyPatchParams.targetResourceRelativePath.string();
+			params.statusCallback( CarbonResources::StatusLevel::DETAIL, CarbonResources::StatusProgressType::UNBOUNDED, 0, message );
+		}
+
+		PendingPatch pendingPatch;
+
+		pendingPatch.patchResource = std::make_unique<PatchResourceInfo>( copyPatchParams );
+
+		Result commitPatchResult = commitPatch( pendingPatch );
+
+		if( commitPatchResult.type != ResultType::SUCCESS )
+		{
+			return commitPatchResult;
+		}
+	}
+
+	patchResourceGroup.SetRemovedResourceRelativePaths( resourceGroupSubtractionParams.removedResources );
+
+	// Update status
+	if( params.statusCallback )
+	{
+		params.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 60, "Exporting ResourceGroups." );
+	}
+
+	return ExportPatch( params, *resourceGroupSubtractionNext, patchResourceGroup );
+}
+
+
+
+Result ResourceGroup::ResourceGroupImpl::CreatePatch( const PatchCreateParams& params ) const
+{
+	PatchBufferRelease patchBufferRelease;
+
+	// Update status
+	if( params.statusCallback )
+	{
+		params.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 0, "Creating Patch" );
+	}
+
+	std::unique_ptr<ResourceTools::ChunkIndexCache> indexCache;
+
+	std::unique_ptr<PatchCache> patchCache;
+
+	CreatePatchCaches( params, indexCache, patchCache );
+
+	// Patches are numbered across all previous builds so those shared between them keep one name
+	int patchId = 0;
+
+	std::unique_ptr<PatchedTransitions> patchedTransitions;
+
+	std::unique_ptr<NextResourceChunks> nextResourceChunks;
+
+	if( !params.additionalPreviousBuilds.empty() )
 	{
+		patchedTransitions = std::make_unique<PatchedTransitions>();
+
+		nextResourceChunks = std::make_unique<NextResourceChunks>();
+	}
+
+	Result createPatchResult = CreatePatchFromPreviousBuild( params, indexCache.get(), patchCache.get(), patchId, patchedTransitions.get(), nextResourceChunks.get() );
 
-		ResourceInfo* resourcePrevious = resourceGroupSubtractionPrevious->m_resourcesParameter.At( i );
+	if( createPatchResult.type != ResultType::SUCCESS )
+	{
+		return createPatchResult;
+	}
 
-		ResourceInfo* resourceNext = resourceGroupSubtractionNext->m_resourcesParameter.At( i );
+	for( const PatchBaseParams& previousBuild : params.additionalPreviousBuilds )
+	{
+		if( !previousBuild.previousResourceGroup )
+		{
+			return Result{ ResultType::RESOURCE_GROUP_NOT_SET };
+		}
 
+		// Update status
 		if( params.statusCallback )
 		{
-			auto percentageComplete = static_cast<unsigned int>( ( 100 * i ) / resourceGroupSubtractionNext->m_resourcesParameter.GetSize() );
+			params.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 0, "Creating Patch: " + previousBuild.resourceGroupPatchRelativePath.string() );
+		}
+
+		PatchCreateParams previousBuildParams = params;
+
+		previousBuildParams.previousResourceGroup = previousBuild.previousResourceGroup;
+
+		previousBuildParams.resourceSourceSettingsPrevious = previousBuild.resourceSourceSettingsPrevious;
+
+		previousBuildParams.resourceGroupRelativePath = previousBuild.resourceGroupRelativePath;
+
+		previousBuildParams.resourceGroupPatchRelativePath = previousBuild.resourceGroupPatchRelativePath;
+
+		previousBuildParams.additionalPreviousBuilds.clear();
+
+		Result createPreviousBuildPatchResult = CreatePatchFromPreviousBuild( previousBuildParams, indexCache.get(), patchCache.get(), patchId, patchedTransitions.get(), nextResourceChunks.get() );
+
+		if( createPreviousBuildPatchResult.type != ResultType::SUCCESS )
+		{
+			return createPreviousBuildPatchResult;
+		}
+	}
+
+	// Update status
+	if( params.statusCallback )
+	{
+		params.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 100, "Patch Created" );
+	}
+
+	return Result{ ResultType::SUCCESS };
+}
+
+Result ResourceGroup::ResourceGroupImpl::SquashPatches( const PatchSquashParams& params, const std::vector<const PatchResourceGroup::PatchResourceGroupImpl*>& patchResourceGroups ) const
+{
+	PatchBufferRelease patchBufferRelease;
+
+	const PatchCreateParams& createParams = params.patchCreateParams;
+
+	if( createParams.statusCallback )
+	{
+		createParams.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 0, "Squashing Patches" );
+	}
+
+	if( !createParams.previousResourceGroup )
+	{
+		return Result{ ResultType::RESOURCE_GROUP_NOT_SET };
+	}
+
+	ResourceGroupImpl* resourceGroupFirst = createParams.previousResourceGroup->m_impl;
+
+	std::map<std::filesystem::path, ResourceInfo*> previousResources;
+
+	for( ResourceInfo* resource : resourceGroupFirst->m_resourcesParameter )
+	{
+		std::filesystem::path relativePath;
+
+		Result getRelativePathResult = resource->GetRelativePath( relativePath );
+
+		if( getRelativePathResult.type != ResultType::SUCCESS )
+		{
+			return getRelativePathResult;
+		}
+
+		previousResources[relativePath] = resource;
+	}
+
+	// Follow every resource a patch changes or removes through the chain
+	std::vector<std::unique_ptr<ResourceGroupImpl>> chainResourceGroups;
+
+	std::map<std::filesystem::path, SquashedResource> squashedResources;
+
+	for( size_t i = 0; i < patchResourceGroups.size(); i++ )
+	{
+		auto chainResourceGroup = std::make_unique<ResourceGroupImpl>();
+
+		Result loadResourceGroupResult = patchResourceGroups[i]->LoadResourceGroup( params.patchBinarySourceSettings, *chainResourceGroup );
+
+		if( loadResourceGroupResult.type != ResultType::SUCCESS )
+		{
+			return loadResourceGroupResult;
+		}
 
+		for( ResourceInfo* resource : chainResourceGroup->m_resourcesParameter )
+		{
 			std::filesystem::path relativePath;
 
-			Result getRelativePathResult = resourcePrevious->GetRelativePath( relativePath );
+			Result getRelativePathResult = resource->GetRelativePath( relativePath );
 
 			if( getRelativePathResult.type != ResultType::SUCCESS )
 			{
 				return getRelativePathResult;
 			}
 
-			std::string message = "Creating patch for: " + relativePath.string();
+			SquashedResource& squashedResource = squashedResources[relativePath];
+
+			squashedResource.changedBy.push_back( i );
+
+			squashedResource.resourceNext = resource;
+		}
+
+		std::vector<std::filesystem::path> removedResources;
+
+		Result getRemovedResourcesResult = patchResourceGroups[i]->GetRemovedResourceRelativePaths( removedResources );
+
+		if( getRemovedResourcesResult.type != ResultType::SUCCESS )
+		{
+			return getRemovedResourcesResult;
+		}
+
+		for( const std::filesystem::path& relativePath : removedResources )
+		{
+			SquashedResource& squashedResource = squashedResources[relativePath];
+
+			squashedResource.removedBy.push_back( i );
 
-			params.statusCallback( CarbonResources::StatusLevel::DETAIL, CarbonResources::StatusProgressType::PERCENTAGE, percentageComplete, message );
+			squashedResource.resourceNext = nullptr;
 		}
 
-		size_t patchSourceOffset{ 0 };
-		uint64_t patchSourceOffsetDelta{ 0 };
-
-		// Check to see if previous entry contains dummy information
-		// Suggesting that this is a new entry in latest
-		// In which case there is no reason to create a patch
-		// The new entry will be stored with the ResourceGroup related to the PatchResourceGroup
-		uintmax_t previousUncompressedSize;
+		chainResourceGroups.push_back( std::move( chainResourceGroup ) );
+	}
 
-		Result getResourcePreviousCompressedSizeResult = resourcePrevious->GetUncompressedSize( previousUncompressedSize );
+	PatchResourceGroup::PatchResourceGroupImpl patchResourceGroup;
 
-		if( getResourcePreviousCompressedSizeResult.type != ResultType::SUCCESS )
-		{
-			return getResourcePreviousCompressedSizeResult;
-		}
+	Result setMaxInputChunkSizeResult = patchResourceGroup.SetMaxInputChunkSize( createParams.maxInputFileChunkSize );
 
+	if( setMaxInputChunkSizeResult.type != ResultType::SUCCESS )
+	{
+		return setMaxInputChunkSizeResult;
+	}
 
+	std::string groupType = resourceGroupFirst->GetType();
 
-		uintmax_t nextUncompressedSize;
+	// Every resource the squashed patch produces
+	std::shared_ptr<ResourceGroupImpl> resourceGroupNext;
 
-		Result getResourceNextCompressedSizeResult = resourceNext->GetUncompressedSize( nextUncompressedSize );
+	Result createNextResourceGroupResult = CreateResourceGroupFromString( groupType, resourceGroupNext );
 
-		if( getResourceNextCompressedSizeResult.type != ResultType::SUCCESS )
-		{
-			return getResourceNextCompressedSizeResult;
-		}
+	if( createNextResourceGroupResult.type != ResultType::SUCCESS )
+	{
+		return createNextResourceGroupResult;
+	}
 
+	// Resources which are diffed again, from the first previous build to the last next build
+	std::shared_ptr<ResourceGroupImpl> resourceGroupDiffPrevious;
 
-		// If previous size is 0 this suggests that this is a new entry in latest
-		// In which case there is no reason to create a patch
-		if( previousUncompressedSize != 0 )
-		{
-			// Get resource data previous
-			auto previousFileDataStream = std::make_shared<ResourceTools::FileDataStreamIn>( params.maxInputFileChunkSize );
+	Result createDiffPreviousResourceGroupResult = CreateResourceGroupFromString( groupType, resourceGroupDiffPrevious );
 
-			ResourceGetDataStreamParams previousResourceGetDataStreamParams;
+	if( createDiffPreviousResourceGroupResult.type != ResultType::SUCCESS )
+	{
+		return createDiffPreviousResourceGroupResult;
+	}
 
-			previousResourceGetDataStreamParams.resourceSourceSettings = params.resourceSourceSettingsPrevious;
+	std::shared_ptr<ResourceGroupImpl> resourceGroupDiffNext;
 
-			previousResourceGetDataStreamParams.downloadRetrySeconds = params.downloadRetrySeconds;
+	Result createDiffNextResourceGroupResult = CreateResourceGroupFromString( groupType, resourceGroupDiffNext );
 
-			previousResourceGetDataStreamParams.dataStream = previousFileDataStream;
+	if( createDiffNextResourceGroupResult.type != ResultType::SUCCESS )
+	{
+		return createDiffNextResourceGroupResult;
+	}
 
-			Result getPreviousDataStreamResult = resourcePrevious->GetDataStream( previousResourceGetDataStreamParams );
+	int patchId = 0;
 
-			if( getPreviousDataStreamResult.type != ResultType::SUCCESS )
-			{
-				return getPreviousDataStreamResult;
-			}
+	std::function<Result( PendingPatch& )> commitPatch = [this, &createParams, &patchId, &patchResourceGroup]( PendingPatch& pendingPatch ) {
+		Result commitPatchResult = CommitPatch( createParams, patchId, pendingPatch, patchResourceGroup );
 
-			// Get resource data next
-			auto nextFileDataStream = std::make_shared<ResourceTools::FileDataStreamIn>( params.maxInputFileChunkSize );
+		if( commitPatchResult.type == ResultType::SUCCESS )
+		{
+			patchId++;
+		}
 
-			ResourceGetDataStreamParams nextResourceGetDataStreamParams;
+		return commitPatchResult;
+	};
 
-			nextResourceGetDataStreamParams.resourceSourceSettings = params.resourceSourceSettingsNext;
+	std::vector<std::filesystem::path> removedResources;
 
-			nextResourceGetDataStreamParams.dataStream = nextFileDataStream;
+	for( const auto& squashedResourceIter : squashedResources )
+	{
+		const std::filesystem::path& relativePath = squashedResourceIter.first;
 
-			Result getNextDataStreamResult = resourceNext->GetDataStream( nextResourceGetDataStreamParams );
+		const SquashedResource& squashedResource = squashedResourceIter.second;
 
-			if( getNextDataStreamResult.type != ResultType::SUCCESS )
-			{
-				return getNextDataStreamResult;
-			}
+		auto previousResourceIter = previousResources.find( relativePath );
 
-			std::filesystem::path relativePath;
-			Result getRelativePathResult = resourcePrevious->GetRelativePath( relativePath );
-			if( getRelativePathResult.type != ResultType::SUCCESS )
-			{
-				return getRelativePathResult;
-			}
+		ResourceInfo* resourcePrevious = previousResourceIter != previousResources.end() ? previousResourceIter->second : nullptr;
 
-			std::function<void( unsigned int, const std::string& )> callback = [params]( unsigned int percent, const std::string& msg ) {
-				if( params.statusCallback )
-				{
-					params.statusCallback( StatusLevel::DETAIL, StatusProgressType::PERCENTAGE, percent, msg );
-				}
-			};
-			ResourceTools::ChunkIndex index( previousFileDataStream->GetPath(), params.maxInputFileChunkSize, params.indexFolder, callback );
-			if( params.statusCallback )
-			{
-				std::string message = "Generating index for " + relativePath.string();
-				params.statusCallback( StatusLevel::DETAIL, StatusProgressType::PERCENTAGE, 0, message );
-			}
-			index.GenerateChecksumFilter( nextFileDataStream->GetPath() );
-			if( !index.Generate() )
+		if( !squashedResource.resourceNext )
+		{
+			// Nothing to remove if the resource was added within the chain
+			if( resourcePrevious )
 			{
-				std::string message = "Index generation failed for " + relativePath.string();
-				params.statusCallback( StatusLevel::DETAIL, StatusProgressType::PERCENTAGE, 0, message );
+				removedResources.push_back( relativePath );
 			}
 
-			// Process one chunk at a time
-			for( uintmax_t dataOffset = 0; dataOffset < nextUncompressedSize; dataOffset += params.maxInputFileChunkSize )
-			{
-				std::string previousFileData = "";
-
-				if( previousFileDataStream->IsFinished() )
-				{
-					if( previousFileDataStream->Size() > nextFileDataStream->GetCurrentPosition() )
-					{
-						// We ran out of data because we found a chunk match later in the file,
-						// but we can rewind back to where the read stream is in hopes
-						// of getting a good diff, rather than just treating it as new data.
-						previousFileDataStream->StartRead( previousFileDataStream->GetPath() );
-					}
-				}
-
-				// Handling if previous file is smaller than next file
-				// If so then previousFileData will be nothing and
-				// All next data will be used for the patch
-				if( !previousFileDataStream->IsFinished() )
-				{
-					if( !( *previousFileDataStream >> previousFileData ) )
-					{
-						return Result{ ResultType::FAILED_TO_RETRIEVE_CHUNK_DATA };
-					}
-				}
+			continue;
+		}
 
-				size_t nextStreamPosition = nextFileDataStream->GetCurrentPosition();
-				// Note: in the case that the next file is smaller than previous
-				// nothing is stored, application of the patch will chop off the extra file data
-				std::string nextFileData;
+		if( resourcePrevious )
+		{
+			std::string previousChecksum;
 
-				if( !nextFileDataStream->IsFinished() )
-				{
-					if( !( *nextFileDataStream >> nextFileData ) )
-					{
-						return Result{ ResultType::FAILED_TO_RETRIEVE_CHUNK_DATA };
-					}
-				}
+			Result getPreviousChecksumResult = resourcePrevious->GetChecksum( previousChecksum );
 
-				// Create a patch
-				// Create a patch from the data
-				std::string patchData;
+			if( getPreviousChecksumResult.type != ResultType::SUCCESS )
+			{
+				return getPreviousChecksumResult;
+			}
 
-				bool chunkMatchFound{ false };
-				size_t matchCount{ 0 };
+			std::string nextChecksum;
 
+			Result getNextChecksumResult = squashedResource.resourceNext->GetChecksum( nextChecksum );
 
-				if( previousFileData != "" )
-				{
-					// Here's how this should work:
-					// We find a matching chunk if it exists. If the chunk exists we make a patch with no data, because we'll get
-					// the data from the source file using the patch info. Consecutive patches should be collapsed into one big one.
-					// If we can't find a matching chunk, we will base the current diff off the chunk in the source starting after the final byte
-					// in the chunk from the source file that we last used.
-					// These should keep our patches pretty minimal, even if lots of data gets added early in the file causing offsets.
-					// It should also handle small changes in moved parts of the file pretty well.
-					if( params.statusCallback )
-					{
-						unsigned int progress = static_cast<uint32_t>( ( dataOffset * 100 ) / nextUncompressedSize );
-						std::stringstream ss;
-						ss << "Generating patch files: " << relativePath.string();
-						params.statusCallback( StatusLevel::DETAIL, StatusProgressType::PERCENTAGE, progress, ss.str() );
-					}
+			if( getNextChecksumResult.type != ResultType::SUCCESS )
+			{
+				return getNextChecksumResult;
+			}
 
-					chunkMatchFound = index.FindMatchingChunk( nextFileData, patchSourceOffset );
+			// Changed back to how it was in the first previous build
+			if( previousChecksum == nextChecksum )
+			{
+				continue;
+			}
+		}
 
-					if( chunkMatchFound )
-					{
-						matchCount = 1;
-						matchCount += ResourceTools::CountMatchingChunks(
-							nextFileDataStream->GetPath(),
-							nextFileDataStream->GetCurrentPosition(),
-							previousFileDataStream->GetPath(),
-							patchSourceOffset + params.maxInputFileChunkSize,
-							params.maxInputFileChunkSize );
+		ResourceInfo* resourceNext = nullptr;
 
-						size_t matchSize = std::min( params.maxInputFileChunkSize * matchCount, previousFileDataStream->Size() - patchSourceOffset );
+		Result createResourceFromResourceResult = CreateResourceFromResource( *squashedResource.resourceNext, resourceNext );
 
-						PatchResourceInfo* patchResource{ nullptr };
+		if( createResourceFromResourceResult.type != ResultType::SUCCESS )
+		{
+			return createResourceFromResourceResult;
+		}
 
-						ConstructPatchResourceInfo( params, patchId, dataOffset, patchSourceOffset, resourceNext, patchResource );
+		resourceGroupNext->AddResource( resourceNext );
 
-						if( previousFileDataStream->IsFinished() )
-						{
-							previousFileDataStream->StartRead( previousFileDataStream->GetPath() );
-						}
+		// A resource changed by a single patch was left as in the first previous build before it, so its patches still apply
+		bool reusePatches = squashedResource.changedBy.size() == 1 && squashedResource.removedBy.empty();
 
-						previousFileDataStream->Seek( patchSourceOffset );
+		std::vector<const PatchResourceInfo*> patches;
 
-						patchResource->SetParametersFromSourceStream( *previousFileDataStream, matchSize );
+		if( reusePatches )
+		{
+			size_t patchIndex = squashedResource.changedBy.front();
 
-						// Advance the first stream by the size of the matching data,
-						// but move the point we generate patches from for the previous
-						// file data stream to the end of the match.
-						// It's hard to tell if it would be smarter to simply advance
-						// the destination data by the same amount of the source data,
-						// or perhaps even not to move it at all.
-						nextFileDataStream->Seek( std::min( nextFileDataStream->Size(), nextStreamPosition + matchSize ) );
+			const PatchResourceGroup::PatchResourceGroupImpl* chainPatchResourceGroup = patchResourceGroups[patchIndex];
 
-						previousFileDataStream->Seek( std::min( previousFileDataStream->Size(), patchSourceOffset + matchSize ) );
+			uintmax_t maxInputChunkSize;
 
-						dataOffset += matchSize - params.maxInputFileChunkSize;
+			Result getMaxInputChunkSizeResult = chainPatchResourceGroup->GetMaxInputChunkSize( maxInputChunkSize );
 
-						patchSourceOffset += matchSize;
+			if( getMaxInputChunkSizeResult.type != ResultType::SUCCESS )
+			{
+				return getMaxInputChunkSizeResult;
+			}
 
-						if( nextStreamPosition == 0 && patchSourceOffset == 0 )
-						{
-							// This is the beginning of the file and it matches.
-							// There is no need to write patch data.
-							continue;
-						}
+			// Patches are applied a chunk at a time, so chunk offsets only hold for the same chunk size
+			reusePatches = maxInputChunkSize == createParams.maxInputFileChunkSize;
 
-						// Add the patch resource to the patchResourceGroup
-						Result addResourceResult = patchResourceGroup.AddResource( patchResource );
+			Result getTargetResourcePatchesResult = chainPatchResourceGroup->GetTargetResourcePatches( squashedResource.resourceNext, patches );
 
-						if( addResourceResult.type != ResultType::SUCCESS )
-						{
-							delete patchResource;
+			if( getTargetResourcePatchesResult.type != ResultType::SUCCESS )
+			{
+				return getTargetResourcePatchesResult;
+			}
 
-							return addResourceResult;
-						}
+			for( const PatchResourceInfo* patch : patches )
+			{
+				std::filesystem::path sourceResourceRelativePath;
 
-						patchId++;
+				Result getSourceResourceRelativePathResult = patch->GetSourceResourceRelativePath( sourceResourceRelativePath );
 
-						continue;
-					}
-					else
-					{
-						// Previous and next data chunk are different, create a patch
-						if( !ResourceTools::CreatePatch( previousFileData, nextFileData, patchData ) )
-						{
-							return Result{ ResultType::FAILED_TO_CREATE_PATCH };
-						}
-						patchSourceOffsetDelta = previousFileData.size();
-					}
-				}
-				else
+				if( getSourceResourceRelativePathResult.type == ResultType::RESOURCE_VALUE_NOT_SET )
 				{
-					// If there is no previous data then just store the data straight from the file
-					// All this data is new
-					if( !ResourceTools::CreatePatch( "", nextFileData, patchData ) )
-					{
-						return Result{ ResultType::FAILED_TO_CREATE_PATCH };
-					}
-					patchSourceOffsetDelta = nextFileData.size();
+					continue;
 				}
 
-				PatchResourceInfo* patchResource{ nullptr };
-				ConstructPatchResourceInfo( params, patchId, dataOffset, patchSourceOffset, resourceNext, patchResource );
-				patchSourceOffset += patchSourceOffsetDelta;
-				if( !patchData.empty() )
+				if( getSourceResourceRelativePathResult.type != ResultType::SUCCESS )
 				{
-					Result setParametersFromDataResult = patchResource->SetParametersFromData( patchData, params.calculateCompressions );
+					return getSourceResourceRelativePathResult;
+				}
 
-					if( setParametersFromDataResult.type != ResultType::SUCCESS )
-					{
-						return setParametersFromDataResult;
-					}
+				// Another resource taken data from must be as in the first previous build until the squashed patch is applied.
+				// Removals happen after patching, so it may be removed by this patch or a later one.
+				auto sourceIter = squashedResources.find( sourceResourceRelativePath );
 
-					// Export patch file
-					ResourcePutDataParams resourcePutDataParams;
+				if( sourceIter != squashedResources.end() && ( !sourceIter->second.changedBy.empty() || sourceIter->second.removedBy.front() < patchIndex ) )
+				{
+					reusePatches = false;
+				}
+			}
+		}
 
-					resourcePutDataParams.resourceDestinationSettings = params.resourcePatchBinaryDestinationSettings;
+		if( reusePatches )
+		{
+			if( createParams.statusCallback )
+			{
+				std::string message = "Reusing patches for: " + relativePath.string();
 
-					resourcePutDataParams.data = &patchData;
+				createParams.statusCallback( CarbonResources::StatusLevel::DETAIL, CarbonResources::StatusProgressType::UNBOUNDED, 0, message );
+			}
 
-					Result putPatchDataResult = patchResource->PutData( resourcePutDataParams );
+			for( const PatchResourceInfo* patch : patches )
+			{
+				PendingPatch pendingPatch;
 
-					if( putPatchDataResult.type != ResultType::SUCCESS )
-					{
-						delete patchResource;
+				Result copyPatchResult = CopyPatch( createParams, *patch, params.patchBinarySourceSettings, pendingPatch );
 
-						return putPatchDataResult;
-					}
+				if( copyPatchResult.type != ResultType::SUCCESS )
+				{
+					return copyPatchResult;
 				}
 
-				// Add the patch resource to the patchResourceGroup
-				Result addResourceResult = patchResourceGroup.AddResource( patchResource );
+				Result commitPatchResult = commitPatch( pendingPatch );
 
-				if( addResourceResult.type != ResultType::SUCCESS )
+				if( commitPatchResult.type != ResultType::SUCCESS )
 				{
-					delete patchResource;
-
-					return addResourceResult;
+					return commitPatchResult;
 				}
-
-				patchId++;
 			}
-		}
-	}
-
-	patchResourceGroup.SetRemovedResourceRelativePaths( resourceGroupSubtractionParams.removedResources );
 
-	// Update status
-	if( params.statusCallback )
-	{
-		params.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 60, "Exporting ResourceGroups." );
-	}
+			continue;
+		}
 
-	// Export the subtraction ResourceGroup
-	std::string resourceGroupData;
+		ResourceInfo* resourceDiffNext = nullptr;
 
-	Result exportResourceGroupSubtractionLatestResult = resourceGroupSubtractionNext->ExportToData( resourceGroupData );
+		Result createResourceDiffNextResult = CreateResourceFromResource( *squashedResource.resourceNext, resourceDiffNext );
 
-	if( exportResourceGroupSubtractionLatestResult.type != ResultType::SUCCESS )
-	{
-		return exportResourceGroupSubtractionLatestResult;
-	}
+		if( createResourceDiffNextResult.type != ResultType::SUCCESS )
+		{
+			return createResourceDiffNextResult;
+		}
 
-	ResourceGroupInfo subtractionResourceGroupInfo( { params.resourceGroupRelativePath } );
+		resourceGroupDiffNext->AddResource( resourceDiffNext );
 
-	Result setParametersFromDataResult = subtractionResourceGroupInfo.SetParametersFromData( resourceGroupData );
+		ResourceInfo* resourceDiffPrevious = nullptr;
 
-	if( setParametersFromDataResult.type != ResultType::SUCCESS )
-	{
-		return setParametersFromDataResult;
-	}
+		if( resourcePrevious )
+		{
+			Result createResourceDiffPreviousResult = CreateResourceFromResource( *resourcePrevious, resourceDiffPrevious );
 
-	ResourcePutDataParams putDataParams;
+			if( createResourceDiffPreviousResult.type != ResultType::SUCCESS )
+			{
+				return createResourceDiffPreviousResult;
+			}
+		}
+		else
+		{
+			// Dummy entry showing the resource is new, as made by Diff
+			ResourceInfoParams dummyResourceParams;
 
-	putDataParams.resourceDestinationSettings = params.resourcePatchBinaryDestinationSettings;
+			dummyResourceParams.relativePath = relativePath;
 
-	putDataParams.data = &resourceGroupData;
+			resourceDiffPrevious = new ResourceInfo( dummyResourceParams );
+		}
 
-	Result subtractionResourcePutResult = subtractionResourceGroupInfo.PutData( putDataParams );
+		resourceGroupDiffPrevious->AddResource( resourceDiffPrevious );
+	}
 
-	if( subtractionResourcePutResult.type != ResultType::SUCCESS )
+	// Update status
+	if( createParams.statusCallback )
 	{
-		return subtractionResourcePutResult;
+		createParams.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 40, "Generating Patches" );
 	}
 
+	std::unique_ptr<ResourceTools::ChunkIndexCache> indexCache;
 
+	std::unique_ptr<PatchCache> patchCache;
 
-	// Export the patchGroup
-	Result setResourceGroupResult = patchResourceGroup.SetResourceGroup( subtractionResourceGroupInfo );
-
-	if( setResourceGroupResult.type != ResultType::SUCCESS )
-	{
-		return setResourceGroupResult;
-	}
-
-	std::string patchResourceGroupData;
+	CreatePatchCaches( createParams, indexCache, patchCache );
 
-	Result exportToDataResult = patchResourceGroup.ExportToData( patchResourceGroupData );
+	Result createResourceGroupPatchesResult = CreateResourceGroupPatches( createParams, *resourceGroupDiffPrevious, *resourceGroupDiffNext, indexCache.get(), patchCache.get(), nullptr, nullptr, commitPatch );
 
-	if( exportToDataResult.type != ResultType::SUCCESS )
+	if( createResourceGroupPatchesResult.type != ResultType::SUCCESS )
 	{
-		return exportToDataResult;
+		return createResourceGroupPatchesResult;
 	}
 
-	PatchResourceGroupInfo patchResourceGroupInfo( { params.resourceGroupPatchRelativePath } );
-
-	Result setPatchParametersFromDataResult = patchResourceGroupInfo.SetParametersFromData( patchResourceGroupData );
+	patchResourceGroup.SetRemovedResourceRelativePaths( removedResources );
 
-	if( setPatchParametersFromDataResult.type != ResultType::SUCCESS )
+	// Update status
+	if( createParams.statusCallback )
 	{
-		return setPatchParametersFromDataResult;
+		createParams.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 60, "Exporting ResourceGroups." );
 	}
 
-	ResourcePutDataParams patchPutDataParams;
-
-	patchPutDataParams.resourceDestinationSettings = params.resourcePatchResourceGroupDestinationSettings;
-
-	patchPutDataParams.data = &patchResourceGroupData;
-
-	Result patchResourceGroupPutResult = patchResourceGroupInfo.PutData( patchPutDataParams );
+	Result exportPatchResult = ExportPatch( createParams, *resourceGroupNext, patchResourceGroup );
 
-	if( patchResourceGroupPutResult.type != ResultType::SUCCESS )
+	if( exportPatchResult.type != ResultType::SUCCESS )
 	{
-		return patchResourceGroupPutResult;
+		return exportPatchResult;
 	}
 
 	// Update status
-	if( params.statusCallback )
+	if( createParams.statusCallback )
 	{
-		params.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 100, "Patch Created" );
+		createParams.statusCallback( CarbonResources::StatusLevel::PROCEDURE, CarbonResources::StatusProgressType::PERCENTAGE, 100, "Patches Squashed" );
 	}
 
 	return Result{ ResultType::SUCCESS };
 }
 
-
 Result ResourceGroup::ResourceGroupImpl::AddResource( ResourceInfo* resource )
 {
 	m_resourcesParameter.PushBack( resource );
@@ -1954,6 +3872,8 @@ Result ResourceGroup::ResourceGroupImpl::DiffChangesAsLists( const ResourceGroup
 
 	subtractionParams.result2 = result2.m_impl;
 
+	subtractionParams.detectCopies = params.moves && params.copies;
+
 	Result diffResult = Diff( subtractionParams );
 
 	if( diffResult.type != ResultType::SUCCESS )
@@ -1961,9 +3881,38 @@ Result ResourceGroup::ResourceGroupImpl::DiffChangesAsLists( const ResourceGroup
 		return diffResult;
 	}
 
+	// Moved resources are reported as moves rather than a subtraction and an addition
+	std::set<std::filesystem::path> movedResources;
+
+	for( const ResourceCopy& resourceCopy : subtractionParams.copiedResources )
+	{
+		std::filesystem::path relativePath;
+
+		Result getRelativePathResult = resourceCopy.resource->GetRelativePath( relativePath );
+
+		if( getRelativePathResult.type != ResultType::SUCCESS )
+		{
+			return getRelativePathResult;
+		}
+
+		if( resourceCopy.isMove )
+		{
+			params.moves->emplace_back( resourceCopy.sourceRelativePath, relativePath );
+
+			movedResources.insert( resourceCopy.sourceRelativePath );
+		}
+		else
+		{
+			params.copies->emplace_back( resourceCopy.sourceRelativePath, relativePath );
+		}
+	}
+
 	for( auto removedResource : subtractionParams.removedResources )
 	{
-		params.subtractions->push_back( removedResource );
+		if( movedResources.find( removedResource ) == movedResources.end() )
+		{
+			params.subtractions->push_back( removedResource );
+		}
 	}
 
 	for( auto resource : result1.m_impl->m_resourcesParameter )
@@ -2015,6 +3964,8 @@ Result ResourceGroup::ResourceGroupImpl::Diff( ResourceGroupSubtractionParams& p
 		[]( const ResourceInfo* a, const ResourceInfo* b ) { return *a < *b; } );
 
 	std::vector<ResourceInfo*> potentiallyModifiedResources;
+
+	std::set<const ResourceInfo*> modifiedResources;
 	std::set_intersection(
 		sortedResourcesParameter.begin(), sortedResourcesParameter.end(),
 		sortedSubtractionResources.begin(), sortedSubtractionResources.end(),
@@ -2092,6 +4043,46 @@ Result ResourceGroup::ResourceGroupImpl::Diff( ResourceGroupSubtractionParams& p
 			}
 
 			params.result1->AddResource( resourceCopy2 );
+
+			modifiedResources.insert( resource2 );
+		}
+	}
+
+	// Previous resources which are left unchanged or removed by checksum, a new resource with the same data is a copy of one
+	std::multimap<std::string, const ResourceInfo*> copySources;
+
+	std::set<const ResourceInfo*> removedResourceSet( removedResources.begin(), removedResources.end() );
+
+	std::set<const ResourceInfo*> movedResources;
+
+	if( params.detectCopies )
+	{
+		for( const ResourceInfo* resource : sortedSubtractionResources )
+		{
+			uintmax_t uncompressedSize;
+
+			Result getUncompressedSizeResult = resource->GetUncompressedSize( uncompressedSize );
+
+			if( getUncompressedSizeResult.type != ResultType::SUCCESS )
+			{
+				return getUncompressedSizeResult;
+			}
+
+			if( uncompressedSize == 0 || modifiedResources.find( resource ) != modifiedResources.end() )
+			{
+				continue;
+			}
+
+			std::string checksum;
+
+			Result getChecksumResult = resource->GetChecksum( checksum );
+
+			if( getChecksumResult.type != ResultType::SUCCESS )
+			{
+				return getChecksumResult;
+			}
+
+			copySources.emplace( checksum, resource );
 		}
 	}
 
@@ -2114,6 +4105,52 @@ Result ResourceGroup::ResourceGroupImpl::Diff( ResourceGroupSubtractionParams& p
 			i++;
 		}
 
+		if( !copySources.empty() )
+		{
+			std::string checksum;
+
+			Result getChecksumResult = resource->GetChecksum( checksum );
+
+			if( getChecksumResult.type != ResultType::SUCCESS )
+			{
+				return getChecksumResult;
+			}
+
+			auto sources = copySources.equal_range( checksum );
+
+			if( sources.first != sources.second )
+			{
+				// Prefer moving a removed resource that hasn't been moved yet
+				const ResourceInfo* source = sources.first->second;
+
+				for( auto sourceIter = sources.first; sourceIter != sources.second; sourceIter++ )
+				{
+					if( removedResourceSet.find( sourceIter->second ) != removedResourceSet.end() && movedResources.find( sourceIter->second ) == movedResources.end() )
+					{
+						source = sourceIter->second;
+						break;
+					}
+				}
+
+				ResourceCopy resourceCopy;
+
+				Result getSourceRelativePathResult = source->GetRelativePath( resourceCopy.sourceRelativePath );
+
+				if( getSourceRelativePathResult.type != ResultType::SUCCESS )
+				{
+					return getSourceRelativePathResult;
+				}
+
+				resourceCopy.resource = resource;
+
+				resourceCopy.isMove = removedResourceSet.find( source ) != removedResourceSet.end() && movedResources.insert( source ).second;
+
+				params.copiedResources.push_back( resourceCopy );
+
+				continue;
+			}
+		}
+
 		ResourceInfo* resourceCopy1 = nullptr;
 
 		Result createResourceFromResourceResult = CreateResourceFromResource( *resource, resourceCopy1 );
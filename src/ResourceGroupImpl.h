@@ -5,14 +5,19 @@
 #define ResourceGroupImpl_H
 
 #include <BundleStreamOut.h>
+#include <ContentDefinedChunking.h>
 #include "ResourceGroup.h"
 #include "ResourceInfo/ResourceInfo.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "VersionInternal.h"
 #include "ResourceInfo/PatchResourceInfo.h"
 
 #include "BundleResourceGroup.h"
+#include "PatchResourceGroup.h"
 
 namespace YAML
 {
@@ -20,8 +25,31 @@ class Emitter;
 class Node;
 }
 
+namespace ResourceTools
+{
+class ChunkIndexCache;
+class FileDataStreamIn;
+struct TargetChunkChecksums;
+}
+
 namespace CarbonResources
 {
+class PatchCache;
+
+// A new resource with the same data as a previous resource which is left unchanged or removed
+struct ResourceCopy
+{
+	std::filesystem::path sourceRelativePath;
+
+	const ResourceInfo* resource = nullptr;
+
+	// The source is removed and this is the first copy of it
+	bool isMove = false;
+};
+
+// Patches committed while patching from one previous build, kept for later previous builds of the same CreatePatch.
+// Keyed by the resource relative path and the checksums of both of its versions.
+using PatchedTransitions = std::unordered_map<std::string, std::vector<std::unique_ptr<ResourceInfo>>>;
 
 struct ResourceGroupSubtractionParams
 {
@@ -33,9 +61,55 @@ struct ResourceGroupSubtractionParams
 
 	std::vector<std::filesystem::path> removedResources;
 
+	// Detect new resources identical to a previous resource, these are listed in copiedResources instead of result1 and result2
+	bool detectCopies = false;
+
+	std::vector<ResourceCopy> copiedResources;
+
 	StatusCallback statusCallback = nullptr;
 };
 
+// A patch created for a resource which is yet to be numbered and added to the PatchResourceGroup
+struct PendingPatch
+{
+	std::unique_ptr<PatchResourceInfo> patchResource;
+
+	std::string patchData;
+};
+
+// Content defined chunks of the previous resources a patch leaves in place, which new resources may take their data from
+struct CrossResourceSources
+{
+	std::vector<std::filesystem::path> relativePaths;
+
+	std::vector<std::filesystem::path> filePaths;
+
+	std::vector<std::vector<ResourceTools::ContentDefinedChunk>> chunks;
+
+	// Start of a chunk hash to the source and chunk index, the first of identical chunks is used
+	std::unordered_map<uint64_t, std::pair<size_t, size_t>> chunkLocations;
+};
+
+// Chunk data of the next resources, generated while patching from the first previous build of a CreatePatch
+// and reused for every other previous build, so each next resource is read, hashed and chunked once.
+// Keyed by the checksum of the next resource, shared by all patch worker threads.
+class NextResourceChunks
+{
+public:
+	// Checksums of the chunkSize chunks of the next resource, generated from nextFilePath if not already known
+	std::shared_ptr<const ResourceTools::TargetChunkChecksums> GetTargetChunkChecksums( const std::string& checksum, const std::filesystem::path& nextFilePath, uint32_t chunkSize );
+
+	// Content defined chunks of the next resource, generated from nextFilePath if not already known
+	std::shared_ptr<const std::vector<ResourceTools::ContentDefinedChunk>> GetContentDefinedChunks( const std::string& checksum, const std::filesystem::path& nextFilePath, const ResourceTools::ContentDefinedChunkSizes& chunkSizes );
+
+private:
+	std::mutex m_mutex;
+
+	std::unordered_map<std::string, std::shared_ptr<const ResourceTools::TargetChunkChecksums>> m_targetChunkChecksums;
+
+	std::unordered_map<std::string, std::shared_ptr<const std::vector<ResourceTools::ContentDefinedChunk>>> m_contentDefinedChunks;
+};
+
 enum class DocumentType
 {
 	CSV,
@@ -120,7 +194,34 @@ private:
 
 	Result RemoveResource( ResourceInfo& relativePath );
 
+	Result CreateResourcePatches( const PatchCreateParams& params, unsigned int percentageComplete, ResourceInfo* resourcePrevious, ResourceInfo* resourceNext, ResourceTools::ChunkIndexCache* indexCache, const CrossResourceSources* crossResourceSources, NextResourceChunks* nextResourceChunks, const std::filesystem::path& indexFolder, const std::function<Result( PendingPatch& )>& onPatch ) const;
+
+	Result CreateResourcePatchesUsingCache( const PatchCreateParams& params, unsigned int percentageComplete, ResourceInfo* resourcePrevious, ResourceInfo* resourceNext, ResourceTools::ChunkIndexCache* indexCache, PatchCache* patchCache, const CrossResourceSources* crossResourceSources, NextResourceChunks* nextResourceChunks, const std::filesystem::path& indexFolder, const std::function<Result( PendingPatch& )>& onPatch ) const;
+
+	Result CreateResourcePatchesConcurrently( const PatchCreateParams& params, ResourceGroupImpl& resourceGroupPrevious, ResourceGroupImpl& resourceGroupNext, ResourceTools::ChunkIndexCache* indexCache, PatchCache* patchCache, const CrossResourceSources* crossResourceSources, NextResourceChunks* nextResourceChunks, unsigned int threadCount, const std::function<Result( PendingPatch& )>& commitPatch ) const;
+
+	Result CreateContentDefinedPatches( const PatchCreateParams& params, const std::filesystem::path& relativePath, ResourceInfo* resourceNext, NextResourceChunks* nextResourceChunks, ResourceTools::FileDataStreamIn& previousFileDataStream, ResourceTools::FileDataStreamIn& nextFileDataStream, const std::function<Result( PendingPatch& )>& onPatch ) const;
+
+	Result IndexCrossResourceSources( const PatchCreateParams& params, const ResourceGroupImpl& resourceGroupNext, CrossResourceSources& crossResourceSources ) const;
+
+	Result CreateCrossResourcePatches( const PatchCreateParams& params, ResourceInfo* resourceNext, const CrossResourceSources& crossResourceSources, const std::function<Result( PendingPatch& )>& onPatch ) const;
+
+	Result CreateChunkPatch( const PatchCreateParams& params, const std::string& previousData, const std::string& nextData, PendingPatch& pendingPatch ) const;
+
+	Result CommitPatch( const PatchCreateParams& params, int patchId, PendingPatch& pendingPatch, PatchResourceGroup::PatchResourceGroupImpl& patchResourceGroup ) const;
+
+	void CreatePatchCaches( const PatchCreateParams& params, std::unique_ptr<ResourceTools::ChunkIndexCache>& indexCache, std::unique_ptr<PatchCache>& patchCache ) const;
+
+	Result CreateResourceGroupPatches( const PatchCreateParams& params, ResourceGroupImpl& resourceGroupPrevious, ResourceGroupImpl& resourceGroupNext, ResourceTools::ChunkIndexCache* indexCache, PatchCache* patchCache, const CrossResourceSources* crossResourceSources, NextResourceChunks* nextResourceChunks, const std::function<Result( PendingPatch& )>& commitPatch ) const;
+
+	Result ExportPatch( const PatchCreateParams& params, const ResourceGroupImpl& resourceGroupNext, PatchResourceGroup::PatchResourceGroupImpl& patchResourceGroup ) const;
+
+	Result CreatePatchFromPreviousBuild( const PatchCreateParams& params, ResourceTools::ChunkIndexCache* indexCache, PatchCache* patchCache, int& patchId, PatchedTransitions* patchedTransitions, NextResourceChunks* nextResourceChunks ) const;
+
 protected:
+	// Create a single patch equivalent to applying patchResourceGroups in order
+	Result SquashPatches( const PatchSquashParams& params, const std::vector<const PatchResourceGroup::PatchResourceGroupImpl*>& patchResourceGroups ) const;
+
 	// Document Parameters
 	DocumentParameter<VersionInternal> m_versionParameter = DocumentParameter<VersionInternal>( VERSION, TypeId() );
 
@@ -22,6 +22,10 @@ PatchResourceInfo::PatchResourceInfo( const PatchResourceInfoParams& params ) :
 
 	m_sourceOffset = params.sourceOffset;
 
+	SetSourceResourceRelativePath( params.sourceResourceRelativePath );
+
+	SetDiffEngine( params.diffEngine );
+
 	m_type = TypeId();
 }
 
@@ -70,6 +74,58 @@ Result PatchResourceInfo::GetSourceOffset( uintmax_t& sourceOffset ) const
 	}
 }
 
+Result PatchResourceInfo::GetSourceResourceRelativePath( std::filesystem::path& sourceResourceRelativePath ) const
+{
+	if( !m_sourceResourceRelativePath.HasValue() )
+	{
+		return Result{ ResultType::RESOURCE_VALUE_NOT_SET };
+	}
+	else
+	{
+		sourceResourceRelativePath = m_sourceResourceRelativePath.GetValue();
+
+		return Result{ ResultType::SUCCESS };
+	}
+}
+
+void PatchResourceInfo::SetSourceResourceRelativePath( const std::filesystem::path& sourceResourceRelativePath )
+{
+	if( !sourceResourceRelativePath.empty() )
+	{
+		m_sourceResourceRelativePath = sourceResourceRelativePath;
+	}
+	else
+	{
+		m_sourceResourceRelativePath.Reset();
+	}
+}
+
+Result PatchResourceInfo::GetDiffEngine( std::string& diffEngine ) const
+{
+	if( !m_diffEngine.HasValue() )
+	{
+		return Result{ ResultType::RESOURCE_VALUE_NOT_SET };
+	}
+	else
+	{
+		diffEngine = m_diffEngine.GetValue();
+
+		return Result{ ResultType::SUCCESS };
+	}
+}
+
+void PatchResourceInfo::SetDiffEngine( const std::string& diffEngine )
+{
+	if( !diffEngine.empty() )
+	{
+		m_diffEngine = diffEngine;
+	}
+	else
+	{
+		m_diffEngine.Reset();
+	}
+}
+
 Result PatchResourceInfo::ImportFromYaml( YAML::Node& resource, const VersionInternal& documentVersion )
 {
 	Result result = SetParameterFromYamlNode( resource, m_targetResourceRelativepath, TypeId(), documentVersion );
@@ -90,6 +146,24 @@ Result PatchResourceInfo::ImportFromYaml( YAML::Node& resource, const VersionInt
 		return result;
 	}
 
+	if( m_sourceResourceRelativePath.IsParameterExpectedInDocumentVersion( documentVersion ) )
+	{
+		YAML::Node parameter = resource[m_sourceResourceRelativePath.GetTag()];
+		if( parameter.IsDefined() )
+		{
+			m_sourceResourceRelativePath = parameter.as<std::string>();
+		}
+	}
+
+	if( m_diffEngine.IsParameterExpectedInDocumentVersion( documentVersion ) )
+	{
+		YAML::Node parameter = resource[m_diffEngine.GetTag()];
+		if( parameter.IsDefined() )
+		{
+			m_diffEngine = parameter.as<std::string>();
+		}
+	}
+
 	return ResourceInfo::ImportFromYaml( resource, documentVersion );
 }
 
@@ -138,6 +212,28 @@ Result PatchResourceInfo::ExportToYaml( YAML::Emitter& out, const VersionInterna
 		out << YAML::Value << m_sourceOffset.GetValue();
 	}
 
+	// Source resource relative path
+	if( m_sourceResourceRelativePath.IsParameterExpectedInDocumentVersion( documentVersion ) )
+	{
+		// This is an optional field
+		if( m_sourceResourceRelativePath.HasValue() )
+		{
+			out << YAML::Key << m_sourceResourceRelativePath.GetTag();
+			out << YAML::Value << m_sourceResourceRelativePath.GetValue().string();
+		}
+	}
+
+	// Diff engine
+	if( m_diffEngine.IsParameterExpectedInDocumentVersion( documentVersion ) )
+	{
+		// This is an optional field, absent for bsdiff
+		if( m_diffEngine.HasValue() )
+		{
+			out << YAML::Key << m_diffEngine.GetTag();
+			out << YAML::Value << m_diffEngine.GetValue();
+		}
+	}
+
 	return Result{ ResultType::SUCCESS };
 }
 
@@ -188,6 +284,54 @@ Result PatchResourceInfo::SetParametersFromResource( const ResourceInfo* other,
 		m_targetResourceRelativepath = targetResourceRelativePath;
 	}
 
+	if( m_sourceResourceRelativePath.IsParameterExpectedInDocumentVersion( documentVersion ) )
+	{
+		std::filesystem::path sourceResourceRelativePath;
+
+		Result getSourceResourceRelativePathResult = otherAsPatch->GetSourceResourceRelativePath( sourceResourceRelativePath );
+
+		if( getSourceResourceRelativePathResult.type == ResultType::SUCCESS )
+		{
+			m_sourceResourceRelativePath = sourceResourceRelativePath;
+		}
+		else
+		{
+			// Source resource is optional, value may not be set
+			if( getSourceResourceRelativePathResult.type != ResultType::RESOURCE_VALUE_NOT_SET )
+			{
+				return getSourceResourceRelativePathResult;
+			}
+			else
+			{
+				m_sourceResourceRelativePath.Reset();
+			}
+		}
+	}
+
+	if( m_diffEngine.IsParameterExpectedInDocumentVersion( documentVersion ) )
+	{
+		std::string diffEngine;
+
+		Result getDiffEngineResult = otherAsPatch->GetDiffEngine( diffEngine );
+
+		if( getDiffEngineResult.type == ResultType::SUCCESS )
+		{
+			m_diffEngine = diffEngine;
+		}
+		else
+		{
+			// Diff engine is optional, value may not be set
+			if( getDiffEngineResult.type != ResultType::RESOURCE_VALUE_NOT_SET )
+			{
+				return getDiffEngineResult;
+			}
+			else
+			{
+				m_diffEngine.Reset();
+			}
+		}
+	}
+
 	return ResourceInfo::SetParametersFromResource( other, documentVersion );
 }
 
@@ -15,6 +15,12 @@ struct PatchResourceInfoParams : public ResourceGroupInfoParams
 	uintmax_t dataOffset = 0;
 
 	uintmax_t sourceOffset = 0;
+
+	// Previous resource the source offset refers to, empty for the previous version of the target resource
+	std::filesystem::path sourceResourceRelativePath;
+
+	// Name of the diff engine that created the patch data, empty for bsdiff
+	std::string diffEngine;
 };
 
 class ResourceGroup;
@@ -34,6 +40,14 @@ public:
 
 	Result GetSourceOffset( uintmax_t& sourceOffset ) const;
 
+	Result GetSourceResourceRelativePath( std::filesystem::path& sourceResourceRelativePath ) const;
+
+	void SetSourceResourceRelativePath( const std::filesystem::path& sourceResourceRelativePath );
+
+	Result GetDiffEngine( std::string& diffEngine ) const;
+
+	void SetDiffEngine( const std::string& diffEngine );
+
 	virtual Result ImportFromYaml( YAML::Node& resource, const VersionInternal& documentVersion ) override;
 
 	virtual Result ExportToYaml( YAML::Emitter& out, const VersionInternal& documentVersion ) override;
@@ -45,6 +59,10 @@ private:
 	DocumentParameter<uintmax_t> m_sourceOffset = DocumentParameter<uintmax_t>( SOURCE_OFFSET, TypeId() );
 
 	DocumentParameter<std::filesystem::path> m_targetResourceRelativepath = DocumentParameter<std::filesystem::path>( TARGET_RESOURCE_RELATIVE_PATH, TypeId() );
+
+	DocumentParameter<std::filesystem::path> m_sourceResourceRelativePath = DocumentParameter<std::filesystem::path>( SOURCE_RESOURCE_RELATIVE_PATH, TypeId() );
+
+	DocumentParameter<std::string> m_diffEngine = DocumentParameter<std::string>( DIFF_ENGINE, TypeId() );
 };
 
 
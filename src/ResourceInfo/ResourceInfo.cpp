@@ -231,6 +231,73 @@ Result ResourceInfo::PutDataStream( ResourcePutDataStreamParams& params ) const
 	}
 }
 
+Result ResourceInfo::GetDestinationPath( const ResourceDestinationSettings& resourceDestinationSettings, std::filesystem::path& destinationPath ) const
+{
+	switch( resourceDestinationSettings.destinationType )
+	{
+	case ResourceDestinationType::LOCAL_RELATIVE:
+
+		destinationPath = resourceDestinationSettings.basePath / m_relativePath.GetValue();
+
+		return Result{ ResultType::SUCCESS };
+
+	case ResourceDestinationType::LOCAL_CDN:
+
+		destinationPath = resourceDestinationSettings.basePath / m_location.GetValue().ToString();
+
+		return Result{ ResultType::SUCCESS };
+
+	default:
+		return Result{ ResultType::FAILED_TO_SAVE_FILE };
+	}
+}
+
+Result ResourceInfo::PutFile( ResourcePutFileParams& params ) const
+{
+	std::filesystem::path destinationPath;
+
+	Result getDestinationPathResult = GetDestinationPath( params.resourceDestinationSettings, destinationPath );
+
+	if( getDestinationPathResult.type != ResultType::SUCCESS )
+	{
+		return getDestinationPathResult;
+	}
+
+	// The moved file carries its own permissions rather than those of the file it replaced.
+	// Without a binary operation to set, keep the permissions of the replaced file as writing over it would.
+	bool hasBinaryOperation = m_binaryOperation.HasValue() && m_binaryOperation.GetValue() != 0;
+
+	std::error_code ec;
+
+	std::filesystem::file_status replacedStatus = std::filesystem::status( destinationPath, ec );
+
+	bool keepReplacedPermissions = !hasBinaryOperation && !ec && std::filesystem::is_regular_file( replacedStatus );
+
+	if( !ResourceTools::MoveFileIntoPlace( params.filePath, destinationPath ) )
+	{
+		return Result{ ResultType::FAILED_TO_SAVE_FILE };
+	}
+
+	if( hasBinaryOperation )
+	{
+		if( !ResourceTools::ApplyBinaryOperation( destinationPath, m_binaryOperation.GetValue() ) )
+		{
+			return Result{ ResultType::FAILED_TO_SAVE_FILE };
+		}
+	}
+	else if( keepReplacedPermissions )
+	{
+		std::filesystem::permissions( destinationPath, replacedStatus.permissions(), std::filesystem::perm_options::replace, ec );
+
+		if( ec )
+		{
+			return Result{ ResultType::FAILED_TO_SAVE_FILE };
+		}
+	}
+
+	return Result{ ResultType::SUCCESS };
+}
+
 Result ResourceInfo::PutData( ResourcePutDataParams& params ) const
 {
 	if( !params.data )
@@ -1039,14 +1106,14 @@ Result ResourceInfo::SetParametersFromData( const std::string& data, bool calcul
 
 	if (calculateCompression)
     {
-		std::string compressedData;
+		uintmax_t compressedSize;
 
-		if( !ResourceTools::GZipCompressData( data, compressedData ) )
+		if( !ResourceTools::GZipCompressedSize( data, compressedSize ) )
 		{
 			return Result{ ResultType::FAILED_TO_COMPRESS_DATA };
 		}
 
-		m_compressedSize = compressedData.size();
+		m_compressedSize = compressedSize;
     }
     else
     {
@@ -271,6 +271,14 @@ struct ResourcePutDataParams
 	std::string* data = nullptr;
 };
 
+struct ResourcePutFileParams
+{
+	ResourceDestinationSettings resourceDestinationSettings;
+
+	// File holding the resource data, moved into place
+	std::filesystem::path filePath;
+};
+
 
 class ResourceInfo
 {
@@ -305,6 +313,13 @@ public:
 
 	Result PutData( ResourcePutDataParams& params ) const;
 
+	// Moves a file into the destination, only local destinations are supported.
+	// The binary operation sets the permissions, without one those of a replaced file are kept.
+	Result PutFile( ResourcePutFileParams& params ) const;
+
+	// Path of the resource in a local destination
+	Result GetDestinationPath( const ResourceDestinationSettings& resourceDestinationSettings, std::filesystem::path& destinationPath ) const;
+
 	virtual Result ImportFromYaml( YAML::Node& resource, const VersionInternal& documentVersion );
 
 	virtual Result ExportToYaml( YAML::Emitter& out, const VersionInternal& documentVersion );
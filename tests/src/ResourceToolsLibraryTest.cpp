@@ -6,20 +6,34 @@
 #include <ResourceTools.h>
 #include <BundleStreamOut.h>
 #include <BundleStreamIn.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <filesystem>
+#include <iostream>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <gtest/gtest.h>
 
 #include "ResourcesTestFixture.h"
+#include "ChecksumFilter.h"
 #include "ChunkIndex.h"
+#include "ChunkIndexCache.h"
+#include "ContentDefinedChunking.h"
 #include "FileDataStreamIn.h"
 #include "FileDataStreamOut.h"
 #include "CompressedFileDataStreamOut.h"
+#include "DiffEngine.h"
 #include "GzipCompressionStream.h"
 #include "GzipDecompressionStream.h"
 #include "Md5ChecksumStream.h"
+#include "MemoryMappedFile.h"
 #include "Patching.h"
 #include "RollingChecksum.h"
+#include "SuffixArray.h"
 
 struct ResourceToolsTest : public ResourcesTestFixture
 {
@@ -461,6 +475,111 @@ TEST_F( ResourceToolsTest, CreateApplyPatch )
 	ASSERT_EQ( patched, after );
 }
 
+TEST_F( ResourceToolsTest, SuffixArray )
+{
+	std::string data = "abracadabra mississippi abracadabra";
+	data += std::string( 64, 'a' );
+	data += "\xff\x80\x01";
+
+	std::vector<int32_t> suffixArray( data.size() + 1 );
+	ResourceTools::BuildSuffixArray( reinterpret_cast<const uint8_t*>( data.data() ), static_cast<int32_t>( data.size() ), suffixArray.data() );
+
+	// The empty suffix sorts first, then every suffix in unsigned byte order
+	std::vector<int32_t> expected( data.size() + 1 );
+	for( size_t i = 0; i < expected.size(); ++i )
+	{
+		expected[i] = static_cast<int32_t>( i );
+	}
+	std::sort( expected.begin(), expected.end(), [&data]( int32_t a, int32_t b ) {
+		return std::lexicographical_compare( data.begin() + a, data.end(), data.begin() + b, data.end(), []( char x, char y ) { return static_cast<uint8_t>( x ) < static_cast<uint8_t>( y ); } );
+	} );
+	EXPECT_EQ( suffixArray, expected );
+
+	std::vector<int64_t> suffixArray64( data.size() + 1 );
+	ResourceTools::BuildSuffixArray( reinterpret_cast<const uint8_t*>( data.data() ), static_cast<int64_t>( data.size() ), suffixArray64.data() );
+	EXPECT_TRUE( std::equal( suffixArray64.begin(), suffixArray64.end(), expected.begin() ) );
+}
+
+TEST_F( ResourceToolsTest, CreatePatchSuffixSortsMatch )
+{
+	std::string before;
+	for( int i = 0; i < 20000; ++i )
+	{
+		before += "resource " + std::to_string( i * 7919 % 1000 ) + "\n";
+	}
+	std::string after = before.substr( 5000 ) + "inserted" + before.substr( 0, 5000 );
+	after[after.size() / 2] = 'x';
+
+	// Buffers are reused between calls, the result must not depend on it
+	for( int i = 0; i < 2; ++i )
+	{
+		std::string saisPatch;
+		ASSERT_TRUE( ResourceTools::CreatePatch( before, after, saisPatch, ResourceTools::SuffixSortAlgorithm::SAIS ) );
+
+		std::string qsufsortPatch;
+		ASSERT_TRUE( ResourceTools::CreatePatch( before, after, qsufsortPatch, ResourceTools::SuffixSortAlgorithm::QSUFSORT ) );
+
+		EXPECT_EQ( saisPatch, qsufsortPatch );
+
+		std::string patched;
+		ASSERT_TRUE( ResourceTools::ApplyPatch( before, saisPatch, patched ) );
+		EXPECT_EQ( patched, after );
+	}
+
+	ResourceTools::ReleasePatchBuffers();
+}
+
+TEST_F( ResourceToolsTest, GZipCompressedSize )
+{
+	std::string before;
+	for( int i = 0; i < 20000; ++i )
+	{
+		before += "resource " + std::to_string( i * 7919 % 1000 ) + "\n";
+	}
+	std::string after = before.substr( 5000 ) + "inserted" + before.substr( 0, 5000 );
+
+	// The header is written ahead of the bsdiff output
+	std::string patch;
+	ASSERT_TRUE( ResourceTools::CreatePatch( before, after, patch ) );
+	std::string patched;
+	ASSERT_TRUE( ResourceTools::ApplyPatch( before, patch, patched ) );
+	EXPECT_EQ( patched, after );
+
+	std::string compressedPatch;
+	uintmax_t compressedSize = 0;
+	ASSERT_TRUE( ResourceTools::GZipCompressData( patch, compressedPatch ) );
+	ASSERT_TRUE( ResourceTools::GZipCompressedSize( patch, compressedSize ) );
+	EXPECT_EQ( compressedSize, compressedPatch.size() );
+}
+
+TEST_F( ResourceToolsTest, DiffEngines )
+{
+	std::string before;
+	std::string after;
+	for( int i = 0; i < 10000; ++i )
+	{
+		before += "line " + std::to_string( i ) + "\n";
+		after += "line " + std::to_string( ( i + 5000 ) % 10000 ) + "\n";
+	}
+
+	for( const char* name : { ResourceTools::DIFF_ENGINE_BSDIFF, ResourceTools::DIFF_ENGINE_ZSTD } )
+	{
+		const ResourceTools::DiffEngine* engine = ResourceTools::GetDiffEngine( name );
+		ASSERT_NE( engine, nullptr );
+		EXPECT_EQ( engine->GetName(), std::string( name ) );
+
+		std::string patch;
+		ASSERT_TRUE( engine->CreatePatch( before, after, patch ) );
+		EXPECT_LT( patch.size(), after.size() );
+
+		std::string patched;
+		ASSERT_TRUE( engine->ApplyPatch( before, patch, patched ) );
+		EXPECT_EQ( patched, after );
+	}
+
+	EXPECT_EQ( ResourceTools::GetDiffEngine( "unknown" ), nullptr );
+}
+
 TEST_F( ResourceToolsTest, CreateApplyPatchFile )
 {
 	const char* testDataPathStr = TEST_DATA_BASE_PATH;
@@ -578,6 +697,98 @@ TEST_F( ResourceToolsTest, RollingChecksum )
 	}
 }
 
+TEST_F( ResourceToolsTest, RollingChecksumFromPointer )
+{
+	// Include bytes above 0x7f, as these are read as negative chars.
+	std::string data;
+	for( int i = 0; i < 1000; ++i )
+	{
+		data.push_back( static_cast<char>( ( i * 131 + 7 ) % 256 ) );
+	}
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>( data.data() );
+
+	for( uint32_t length : { 1, 4, 15, 16, 17, 31, 32, 33, 500, 999 } )
+	{
+		uint32_t start = static_cast<uint32_t>( data.size() ) - length;
+
+		// Reference implementation of the rsync checksum.
+		uint32_t alpha = 0;
+		uint32_t beta = 0;
+		for( uint32_t i = start; i < start + length; ++i )
+		{
+			alpha += data[i];
+			beta += ( start + length - i ) * data[i];
+		}
+		alpha %= 65536;
+		beta %= 65536;
+
+		ResourceTools::RollingChecksum fromPointer = ResourceTools::GenerateRollingAdlerChecksum( bytes + start, length );
+		ASSERT_EQ( fromPointer.alpha, alpha );
+		ASSERT_EQ( fromPointer.beta, beta );
+		ASSERT_EQ( fromPointer.checksum, alpha + beta * 65536 );
+
+		ResourceTools::RollingChecksum fromString = ResourceTools::GenerateRollingAdlerChecksum( data, start, start + length );
+		ASSERT_EQ( fromPointer.checksum, fromString.checksum );
+
+		ResourceTools::RollingChecksum previous = ResourceTools::GenerateRollingAdlerChecksum( bytes + start - 1, length );
+		ResourceTools::RollingChecksum incremental = ResourceTools::GenerateRollingAdlerChecksum( bytes + start, length, previous );
+		ASSERT_EQ( fromPointer.alpha, incremental.alpha );
+		ASSERT_EQ( fromPointer.beta, incremental.beta );
+		ASSERT_EQ( fromPointer.checksum, incremental.checksum );
+	}
+}
+
+TEST_F( ResourceToolsTest, RollingChecksumScanner )
+{
+	std::string data;
+	for( int i = 0; i < 1000; ++i )
+	{
+		data.push_back( static_cast<char>( ( i * 131 + 7 ) % 256 ) );
+	}
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>( data.data() );
+
+	for( uint32_t windowSize : { 1, 7, 64, 300 } )
+	{
+		// Feed the data in buffers both shorter and longer than the window.
+		std::vector<std::pair<uint64_t, uint32_t>> windows;
+		ResourceTools::RollingChecksumScanner scanner( windowSize );
+		size_t position = 0;
+		size_t bufferSize = 1;
+		while( position < data.size() )
+		{
+			size_t length = std::min( bufferSize, data.size() - position );
+			bool completed = scanner.Scan(
+				bytes + position, length, []( uint32_t ) { return true; }, [&windows]( uint64_t offset, uint32_t checksum ) {
+					windows.emplace_back( offset, checksum );
+					return true;
+				} );
+			ASSERT_TRUE( completed );
+			position += length;
+			bufferSize = bufferSize * 3 + 1;
+		}
+		ASSERT_EQ( scanner.GetStreamSize(), data.size() );
+		ASSERT_EQ( windows.size(), data.size() - windowSize + 1 );
+		for( size_t i = 0; i < windows.size(); ++i )
+		{
+			ASSERT_EQ( windows[i].first, i );
+			ASSERT_EQ( windows[i].second, ResourceTools::GenerateRollingAdlerChecksum( data, static_cast<uint32_t>( i ), static_cast<uint32_t>( i ) + windowSize ).checksum );
+		}
+
+		// Only relevant windows are reported and returning false stops the scan.
+		uint32_t wanted = windows[500].second;
+		uint64_t foundOffset = 0;
+		ResourceTools::RollingChecksumScanner filteredScanner( windowSize );
+		bool completed = filteredScanner.Scan(
+			bytes, data.size(), [wanted]( uint32_t checksum ) { return checksum == wanted; }, [&foundOffset]( uint64_t offset, uint32_t ) {
+				foundOffset = offset;
+				return false;
+			} );
+		ASSERT_FALSE( completed );
+		ASSERT_LE( foundOffset, 500 );
+		ASSERT_EQ( windows[foundOffset].second, wanted );
+	}
+}
+
 TEST_F( ResourceToolsTest, FindMatchingChunksEverythingMatches )
 {
 	std::string source( "0123456789" );
@@ -760,6 +971,461 @@ TEST_F( ResourceToolsTest, GenerateChunkIndexWithFilter )
 	finalIndex.Generate();
 	ASSERT_TRUE( finalIndex.FindMatchingChunk( final, offset ) );
 	ASSERT_EQ( offset, data.size() - 31 );
+
+	// Target chunk checksums generated once can be shared by the indexes of several files.
+	ResourceTools::TargetChunkChecksums targetChunkChecksums;
+	ASSERT_TRUE( ResourceTools::GenerateTargetChunkChecksums( introMovieFilePath, 10, targetChunkChecksums ) );
+	ASSERT_FALSE( targetChunkChecksums.filter.IsEmpty() );
+	ResourceTools::ChunkIndex sharedIndex( introMovieFilePath, 10, indexFolder );
+	sharedIndex.SetChecksumFilter( targetChunkChecksums );
+	sharedIndex.Generate();
+	ASSERT_TRUE( sharedIndex.FindMatchingChunk( early, offset ) );
+	ASSERT_EQ( data.substr( offset, 10 ), early );
+}
+
+TEST_F( ResourceToolsTest, GenerateLargeChunkIndex )
+{
+	// Enough data for the index to be written to disk and memory mapped, rather than kept in memory.
+	std::filesystem::path largeFilePath = "GenerateLargeChunkIndex/large.bin";
+	std::string data;
+	for( uint32_t i = 0; i < 2 * 1024 * 1024; ++i )
+	{
+		data.push_back( static_cast<char>( ( i * 2654435761u ) >> 24 ) );
+	}
+	ASSERT_TRUE( ResourceTools::SaveFile( largeFilePath, data ) );
+
+	std::filesystem::path indexFolder = "./GenerateLargeChunkIndex/Indexes";
+	size_t offset;
+
+	std::string late = data.substr( 1500000, 64 );
+	ResourceTools::ChunkIndex lateIndex( largeFilePath, static_cast<uint32_t>( late.size() ), indexFolder );
+	ASSERT_TRUE( lateIndex.Generate() );
+	ASSERT_TRUE( lateIndex.FindMatchingChunk( late, offset ) );
+	ASSERT_EQ( data.substr( offset, 64 ), late );
+
+	std::string notInFile( 64, 'x' );
+	ASSERT_FALSE( lateIndex.FindMatchingChunk( notInFile, offset ) );
+
+	// A small memory budget spreads the sort over many runs on disk, the result must not change.
+	ResourceTools::ChunkIndex budgetIndex( largeFilePath, static_cast<uint32_t>( late.size() ), "./GenerateLargeChunkIndex/BudgetIndexes", nullptr, 1, false, 64 * 1024 );
+	ASSERT_TRUE( budgetIndex.Generate() );
+	for( size_t sample = 0; sample + 64 <= data.size(); sample += 65537 )
+	{
+		uint32_t checksum = ResourceTools::GenerateRollingAdlerChecksum( data, static_cast<uint32_t>( sample ), static_cast<uint32_t>( sample + 64 ) ).checksum;
+		std::vector<size_t> expected;
+		std::vector<size_t> actual;
+		ASSERT_TRUE( lateIndex.FindChunkOffsets( checksum, expected ) );
+		ASSERT_TRUE( budgetIndex.FindChunkOffsets( checksum, actual ) );
+		ASSERT_EQ( expected, actual );
+	}
+}
+
+TEST_F( ResourceToolsTest, GenerateChunkIndexOver4GiB )
+{
+	// Sparse file with data beyond 4 GiB, offsets there do not fit in 32 bits.
+	std::filesystem::path filePath = "GenerateChunkIndexOver4GiB/sparse.bin";
+	std::filesystem::create_directories( filePath.parent_path() );
+	const uint64_t dataOffset = ( uint64_t( 1 ) << 32 ) + 4096 * 3 + 5;
+	const uint32_t chunkSize = 4096;
+	std::string data;
+	for( uint32_t i = 0; i < chunkSize * 4; ++i )
+	{
+		data.push_back( static_cast<char>( ( i * 2654435761u ) >> 24 ) );
+	}
+	{
+		std::ofstream out( filePath, std::ios::binary | std::ios::trunc );
+		ASSERT_TRUE( out );
+	}
+	std::filesystem::resize_file( filePath, dataOffset + data.size() + chunkSize );
+	{
+		std::fstream out( filePath, std::ios::binary | std::ios::in | std::ios::out );
+		out.seekp( static_cast<std::streamoff>( dataOffset ) );
+		out.write( data.data(), data.size() );
+		ASSERT_TRUE( out );
+	}
+
+	// Only chunks of the target are indexed, so the empty bulk of the file costs no index space.
+	std::filesystem::path targetPath = "GenerateChunkIndexOver4GiB/target.bin";
+	std::string unaligned = data.substr( 0, chunkSize );
+	std::string aligned = data.substr( chunkSize - 5, chunkSize );
+	ASSERT_TRUE( ResourceTools::SaveFile( targetPath, unaligned + aligned ) );
+
+	{
+		ResourceTools::ChunkIndex index( filePath, chunkSize, "./GenerateChunkIndexOver4GiB/Indexes", nullptr, 0, true );
+		ASSERT_TRUE( index.GenerateChecksumFilter( targetPath ) );
+		ASSERT_TRUE( index.Generate() );
+
+		size_t offset;
+		ASSERT_TRUE( index.FindMatchingChunk( unaligned, offset ) );
+		ASSERT_EQ( offset, dataOffset );
+		ASSERT_TRUE( index.FindMatchingChunk( aligned, offset ) );
+		ASSERT_EQ( offset, dataOffset + chunkSize - 5 );
+		ASSERT_EQ( offset % chunkSize, 0 );
+	}
+
+	std::filesystem::remove( filePath );
+}
+
+TEST_F( ResourceToolsTest, ChecksumFilter )
+{
+	ResourceTools::ChecksumFilter filter;
+	ASSERT_TRUE( filter.IsEmpty() );
+	ASSERT_FALSE( filter.MayContain( 0 ) );
+
+	const uint32_t count = 100000;
+	filter.Reserve( count );
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		filter.Add( i * 7919 );
+	}
+	ASSERT_FALSE( filter.IsEmpty() );
+
+	// Never a false negative.
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		ASSERT_TRUE( filter.MayContain( i * 7919 ) );
+	}
+
+	// Few false positives.
+	uint32_t falsePositives = 0;
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		if( filter.MayContain( i * 7919 + 1 ) )
+		{
+			++falsePositives;
+		}
+	}
+	ASSERT_LT( falsePositives, count / 100 );
+
+	filter.Clear();
+	ASSERT_TRUE( filter.IsEmpty() );
+	ASSERT_FALSE( filter.MayContain( 7919 ) );
+}
+
+// Time of ChecksumFilter and the std::unordered_set it replaced in ChunkIndex, rejecting the windows of a
+// generated 4 GiB previous file against the chunk checksums of a generated 1 GiB next file.
+// Run with --gtest_also_run_disabled_tests --gtest_filter=*ChecksumFilterBenchmark
+TEST_F( ResourceToolsTest, DISABLED_ChecksumFilterBenchmark )
+{
+	const uint32_t chunkSize = 1024;
+	const size_t bufferSize = 64 * 1024 * 1024;
+	const size_t nextBufferCount = 16;
+	const size_t previousBufferCount = 64;
+
+	std::mt19937_64 random( 1 );
+	std::vector<uint8_t> buffer( bufferSize );
+	auto fillBuffer = [&]() {
+		for( size_t i = 0; i < bufferSize; i += sizeof( uint64_t ) )
+		{
+			uint64_t value = random();
+			std::memcpy( buffer.data() + i, &value, sizeof( value ) );
+		}
+	};
+
+	ResourceTools::ChecksumFilter filter;
+	std::unordered_set<uint32_t> checksums;
+	std::vector<uint32_t> nextChecksums;
+	for( size_t i = 0; i < nextBufferCount; ++i )
+	{
+		fillBuffer();
+		for( size_t offset = 0; offset < bufferSize; offset += chunkSize )
+		{
+			nextChecksums.push_back( ResourceTools::GenerateRollingAdlerChecksum( buffer.data() + offset, chunkSize ).checksum );
+		}
+	}
+	filter.Reserve( nextChecksums.size() );
+	for( uint32_t checksum : nextChecksums )
+	{
+		filter.Add( checksum );
+		checksums.insert( checksum );
+	}
+
+	uint64_t filterMatches = 0;
+	uint64_t setMatches = 0;
+	auto filterContains = [&filter]( uint32_t checksum ) { return filter.MayContain( checksum ); };
+	auto setContains = [&checksums]( uint32_t checksum ) { return checksums.count( checksum ) != 0; };
+	auto countFilterMatch = [&filterMatches]( uint64_t, uint32_t ) {
+		++filterMatches;
+		return true;
+	};
+	auto countSetMatch = [&setMatches]( uint64_t, uint32_t ) {
+		++setMatches;
+		return true;
+	};
+
+	ResourceTools::RollingChecksumScanner filterScanner( chunkSize );
+	ResourceTools::RollingChecksumScanner setScanner( chunkSize );
+	std::chrono::steady_clock::duration filterTime{};
+	std::chrono::steady_clock::duration setTime{};
+	for( size_t i = 0; i < previousBufferCount; ++i )
+	{
+		fillBuffer();
+
+		auto start = std::chrono::steady_clock::now();
+		filterScanner.Scan( buffer.data(), buffer.size(), filterContains, countFilterMatch );
+		filterTime += std::chrono::steady_clock::now() - start;
+
+		start = std::chrono::steady_clock::now();
+		setScanner.Scan( buffer.data(), buffer.size(), setContains, countSetMatch );
+		setTime += std::chrono::steady_clock::now() - start;
+	}
+
+	// The filter never misses a checksum in the set.
+	ASSERT_GE( filterMatches, setMatches );
+
+	uint64_t windowCount = previousBufferCount * bufferSize - chunkSize + 1;
+	std::cout << nextChecksums.size() << " next chunks, " << windowCount << " previous windows" << std::endl;
+	std::cout << "  ChecksumFilter:     " << std::chrono::duration<double>( filterTime ).count() << "s, " << filterMatches << " matches" << std::endl;
+	std::cout << "  std::unordered_set: " << std::chrono::duration<double>( setTime ).count() << "s, " << setMatches << " matches" << std::endl;
+	std::cout << "  False positive rate: " << 100.0 * ( filterMatches - setMatches ) / ( windowCount - setMatches ) << "%" << std::endl;
+}
+
+TEST_F( ResourceToolsTest, GenerateChunkIndexMultiThreaded )
+{
+	// Large enough to be split into several segments, with repeated blocks so checksums have several offsets.
+	std::filesystem::path filePath = "GenerateChunkIndexMultiThreaded/large.bin";
+	std::string data;
+	for( uint32_t i = 0; i < 16 * 1024 * 1024; ++i )
+	{
+		uint32_t value = i % ( 3 * 1024 * 1024 + 7 );
+		data.push_back( static_cast<char>( ( value * 2654435761u ) >> 24 ) );
+	}
+	ASSERT_TRUE( ResourceTools::SaveFile( filePath, data ) );
+
+	// Index files are named after the indexed file, so each index needs its own folder.
+	const uint32_t chunkSize = 32;
+
+	ResourceTools::ChunkIndex singleThreadedIndex( filePath, chunkSize, "./GenerateChunkIndexMultiThreaded/SingleThreaded", nullptr, 1 );
+	ASSERT_TRUE( singleThreadedIndex.Generate() );
+	ResourceTools::ChunkIndex multiThreadedIndex( filePath, chunkSize, "./GenerateChunkIndexMultiThreaded/MultiThreaded", nullptr, 4 );
+	ASSERT_TRUE( multiThreadedIndex.Generate() );
+
+	// Sample windows across the file, including the ones straddling segment boundaries.
+	std::vector<size_t> windows;
+	for( size_t offset = 0; offset + chunkSize <= data.size(); offset += 9973 )
+	{
+		windows.push_back( offset );
+	}
+	for( size_t segment = 1; segment < 4; ++segment )
+	{
+		for( size_t offset = segment * data.size() / 4 - chunkSize; offset < segment * data.size() / 4 + chunkSize; ++offset )
+		{
+			windows.push_back( offset );
+		}
+	}
+	windows.push_back( data.size() - chunkSize );
+
+	for( size_t window : windows )
+	{
+		uint32_t checksum = ResourceTools::GenerateRollingAdlerChecksum( data, static_cast<uint32_t>( window ), static_cast<uint32_t>( window + chunkSize ) ).checksum;
+		std::vector<size_t> expected;
+		std::vector<size_t> actual;
+		ASSERT_TRUE( singleThreadedIndex.FindChunkOffsets( checksum, expected ) );
+		ASSERT_TRUE( multiThreadedIndex.FindChunkOffsets( checksum, actual ) );
+		ASSERT_EQ( expected, actual );
+		ASSERT_NE( std::find( actual.begin(), actual.end(), window ), actual.end() );
+	}
+}
+
+TEST_F( ResourceToolsTest, FindChunkOffsetsBatch )
+{
+	const char* testDataPathStr = TEST_DATA_BASE_PATH;
+	ASSERT_TRUE( testDataPathStr );
+	std::filesystem::path testDataPath( testDataPathStr );
+	std::filesystem::path introMovieFilePath = testDataPath / "resourcesOnBranch" / "introMovie.txt";
+	std::string data;
+	ResourceTools::GetLocalFileData( introMovieFilePath, data );
+
+	const uint32_t chunkSize = 16;
+	ResourceTools::ChunkIndex index( introMovieFilePath, chunkSize, "./FindChunkOffsetsBatch/Indexes" );
+	ASSERT_TRUE( index.Generate() );
+
+	// Unsorted, with duplicates and checksums that are not in the file.
+	std::vector<uint32_t> checksums;
+	for( size_t offset = data.size() - chunkSize; offset > chunkSize; offset -= 37 )
+	{
+		checksums.push_back( ResourceTools::GenerateRollingAdlerChecksum( data, static_cast<uint32_t>( offset ), static_cast<uint32_t>( offset + chunkSize ) ).checksum );
+	}
+	checksums.push_back( checksums.front() );
+	checksums.push_back( 0xffffffff );
+	checksums.push_back( 0 );
+
+	std::vector<std::vector<size_t>> batchOffsets;
+	ASSERT_TRUE( index.FindChunkOffsets( checksums, batchOffsets ) );
+	ASSERT_EQ( batchOffsets.size(), checksums.size() );
+	for( size_t i = 0; i < checksums.size(); ++i )
+	{
+		std::vector<size_t> offsets;
+		ASSERT_TRUE( index.FindChunkOffsets( checksums[i], offsets ) );
+		ASSERT_EQ( batchOffsets[i], offsets );
+	}
+	ASSERT_FALSE( batchOffsets.front().empty() );
+
+	// Matching chunks of the target file go through the batch lookup.
+	ResourceTools::ChunkIndex targetIndex( introMovieFilePath, chunkSize, "./FindChunkOffsetsBatch/TargetIndexes" );
+	ASSERT_TRUE( targetIndex.GenerateChecksumFilter( introMovieFilePath ) );
+	ASSERT_TRUE( targetIndex.Generate() );
+	for( size_t offset = 0; offset + chunkSize <= data.size(); offset += chunkSize * 11 )
+	{
+		std::string chunk = data.substr( offset, chunkSize );
+		size_t matchOffset;
+		ASSERT_TRUE( targetIndex.FindMatchingChunk( chunk, matchOffset ) );
+		ASSERT_EQ( data.substr( matchOffset, chunkSize ), chunk );
+	}
+}
+
+TEST_F( ResourceToolsTest, ChunkIndexBlockHashes )
+{
+	// Large enough to be hashed by more than one segment.
+	std::filesystem::path filePath = "ChunkIndexBlockHashes/data.bin";
+	std::string data;
+	for( uint32_t i = 0; i < 9 * 1024 * 1024; ++i )
+	{
+		data.push_back( static_cast<char>( ( i * 2654435761u ) >> 24 ) );
+	}
+	ASSERT_TRUE( ResourceTools::SaveFile( filePath, data ) );
+
+	const uint32_t chunkSize = 4096;
+	std::filesystem::path cacheFolder = "./ChunkIndexBlockHashes/Cache";
+	std::filesystem::remove_all( cacheFolder );
+	ResourceTools::ChunkIndexCache cache( cacheFolder, 100000000 );
+
+	ResourceTools::ChunkIndex index( filePath, chunkSize, "./ChunkIndexBlockHashes/Indexes", nullptr, 4, true );
+	ASSERT_TRUE( index.Generate( cache, "0123456789abcdef0123456789abcdef" ) );
+	ResourceTools::ChunkIndex cachedIndex( filePath, chunkSize, "./ChunkIndexBlockHashes/CachedIndexes", nullptr, 1, true );
+	ASSERT_TRUE( cachedIndex.Generate( cache, "0123456789abcdef0123456789abcdef" ) );
+
+	// Aligned matches are verified from the stored hashes alone, so they are still found once the file changes.
+	ASSERT_TRUE( ResourceTools::SaveFile( filePath, std::string( data.size(), '\0' ) ) );
+	for( size_t offset = 0; offset + chunkSize <= data.size(); offset += chunkSize * 97 )
+	{
+		std::string chunk = data.substr( offset, chunkSize );
+		size_t matchOffset;
+		ASSERT_TRUE( index.FindMatchingChunk( chunk, matchOffset ) );
+		ASSERT_EQ( matchOffset, offset );
+		ASSERT_TRUE( cachedIndex.FindMatchingChunk( chunk, matchOffset ) );
+		ASSERT_EQ( matchOffset, offset );
+	}
+
+	// Unaligned matches still have to be read back.
+	size_t matchOffset;
+	ASSERT_FALSE( index.FindMatchingChunk( data.substr( 100, chunkSize ), matchOffset ) );
+}
+
+TEST_F( ResourceToolsTest, ChunkIndexCache )
+{
+	const char* testDataPathStr = TEST_DATA_BASE_PATH;
+	ASSERT_TRUE( testDataPathStr );
+	std::filesystem::path testDataPath( testDataPathStr );
+	std::filesystem::path introMovieFilePath = testDataPath / "resourcesOnBranch" / "introMovie.txt";
+	std::string data;
+	ResourceTools::GetLocalFileData( introMovieFilePath, data );
+	std::string checksum;
+	ASSERT_TRUE( ResourceTools::GenerateMd5Checksum( data, checksum ) );
+
+	std::filesystem::path indexFolder = "./ChunkIndexCache/Indexes";
+	std::filesystem::path cacheFolder = "./ChunkIndexCache/Cache";
+	std::filesystem::remove_all( cacheFolder );
+	ResourceTools::ChunkIndexCache cache( cacheFolder, 100000000 );
+
+	size_t offset;
+	std::string early = data.substr( 100, 10 );
+	std::filesystem::path cachedIndexPath = cache.GetEntryPath( checksum + "_10" );
+	{
+		// A filter is ignored by cached indexes.
+		ResourceTools::ChunkIndex index( introMovieFilePath, 10, indexFolder );
+		index.GenerateChecksumFilter( introMovieFilePath );
+		ASSERT_TRUE( index.Generate( cache, checksum ) );
+		ASSERT_TRUE( index.FindMatchingChunk( early, offset ) );
+		ASSERT_EQ( data.substr( offset, 10 ), early );
+	}
+	ASSERT_TRUE( std::filesystem::exists( cachedIndexPath ) );
+	// The cached index header is magic, version, chunk size, block count, block hash count, blocks hash and file checksum.
+	const uintmax_t cachedIndexHeaderSize = 8 + 4 + 4 + 8 + 8 + 8 + 32;
+	uintmax_t cachedIndexSize = std::filesystem::file_size( cachedIndexPath );
+	ASSERT_GT( cachedIndexSize, cachedIndexHeaderSize );
+	ASSERT_EQ( ( cachedIndexSize - cachedIndexHeaderSize ) % sizeof( ResourceTools::ChunkIndexEntry ), 0 );
+
+	// Second time around the index comes from the cache, even for chunks the filter would have dropped.
+	std::string notInFilter = data.substr( 105, 10 );
+	{
+		ResourceTools::ChunkIndex index( introMovieFilePath, 10, indexFolder );
+		ASSERT_TRUE( index.Generate( cache, checksum ) );
+		ASSERT_TRUE( index.FindMatchingChunk( notInFilter, offset ) );
+		ASSERT_EQ( data.substr( offset, 10 ), notInFilter );
+	}
+
+	// A corrupt cache entry is detected and regenerated.
+	{
+		std::fstream corrupt( cachedIndexPath, std::ios::in | std::ios::out | std::ios::binary );
+		corrupt.seekp( -4, std::ios::end );
+		corrupt.write( "\xff\xff\xff\xff", 4 );
+	}
+	{
+		ResourceTools::ChunkIndex index( introMovieFilePath, 10, indexFolder );
+		ASSERT_TRUE( index.Generate( cache, checksum ) );
+		ASSERT_TRUE( index.FindMatchingChunk( early, offset ) );
+		ASSERT_EQ( data.substr( offset, 10 ), early );
+	}
+
+	// A cache too small for two indexes evicts the least recently used one.
+	ResourceTools::ChunkIndexCache smallCache( cacheFolder, std::filesystem::file_size( cachedIndexPath ) + 1 );
+	{
+		ResourceTools::ChunkIndex index( introMovieFilePath, 20, indexFolder );
+		ASSERT_TRUE( index.Generate( smallCache, checksum ) );
+	}
+	ASSERT_FALSE( std::filesystem::exists( cachedIndexPath ) );
+	ASSERT_TRUE( std::filesystem::exists( smallCache.GetEntryPath( checksum + "_20" ) ) );
+}
+
+TEST_F( ResourceToolsTest, MemoryMappedFile )
+{
+	const char* testDataPathStr = TEST_DATA_BASE_PATH;
+	ASSERT_TRUE( testDataPathStr );
+	std::filesystem::path testDataPath( testDataPathStr );
+	std::filesystem::path introMovieFilePath = testDataPath / "resourcesOnBranch" / "introMovie.txt";
+	std::string data;
+	ASSERT_TRUE( ResourceTools::GetLocalFileData( introMovieFilePath, data ) );
+
+	ResourceTools::MemoryMappedFile mappedFile;
+	ASSERT_TRUE( mappedFile.Open( introMovieFilePath ) );
+	ASSERT_TRUE( mappedFile.IsOpen() );
+	ASSERT_EQ( mappedFile.GetSize(), data.size() );
+	ASSERT_EQ( std::string( reinterpret_cast<const char*>( mappedFile.GetData() ), mappedFile.GetSize() ), data );
+
+	mappedFile.Close();
+	ASSERT_FALSE( mappedFile.IsOpen() );
+	ASSERT_FALSE( mappedFile.Open( testDataPath / "resourcesOnBranch" / "thisFileDoesNotExist.txt" ) );
+}
+
+TEST_F( ResourceToolsTest, MoveFileIntoPlace )
+{
+	std::filesystem::path sourcePath = "MoveFileIntoPlace/source.txt";
+	std::filesystem::path destinationPath = "MoveFileIntoPlace/Destination/destination.txt";
+
+	ASSERT_TRUE( ResourceTools::SaveFile( sourcePath, "patched" ) );
+	ASSERT_TRUE( ResourceTools::SaveFile( destinationPath, "previous" ) );
+
+	// Existing destination is replaced and the source is gone
+	ASSERT_TRUE( ResourceTools::MoveFileIntoPlace( sourcePath, destinationPath ) );
+	EXPECT_FALSE( std::filesystem::exists( sourcePath ) );
+
+	std::string data;
+	ASSERT_TRUE( ResourceTools::GetLocalFileData( destinationPath, data ) );
+	EXPECT_EQ( data, "patched" );
+
+	// Missing destination directories are created
+	ASSERT_TRUE( ResourceTools::SaveFile( sourcePath, "new" ) );
+	ASSERT_TRUE( ResourceTools::MoveFileIntoPlace( sourcePath, "MoveFileIntoPlace/New/Folder/new.txt" ) );
+	EXPECT_TRUE( std::filesystem::exists( "MoveFileIntoPlace/New/Folder/new.txt" ) );
+
+	EXPECT_FALSE( ResourceTools::MoveFileIntoPlace( "MoveFileIntoPlace/thisFileDoesNotExist.txt", destinationPath ) );
+
+	// Permission bits of the binary operation are applied
+	unsigned int binaryOperation = ResourceTools::CalculateBinaryOperation( destinationPath );
+	ASSERT_NE( binaryOperation, 0u );
+	EXPECT_TRUE( ResourceTools::ApplyBinaryOperation( destinationPath, binaryOperation ) );
+	EXPECT_EQ( ResourceTools::CalculateBinaryOperation( destinationPath ), binaryOperation );
 }
 
 #if __APPLE__
@@ -833,3 +1499,276 @@ TEST_F( ResourceToolsTest, GzipStreams )
 	EXPECT_TRUE( uncompressedMd5Stream.FinishAndRetrieve( uncompressedChecksum ) );
 	EXPECT_EQ( uncompressedChecksum, originalChecksum );
 }
+
+TEST_F( ResourceToolsTest, ContentDefinedChunking )
+{
+	std::string data;
+	uint32_t state = 12345;
+	for( uint32_t i = 0; i < 4 * 1024 * 1024; ++i )
+	{
+		state = state * 1664525u + 1013904223u;
+		data.push_back( static_cast<char>( state >> 24 ) );
+	}
+
+	ResourceTools::ContentDefinedChunkSizes sizes = ResourceTools::GetContentDefinedChunkSizes( 64 * 1024 );
+	ASSERT_LT( sizes.minimumSize, sizes.averageSize );
+	ASSERT_LT( sizes.averageSize, sizes.maximumSize );
+
+	auto chunkEnds = [&sizes]( const std::string& input ) {
+		std::vector<size_t> ends;
+		const auto* bytes = reinterpret_cast<const uint8_t*>( input.data() );
+		for( size_t offset = 0; offset < input.size(); )
+		{
+			size_t chunkSize = ResourceTools::FindContentDefinedChunkEnd( bytes + offset, input.size() - offset, sizes );
+			EXPECT_GT( chunkSize, 0u );
+			EXPECT_LE( chunkSize, sizes.maximumSize );
+			offset += chunkSize;
+			if( offset < input.size() )
+			{
+				EXPECT_GT( chunkSize, sizes.minimumSize );
+			}
+			ends.push_back( offset );
+		}
+		return ends;
+	};
+
+	std::vector<size_t> originalEnds = chunkEnds( data );
+	ASSERT_EQ( originalEnds.back(), data.size() );
+	ASSERT_GT( originalEnds.size(), data.size() / sizes.maximumSize );
+
+	// Boundaries after an insertion are the original ones shifted by its size.
+	const size_t insertOffset = 100000;
+	const std::string insertion( 17, 'x' );
+	std::string edited = data;
+	edited.insert( insertOffset, insertion );
+	std::vector<size_t> editedEnds = chunkEnds( edited );
+
+	size_t shiftedCount = 0;
+	size_t comparedCount = 0;
+	for( size_t end : originalEnds )
+	{
+		if( end < insertOffset + sizes.maximumSize )
+		{
+			continue;
+		}
+		++comparedCount;
+		if( std::binary_search( editedEnds.begin(), editedEnds.end(), end + insertion.size() ) )
+		{
+			++shiftedCount;
+		}
+	}
+	ASSERT_GT( comparedCount, 0u );
+	EXPECT_EQ( shiftedCount, comparedCount );
+
+	// Chunks of a file cover it in order and identical content hashes the same.
+	std::filesystem::path filePath = "ContentDefinedChunking/data.bin";
+	ASSERT_TRUE( ResourceTools::SaveFile( filePath, data + data ) );
+	std::vector<ResourceTools::ContentDefinedChunk> chunks;
+	ASSERT_TRUE( ResourceTools::GenerateContentDefinedChunks( filePath, sizes, chunks ) );
+	uint64_t expectedOffset = 0;
+	for( auto& chunk : chunks )
+	{
+		EXPECT_EQ( chunk.offset, expectedOffset );
+		expectedOffset += chunk.size;
+	}
+	EXPECT_EQ( expectedOffset, data.size() * 2 );
+	EXPECT_EQ( chunks.front().size, originalEnds.front() );
+
+	std::map<uint64_t, const ResourceTools::ContentDefinedChunk*> chunksByOffset;
+	for( auto& chunk : chunks )
+	{
+		chunksByOffset[chunk.offset] = &chunk;
+	}
+	size_t repeatedCount = 0;
+	for( size_t end : originalEnds )
+	{
+		auto first = chunksByOffset.find( end );
+		auto second = chunksByOffset.find( end + data.size() );
+		if( first != chunksByOffset.end() && second != chunksByOffset.end() && first->second->size == second->second->size )
+		{
+			EXPECT_EQ( first->second->hash, second->second->hash );
+			++repeatedCount;
+		}
+	}
+	EXPECT_GT( repeatedCount, originalEnds.size() / 2 );
+}
+
+// Patch data, patch count and time of fixed size and content defined chunking, replaying the chunk loops of
+// ResourceGroupImpl::CreateResourcePatches and CreateContentDefinedPatches with the zstd diff engine.
+// Run with --gtest_also_run_disabled_tests --gtest_filter=*ContentDefinedChunkingBenchmark
+TEST_F( ResourceToolsTest, DISABLED_ContentDefinedChunkingBenchmark )
+{
+	const size_t dataSize = 64 * 1024 * 1024;
+	const size_t chunkSize = 1024 * 1024;
+	const ResourceTools::DiffEngine* diffEngine = ResourceTools::GetDiffEngine( ResourceTools::DIFF_ENGINE_ZSTD );
+	ASSERT_NE( diffEngine, nullptr );
+
+	std::filesystem::path previousPath = "ContentDefinedChunkingBenchmark/previous.bin";
+	std::filesystem::path nextPath = "ContentDefinedChunkingBenchmark/next.bin";
+	std::filesystem::path indexFolder = "ContentDefinedChunkingBenchmark/Indexes";
+
+	struct BenchmarkResult
+	{
+		size_t patchDataSize = 0;
+		size_t patchCount = 0;
+		double seconds = 0;
+	};
+
+	auto diff = [diffEngine]( const std::string& previous, const std::string& next ) {
+		std::string patch;
+		EXPECT_TRUE( diffEngine->CreatePatch( previous, next, patch ) );
+		return patch.size();
+	};
+
+	auto fixedSize = [&]( const std::string& previous, const std::string& next ) {
+		BenchmarkResult result;
+		auto start = std::chrono::steady_clock::now();
+		std::filesystem::remove_all( indexFolder );
+		ResourceTools::ChunkIndex index( previousPath, static_cast<uint32_t>( chunkSize ), indexFolder );
+		EXPECT_TRUE( index.GenerateChecksumFilter( nextPath ) );
+		EXPECT_TRUE( index.Generate() );
+		size_t previousPosition = 0;
+		size_t nextPosition = 0;
+		size_t patchSourceOffset = 0;
+		for( size_t dataOffset = 0; dataOffset < next.size(); dataOffset += chunkSize )
+		{
+			if( previousPosition >= previous.size() && previous.size() > nextPosition )
+			{
+				previousPosition = 0;
+			}
+			std::string previousData = previousPosition < previous.size() ? previous.substr( previousPosition, chunkSize ) : "";
+			previousPosition += previousData.size();
+			size_t nextStreamPosition = nextPosition;
+			std::string nextData = next.substr( nextPosition, chunkSize );
+			nextPosition += nextData.size();
+			size_t patchSourceOffsetDelta = nextData.size();
+			if( !previousData.empty() )
+			{
+				size_t sourceOffset = patchSourceOffset;
+				if( index.FindMatchingChunk( nextData, sourceOffset ) )
+				{
+					size_t matchCount = 1;
+					while( nextPosition + ( matchCount - 1 ) * chunkSize < next.size() && sourceOffset + matchCount * chunkSize < previous.size() && next.compare( nextPosition + ( matchCount - 1 ) * chunkSize, chunkSize, previous, sourceOffset + matchCount * chunkSize, chunkSize ) == 0 )
+					{
+						++matchCount;
+					}
+					size_t matchSize = std::min( chunkSize * matchCount, previous.size() - sourceOffset );
+					nextPosition = std::min( next.size(), nextStreamPosition + matchSize );
+					previousPosition = std::min( previous.size(), sourceOffset + matchSize );
+					dataOffset += matchSize - chunkSize;
+					patchSourceOffset = sourceOffset + matchSize;
+					if( nextStreamPosition != 0 || patchSourceOffset != 0 )
+					{
+						++result.patchCount;
+					}
+					continue;
+				}
+				patchSourceOffsetDelta = previousData.size();
+			}
+			++result.patchCount;
+			result.patchDataSize += diff( previousData, nextData );
+			patchSourceOffset += patchSourceOffsetDelta;
+		}
+		result.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+		return result;
+	};
+
+	auto contentDefined = [&]( const std::string& previous, const std::string& next ) {
+		BenchmarkResult result;
+		auto start = std::chrono::steady_clock::now();
+		ResourceTools::ContentDefinedChunkSizes sizes = ResourceTools::GetContentDefinedChunkSizes( chunkSize );
+		std::vector<ResourceTools::ContentDefinedChunk> previousChunks;
+		std::vector<ResourceTools::ContentDefinedChunk> nextChunks;
+		EXPECT_TRUE( ResourceTools::GenerateContentDefinedChunks( previousPath, sizes, previousChunks ) );
+		EXPECT_TRUE( ResourceTools::GenerateContentDefinedChunks( nextPath, sizes, nextChunks ) );
+		auto key = []( const ResourceTools::ContentDefinedChunk& chunk ) {
+			uint64_t chunkKey;
+			std::memcpy( &chunkKey, chunk.hash.bytes, sizeof( chunkKey ) );
+			return chunkKey;
+		};
+		auto chunksMatch = []( const ResourceTools::ContentDefinedChunk& a, const ResourceTools::ContentDefinedChunk& b ) {
+			return a.size == b.size && a.hash == b.hash;
+		};
+		std::unordered_map<uint64_t, size_t> previousChunkIndices;
+		for( size_t i = 0; i < previousChunks.size(); ++i )
+		{
+			previousChunkIndices.emplace( key( previousChunks[i] ), i );
+		}
+		uint64_t patchSourceOffset = 0;
+		for( size_t i = 0; i < nextChunks.size(); )
+		{
+			auto previousChunkIndex = previousChunkIndices.find( key( nextChunks[i] ) );
+			if( previousChunkIndex != previousChunkIndices.end() && chunksMatch( previousChunks[previousChunkIndex->second], nextChunks[i] ) )
+			{
+				size_t previousIndex = previousChunkIndex->second;
+				size_t matchCount = 1;
+				uint64_t matchSize = nextChunks[i].size;
+				while( i + matchCount < nextChunks.size() && previousIndex + matchCount < previousChunks.size() && chunksMatch( previousChunks[previousIndex + matchCount], nextChunks[i + matchCount] ) )
+				{
+					matchSize += nextChunks[i + matchCount].size;
+					++matchCount;
+				}
+				++result.patchCount;
+				patchSourceOffset = previousChunks[previousIndex].offset + matchSize;
+				i += matchCount;
+				continue;
+			}
+			std::string previousData = patchSourceOffset < previous.size() ? previous.substr( patchSourceOffset, chunkSize ) : "";
+			++result.patchCount;
+			result.patchDataSize += diff( previousData, next.substr( nextChunks[i].offset, nextChunks[i].size ) );
+			patchSourceOffset += nextChunks[i].size;
+			++i;
+		}
+		result.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+		return result;
+	};
+
+	for( bool text : { false, true } )
+	{
+		for( int insertCount : { 0, 20, 200 } )
+		{
+			std::mt19937_64 random( 1 );
+			std::string previous;
+			if( text )
+			{
+				while( previous.size() < dataSize )
+				{
+					previous += "entry " + std::to_string( random() % 100000 ) + " value " + std::to_string( random() % 1000 ) + "\n";
+				}
+				previous.resize( dataSize );
+			}
+			else
+			{
+				previous.resize( dataSize );
+				for( char& c : previous )
+				{
+					c = static_cast<char>( random() );
+				}
+			}
+
+			// Inserts of 100 random bytes at random offsets
+			std::string next = previous;
+			for( int i = 0; i < insertCount; ++i )
+			{
+				std::string insertion( 100, 0 );
+				for( char& c : insertion )
+				{
+					c = static_cast<char>( random() );
+				}
+				next.insert( random() % next.size(), insertion );
+			}
+
+			ASSERT_TRUE( ResourceTools::SaveFile( previousPath, previous ) );
+			ASSERT_TRUE( ResourceTools::SaveFile( nextPath, next ) );
+
+			BenchmarkResult fixedSizeResult = fixedSize( previous, next );
+			BenchmarkResult contentDefinedResult = contentDefined( previous, next );
+
+			std::cout << ( text ? "Text" : "Random data" ) << ", " << insertCount << " inserts" << std::endl;
+			std::cout << "  Fixed size:      " << fixedSizeResult.patchDataSize << " bytes, " << fixedSizeResult.patchCount << " patches, " << fixedSizeResult.seconds << "s" << std::endl;
+			std::cout << "  Content defined: " << contentDefinedResult.patchDataSize << " bytes, " << contentDefinedResult.patchCount << " patches, " << contentDefinedResult.seconds << "s" << std::endl;
+		}
+	}
+
+	std::filesystem::remove_all( previousPath.parent_path() );
+}
@@ -613,6 +613,69 @@ TEST_F( ResourcesCliTest, CreatePatch )
 	EXPECT_TRUE( DirectoryIsSubset( goldDirectory, "PatchOut/Patches" ) );
 }
 
+TEST_F( ResourcesCliTest, CreatePatchFromSeveralPreviousBuilds )
+{
+	std::string output;
+
+	std::vector<std::string> arguments;
+
+	arguments.push_back( "create-patch" );
+
+	arguments.push_back( "--verbosity-level" );
+	arguments.push_back( "3" );
+
+	std::string previousResourceGroupPath = GetTestFileFileAbsolutePath( "Patch/resfileindexShort_build_previous.txt" ).string();
+
+	arguments.push_back( previousResourceGroupPath );
+
+	std::string nextResourceGroupPath = GetTestFileFileAbsolutePath( "Patch/resfileindexShort_build_next.txt" ).string();
+
+	arguments.push_back( nextResourceGroupPath );
+
+	arguments.push_back( "--resource-source-type-previous" );
+	arguments.push_back( "LOCAL_RELATIVE" );
+
+	std::string nextResourcesLocation = GetTestFileFileAbsolutePath( "Patch/NextBuildResources" ).string();
+
+	arguments.push_back( "--resource-source-base-path-next" );
+	arguments.push_back( nextResourcesLocation );
+
+	std::string previousResourcesLocation = GetTestFileFileAbsolutePath( "Patch/PreviousBuildResources" ).string();
+
+	arguments.push_back( "--resource-source-base-path-previous" );
+	arguments.push_back( previousResourcesLocation );
+
+	// The same previous build again, every resource reuses the patches made for the first
+	arguments.push_back( "--additional-previous-build" );
+	arguments.push_back( previousResourceGroupPath );
+	arguments.push_back( previousResourcesLocation );
+
+	arguments.push_back( "--patch-resourcegroup-destination-path" );
+	arguments.push_back( "SeveralPreviousBuildsPatchOut" );
+
+	arguments.push_back( "--patch-destination-base-path" );
+	arguments.push_back( "SeveralPreviousBuildsPatchOut/Patches" );
+
+	arguments.push_back( "--patch-destination-type" );
+	arguments.push_back( "LOCAL_CDN" );
+
+	arguments.push_back( "--chunk-size" );
+	arguments.push_back( "50000000" );
+
+	int res = RunCli( arguments, output );
+
+	EXPECT_EQ( res, 0 );
+
+	// Check expected outcome
+	std::filesystem::path goldFile = GetTestFileFileAbsolutePath( "Patch/PatchResourceGroup.yaml" );
+	EXPECT_TRUE( FilesMatch( goldFile, "SeveralPreviousBuildsPatchOut/PatchResourceGroup.yaml" ) );
+
+	EXPECT_TRUE( std::filesystem::exists( "SeveralPreviousBuildsPatchOut/PatchResourceGroup_1.yaml" ) );
+
+	std::filesystem::path goldDirectory = GetTestFileFileAbsolutePath( "Patch/LocalCDNPatches" );
+	EXPECT_TRUE( DirectoryIsSubset( goldDirectory, "SeveralPreviousBuildsPatchOut/Patches" ) );
+}
+
 TEST_F( ResourcesCliTest, CreateGroup )
 {
 	std::string output;
@@ -9,6 +9,10 @@
 #include <gtest/gtest.h>
 
 #include <FileDataStreamOut.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
 
 struct ResourcesLibraryTest : public ResourcesTestFixture
 {
@@ -754,30 +758,1329 @@ TEST_F( ResourcesLibraryTest, ApplyPatchWithChunking )
 	EXPECT_TRUE( FilesMatch( nextTestResource, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "testresource2.txt" ) );
 }
 
+TEST_F( ResourcesLibraryTest, ApplyPatchConcurrently )
+{
+	// Load the patch file
+	CarbonResources::PatchResourceGroup patchResourceGroup;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPrevious;
+
+	importParamsPrevious.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PatchResourceGroup_previousBuild_latestBuild.yaml" );
+
+	EXPECT_EQ( patchResourceGroup.ImportFromFile( importParamsPrevious ).type, CarbonResources::ResultType::SUCCESS );
+
+
+	// Apply the patch with a worker per resource
+	CarbonResources::PatchApplyParams patchApplyParams;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/" ) };
+
+	patchApplyParams.patchBinarySourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_CDN;
+
+	patchApplyParams.patchBinarySourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/LocalCDNPatches/" ) };
+
+	patchApplyParams.resourcesToPatchSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchSourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources/" ) };
+
+	patchApplyParams.resourcesToPatchDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchDestinationSettings.basePath = "ApplyPatchConcurrentlyOut";
+
+	patchApplyParams.temporaryFilePath = "ApplyPatchConcurrentlyStaging/tempFile.resource";
+
+	patchApplyParams.applyThreadCount = 3;
+
+	EXPECT_EQ( patchResourceGroup.Apply( patchApplyParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	std::filesystem::path nextIntroMovie = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/introMovie.txt" );
+	EXPECT_TRUE( FilesMatch( nextIntroMovie, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "introMovie.txt" ) );
+	std::filesystem::path nextIntroMoviePrefixed = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/introMoviePrefixed.txt" );
+	EXPECT_TRUE( FilesMatch( nextIntroMoviePrefixed, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "introMoviePrefixed.txt" ) );
+	std::filesystem::path nextTestResource = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/testresource2.txt" );
+	EXPECT_TRUE( FilesMatch( nextTestResource, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "testresource2.txt" ) );
+
+	// Worker temporary files are removed once done
+	for( int workerIndex = 0; workerIndex < 3; workerIndex++ )
+	{
+		EXPECT_FALSE( std::filesystem::exists( "ApplyPatchConcurrentlyStaging/tempFile.resource." + std::to_string( workerIndex ) ) );
+	}
+}
+
+TEST_F( ResourcesLibraryTest, ApplyPatchConcurrentlyWithCorruptedPatch )
+{
+	// Load the patch file
+	CarbonResources::PatchResourceGroup patchResourceGroup;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPrevious;
+
+	importParamsPrevious.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PatchResourceGroup_previousBuild_latestBuild.yaml" );
+
+	EXPECT_EQ( patchResourceGroup.ImportFromFile( importParamsPrevious ).type, CarbonResources::ResultType::SUCCESS );
+
+	// Corrupt the first patch binary of introMovieSomewhatChanged.txt
+	std::filesystem::path patchBinaries = "ApplyPatchConcurrentlyCorruptedPatches";
+	std::filesystem::remove_all( patchBinaries );
+	std::filesystem::copy( GetTestFileFileAbsolutePath( "PatchWithInputChunk/LocalCDNPatches" ), patchBinaries, std::filesystem::copy_options::recursive );
+	std::ofstream corruptedPatch( patchBinaries / "b6" / "b6162ef461fa3547_80575d7211c77cb6d98957287349d61c", std::ios::binary | std::ios::trunc );
+	corruptedPatch << "Not a patch";
+	corruptedPatch.close();
+
+	// Apply sequentially and with a worker per resource, both in place
+	CarbonResources::Result results[2];
+
+	std::filesystem::path destinations[2] = { "ApplyPatchCorruptedSequentialOut", "ApplyPatchCorruptedConcurrentOut" };
+
+	unsigned int threadCounts[2] = { 1, 3 };
+
+	std::filesystem::path previousResources = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources" );
+
+	for( int i = 0; i < 2; i++ )
+	{
+		std::filesystem::remove_all( destinations[i] );
+		std::filesystem::copy( previousResources, destinations[i], std::filesystem::copy_options::recursive );
+
+		CarbonResources::PatchApplyParams patchApplyParams;
+
+		patchApplyParams.nextBuildResourcesSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+		patchApplyParams.nextBuildResourcesSourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/" ) };
+
+		patchApplyParams.patchBinarySourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_CDN;
+
+		patchApplyParams.patchBinarySourceSettings.basePaths = { patchBinaries };
+
+		patchApplyParams.resourcesToPatchSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+		patchApplyParams.resourcesToPatchSourceSettings.basePaths = { destinations[i] };
+
+		patchApplyParams.resourcesToPatchDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+		patchApplyParams.resourcesToPatchDestinationSettings.basePath = destinations[i];
+
+		patchApplyParams.temporaryFilePath = destinations[i].string() + "Staging/tempFile.resource";
+
+		patchApplyParams.applyThreadCount = threadCounts[i];
+
+		results[i] = patchResourceGroup.Apply( patchApplyParams );
+	}
+
+	// Whichever worker fails first, the failure of the first resource in order is returned, as when applied sequentially
+	EXPECT_NE( results[1].type, CarbonResources::ResultType::SUCCESS );
+	EXPECT_EQ( results[1].type, results[0].type );
+
+	// The resource with the corrupted patch is left as it was
+	EXPECT_TRUE( FilesMatch( previousResources / "introMovieSomewhatChanged.txt", destinations[1] / "introMovieSomewhatChanged.txt" ) );
+}
+
+TEST_F( ResourcesLibraryTest, ApplyPatchFromBundle )
+{
+	// Load the patch file
+	CarbonResources::PatchResourceGroup patchResourceGroup;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPatch;
+
+	importParamsPatch.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PatchResourceGroup_previousBuild_latestBuild.yaml" );
+
+	EXPECT_EQ( patchResourceGroup.ImportFromFile( importParamsPatch ).type, CarbonResources::ResultType::SUCCESS );
+
+
+	// Bundle the patch binaries, small chunks spread patches over several
+	CarbonResources::BundleCreateParams bundleCreateParams;
+
+	bundleCreateParams.resourceGroupRelativePath = "PatchResourceGroup.yaml";
+
+	bundleCreateParams.resourceGroupBundleRelativePath = "BundleResourceGroup.yaml";
+
+	bundleCreateParams.resourceSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_CDN;
+
+	bundleCreateParams.resourceSourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/LocalCDNPatches/" ) };
+
+	bundleCreateParams.chunkDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_CDN;
+
+	bundleCreateParams.chunkDestinationSettings.basePath = "ApplyPatchFromBundleChunks";
+
+	bundleCreateParams.resourceBundleResourceGroupDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	bundleCreateParams.resourceBundleResourceGroupDestinationSettings.basePath = "ApplyPatchFromBundleGroup";
+
+	bundleCreateParams.chunkSize = 100;
+
+	EXPECT_EQ( patchResourceGroup.CreateBundle( bundleCreateParams ).type, CarbonResources::ResultType::SUCCESS );
+
+
+	// Load the bundle file
+	CarbonResources::BundleResourceGroup bundleResourceGroup;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsBundle;
+
+	importParamsBundle.filename = bundleCreateParams.resourceBundleResourceGroupDestinationSettings.basePath / bundleCreateParams.resourceGroupBundleRelativePath;
+
+	EXPECT_EQ( bundleResourceGroup.ImportFromFile( importParamsBundle ).type, CarbonResources::ResultType::SUCCESS );
+
+
+	// Apply the patch straight from the chunks
+	CarbonResources::BundleApplyPatchParams bundleApplyPatchParams;
+
+	bundleApplyPatchParams.chunkSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_CDN;
+
+	bundleApplyPatchParams.chunkSourceSettings.basePaths = { bundleCreateParams.chunkDestinationSettings.basePath };
+
+	CarbonResources::PatchApplyParams& patchApplyParams = bundleApplyPatchParams.patchApplyParams;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/" ) };
+
+	patchApplyParams.resourcesToPatchSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchSourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources/" ) };
+
+	patchApplyParams.resourcesToPatchDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchDestinationSettings.basePath = "ApplyPatchFromBundleOut";
+
+	patchApplyParams.temporaryFilePath = "ApplyPatchFromBundleStaging/tempFile.resource";
+
+	EXPECT_EQ( bundleResourceGroup.ApplyPatch( bundleApplyPatchParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	std::filesystem::path nextIntroMovie = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/introMovie.txt" );
+	EXPECT_TRUE( FilesMatch( nextIntroMovie, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "introMovie.txt" ) );
+	std::filesystem::path nextIntroMoviePrefixed = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/introMoviePrefixed.txt" );
+	EXPECT_TRUE( FilesMatch( nextIntroMoviePrefixed, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "introMoviePrefixed.txt" ) );
+	std::filesystem::path nextTestResource = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/testresource2.txt" );
+	EXPECT_TRUE( FilesMatch( nextTestResource, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "testresource2.txt" ) );
+
+	// No patch binaries are unpacked
+	EXPECT_FALSE( std::filesystem::exists( patchApplyParams.resourcesToPatchDestinationSettings.basePath / "Patches" ) );
+}
+
+TEST_F( ResourcesLibraryTest, ApplyPatchResumesAfterBeingKilled )
+{
+	// Load the patch file
+	CarbonResources::PatchResourceGroup patchResourceGroup;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPatch;
+
+	importParamsPatch.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PatchResourceGroup_previousBuild_latestBuild.yaml" );
+
+	EXPECT_EQ( patchResourceGroup.ImportFromFile( importParamsPatch ).type, CarbonResources::ResultType::SUCCESS );
+
+
+	// Patch in place, the previous version of each resource is gone once it is patched
+	std::filesystem::path previousBuildResources = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources/" );
+
+	std::filesystem::path workingResources = "ApplyPatchResumeWorking";
+
+	CarbonResources::PatchApplyParams patchApplyParams;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/" ) };
+
+	patchApplyParams.patchBinarySourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_CDN;
+
+	patchApplyParams.patchBinarySourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/LocalCDNPatches/" ) };
+
+	patchApplyParams.resourcesToPatchSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchSourceSettings.basePaths = { workingResources };
+
+	patchApplyParams.resourcesToPatchDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchDestinationSettings.basePath = workingResources;
+
+	patchApplyParams.temporaryFilePath = "ApplyPatchResumeStaging/tempFile.resource";
+
+	patchApplyParams.journalFilePath = "ApplyPatchResumeStaging/apply.journal";
+
+
+	// Count the resources the patch writes
+	CarbonResources::PatchApplyParams countParams = patchApplyParams;
+
+	countParams.resourcesToPatchSourceSettings.basePaths = { previousBuildResources };
+
+	countParams.resourcesToPatchDestinationSettings.basePath = "ApplyPatchResumeCount";
+
+	countParams.journalFilePath.clear();
+
+	int resourceCount = 0;
+
+	countParams.statusCallback = [&resourceCount]( CarbonResources::StatusLevel, CarbonResources::StatusProgressType, unsigned int, const std::string& info ) {
+		if( info.rfind( "Patching: ", 0 ) == 0 )
+		{
+			resourceCount++;
+		}
+	};
+
+	EXPECT_EQ( patchResourceGroup.Apply( countParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	ASSERT_GT( resourceCount, 1 );
+
+
+	// Kill the process at each step of each resource in turn, the resources before it already replaced.
+	// Killed after the journal records a resource as moving, the resume has to check the destination's checksum
+	// to tell if the move happened: before it the old file is patched again, unless it is unchanged by the patch,
+	// after it the file is kept.
+	struct KillPoint
+	{
+		const char* status;
+
+		bool resourceReplaced;
+	};
+
+	const KillPoint killPoints[] = { { "Patching: ", false }, { "Moving into place: ", false }, { "Moved into place: ", true } };
+
+	for( const KillPoint& killPoint : killPoints )
+	{
+		for( int killAt = 1; killAt <= resourceCount; killAt++ )
+		{
+			std::filesystem::remove_all( workingResources );
+
+			std::filesystem::copy( previousBuildResources, workingResources, std::filesystem::copy_options::recursive );
+
+			std::filesystem::remove( patchApplyParams.journalFilePath );
+
+			auto applyUntilKilled = [&patchResourceGroup, &patchApplyParams, &killPoint, killAt]() {
+				CarbonResources::PatchApplyParams killedParams = patchApplyParams;
+
+				int reached = 0;
+
+				killedParams.statusCallback = [&reached, &killPoint, killAt]( CarbonResources::StatusLevel, CarbonResources::StatusProgressType, unsigned int, const std::string& info ) {
+					if( info.rfind( killPoint.status, 0 ) == 0 && ++reached == killAt )
+					{
+						std::_Exit( 1 );
+					}
+				};
+
+				patchResourceGroup.Apply( killedParams );
+
+				std::_Exit( 0 );
+			};
+
+			EXPECT_EXIT( applyUntilKilled(), ::testing::ExitedWithCode( 1 ), "" );
+
+			ASSERT_TRUE( std::filesystem::exists( patchApplyParams.journalFilePath ) );
+
+			// The killed resource is left recorded as moving, with nothing after it
+			bool killedResourceVerified = false;
+
+			if( &killPoint != &killPoints[0] )
+			{
+				std::ifstream journal( patchApplyParams.journalFilePath );
+
+				std::string line;
+
+				std::string lastLine;
+
+				while( std::getline( journal, line ) )
+				{
+					lastLine = line;
+				}
+
+				journal.close();
+
+				std::istringstream lastLineStream( lastLine );
+
+				std::string entryType;
+
+				std::string checksum;
+
+				uintmax_t size;
+
+				std::string killedResource;
+
+				ASSERT_TRUE( lastLineStream >> entryType >> checksum >> size );
+
+				ASSERT_TRUE( std::getline( lastLineStream >> std::ws, killedResource ) );
+
+				EXPECT_EQ( entryType, "M" );
+
+				bool killedResourceUnchanged = FilesMatch( previousBuildResources / killedResource, GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources" ) / killedResource );
+
+				killedResourceVerified = killPoint.resourceReplaced || killedResourceUnchanged;
+			}
+
+			// Left behind by the killed Apply, next to a file which only looks like a worker's
+			std::ofstream( patchApplyParams.temporaryFilePath ) << "interrupted";
+
+			std::filesystem::path unrelatedFilePath = patchApplyParams.temporaryFilePath.string() + ".0";
+
+			std::ofstream( unrelatedFilePath ) << "unrelated";
+
+			// Running again skips the resources already patched and finishes the rest
+			int skipped = 0;
+
+			patchApplyParams.statusCallback = [&skipped]( CarbonResources::StatusLevel, CarbonResources::StatusProgressType, unsigned int, const std::string& info ) {
+				if( info.rfind( "Already patched: ", 0 ) == 0 )
+				{
+					skipped++;
+				}
+			};
+
+			EXPECT_EQ( patchResourceGroup.Apply( patchApplyParams ).type, CarbonResources::ResultType::SUCCESS );
+
+			patchApplyParams.statusCallback = nullptr;
+
+			EXPECT_EQ( skipped, killedResourceVerified ? killAt : killAt - 1 );
+
+			std::filesystem::path nextIntroMovie = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/introMovie.txt" );
+			EXPECT_TRUE( FilesMatch( nextIntroMovie, workingResources / "introMovie.txt" ) );
+			std::filesystem::path nextIntroMoviePrefixed = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/introMoviePrefixed.txt" );
+			EXPECT_TRUE( FilesMatch( nextIntroMoviePrefixed, workingResources / "introMoviePrefixed.txt" ) );
+			std::filesystem::path nextTestResource = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/testresource2.txt" );
+			EXPECT_TRUE( FilesMatch( nextTestResource, workingResources / "testresource2.txt" ) );
+
+			EXPECT_FALSE( std::filesystem::exists( patchApplyParams.journalFilePath ) );
+			EXPECT_FALSE( std::filesystem::exists( patchApplyParams.temporaryFilePath ) );
+			EXPECT_TRUE( std::filesystem::exists( unrelatedFilePath ) );
+
+			std::filesystem::remove( unrelatedFilePath );
+		}
+	}
+}
+
+#ifndef WIN32
+TEST_F( ResourcesLibraryTest, ApplyPatchKeepsPermissionsOfReplacedFiles )
+{
+	// Load the patch file, its resources have no binary operation
+	CarbonResources::PatchResourceGroup patchResourceGroup;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPatch;
+
+	importParamsPatch.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PatchResourceGroup_previousBuild_latestBuild.yaml" );
+
+	EXPECT_EQ( patchResourceGroup.ImportFromFile( importParamsPatch ).type, CarbonResources::ResultType::SUCCESS );
+
+
+	// Patch in place over an executable previous version
+	std::filesystem::path workingResources = "ApplyPatchPermissionsWorking";
+
+	std::filesystem::remove_all( workingResources );
+
+	std::filesystem::copy( GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources/" ), workingResources, std::filesystem::copy_options::recursive );
+
+	std::filesystem::path executableResource = workingResources / "introMovieSomewhatChanged.txt";
+
+	std::filesystem::perms executablePermissions = std::filesystem::perms::owner_all | std::filesystem::perms::group_read | std::filesystem::perms::group_exec | std::filesystem::perms::others_read | std::filesystem::perms::others_exec;
+
+	std::filesystem::permissions( executableResource, executablePermissions, std::filesystem::perm_options::replace );
+
+	CarbonResources::PatchApplyParams patchApplyParams;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/" ) };
+
+	patchApplyParams.patchBinarySourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_CDN;
+
+	patchApplyParams.patchBinarySourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/LocalCDNPatches/" ) };
+
+	patchApplyParams.resourcesToPatchSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchSourceSettings.basePaths = { workingResources };
+
+	patchApplyParams.resourcesToPatchDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchDestinationSettings.basePath = workingResources;
+
+	patchApplyParams.temporaryFilePath = "ApplyPatchPermissionsStaging/tempFile.resource";
+
+	EXPECT_EQ( patchResourceGroup.Apply( patchApplyParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	std::filesystem::path nextResource = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/introMovieSomewhatChanged.txt" );
+	EXPECT_TRUE( FilesMatch( nextResource, executableResource ) );
+
+	EXPECT_EQ( std::filesystem::status( executableResource ).permissions() & std::filesystem::perms::mask, executablePermissions );
+}
+#endif
+
 TEST_F( ResourcesLibraryTest, CreatePatchWithChunking )
 {
-	// Previous ResourceGroup
-	CarbonResources::ResourceGroup resourceGroupPrevious;
+	// Previous ResourceGroup
+	CarbonResources::ResourceGroup resourceGroupPrevious;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPrevious;
+
+	importParamsPrevious.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_previous.txt" );
+
+	EXPECT_EQ( resourceGroupPrevious.ImportFromFile( importParamsPrevious ).type, CarbonResources::ResultType::SUCCESS );
+
+
+	// Latest ResourceGroup
+	CarbonResources::ResourceGroup resourceGroupLatest;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsLatest;
+
+	importParamsLatest.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_next.txt" );
+
+	EXPECT_EQ( resourceGroupLatest.ImportFromFile( importParamsLatest ).type, CarbonResources::ResultType::SUCCESS );
+
+
+
+	// Create a patch from the subtraction index
+	CarbonResources::PatchCreateParams patchCreateParams;
+
+	patchCreateParams.resourceGroupRelativePath = "ResourceGroup_previousBuild_latestBuild.yaml";
+
+	patchCreateParams.resourceGroupPatchRelativePath = "PatchResourceGroup_previousBuild_latestBuild.yaml";
+
+	patchCreateParams.resourceSourceSettingsPrevious.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourceSourceSettingsPrevious.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources" ) };
+
+	patchCreateParams.resourceSourceSettingsNext.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourceSourceSettingsNext.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources" ) };
+
+	patchCreateParams.resourcePatchBinaryDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_CDN;
+
+	patchCreateParams.resourcePatchBinaryDestinationSettings.basePath = "SharedCache";
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath = "resPath";
+
+	patchCreateParams.patchFileRelativePathPrefix = "Patches/Patch1";
+
+	patchCreateParams.previousResourceGroup = &resourceGroupPrevious;
+
+	patchCreateParams.maxInputFileChunkSize = 500;
+
+	EXPECT_EQ( resourceGroupLatest.CreatePatch( patchCreateParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	std::filesystem::path goldFile = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PatchResourceGroup_previousBuild_latestBuild.yaml" );
+	EXPECT_TRUE( FilesMatch( goldFile, patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath / "PatchResourceGroup_previousBuild_latestBuild.yaml" ) );
+
+	std::filesystem::path goldDirectory = GetTestFileFileAbsolutePath( "PatchWithInputChunk/LocalCDNPatches" );
+	EXPECT_TRUE( DirectoryIsSubset( goldDirectory, patchCreateParams.resourcePatchBinaryDestinationSettings.basePath ) );
+}
+
+TEST_F( ResourcesLibraryTest, CreatePatchWithChunkingUsingIndexCache )
+{
+	// Previous ResourceGroup
+	CarbonResources::ResourceGroup resourceGroupPrevious;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPrevious;
+
+	importParamsPrevious.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_previous.txt" );
+
+	EXPECT_EQ( resourceGroupPrevious.ImportFromFile( importParamsPrevious ).type, CarbonResources::ResultType::SUCCESS );
+
+
+	// Latest ResourceGroup
+	CarbonResources::ResourceGroup resourceGroupLatest;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsLatest;
+
+	importParamsLatest.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_next.txt" );
+
+	EXPECT_EQ( resourceGroupLatest.ImportFromFile( importParamsLatest ).type, CarbonResources::ResultType::SUCCESS );
+
+	std::filesystem::path indexCacheFolder = "IndexCache";
+
+	std::filesystem::remove_all( indexCacheFolder );
+
+	// The first run populates the cache, the second uses it, both must match the uncached output
+	for( int run = 0; run < 2; ++run )
+	{
+		CarbonResources::PatchCreateParams patchCreateParams;
+
+		patchCreateParams.resourceGroupRelativePath = "ResourceGroup_previousBuild_latestBuild.yaml";
+
+		patchCreateParams.resourceGroupPatchRelativePath = "PatchResourceGroup_previousBuild_latestBuild.yaml";
+
+		patchCreateParams.resourceSourceSettingsPrevious.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+		patchCreateParams.resourceSourceSettingsPrevious.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources" ) };
+
+		patchCreateParams.resourceSourceSettingsNext.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+		patchCreateParams.resourceSourceSettingsNext.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources" ) };
+
+		patchCreateParams.resourcePatchBinaryDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_CDN;
+
+		patchCreateParams.resourcePatchBinaryDestinationSettings.basePath = "SharedCacheIndexCache";
+
+		patchCreateParams.resourcePatchResourceGroupDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+		patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath = "resPathIndexCache";
+
+		patchCreateParams.patchFileRelativePathPrefix = "Patches/Patch1";
+
+		patchCreateParams.previousResourceGroup = &resourceGroupPrevious;
+
+		patchCreateParams.maxInputFileChunkSize = 500;
+
+		patchCreateParams.indexCacheFolder = indexCacheFolder;
+
+		EXPECT_EQ( resourceGroupLatest.CreatePatch( patchCreateParams ).type, CarbonResources::ResultType::SUCCESS );
+
+		EXPECT_FALSE( std::filesystem::is_empty( indexCacheFolder ) );
+
+		std::filesystem::path goldFile = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PatchResourceGroup_previousBuild_latestBuild.yaml" );
+		EXPECT_TRUE( FilesMatch( goldFile, patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath / "PatchResourceGroup_previousBuild_latestBuild.yaml" ) );
+
+		std::filesystem::path goldDirectory = GetTestFileFileAbsolutePath( "PatchWithInputChunk/LocalCDNPatches" );
+		EXPECT_TRUE( DirectoryIsSubset( goldDirectory, patchCreateParams.resourcePatchBinaryDestinationSettings.basePath ) );
+	}
+}
+
+TEST_F( ResourcesLibraryTest, CreatePatchWithChunkingMultiThreaded )
+{
+	// Previous ResourceGroup
+	CarbonResources::ResourceGroup resourceGroupPrevious;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPrevious;
+
+	importParamsPrevious.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_previous.txt" );
+
+	EXPECT_EQ( resourceGroupPrevious.ImportFromFile( importParamsPrevious ).type, CarbonResources::ResultType::SUCCESS );
+
+
+	// Latest ResourceGroup
+	CarbonResources::ResourceGroup resourceGroupLatest;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsLatest;
+
+	importParamsLatest.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_next.txt" );
+
+	EXPECT_EQ( resourceGroupLatest.ImportFromFile( importParamsLatest ).type, CarbonResources::ResultType::SUCCESS );
+
+	// Output must match the single threaded output, also when patches have to wait on the memory budget
+	for( uintmax_t patchMemoryBudget : { uintmax_t( 1073741824 ), uintmax_t( 1 ) } )
+	{
+		CarbonResources::PatchCreateParams patchCreateParams;
+
+		patchCreateParams.resourceGroupRelativePath = "ResourceGroup_previousBuild_latestBuild.yaml";
+
+		patchCreateParams.resourceGroupPatchRelativePath = "PatchResourceGroup_previousBuild_latestBuild.yaml";
+
+		patchCreateParams.resourceSourceSettingsPrevious.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+		patchCreateParams.resourceSourceSettingsPrevious.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources" ) };
+
+		patchCreateParams.resourceSourceSettingsNext.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+		patchCreateParams.resourceSourceSettingsNext.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources" ) };
+
+		patchCreateParams.resourcePatchBinaryDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_CDN;
+
+		patchCreateParams.resourcePatchBinaryDestinationSettings.basePath = "SharedCacheMultiThreaded" + std::to_string( patchMemoryBudget );
+
+		patchCreateParams.resourcePatchResourceGroupDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+		patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath = "resPathMultiThreaded" + std::to_string( patchMemoryBudget );
+
+		patchCreateParams.patchFileRelativePathPrefix = "Patches/Patch1";
+
+		patchCreateParams.previousResourceGroup = &resourceGroupPrevious;
+
+		patchCreateParams.maxInputFileChunkSize = 500;
+
+		patchCreateParams.patchThreadCount = 4;
+
+		patchCreateParams.patchMemoryBudget = patchMemoryBudget;
+
+		EXPECT_EQ( resourceGroupLatest.CreatePatch( patchCreateParams ).type, CarbonResources::ResultType::SUCCESS );
+
+		std::filesystem::path goldFile = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PatchResourceGroup_previousBuild_latestBuild.yaml" );
+		EXPECT_TRUE( FilesMatch( goldFile, patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath / "PatchResourceGroup_previousBuild_latestBuild.yaml" ) );
+
+		std::filesystem::path goldDirectory = GetTestFileFileAbsolutePath( "PatchWithInputChunk/LocalCDNPatches" );
+		EXPECT_TRUE( DirectoryIsSubset( goldDirectory, patchCreateParams.resourcePatchBinaryDestinationSettings.basePath ) );
+	}
+}
+
+TEST_F( ResourcesLibraryTest, CreatePatchWithChunkingParallelDiff )
+{
+	// Previous ResourceGroup
+	CarbonResources::ResourceGroup resourceGroupPrevious;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPrevious;
+
+	importParamsPrevious.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_previous.txt" );
+
+	EXPECT_EQ( resourceGroupPrevious.ImportFromFile( importParamsPrevious ).type, CarbonResources::ResultType::SUCCESS );
+
+
+	// Latest ResourceGroup
+	CarbonResources::ResourceGroup resourceGroupLatest;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsLatest;
+
+	importParamsLatest.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_next.txt" );
+
+	EXPECT_EQ( resourceGroupLatest.ImportFromFile( importParamsLatest ).type, CarbonResources::ResultType::SUCCESS );
+
+	CarbonResources::PatchCreateParams patchCreateParams;
+
+	patchCreateParams.resourceGroupRelativePath = "ResourceGroup_previousBuild_latestBuild.yaml";
+
+	patchCreateParams.resourceGroupPatchRelativePath = "PatchResourceGroup_previousBuild_latestBuild.yaml";
+
+	patchCreateParams.resourceSourceSettingsPrevious.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourceSourceSettingsPrevious.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources" ) };
+
+	patchCreateParams.resourceSourceSettingsNext.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourceSourceSettingsNext.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources" ) };
+
+	patchCreateParams.resourcePatchBinaryDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_CDN;
+
+	patchCreateParams.resourcePatchBinaryDestinationSettings.basePath = "SharedCacheParallelDiff";
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath = "resPathParallelDiff";
+
+	patchCreateParams.patchFileRelativePathPrefix = "Patches/Patch1";
+
+	patchCreateParams.previousResourceGroup = &resourceGroupPrevious;
+
+	patchCreateParams.maxInputFileChunkSize = 500;
+
+	patchCreateParams.diffThreadCount = 4;
+
+	EXPECT_EQ( resourceGroupLatest.CreatePatch( patchCreateParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	std::filesystem::path goldFile = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PatchResourceGroup_previousBuild_latestBuild.yaml" );
+	EXPECT_TRUE( FilesMatch( goldFile, patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath / "PatchResourceGroup_previousBuild_latestBuild.yaml" ) );
+
+	std::filesystem::path goldDirectory = GetTestFileFileAbsolutePath( "PatchWithInputChunk/LocalCDNPatches" );
+	EXPECT_TRUE( DirectoryIsSubset( goldDirectory, patchCreateParams.resourcePatchBinaryDestinationSettings.basePath ) );
+}
+
+TEST_F( ResourcesLibraryTest, CreateAndApplyPatchWithContentDefinedChunking )
+{
+	// Previous ResourceGroup
+	CarbonResources::ResourceGroup resourceGroupPrevious;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPrevious;
+
+	importParamsPrevious.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_previous.txt" );
+
+	EXPECT_EQ( resourceGroupPrevious.ImportFromFile( importParamsPrevious ).type, CarbonResources::ResultType::SUCCESS );
+
+
+	// Latest ResourceGroup
+	CarbonResources::ResourceGroup resourceGroupLatest;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsLatest;
+
+	importParamsLatest.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_next.txt" );
+
+	EXPECT_EQ( resourceGroupLatest.ImportFromFile( importParamsLatest ).type, CarbonResources::ResultType::SUCCESS );
+
+	// Patches differ from the fixed size chunking ones, so check they apply rather than compare them
+	CarbonResources::PatchCreateParams patchCreateParams;
+
+	patchCreateParams.resourceGroupRelativePath = "ResourceGroup_previousBuild_latestBuild.yaml";
+
+	patchCreateParams.resourceGroupPatchRelativePath = "PatchResourceGroup_previousBuild_latestBuild.yaml";
+
+	patchCreateParams.resourceSourceSettingsPrevious.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourceSourceSettingsPrevious.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources" ) };
+
+	patchCreateParams.resourceSourceSettingsNext.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourceSourceSettingsNext.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources" ) };
+
+	patchCreateParams.resourcePatchBinaryDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_CDN;
+
+	patchCreateParams.resourcePatchBinaryDestinationSettings.basePath = "SharedCacheContentDefined";
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath = "resPathContentDefined";
+
+	patchCreateParams.patchFileRelativePathPrefix = "Patches/Patch1";
+
+	patchCreateParams.previousResourceGroup = &resourceGroupPrevious;
+
+	patchCreateParams.maxInputFileChunkSize = 500;
+
+	patchCreateParams.contentDefinedChunking = true;
+
+	EXPECT_EQ( resourceGroupLatest.CreatePatch( patchCreateParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	// Apply the patch
+	CarbonResources::PatchResourceGroup patchResourceGroup;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPatch;
+
+	importParamsPatch.filename = patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath / "PatchResourceGroup_previousBuild_latestBuild.yaml";
+
+	EXPECT_EQ( patchResourceGroup.ImportFromFile( importParamsPatch ).type, CarbonResources::ResultType::SUCCESS );
+
+	CarbonResources::PatchApplyParams patchApplyParams;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/" ) };
+
+	patchApplyParams.patchBinarySourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_CDN;
+
+	patchApplyParams.patchBinarySourceSettings.basePaths = { patchCreateParams.resourcePatchBinaryDestinationSettings.basePath };
+
+	patchApplyParams.resourcesToPatchSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchSourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources/" ) };
+
+	patchApplyParams.resourcesToPatchDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchDestinationSettings.basePath = "ApplyPatchWithContentDefinedChunkingOut";
+
+	patchApplyParams.temporaryFilePath = "tempFile.resource";
+
+	EXPECT_EQ( patchResourceGroup.Apply( patchApplyParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	std::filesystem::path nextIntroMovie = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/introMovie.txt" );
+	EXPECT_TRUE( FilesMatch( nextIntroMovie, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "introMovie.txt" ) );
+	std::filesystem::path nextIntroMoviePrefixed = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/introMoviePrefixed.txt" );
+	EXPECT_TRUE( FilesMatch( nextIntroMoviePrefixed, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "introMoviePrefixed.txt" ) );
+	std::filesystem::path nextTestResource = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/testresource2.txt" );
+	EXPECT_TRUE( FilesMatch( nextTestResource, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "testresource2.txt" ) );
+}
+
+TEST_F( ResourcesLibraryTest, CreateAndApplyPatchWithZstdDiffEngine )
+{
+	// Previous ResourceGroup
+	CarbonResources::ResourceGroup resourceGroupPrevious;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPrevious;
+
+	importParamsPrevious.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_previous.txt" );
+
+	EXPECT_EQ( resourceGroupPrevious.ImportFromFile( importParamsPrevious ).type, CarbonResources::ResultType::SUCCESS );
+
+
+	// Latest ResourceGroup
+	CarbonResources::ResourceGroup resourceGroupLatest;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsLatest;
+
+	importParamsLatest.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_next.txt" );
+
+	EXPECT_EQ( resourceGroupLatest.ImportFromFile( importParamsLatest ).type, CarbonResources::ResultType::SUCCESS );
+
+	// zstd patches differ from the bsdiff ones, so check they apply rather than compare them
+	CarbonResources::PatchCreateParams patchCreateParams;
+
+	patchCreateParams.resourceGroupRelativePath = "ResourceGroup_previousBuild_latestBuild.yaml";
+
+	patchCreateParams.resourceGroupPatchRelativePath = "PatchResourceGroup_previousBuild_latestBuild.yaml";
+
+	patchCreateParams.resourceSourceSettingsPrevious.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourceSourceSettingsPrevious.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources" ) };
+
+	patchCreateParams.resourceSourceSettingsNext.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourceSourceSettingsNext.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources" ) };
+
+	patchCreateParams.resourcePatchBinaryDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_CDN;
+
+	patchCreateParams.resourcePatchBinaryDestinationSettings.basePath = "SharedCacheZstd";
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath = "resPathZstd";
+
+	patchCreateParams.patchFileRelativePathPrefix = "Patches/Patch1";
+
+	patchCreateParams.previousResourceGroup = &resourceGroupPrevious;
+
+	patchCreateParams.maxInputFileChunkSize = 500;
+
+	patchCreateParams.diffEngine = CarbonResources::DiffEngineType::ZSTD;
+
+	EXPECT_EQ( resourceGroupLatest.CreatePatch( patchCreateParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	// The engine is recorded so clients know how to apply the patches
+	std::ifstream patchResourceGroupFile( patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath / "PatchResourceGroup_previousBuild_latestBuild.yaml" );
+	std::stringstream patchResourceGroupContents;
+	patchResourceGroupContents << patchResourceGroupFile.rdbuf();
+	EXPECT_NE( patchResourceGroupContents.str().find( "DiffEngine: zstd" ), std::string::npos );
+
+	// Apply the patch
+	CarbonResources::PatchResourceGroup patchResourceGroup;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPatch;
+
+	importParamsPatch.filename = patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath / "PatchResourceGroup_previousBuild_latestBuild.yaml";
+
+	EXPECT_EQ( patchResourceGroup.ImportFromFile( importParamsPatch ).type, CarbonResources::ResultType::SUCCESS );
+
+	CarbonResources::PatchApplyParams patchApplyParams;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/" ) };
+
+	patchApplyParams.patchBinarySourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_CDN;
+
+	patchApplyParams.patchBinarySourceSettings.basePaths = { patchCreateParams.resourcePatchBinaryDestinationSettings.basePath };
+
+	patchApplyParams.resourcesToPatchSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchSourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources/" ) };
+
+	patchApplyParams.resourcesToPatchDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchDestinationSettings.basePath = "ApplyPatchWithZstdOut";
+
+	patchApplyParams.temporaryFilePath = "tempFile.resource";
+
+	EXPECT_EQ( patchResourceGroup.Apply( patchApplyParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	std::filesystem::path nextIntroMovie = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/introMovie.txt" );
+	EXPECT_TRUE( FilesMatch( nextIntroMovie, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "introMovie.txt" ) );
+	std::filesystem::path nextIntroMoviePrefixed = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/introMoviePrefixed.txt" );
+	EXPECT_TRUE( FilesMatch( nextIntroMoviePrefixed, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "introMoviePrefixed.txt" ) );
+	std::filesystem::path nextTestResource = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/testresource2.txt" );
+	EXPECT_TRUE( FilesMatch( nextTestResource, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "testresource2.txt" ) );
+}
+
+TEST_F( ResourcesLibraryTest, CreateAndApplyPatchWithPatchCache )
+{
+	// Previous ResourceGroup
+	CarbonResources::ResourceGroup resourceGroupPrevious;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPrevious;
+
+	importParamsPrevious.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_previous.txt" );
+
+	EXPECT_EQ( resourceGroupPrevious.ImportFromFile( importParamsPrevious ).type, CarbonResources::ResultType::SUCCESS );
+
+
+	// Latest ResourceGroup
+	CarbonResources::ResourceGroup resourceGroupLatest;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsLatest;
+
+	importParamsLatest.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_next.txt" );
+
+	EXPECT_EQ( resourceGroupLatest.ImportFromFile( importParamsLatest ).type, CarbonResources::ResultType::SUCCESS );
+
+	std::filesystem::path patchCacheFolder = "PatchCache";
+
+	std::filesystem::remove_all( patchCacheFolder );
+
+	CarbonResources::PatchCreateParams patchCreateParams;
+
+	patchCreateParams.resourceGroupRelativePath = "ResourceGroup_previousBuild_latestBuild.yaml";
+
+	patchCreateParams.resourceGroupPatchRelativePath = "PatchResourceGroup_previousBuild_latestBuild.yaml";
+
+	patchCreateParams.resourceSourceSettingsPrevious.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourceSourceSettingsPrevious.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources" ) };
+
+	patchCreateParams.resourceSourceSettingsNext.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourceSourceSettingsNext.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources" ) };
+
+	patchCreateParams.resourcePatchBinaryDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_CDN;
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchCreateParams.patchFileRelativePathPrefix = "Patches/Patch1";
+
+	patchCreateParams.previousResourceGroup = &resourceGroupPrevious;
+
+	patchCreateParams.maxInputFileChunkSize = 500;
+
+	patchCreateParams.patchCacheFolder = patchCacheFolder;
+
+	uintmax_t patchCacheHits{ 0 };
+
+	uintmax_t patchCacheMisses{ 0 };
+
+	patchCreateParams.patchCacheHits = &patchCacheHits;
+
+	patchCreateParams.patchCacheMisses = &patchCacheMisses;
+
+	// First run fills the cache
+	patchCreateParams.resourcePatchBinaryDestinationSettings.basePath = "SharedCachePatchCacheFirst";
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath = "resPathPatchCacheFirst";
+
+	EXPECT_EQ( resourceGroupLatest.CreatePatch( patchCreateParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	EXPECT_EQ( patchCacheHits, 0 );
+
+	EXPECT_GT( patchCacheMisses, 0 );
+
+	uintmax_t patchedResourceCount = patchCacheMisses;
+
+	// Second run takes every patch from the cache and produces the same output
+	patchCreateParams.resourcePatchBinaryDestinationSettings.basePath = "SharedCachePatchCacheSecond";
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath = "resPathPatchCacheSecond";
+
+	EXPECT_EQ( resourceGroupLatest.CreatePatch( patchCreateParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	EXPECT_EQ( patchCacheHits, patchedResourceCount );
+
+	EXPECT_EQ( patchCacheMisses, 0 );
+
+	EXPECT_TRUE( FilesMatch( std::filesystem::path( "resPathPatchCacheFirst" ) / "PatchResourceGroup_previousBuild_latestBuild.yaml", std::filesystem::path( "resPathPatchCacheSecond" ) / "PatchResourceGroup_previousBuild_latestBuild.yaml" ) );
+
+	// Apply the patch created from the cache
+	CarbonResources::PatchResourceGroup patchResourceGroup;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPatch;
+
+	importParamsPatch.filename = patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath / "PatchResourceGroup_previousBuild_latestBuild.yaml";
+
+	EXPECT_EQ( patchResourceGroup.ImportFromFile( importParamsPatch ).type, CarbonResources::ResultType::SUCCESS );
+
+	CarbonResources::PatchApplyParams patchApplyParams;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/" ) };
+
+	patchApplyParams.patchBinarySourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_CDN;
+
+	patchApplyParams.patchBinarySourceSettings.basePaths = { patchCreateParams.resourcePatchBinaryDestinationSettings.basePath };
+
+	patchApplyParams.resourcesToPatchSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchSourceSettings.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources/" ) };
+
+	patchApplyParams.resourcesToPatchDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchDestinationSettings.basePath = "ApplyPatchWithPatchCacheOut";
+
+	patchApplyParams.temporaryFilePath = "tempFile.resource";
+
+	EXPECT_EQ( patchResourceGroup.Apply( patchApplyParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	std::filesystem::path nextIntroMovie = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/introMovie.txt" );
+	EXPECT_TRUE( FilesMatch( nextIntroMovie, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "introMovie.txt" ) );
+	std::filesystem::path nextIntroMoviePrefixed = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/introMoviePrefixed.txt" );
+	EXPECT_TRUE( FilesMatch( nextIntroMoviePrefixed, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "introMoviePrefixed.txt" ) );
+	std::filesystem::path nextTestResource = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/testresource2.txt" );
+	EXPECT_TRUE( FilesMatch( nextTestResource, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "testresource2.txt" ) );
+}
+
+TEST_F( ResourcesLibraryTest, CreateAndApplyPatchFromSeveralPreviousBuilds )
+{
+	// introMovie.txt is the same in both previous builds, changed.txt differs between them
+	std::filesystem::path firstDirectory = "SeveralPreviousBuildsFirst";
+	std::filesystem::path secondDirectory = "SeveralPreviousBuildsSecond";
+	std::filesystem::path nextDirectory = "SeveralPreviousBuildsNext";
+	std::filesystem::create_directories( firstDirectory );
+	std::filesystem::create_directories( secondDirectory );
+	std::filesystem::create_directories( nextDirectory );
+	std::filesystem::path previousResources = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources" );
+	std::filesystem::path nextResources = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources" );
+	auto overwrite = std::filesystem::copy_options::overwrite_existing;
+	std::filesystem::copy_file( previousResources / "introMovie.txt", firstDirectory / "introMovie.txt", overwrite );
+	std::filesystem::copy_file( previousResources / "introMovieSomewhatChanged.txt", firstDirectory / "changed.txt", overwrite );
+	std::filesystem::copy_file( previousResources / "testResource.txt", firstDirectory / "testResource.txt", overwrite );
+	std::filesystem::copy_file( previousResources / "introMovie.txt", secondDirectory / "introMovie.txt", overwrite );
+	std::filesystem::copy_file( nextResources / "introMovieSomewhatChanged.txt", secondDirectory / "changed.txt", overwrite );
+	std::filesystem::copy_file( nextResources / "introMovie.txt", nextDirectory / "introMovie.txt", overwrite );
+	std::filesystem::copy_file( nextResources / "introMoviePrefixed.txt", nextDirectory / "changed.txt", overwrite );
+	std::filesystem::copy_file( nextResources / "testResource2.txt", nextDirectory / "added.txt", overwrite );
+
+	CarbonResources::ResourceGroup resourceGroups[3];
+
+	std::filesystem::path directories[3] = { firstDirectory, secondDirectory, nextDirectory };
+
+	for( int i = 0; i < 3; i++ )
+	{
+		CarbonResources::CreateResourceGroupFromDirectoryParams createParams;
+
+		createParams.directory = directories[i];
+
+		EXPECT_EQ( resourceGroups[i].CreateFromDirectory( createParams ).type, CarbonResources::ResultType::SUCCESS );
+	}
+
+	CarbonResources::PatchCreateParams patchCreateParams;
+
+	patchCreateParams.previousResourceGroup = &resourceGroups[0];
+
+	patchCreateParams.resourceGroupRelativePath = "ResourceGroup_0.yaml";
+
+	patchCreateParams.resourceGroupPatchRelativePath = "PatchResourceGroup_0.yaml";
+
+	patchCreateParams.resourceSourceSettingsPrevious.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourceSourceSettingsPrevious.basePaths = { firstDirectory };
+
+	patchCreateParams.resourceSourceSettingsNext.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourceSourceSettingsNext.basePaths = { nextDirectory };
+
+	patchCreateParams.resourcePatchBinaryDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_CDN;
+
+	patchCreateParams.resourcePatchBinaryDestinationSettings.basePath = "SharedCacheSeveralPreviousBuilds";
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath = "resPathSeveralPreviousBuilds";
+
+	patchCreateParams.maxInputFileChunkSize = 500;
+
+	CarbonResources::PatchBaseParams secondBuild;
+
+	secondBuild.previousResourceGroup = &resourceGroups[1];
+
+	secondBuild.resourceSourceSettingsPrevious.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	secondBuild.resourceSourceSettingsPrevious.basePaths = { secondDirectory };
+
+	secondBuild.resourceGroupRelativePath = "ResourceGroup_1.yaml";
+
+	secondBuild.resourceGroupPatchRelativePath = "PatchResourceGroup_1.yaml";
+
+	patchCreateParams.additionalPreviousBuilds = { secondBuild };
+
+	std::vector<std::string> messages;
+
+	patchCreateParams.statusCallback = [&messages]( CarbonResources::StatusLevel, CarbonResources::StatusProgressType, unsigned int, const std::string& info ) {
+		messages.push_back( info );
+	};
+
+	EXPECT_EQ( resourceGroups[2].CreatePatch( patchCreateParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	// The patches of introMovie.txt from the first previous build serve the second
+	EXPECT_EQ( std::count( messages.begin(), messages.end(), "Creating patch for: introMovie.txt" ), 1 );
+
+	EXPECT_EQ( std::count( messages.begin(), messages.end(), "Reusing patches for: introMovie.txt" ), 1 );
+
+	EXPECT_EQ( std::count( messages.begin(), messages.end(), "Creating patch for: changed.txt" ), 2 );
+
+	// Apply the patch of each previous build
+	for( int i = 0; i < 2; i++ )
+	{
+		std::string step = std::to_string( i );
+
+		CarbonResources::PatchResourceGroup patchResourceGroup;
+
+		CarbonResources::ResourceGroupImportFromFileParams importParamsPatch;
+
+		importParamsPatch.filename = patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath / ( "PatchResourceGroup_" + step + ".yaml" );
+
+		EXPECT_EQ( patchResourceGroup.ImportFromFile( importParamsPatch ).type, CarbonResources::ResultType::SUCCESS );
+
+		CarbonResources::PatchApplyParams patchApplyParams;
+
+		patchApplyParams.nextBuildResourcesSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+		patchApplyParams.nextBuildResourcesSourceSettings.basePaths = { nextDirectory };
+
+		patchApplyParams.patchBinarySourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_CDN;
+
+		patchApplyParams.patchBinarySourceSettings.basePaths = { "SharedCacheSeveralPreviousBuilds" };
+
+		patchApplyParams.resourcesToPatchSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+		patchApplyParams.resourcesToPatchSourceSettings.basePaths = { directories[i] };
+
+		patchApplyParams.resourcesToPatchDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+		patchApplyParams.resourcesToPatchDestinationSettings.basePath = "ApplySeveralPreviousBuildsOut_" + step;
+
+		patchApplyParams.temporaryFilePath = "tempFile.resource";
+
+		EXPECT_EQ( patchResourceGroup.Apply( patchApplyParams ).type, CarbonResources::ResultType::SUCCESS );
+
+		EXPECT_TRUE( FilesMatch( nextDirectory / "introMovie.txt", patchApplyParams.resourcesToPatchDestinationSettings.basePath / "introMovie.txt" ) );
+		EXPECT_TRUE( FilesMatch( nextDirectory / "changed.txt", patchApplyParams.resourcesToPatchDestinationSettings.basePath / "changed.txt" ) );
+		EXPECT_TRUE( FilesMatch( nextDirectory / "added.txt", patchApplyParams.resourcesToPatchDestinationSettings.basePath / "added.txt" ) );
+	}
+}
+
+TEST_F( ResourcesLibraryTest, SquashAndApplyPatchChain )
+{
+	// introMovie.txt changes in the first patch only, changed.txt in both, testResource.txt is removed and added.txt added by the second
+	std::filesystem::path firstDirectory = "SquashPatchChainFirst";
+	std::filesystem::path secondDirectory = "SquashPatchChainSecond";
+	std::filesystem::path thirdDirectory = "SquashPatchChainThird";
+	std::filesystem::create_directories( firstDirectory );
+	std::filesystem::create_directories( secondDirectory );
+	std::filesystem::create_directories( thirdDirectory );
+	std::filesystem::path previousResources = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources" );
+	std::filesystem::path nextResources = GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources" );
+	auto overwrite = std::filesystem::copy_options::overwrite_existing;
+	std::filesystem::copy_file( previousResources / "introMovie.txt", firstDirectory / "introMovie.txt", overwrite );
+	std::filesystem::copy_file( previousResources / "introMovieSomewhatChanged.txt", firstDirectory / "changed.txt", overwrite );
+	std::filesystem::copy_file( previousResources / "testResource.txt", firstDirectory / "testResource.txt", overwrite );
+	std::filesystem::copy_file( nextResources / "introMovie.txt", secondDirectory / "introMovie.txt", overwrite );
+	std::filesystem::copy_file( nextResources / "introMovieSomewhatChanged.txt", secondDirectory / "changed.txt", overwrite );
+	std::filesystem::copy_file( previousResources / "testResource.txt", secondDirectory / "testResource.txt", overwrite );
+	std::filesystem::copy_file( nextResources / "introMovie.txt", thirdDirectory / "introMovie.txt", overwrite );
+	std::filesystem::copy_file( nextResources / "introMoviePrefixed.txt", thirdDirectory / "changed.txt", overwrite );
+	std::filesystem::copy_file( nextResources / "testResource2.txt", thirdDirectory / "added.txt", overwrite );
+
+	CarbonResources::ResourceGroup resourceGroups[3];
+
+	std::filesystem::path directories[3] = { firstDirectory, secondDirectory, thirdDirectory };
+
+	for( int i = 0; i < 3; i++ )
+	{
+		CarbonResources::CreateResourceGroupFromDirectoryParams createParams;
 
-	CarbonResources::ResourceGroupImportFromFileParams importParamsPrevious;
+		createParams.directory = directories[i];
 
-	importParamsPrevious.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_previous.txt" );
+		EXPECT_EQ( resourceGroups[i].CreateFromDirectory( createParams ).type, CarbonResources::ResultType::SUCCESS );
+	}
 
-	EXPECT_EQ( resourceGroupPrevious.ImportFromFile( importParamsPrevious ).type, CarbonResources::ResultType::SUCCESS );
+	// Patch each build to the next
+	CarbonResources::PatchCreateParams patchCreateParams;
 
+	patchCreateParams.resourceSourceSettingsPrevious.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
 
-	// Latest ResourceGroup
-	CarbonResources::ResourceGroup resourceGroupLatest;
+	patchCreateParams.resourceSourceSettingsNext.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
 
-	CarbonResources::ResourceGroupImportFromFileParams importParamsLatest;
+	patchCreateParams.resourcePatchBinaryDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_CDN;
 
-	importParamsLatest.filename = GetTestFileFileAbsolutePath( "PatchWithInputChunk/resfileindexShort_build_next.txt" );
+	patchCreateParams.resourcePatchBinaryDestinationSettings.basePath = "SharedCacheSquashPatchChain";
 
-	EXPECT_EQ( resourceGroupLatest.ImportFromFile( importParamsLatest ).type, CarbonResources::ResultType::SUCCESS );
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath = "resPathSquashPatchChain";
 
+	patchCreateParams.maxInputFileChunkSize = 500;
 
+	CarbonResources::PatchResourceGroup patchResourceGroups[2];
+
+	for( int i = 0; i < 2; i++ )
+	{
+		std::string step = std::to_string( i );
+
+		patchCreateParams.resourceGroupRelativePath = "ResourceGroup_" + step + ".yaml";
+
+		patchCreateParams.resourceGroupPatchRelativePath = "PatchResourceGroup_" + step + ".yaml";
+
+		patchCreateParams.patchFileRelativePathPrefix = "Patches/Patch" + step;
+
+		patchCreateParams.resourceSourceSettingsPrevious.basePaths = { directories[i] };
+
+		patchCreateParams.resourceSourceSettingsNext.basePaths = { directories[i + 1] };
+
+		patchCreateParams.previousResourceGroup = &resourceGroups[i];
+
+		EXPECT_EQ( resourceGroups[i + 1].CreatePatch( patchCreateParams ).type, CarbonResources::ResultType::SUCCESS );
+
+		CarbonResources::ResourceGroupImportFromFileParams importParamsPatch;
+
+		importParamsPatch.filename = patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath / patchCreateParams.resourceGroupPatchRelativePath;
+
+		EXPECT_EQ( patchResourceGroups[i].ImportFromFile( importParamsPatch ).type, CarbonResources::ResultType::SUCCESS );
+	}
+
+	// Squash the chain
+	CarbonResources::PatchSquashParams patchSquashParams;
+
+	patchSquashParams.nextPatchResourceGroups = { &patchResourceGroups[1] };
+
+	patchSquashParams.patchBinarySourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_CDN;
+
+	patchSquashParams.patchBinarySourceSettings.basePaths = { "SharedCacheSquashPatchChain" };
+
+	patchSquashParams.patchCreateParams = patchCreateParams;
+
+	patchSquashParams.patchCreateParams.resourceGroupRelativePath = "ResourceGroup_squashed.yaml";
+
+	patchSquashParams.patchCreateParams.resourceGroupPatchRelativePath = "PatchResourceGroup_squashed.yaml";
+
+	patchSquashParams.patchCreateParams.patchFileRelativePathPrefix = "Patches/PatchSquashed";
+
+	patchSquashParams.patchCreateParams.resourcePatchBinaryDestinationSettings.basePath = "SharedCacheSquashedPatch";
+
+	patchSquashParams.patchCreateParams.resourceSourceSettingsPrevious.basePaths = { firstDirectory };
+
+	patchSquashParams.patchCreateParams.resourceSourceSettingsNext.basePaths = { thirdDirectory };
+
+	patchSquashParams.patchCreateParams.previousResourceGroup = &resourceGroups[0];
+
+	std::vector<std::string> messages;
+
+	patchSquashParams.patchCreateParams.statusCallback = [&messages]( CarbonResources::StatusLevel, CarbonResources::StatusProgressType, unsigned int, const std::string& info ) {
+		messages.push_back( info );
+	};
+
+	EXPECT_EQ( patchResourceGroups[0].Squash( patchSquashParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	// Patches of a resource changed once are kept, a resource changed twice is diffed again
+	EXPECT_NE( std::find( messages.begin(), messages.end(), "Reusing patches for: introMovie.txt" ), messages.end() );
+
+	EXPECT_EQ( std::find( messages.begin(), messages.end(), "Reusing patches for: changed.txt" ), messages.end() );
+
+	EXPECT_NE( std::find( messages.begin(), messages.end(), "Creating patch for: changed.txt" ), messages.end() );
+
+	// Apply the squashed patch to the first build
+	CarbonResources::PatchResourceGroup patchResourceGroup;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPatch;
+
+	importParamsPatch.filename = patchSquashParams.patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath / "PatchResourceGroup_squashed.yaml";
+
+	EXPECT_EQ( patchResourceGroup.ImportFromFile( importParamsPatch ).type, CarbonResources::ResultType::SUCCESS );
+
+	CarbonResources::PatchApplyParams patchApplyParams;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.basePaths = { thirdDirectory };
+
+	patchApplyParams.patchBinarySourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_CDN;
+
+	patchApplyParams.patchBinarySourceSettings.basePaths = { "SharedCacheSquashedPatch" };
+
+	patchApplyParams.resourcesToPatchSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchSourceSettings.basePaths = { firstDirectory };
+
+	patchApplyParams.resourcesToPatchDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchDestinationSettings.basePath = "ApplySquashedPatchOut";
+
+	patchApplyParams.temporaryFilePath = "tempFile.resource";
+
+	EXPECT_EQ( patchResourceGroup.Apply( patchApplyParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	EXPECT_TRUE( FilesMatch( thirdDirectory / "introMovie.txt", patchApplyParams.resourcesToPatchDestinationSettings.basePath / "introMovie.txt" ) );
+	EXPECT_TRUE( FilesMatch( thirdDirectory / "changed.txt", patchApplyParams.resourcesToPatchDestinationSettings.basePath / "changed.txt" ) );
+	EXPECT_TRUE( FilesMatch( thirdDirectory / "added.txt", patchApplyParams.resourcesToPatchDestinationSettings.basePath / "added.txt" ) );
+}
+
+TEST_F( ResourcesLibraryTest, CreateAndApplyPatchWithCrossResourceMatching )
+{
+	// introMovie.txt is removed and an edited copy of it is added under another name
+	std::filesystem::path previousDirectory = "CrossResourceMatchingPrevious";
+	std::filesystem::path nextDirectory = "CrossResourceMatchingNext";
+	std::filesystem::create_directories( previousDirectory );
+	std::filesystem::create_directories( nextDirectory / "Movies" );
+	std::filesystem::copy_file( GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources/introMovie.txt" ), previousDirectory / "introMovie.txt", std::filesystem::copy_options::overwrite_existing );
+	std::filesystem::copy_file( GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources/introMovie.txt" ), nextDirectory / "Movies" / "introMovieMoved.txt", std::filesystem::copy_options::overwrite_existing );
+
+	CarbonResources::ResourceGroup resourceGroupPrevious;
+
+	CarbonResources::CreateResourceGroupFromDirectoryParams createPreviousParams;
+
+	createPreviousParams.directory = previousDirectory;
+
+	EXPECT_EQ( resourceGroupPrevious.CreateFromDirectory( createPreviousParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	CarbonResources::ResourceGroup resourceGroupLatest;
+
+	CarbonResources::CreateResourceGroupFromDirectoryParams createLatestParams;
+
+	createLatestParams.directory = nextDirectory;
+
+	EXPECT_EQ( resourceGroupLatest.CreateFromDirectory( createLatestParams ).type, CarbonResources::ResultType::SUCCESS );
 
-	// Create a patch from the subtraction index
 	CarbonResources::PatchCreateParams patchCreateParams;
 
 	patchCreateParams.resourceGroupRelativePath = "ResourceGroup_previousBuild_latestBuild.yaml";
@@ -786,19 +2089,19 @@ TEST_F( ResourcesLibraryTest, CreatePatchWithChunking )
 
 	patchCreateParams.resourceSourceSettingsPrevious.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
 
-	patchCreateParams.resourceSourceSettingsPrevious.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources" ) };
+	patchCreateParams.resourceSourceSettingsPrevious.basePaths = { previousDirectory };
 
 	patchCreateParams.resourceSourceSettingsNext.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
 
-	patchCreateParams.resourceSourceSettingsNext.basePaths = { GetTestFileFileAbsolutePath( "PatchWithInputChunk/NextBuildResources" ) };
+	patchCreateParams.resourceSourceSettingsNext.basePaths = { nextDirectory };
 
 	patchCreateParams.resourcePatchBinaryDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_CDN;
 
-	patchCreateParams.resourcePatchBinaryDestinationSettings.basePath = "SharedCache";
+	patchCreateParams.resourcePatchBinaryDestinationSettings.basePath = "SharedCacheCrossResource";
 
 	patchCreateParams.resourcePatchResourceGroupDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
 
-	patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath = "resPath";
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath = "resPathCrossResource";
 
 	patchCreateParams.patchFileRelativePathPrefix = "Patches/Patch1";
 
@@ -806,13 +2109,146 @@ TEST_F( ResourcesLibraryTest, CreatePatchWithChunking )
 
 	patchCreateParams.maxInputFileChunkSize = 500;
 
+	patchCreateParams.crossResourceMatching = true;
+
 	EXPECT_EQ( resourceGroupLatest.CreatePatch( patchCreateParams ).type, CarbonResources::ResultType::SUCCESS );
 
-	std::filesystem::path goldFile = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PatchResourceGroup_previousBuild_latestBuild.yaml" );
-	EXPECT_TRUE( FilesMatch( goldFile, patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath / "PatchResourceGroup_previousBuild_latestBuild.yaml" ) );
+	// The new resource is patched from the removed one rather than shipped whole
+	std::filesystem::path patchResourceGroupPath = patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath / "PatchResourceGroup_previousBuild_latestBuild.yaml";
 
-	std::filesystem::path goldDirectory = GetTestFileFileAbsolutePath( "PatchWithInputChunk/LocalCDNPatches" );
-	EXPECT_TRUE( DirectoryIsSubset( goldDirectory, patchCreateParams.resourcePatchBinaryDestinationSettings.basePath ) );
+	std::ifstream patchResourceGroupIn( patchResourceGroupPath );
+	std::stringstream patchResourceGroupData;
+	patchResourceGroupData << patchResourceGroupIn.rdbuf();
+	EXPECT_NE( patchResourceGroupData.str().find( "SourceResourceRelativePath: introMovie.txt" ), std::string::npos );
+
+	// Apply the patch
+	CarbonResources::PatchResourceGroup patchResourceGroup;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPatch;
+
+	importParamsPatch.filename = patchResourceGroupPath;
+
+	EXPECT_EQ( patchResourceGroup.ImportFromFile( importParamsPatch ).type, CarbonResources::ResultType::SUCCESS );
+
+	CarbonResources::PatchApplyParams patchApplyParams;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.basePaths = { nextDirectory };
+
+	patchApplyParams.patchBinarySourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_CDN;
+
+	patchApplyParams.patchBinarySourceSettings.basePaths = { patchCreateParams.resourcePatchBinaryDestinationSettings.basePath };
+
+	patchApplyParams.resourcesToPatchSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchSourceSettings.basePaths = { previousDirectory };
+
+	patchApplyParams.resourcesToPatchDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchDestinationSettings.basePath = "ApplyPatchWithCrossResourceMatchingOut";
+
+	patchApplyParams.temporaryFilePath = "tempFile.resource";
+
+	EXPECT_EQ( patchResourceGroup.Apply( patchApplyParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	EXPECT_TRUE( FilesMatch( nextDirectory / "Movies" / "introMovieMoved.txt", patchApplyParams.resourcesToPatchDestinationSettings.basePath / "Movies" / "introMovieMoved.txt" ) );
+}
+
+TEST_F( ResourcesLibraryTest, CreateAndApplyPatchWithResourceCopies )
+{
+	// introMovie.txt is moved and testResource.txt copied, neither changes
+	std::filesystem::path previousDirectory = "ResourceCopiesPrevious";
+	std::filesystem::path nextDirectory = "ResourceCopiesNext";
+	std::filesystem::create_directories( previousDirectory );
+	std::filesystem::create_directories( nextDirectory / "Movies" );
+	std::filesystem::path introMovie = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources/introMovie.txt" );
+	std::filesystem::path testResource = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources/testResource.txt" );
+	std::filesystem::copy_file( introMovie, previousDirectory / "introMovie.txt", std::filesystem::copy_options::overwrite_existing );
+	std::filesystem::copy_file( testResource, previousDirectory / "testResource.txt", std::filesystem::copy_options::overwrite_existing );
+	std::filesystem::copy_file( introMovie, nextDirectory / "Movies" / "introMovie.txt", std::filesystem::copy_options::overwrite_existing );
+	std::filesystem::copy_file( testResource, nextDirectory / "testResource.txt", std::filesystem::copy_options::overwrite_existing );
+	std::filesystem::copy_file( testResource, nextDirectory / "testResourceCopy.txt", std::filesystem::copy_options::overwrite_existing );
+
+	CarbonResources::ResourceGroup resourceGroupPrevious;
+
+	CarbonResources::CreateResourceGroupFromDirectoryParams createPreviousParams;
+
+	createPreviousParams.directory = previousDirectory;
+
+	EXPECT_EQ( resourceGroupPrevious.CreateFromDirectory( createPreviousParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	CarbonResources::ResourceGroup resourceGroupLatest;
+
+	CarbonResources::CreateResourceGroupFromDirectoryParams createLatestParams;
+
+	createLatestParams.directory = nextDirectory;
+
+	EXPECT_EQ( resourceGroupLatest.CreateFromDirectory( createLatestParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	CarbonResources::PatchCreateParams patchCreateParams;
+
+	patchCreateParams.resourceGroupRelativePath = "ResourceGroup_previousBuild_latestBuild.yaml";
+
+	patchCreateParams.resourceGroupPatchRelativePath = "PatchResourceGroup_previousBuild_latestBuild.yaml";
+
+	patchCreateParams.resourceSourceSettingsPrevious.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourceSourceSettingsPrevious.basePaths = { previousDirectory };
+
+	patchCreateParams.resourceSourceSettingsNext.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourceSourceSettingsNext.basePaths = { nextDirectory };
+
+	patchCreateParams.resourcePatchBinaryDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_CDN;
+
+	patchCreateParams.resourcePatchBinaryDestinationSettings.basePath = "SharedCacheResourceCopies";
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath = "resPathResourceCopies";
+
+	patchCreateParams.patchFileRelativePathPrefix = "Patches/Patch1";
+
+	patchCreateParams.previousResourceGroup = &resourceGroupPrevious;
+
+	patchCreateParams.detectResourceCopies = true;
+
+	EXPECT_EQ( resourceGroupLatest.CreatePatch( patchCreateParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	// Apply the patch, with no access to the next build resources
+	CarbonResources::PatchResourceGroup patchResourceGroup;
+
+	CarbonResources::ResourceGroupImportFromFileParams importParamsPatch;
+
+	importParamsPatch.filename = patchCreateParams.resourcePatchResourceGroupDestinationSettings.basePath / "PatchResourceGroup_previousBuild_latestBuild.yaml";
+
+	EXPECT_EQ( patchResourceGroup.ImportFromFile( importParamsPatch ).type, CarbonResources::ResultType::SUCCESS );
+
+	CarbonResources::PatchApplyParams patchApplyParams;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.nextBuildResourcesSourceSettings.basePaths = { "ResourceCopiesMissing" };
+
+	patchApplyParams.patchBinarySourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_CDN;
+
+	patchApplyParams.patchBinarySourceSettings.basePaths = { patchCreateParams.resourcePatchBinaryDestinationSettings.basePath };
+
+	patchApplyParams.resourcesToPatchSourceSettings.sourceType = CarbonResources::ResourceSourceType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchSourceSettings.basePaths = { previousDirectory };
+
+	patchApplyParams.resourcesToPatchDestinationSettings.destinationType = CarbonResources::ResourceDestinationType::LOCAL_RELATIVE;
+
+	patchApplyParams.resourcesToPatchDestinationSettings.basePath = "ApplyPatchWithResourceCopiesOut";
+
+	patchApplyParams.temporaryFilePath = "tempFile.resource";
+
+	EXPECT_EQ( patchResourceGroup.Apply( patchApplyParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	EXPECT_TRUE( FilesMatch( introMovie, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "Movies" / "introMovie.txt" ) );
+	EXPECT_TRUE( FilesMatch( testResource, patchApplyParams.resourcesToPatchDestinationSettings.basePath / "testResourceCopy.txt" ) );
 }
 
 TEST_F( ResourcesLibraryTest, CreateResourceGroupFromDirectory )
@@ -1041,6 +2477,83 @@ TEST_F( ResourcesLibraryTest, DiffResourceGroupsWithTwoSubtractions )
 	EXPECT_EQ( subtractions.size(), 2 );
 }
 
+TEST_F( ResourcesLibraryTest, DiffResourceGroupsWithMoveAndCopy )
+{
+	// introMovie.txt is moved and testResource.txt copied, neither changes
+	std::filesystem::path baseDirectory = "DiffMoveAndCopyBase";
+	std::filesystem::path diffDirectory = "DiffMoveAndCopyDiff";
+	std::filesystem::create_directories( baseDirectory );
+	std::filesystem::create_directories( diffDirectory / "Movies" );
+	std::filesystem::path introMovie = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources/introMovie.txt" );
+	std::filesystem::path testResource = GetTestFileFileAbsolutePath( "PatchWithInputChunk/PreviousBuildResources/testResource.txt" );
+	std::filesystem::copy_file( introMovie, baseDirectory / "introMovie.txt", std::filesystem::copy_options::overwrite_existing );
+	std::filesystem::copy_file( testResource, baseDirectory / "testResource.txt", std::filesystem::copy_options::overwrite_existing );
+	std::filesystem::copy_file( introMovie, diffDirectory / "Movies" / "introMovie.txt", std::filesystem::copy_options::overwrite_existing );
+	std::filesystem::copy_file( testResource, diffDirectory / "testResource.txt", std::filesystem::copy_options::overwrite_existing );
+	std::filesystem::copy_file( testResource, diffDirectory / "testResourceCopy.txt", std::filesystem::copy_options::overwrite_existing );
+
+	CarbonResources::ResourceGroup baseResourceGroup;
+
+	CarbonResources::CreateResourceGroupFromDirectoryParams createBaseParams;
+
+	createBaseParams.directory = baseDirectory;
+
+	EXPECT_EQ( baseResourceGroup.CreateFromDirectory( createBaseParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	CarbonResources::ResourceGroup diffResourceGroup;
+
+	CarbonResources::CreateResourceGroupFromDirectoryParams createDiffParams;
+
+	createDiffParams.directory = diffDirectory;
+
+	EXPECT_EQ( diffResourceGroup.CreateFromDirectory( createDiffParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	// Perform diff
+	CarbonResources::ResourceGroupDiffAgainstGroupParams diffAgainstGroupParams;
+
+	diffAgainstGroupParams.resourceGroupToDiffAgainst = &baseResourceGroup;
+
+	std::vector<std::filesystem::path> additions;
+
+	std::vector<std::filesystem::path> subtractions;
+
+	std::vector<std::pair<std::filesystem::path, std::filesystem::path>> moves;
+
+	std::vector<std::pair<std::filesystem::path, std::filesystem::path>> copies;
+
+	diffAgainstGroupParams.additions = &additions;
+
+	diffAgainstGroupParams.subtractions = &subtractions;
+
+	diffAgainstGroupParams.moves = &moves;
+
+	diffAgainstGroupParams.copies = &copies;
+
+	EXPECT_EQ( diffResourceGroup.DiffAgainstGroup( diffAgainstGroupParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	// Test the result
+	EXPECT_TRUE( additions.empty() );
+	EXPECT_TRUE( subtractions.empty() );
+	ASSERT_EQ( moves.size(), 1 );
+	EXPECT_EQ( moves[0].first, std::filesystem::path( "introMovie.txt" ) );
+	EXPECT_EQ( moves[0].second, std::filesystem::path( "Movies" ) / "introMovie.txt" );
+	ASSERT_EQ( copies.size(), 1 );
+	EXPECT_EQ( copies[0].first, std::filesystem::path( "testResource.txt" ) );
+	EXPECT_EQ( copies[0].second, std::filesystem::path( "testResourceCopy.txt" ) );
+
+	// Without moves and copies requested they are additions and subtractions
+	additions.clear();
+
+	diffAgainstGroupParams.moves = nullptr;
+
+	diffAgainstGroupParams.copies = nullptr;
+
+	EXPECT_EQ( diffResourceGroup.DiffAgainstGroup( diffAgainstGroupParams ).type, CarbonResources::ResultType::SUCCESS );
+
+	EXPECT_EQ( additions.size(), 2 );
+	EXPECT_EQ( subtractions.size(), 1 );
+}
+
 TEST_F( ResourcesLibraryTest, MergeResourceGroupsAdditive )
 {
 	CarbonResources::ResourceGroup resourceGroup;
@@ -0,0 +1,57 @@
+// Copyright © 2025 CCP ehf.
+
+#pragma once
+#ifndef BlockHashStream_H
+#define BlockHashStream_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace CryptoPP
+{
+class BLAKE2b;
+}
+
+namespace ResourceTools
+{
+
+// 128 bit strong hash of a block of data, compared in place of the data itself.
+struct BlockHash
+{
+	uint8_t bytes[16];
+
+	bool operator==( const BlockHash& other ) const
+	{
+		return std::memcmp( bytes, other.bytes, sizeof( bytes ) ) == 0;
+	}
+
+	bool operator!=( const BlockHash& other ) const
+	{
+		return !( *this == other );
+	}
+};
+
+// Hashes consecutive blocks of data, each Finish starts a new block.
+class BlockHashStream
+{
+public:
+	BlockHashStream();
+
+	~BlockHashStream();
+
+	BlockHashStream( const BlockHashStream& ) = delete;
+
+	BlockHashStream& operator=( const BlockHashStream& ) = delete;
+
+	void Update( const uint8_t* data, size_t length );
+
+	BlockHash Finish();
+
+private:
+	CryptoPP::BLAKE2b* m_hash;
+};
+
+}
+
+#endif // BlockHashStream_H
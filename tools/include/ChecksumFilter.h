@@ -0,0 +1,89 @@
+// Copyright © 2025 CCP ehf.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ResourceTools
+{
+// Blocked Bloom filter over 32 bit checksums.
+// Each checksum maps to a single 32 byte block and sets one bit in each of its eight words,
+// so a query touches one cache line and has no data dependent branches.
+// May report checksums that were never added, never misses one that was.
+class ChecksumFilter
+{
+public:
+	ChecksumFilter();
+
+	// Size the filter for about expectedCount checksums, clearing it.
+	void Reserve( size_t expectedCount );
+
+	void Add( uint32_t checksum );
+
+	bool MayContain( uint32_t checksum ) const;
+
+	// True if no checksum has been added.
+	bool IsEmpty() const;
+
+	void Clear();
+
+private:
+	struct alignas( 32 ) Block
+	{
+		uint32_t words[8];
+	};
+
+	size_t GetBlockIndex( uint64_t hash ) const;
+
+	static void GetMask( uint64_t hash, uint32_t mask[8] );
+
+	static uint64_t Hash( uint32_t checksum );
+
+	std::vector<Block> m_blocks;
+
+	size_t m_count;
+};
+
+inline uint64_t ChecksumFilter::Hash( uint32_t checksum )
+{
+	// Rolling checksums are far from uniform, spread them over all 64 bits.
+	return ( static_cast<uint64_t>( checksum ) + 1 ) * 0x9E3779B97F4A7C15ULL;
+}
+
+inline size_t ChecksumFilter::GetBlockIndex( uint64_t hash ) const
+{
+	// Maps the high bits onto [0, blockCount) without a division.
+	return static_cast<size_t>( ( ( hash >> 32 ) * m_blocks.size() ) >> 32 );
+}
+
+inline void ChecksumFilter::GetMask( uint64_t hash, uint32_t mask[8] )
+{
+	static constexpr uint32_t SALT[8] = { 0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U };
+	auto key = static_cast<uint32_t>( hash );
+	for( int i = 0; i < 8; ++i )
+	{
+		mask[i] = 1U << ( ( key * SALT[i] ) >> 27 );
+	}
+}
+
+inline bool ChecksumFilter::MayContain( uint32_t checksum ) const
+{
+	if( m_blocks.empty() )
+	{
+		return false;
+	}
+	uint64_t hash = Hash( checksum );
+	const Block& block = m_blocks[GetBlockIndex( hash )];
+	uint32_t mask[8];
+	GetMask( hash, mask );
+	uint32_t missing = 0;
+	for( int i = 0; i < 8; ++i )
+	{
+		missing |= mask[i] & ~block.words[i];
+	}
+	return missing == 0;
+}
+
+}
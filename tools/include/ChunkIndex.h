@@ -2,29 +2,101 @@
 
 #pragma once
 
+#include <atomic>
 #include <filesystem>
 #include <map>
-#include <unordered_set>
+#include <mutex>
 #include <vector>
 
+#include "BlockHashStream.h"
+#include "ChecksumFilter.h"
+#include "ChunkIndexCache.h"
+#include "MemoryMappedFile.h"
 #include "StatusCallback.h"
 
 namespace ResourceTools
 {
+// Default memory used to sort index entries before they are spilled to disk and merged.
+constexpr size_t CHUNK_INDEX_DEFAULT_MEMORY_BUDGET = 1024 * 1024 * 512;
+
+// Index entries are stored on disk as is, the offset is split so the entry has no padding.
+struct ChunkIndexEntry
+{
+	uint32_t checksum;
+	uint32_t offsetLow;
+	uint32_t offsetHigh;
+
+	ChunkIndexEntry() = default;
+
+	ChunkIndexEntry( uint32_t checksum, uint64_t offset ) :
+		checksum( checksum ), offsetLow( static_cast<uint32_t>( offset ) ), offsetHigh( static_cast<uint32_t>( offset >> 32 ) )
+	{
+	}
+
+	uint64_t GetOffset() const
+	{
+		return ( static_cast<uint64_t>( offsetHigh ) << 32 ) | offsetLow;
+	}
+
+	bool operator<( const ChunkIndexEntry& other ) const
+	{
+		if( checksum != other.checksum )
+		{
+			return checksum < other.checksum;
+		}
+		return GetOffset() < other.GetOffset();
+	}
+
+	bool operator>( const ChunkIndexEntry& other ) const
+	{
+		return other < *this;
+	}
+};
+
+// Checksum filter and sorted, unique checksums of the chunkSize chunks of a target file.
+// Generated once per target file, it can be passed to the indexes of any number of files.
+struct TargetChunkChecksums
+{
+	ChecksumFilter filter;
+	std::vector<uint32_t> checksums;
+};
+
+bool GenerateTargetChunkChecksums( const std::filesystem::path& targetFile, uint32_t chunkSize, TargetChunkChecksums& targetChunkChecksums );
+
 class ChunkIndex
 {
 public:
-	ChunkIndex( std::filesystem::path fileToIndex, uint32_t chunkSize, const std::filesystem::path& indexFolder, StatusCallback statusCallback = nullptr );
+	// threadCount is the number of threads used to generate the index, 0 uses one per hardware thread.
+	// storeBlockHashes records a strong hash of every chunkSize aligned block, so matches at those offsets
+	// are verified without reading the file again.
+	// memoryBudget bounds the memory used to sort entries, larger indexes are sorted in runs on disk and merged.
+	ChunkIndex( std::filesystem::path fileToIndex, uint32_t chunkSize, const std::filesystem::path& indexFolder, StatusCallback statusCallback = nullptr, unsigned int threadCount = 1, bool storeBlockHashes = false, size_t memoryBudget = CHUNK_INDEX_DEFAULT_MEMORY_BUDGET );
 	~ChunkIndex();
 	bool Generate();
+	// Use the cached index for the file if a valid one exists, otherwise generate one and add it to the cache.
+	// Cached indexes ignore the checksum filter so they can be reused against any target file.
+	bool Generate( ChunkIndexCache& cache, const std::string& fileChecksum );
 	bool FindChunkOffsets( uint32_t chunk, std::vector<size_t>& offsets );
+	// Look up many checksums with a single forward pass over the index.
+	// offsets[i] receives the candidates for checksums[i], in the same order as the single checksum overload.
+	bool FindChunkOffsets( const std::vector<uint32_t>& checksums, std::vector<std::vector<size_t>>& offsets );
+	// Chunks of the file passed to GenerateChecksumFilter are resolved against the index in one batch on first use.
 	bool FindMatchingChunk( const std::string& chunk, size_t& chunkOffset );
 	bool GenerateChecksumFilter( const std::filesystem::path& targetFile );
+	// Same as GenerateChecksumFilter, from checksums generated with the chunk size of this index.
+	void SetChecksumFilter( const TargetChunkChecksums& targetChunkChecksums );
 
 private:
 	std::filesystem::path GenerateIndexPath();
-	bool Flush( std::vector<std::pair<uint32_t, uint32_t>>& index );
+	bool GenerateSegment( uint64_t firstWindow, uint64_t windowCount, size_t runBlocks, std::vector<ChunkIndexEntry>& index, std::atomic<uint64_t>& scannedBytes, bool reportProgress );
+	// Write a sorted run of the index to a new index file.
+	bool Flush( std::vector<ChunkIndexEntry>& index );
+	bool MergeIndexFiles();
+	bool MapIndexFile( const std::filesystem::path& path, size_t headerSize );
+	bool LoadCachedIndex( const std::filesystem::path& path );
+	bool WriteCachedIndex( const std::filesystem::path& path, const std::string& fileChecksum );
 	bool IsRelevant( uint32_t checksum );
+	const std::vector<size_t>* FindTargetChunkOffsets( uint32_t checksum );
 
 	std::filesystem::path m_fileToIndex;
 	uint32_t m_chunkSize;
@@ -32,7 +104,30 @@ private:
 	size_t m_currentIndexFile;
 	StatusCallback m_statusCallback;
 	std::filesystem::path m_indexFolder;
-	std::unordered_set<uint32_t> m_checksumFilter;
+	ChecksumFilter m_checksumFilter;
+	unsigned int m_threadCount;
+
+	// Sorted, unique checksums of the target file chunks and their candidate offsets once resolved.
+	std::vector<uint32_t> m_targetChecksums;
+	std::vector<std::vector<size_t>> m_targetOffsets;
+	bool m_targetChunksResolved;
+
+	// Guards m_indexFiles, m_currentIndexFile and m_statusCallback while segments are generated in parallel.
+	std::mutex m_mutex;
+
+	// Sorted ( checksum, offset ) pairs, either owned by m_inMemoryIndex or mapped from the index file.
+	std::vector<ChunkIndexEntry> m_inMemoryIndex;
+	MemoryMappedFile m_mappedIndex;
+	const ChunkIndexEntry* m_index;
+	size_t m_indexSize;
+
+	// Hash of block n covers [n * m_chunkSize, ( n + 1 ) * m_chunkSize), owned by m_inMemoryBlockHashes or mapped with the index.
+	bool m_storeBlockHashes;
+	std::vector<BlockHash> m_inMemoryBlockHashes;
+	const BlockHash* m_blockHashes;
+	size_t m_blockHashCount;
+
+	size_t m_memoryBudget;
 };
 
 }
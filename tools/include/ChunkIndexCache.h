@@ -0,0 +1,51 @@
+// Copyright © 2025 CCP ehf.
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+#include "StatusCallback.h"
+
+namespace ResourceTools
+{
+// Folder of chunk indexes kept between runs, keyed by the content of the indexed file.
+// The folder is kept below a maximum size by evicting the least recently used entries.
+// Entries may be looked up and added from several threads at once.
+// Only files with the entry extension are counted and evicted, so caches of other
+// entries, such as patches, may use the same class and share the folder.
+class ChunkIndexCache
+{
+public:
+	ChunkIndexCache( const std::filesystem::path& cacheFolder, uintmax_t maxSize, StatusCallback statusCallback = nullptr, const std::string& entryExtension = ".index" );
+
+	// Path where the entry for key is stored.
+	std::filesystem::path GetEntryPath( const std::string& key ) const;
+
+	// Path to write a new entry to before adding it with Add.
+	std::filesystem::path GetTemporaryPath( const std::string& key ) const;
+
+	// Returns true if an entry exists for key, marking it as recently used.
+	bool Touch( const std::string& key );
+
+	// Move a complete index file into the cache and evict old entries if over the maximum size.
+	bool Add( const std::string& key, const std::filesystem::path& indexFile );
+
+	// Remove the entry for key, if any.
+	void Remove( const std::string& key );
+
+private:
+	void Evict( const std::filesystem::path& keep );
+
+	std::filesystem::path m_cacheFolder;
+	uintmax_t m_maxSize;
+	StatusCallback m_statusCallback;
+	std::string m_entryExtension;
+
+	// Serialises changes to the folder, so eviction never races an entry being added.
+	std::mutex m_mutex;
+};
+
+}
@@ -0,0 +1,39 @@
+// Copyright © 2025 CCP ehf.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "BlockHashStream.h"
+
+namespace ResourceTools
+{
+// Size limits of content defined chunks, chunk sizes are spread around averageSize.
+struct ContentDefinedChunkSizes
+{
+	size_t minimumSize;
+	size_t averageSize;
+	size_t maximumSize;
+};
+
+struct ContentDefinedChunk
+{
+	uint64_t offset;
+	uint64_t size;
+	BlockHash hash;
+};
+
+// Chunk size limits for chunks of at most maximumSize bytes.
+ContentDefinedChunkSizes GetContentDefinedChunkSizes( size_t maximumSize );
+
+// Length of the chunk starting at data, using FastCDC https://www.usenix.org/conference/atc16/technical-sessions/presentation/xia
+// Past the minimum size a boundary only depends on the 64 bytes before it, so boundaries resynchronise shortly after an edit.
+size_t FindContentDefinedChunkEnd( const uint8_t* data, size_t length, const ContentDefinedChunkSizes& sizes );
+
+// Split a file into content defined chunks and hash each of them.
+bool GenerateContentDefinedChunks( const std::filesystem::path& path, const ContentDefinedChunkSizes& sizes, std::vector<ContentDefinedChunk>& chunks );
+
+}
@@ -0,0 +1,64 @@
+// Copyright © 2025 CCP ehf.
+
+#pragma once
+
+#ifndef DiffEngine_H
+#define DiffEngine_H
+
+#include <string>
+
+namespace ResourceTools
+{
+
+// Names engines are recorded under in patches
+constexpr const char* DIFF_ENGINE_BSDIFF{ "bsdiff" };
+constexpr const char* DIFF_ENGINE_ZSTD{ "zstd" };
+
+// Creates patches turning previous data into latest data, and applies them.
+// Engines hold no state, so one engine may be used from several threads.
+class DiffEngine
+{
+public:
+	virtual ~DiffEngine() = default;
+
+	virtual std::string GetName() const = 0;
+
+	virtual bool CreatePatch( const std::string& previousData, const std::string& latestData, std::string& patchData ) const = 0;
+
+	virtual bool ApplyPatch( const std::string& previousData, const std::string& patchData, std::string& out ) const = 0;
+};
+
+// bsdiff, low patch sizes but suffix sorting needs several times the previous data in memory.
+class BsdiffDiffEngine : public DiffEngine
+{
+public:
+	std::string GetName() const override;
+
+	bool CreatePatch( const std::string& previousData, const std::string& latestData, std::string& patchData ) const override;
+
+	bool ApplyPatch( const std::string& previousData, const std::string& patchData, std::string& out ) const override;
+};
+
+// zstd compression of the latest data with the previous data as prefix, as zstd --patch-from.
+// Long distance matching finds data moved anywhere within the previous data.
+class ZstdDiffEngine : public DiffEngine
+{
+public:
+	explicit ZstdDiffEngine( int compressionLevel = 19 );
+
+	std::string GetName() const override;
+
+	bool CreatePatch( const std::string& previousData, const std::string& latestData, std::string& patchData ) const override;
+
+	bool ApplyPatch( const std::string& previousData, const std::string& patchData, std::string& out ) const override;
+
+private:
+	int m_compressionLevel;
+};
+
+// Engine recorded under name, nullptr if there is none.
+const DiffEngine* GetDiffEngine( const std::string& name );
+
+}
+
+#endif // DiffEngine_H
@@ -4,6 +4,7 @@
 #ifndef GzipCompressionStream_H
 #define GzipCompressionStream_H
 
+#include <cstdint>
 #include <string>
 #include <zlib.h>
 
@@ -12,6 +13,7 @@ namespace ResourceTools
 class GzipCompressionStream
 {
 public:
+	// With out nullptr the compressed data is only counted, see GetCompressedSize
 	GzipCompressionStream( std::string* out );
 
 	~GzipCompressionStream();
@@ -22,12 +24,15 @@ public:
 
 	bool Finish();
 
+	uintmax_t GetCompressedSize() const;
+
 
 private:
 	bool m_compressionInProgress;
 	z_stream m_stream;
 	std::string m_buffer;
 	std::string* m_out;
+	uintmax_t m_compressedSize;
 
 	bool ProcessBuffer( bool finish );
 };
@@ -0,0 +1,53 @@
+// Copyright © 2025 CCP ehf.
+
+#pragma once
+#ifndef MemoryMappedFile_H
+#define MemoryMappedFile_H
+
+#include <cstdint>
+#include <filesystem>
+
+namespace ResourceTools
+{
+
+// Read only view of a whole file mapped into memory.
+class MemoryMappedFile
+{
+public:
+	MemoryMappedFile();
+
+	~MemoryMappedFile();
+
+	MemoryMappedFile( const MemoryMappedFile& ) = delete;
+
+	MemoryMappedFile& operator=( const MemoryMappedFile& ) = delete;
+
+	bool Open( const std::filesystem::path& path );
+
+	void Close();
+
+	bool IsOpen() const;
+
+	const uint8_t* GetData() const;
+
+	size_t GetSize() const;
+
+private:
+	bool m_open;
+
+	const uint8_t* m_data;
+
+	size_t m_size;
+
+#if WIN32
+	void* m_fileHandle;
+
+	void* m_mappingHandle;
+#else
+	int m_fileDescriptor;
+#endif
+};
+
+}
+
+#endif // MemoryMappedFile_H
@@ -19,7 +19,19 @@ class BundleStreamOut;
 
 bool ApplyPatch( const std::string& data, const std::string& patchData, std::string& out );
 
-bool CreatePatch( const std::string& data1, const std::string& data2, std::string& patchData );
+// Suffix sorting used by CreatePatch, both produce the same patch.
+// SAIS is linear time and needs a quarter of the memory for data under 2 GiB.
+// QSUFSORT is bsdiff's own.
+enum class SuffixSortAlgorithm
+{
+	SAIS,
+	QSUFSORT
+};
+
+bool CreatePatch( const std::string& data1, const std::string& data2, std::string& patchData, SuffixSortAlgorithm suffixSort = SuffixSortAlgorithm::SAIS );
+
+// Free the buffers CreatePatch keeps for reuse between calls.
+void ReleasePatchBuffers();
 
 bool CreatePatchFile( fs::path before, fs::path after, fs::path patch );
 
@@ -52,10 +52,23 @@ bool GetLocalFileData( const std::filesystem::path& filepath, std::string& data
 
 bool GZipCompressData( const std::string& dataToCompress, std::string& compressedData );
 
+// Size data would be gzip compressed to by GZipCompressData, without holding the compressed data
+bool GZipCompressedSize( const std::string& dataToCompress, uintmax_t& compressedSize );
+
 bool GZipUncompressData( const std::string& dataToUncompress, std::string& uncompressedData );
 
 bool SaveFile( const std::filesystem::path& path, const std::string& data );
 
+// Renames source to destination, replacing it. When the rename is not possible, such as across devices,
+// source is copied next to destination and renamed over it, so destination is always either the old or the new file
+bool MoveFileIntoPlace( const std::filesystem::path& source, const std::filesystem::path& destination );
+
+// Sets the permission bits of a mode as returned by CalculateBinaryOperation on the file at path
+bool ApplyBinaryOperation( const std::filesystem::path& path, unsigned int binaryOperation );
+
+// Waits for data written to the file at path to reach the disk, so it survives the machine going down
+bool SyncFile( const std::filesystem::path& path );
+
 unsigned int CalculateBinaryOperation( const std::filesystem::path& path );
 }
 
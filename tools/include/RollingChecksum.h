@@ -2,11 +2,20 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace ResourceTools
 {
+constexpr uint32_t ROLLING_CHECKSUM_MODULO{ 2 << 15 };
+
+// Preferred minimum size of the buffers fed to a RollingChecksumScanner.
+// The scanner copies up to one window per buffer, larger buffers keep that cost small.
+constexpr size_t ROLLING_CHECKSUM_SCAN_READ_SIZE{ 1024 * 1024 * 4 };
+
 struct RollingChecksum
 {
 	uint32_t alpha;
@@ -20,4 +29,130 @@ RollingChecksum GenerateRollingAdlerChecksum( const std::string& input, uint32_t
 // Generate a weak checksum using the rsync algorithm https://rsync.samba.org/tech_report/node3.html
 RollingChecksum GenerateRollingAdlerChecksum( const std::string& input, uint32_t start, uint32_t end, RollingChecksum previous );
 
-}
\ No newline at end of file
+// Generate a weak checksum over length bytes starting at data, without copying.
+// Bytes are read as char so results match the std::string overloads.
+RollingChecksum GenerateRollingAdlerChecksum( const uint8_t* data, size_t length );
+
+// Roll the checksum of the window [data - 1, data + length - 1) forward by one byte.
+// data[-1] must be readable, it is the byte leaving the window.
+RollingChecksum GenerateRollingAdlerChecksum( const uint8_t* data, size_t length, RollingChecksum previous );
+
+// Computes the checksum of every window of windowSize bytes in a stream of buffers.
+// Buffers are fed in order, windows spanning two buffers are handled by keeping the
+// last windowSize bytes of the stream, so buffers never need to be concatenated.
+class RollingChecksumScanner
+{
+public:
+	explicit RollingChecksumScanner( uint32_t windowSize );
+
+	// Checksum every window that ends within data.
+	// isRelevant( checksum ) is evaluated for every window, onWindow( offset, checksum ) only for
+	// the relevant ones, offset being the position of the window in the stream.
+	// Returning false from onWindow stops the scan, Scan then returns false, as will any further calls.
+	template <typename Predicate, typename Callback>
+	bool Scan( const uint8_t* data, size_t length, Predicate isRelevant, Callback onWindow );
+
+	// Total number of bytes fed to the scanner so far.
+	uint64_t GetStreamSize() const;
+
+private:
+	RollingChecksum GenerateFirstWindowChecksum( const uint8_t* data ) const;
+
+	void UpdateCarry( const uint8_t* data, size_t length );
+
+	template <typename Predicate, typename Callback>
+	bool RollWindows( const uint8_t* outgoing, const uint8_t* incoming, uint64_t count, Predicate& isRelevant, Callback& onWindow );
+
+	uint32_t m_windowSize;
+
+	uint64_t m_streamSize;
+
+	uint64_t m_nextWindow;
+
+	bool m_stopped;
+
+	RollingChecksum m_checksum;
+
+	// The last m_windowSize bytes of the stream, or all of it if shorter.
+	std::vector<uint8_t> m_carry;
+};
+
+template <typename Predicate, typename Callback>
+bool RollingChecksumScanner::Scan( const uint8_t* data, size_t length, Predicate isRelevant, Callback onWindow )
+{
+	if( m_stopped )
+	{
+		return false;
+	}
+
+	uint64_t bufferStart = m_streamSize;
+	uint64_t bufferEnd = m_streamSize + length;
+
+	if( bufferEnd >= m_windowSize )
+	{
+		uint64_t lastWindow = bufferEnd - m_windowSize;
+		if( m_nextWindow == 0 )
+		{
+			m_checksum = GenerateFirstWindowChecksum( data );
+			m_nextWindow = 1;
+			if( isRelevant( m_checksum.checksum ) && !onWindow( uint64_t( 0 ), m_checksum.checksum ) )
+			{
+				m_stopped = true;
+			}
+		}
+
+		// Windows where the byte leaving the window is still in the carry.
+		uint64_t carryWindowsEnd = std::min( bufferStart, lastWindow ) + 1;
+		if( !m_stopped && m_nextWindow < carryWindowsEnd )
+		{
+			const uint8_t* outgoing = m_carry.data() + ( m_nextWindow - 1 - ( bufferStart - m_carry.size() ) );
+			const uint8_t* incoming = data + ( m_nextWindow + m_windowSize - 1 - bufferStart );
+			m_stopped = !RollWindows( outgoing, incoming, carryWindowsEnd - m_nextWindow, isRelevant, onWindow );
+		}
+
+		// Windows entirely within data.
+		if( !m_stopped && m_nextWindow <= lastWindow )
+		{
+			const uint8_t* outgoing = data + ( m_nextWindow - 1 - bufferStart );
+			const uint8_t* incoming = outgoing + m_windowSize;
+			m_stopped = !RollWindows( outgoing, incoming, lastWindow + 1 - m_nextWindow, isRelevant, onWindow );
+		}
+	}
+
+	UpdateCarry( data, length );
+	m_streamSize = bufferEnd;
+
+	return !m_stopped;
+}
+
+template <typename Predicate, typename Callback>
+bool RollingChecksumScanner::RollWindows( const uint8_t* outgoing, const uint8_t* incoming, uint64_t count, Predicate& isRelevant, Callback& onWindow )
+{
+	// Same update as GenerateRollingAdlerChecksum( data, length, previous ), kept inline so
+	// windows that are not relevant are never written back to memory.
+	uint32_t alpha = m_checksum.alpha;
+	uint32_t beta = m_checksum.beta;
+	uint32_t windowSize = m_windowSize;
+	uint64_t firstWindow = m_nextWindow;
+
+	for( uint64_t i = 0; i < count; ++i )
+	{
+		auto outgoingByte = static_cast<char>( outgoing[i] );
+		auto incomingByte = static_cast<char>( incoming[i] );
+		alpha = ( alpha - outgoingByte + incomingByte ) % ROLLING_CHECKSUM_MODULO;
+		beta = ( beta + alpha - windowSize * outgoingByte ) % ROLLING_CHECKSUM_MODULO;
+		uint32_t checksum = alpha + ( beta * ROLLING_CHECKSUM_MODULO );
+		if( isRelevant( checksum ) && !onWindow( firstWindow + i, checksum ) )
+		{
+			m_checksum = RollingChecksum{ alpha, beta, checksum };
+			m_nextWindow = firstWindow + i + 1;
+			return false;
+		}
+	}
+
+	m_checksum = RollingChecksum{ alpha, beta, alpha + ( beta * ROLLING_CHECKSUM_MODULO ) };
+	m_nextWindow = firstWindow + count;
+	return true;
+}
+
+}
@@ -0,0 +1,24 @@
+// Copyright © 2025 CCP ehf.
+
+#pragma once
+
+#ifndef SuffixArray_H
+#define SuffixArray_H
+
+#include <cstdint>
+
+namespace ResourceTools
+{
+
+// Sort the suffixes of data, writing size + 1 entries to suffixArray.
+// The first entry is size, the empty suffix, followed by the start of every suffix of data in
+// lexicographic order, bytes compared unsigned. This is the layout bsdiff searches.
+// Uses SA-IS, linear in size. The reduced problem is solved within suffixArray, beyond it only
+// bucket counts and one bit per byte are held in memory.
+void BuildSuffixArray( const uint8_t* data, int32_t size, int32_t* suffixArray );
+
+void BuildSuffixArray( const uint8_t* data, int64_t size, int64_t* suffixArray );
+
+}
+
+#endif // SuffixArray_H
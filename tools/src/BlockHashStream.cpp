@@ -0,0 +1,33 @@
+// Copyright © 2025 CCP ehf.
+
+#include "BlockHashStream.h"
+
+#include <cryptopp/blake2.h>
+
+namespace ResourceTools
+{
+
+BlockHashStream::BlockHashStream()
+{
+	m_hash = new CryptoPP::BLAKE2b( false, sizeof( BlockHash::bytes ) );
+}
+
+BlockHashStream::~BlockHashStream()
+{
+	delete m_hash;
+}
+
+void BlockHashStream::Update( const uint8_t* data, size_t length )
+{
+	m_hash->Update( data, length );
+}
+
+BlockHash BlockHashStream::Finish()
+{
+	// Final restarts the hash, ready for the next block.
+	BlockHash blockHash;
+	m_hash->Final( blockHash.bytes );
+	return blockHash;
+}
+
+}
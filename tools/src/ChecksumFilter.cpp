@@ -0,0 +1,55 @@
+// Copyright © 2025 CCP ehf.
+
+#include "ChecksumFilter.h"
+
+#include <algorithm>
+
+// Filter bits per expected checksum, gives a false positive rate of around 0.13% on rolling checksums.
+constexpr size_t CHECKSUM_FILTER_BITS_PER_ENTRY = 16;
+
+constexpr size_t CHECKSUM_FILTER_BITS_PER_BLOCK = 256;
+
+namespace ResourceTools
+{
+ChecksumFilter::ChecksumFilter() :
+	m_count( 0 )
+{
+}
+
+void ChecksumFilter::Reserve( size_t expectedCount )
+{
+	size_t blockCount = std::max<size_t>( ( expectedCount * CHECKSUM_FILTER_BITS_PER_ENTRY + CHECKSUM_FILTER_BITS_PER_BLOCK - 1 ) / CHECKSUM_FILTER_BITS_PER_BLOCK, 1 );
+	m_blocks.assign( blockCount, Block{} );
+	m_count = 0;
+}
+
+void ChecksumFilter::Add( uint32_t checksum )
+{
+	if( m_blocks.empty() )
+	{
+		Reserve( 1 );
+	}
+	uint64_t hash = Hash( checksum );
+	Block& block = m_blocks[GetBlockIndex( hash )];
+	uint32_t mask[8];
+	GetMask( hash, mask );
+	for( int i = 0; i < 8; ++i )
+	{
+		block.words[i] |= mask[i];
+	}
+	++m_count;
+}
+
+bool ChecksumFilter::IsEmpty() const
+{
+	return m_count == 0;
+}
+
+void ChecksumFilter::Clear()
+{
+	m_blocks.clear();
+	m_blocks.shrink_to_fit();
+	m_count = 0;
+}
+
+}
@@ -2,31 +2,82 @@
 
 #include "ChunkIndex.h"
 
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <queue>
 #include <sstream>
+#include <thread>
 
 #include "FileDataStreamIn.h"
 #include "ResourceTools.h"
 #include "RollingChecksum.h"
 
-// Block contains checksum ( uint32_t ) and offset ( uint32_t )
-// Index files will take up 8x the size of the original file.
-constexpr size_t CHUNK_BLOCK_SIZE = sizeof( uint32_t ) + sizeof( uint32_t );
-constexpr size_t TARGET_FILE_SIZE = 1024 * 1024 * 512; // 512 MB index files, each covering 64 MB of the source file.
-constexpr size_t BLOCKS_PER_FILE = TARGET_FILE_SIZE / CHUNK_BLOCK_SIZE;
+// Block contains checksum ( uint32_t ) and offset ( uint64_t )
+// An unfiltered index takes up 12x the size of the original file.
+constexpr size_t CHUNK_BLOCK_SIZE = sizeof( ResourceTools::ChunkIndexEntry );
+static_assert( CHUNK_BLOCK_SIZE == 12, "Index entries must not contain padding" );
+
+// Indexes with at most this many entries are kept in memory rather than written to disk.
+constexpr size_t IN_MEMORY_INDEX_BLOCKS = 1024 * 1024;
+
+// Smallest sorted run written while generating, however small the memory budget.
+constexpr size_t MIN_RUN_BLOCKS = 4096;
+
+// Number of blocks buffered before writing while merging index files.
+constexpr size_t MERGE_WRITE_BLOCKS = 64 * 1024;
+
+// Files are only split between threads when every segment gets at least this many windows,
+// below that the cost of starting a thread outweighs the hashing.
+constexpr uint64_t MIN_SEGMENT_WINDOWS = 1024 * 1024 * 4;
+
+// Cached indexes start with this header, followed by the sorted blocks.
+// Bump the version whenever the block layout changes.
+constexpr char CACHED_INDEX_MAGIC[8] = { 'C', 'R', 'C', 'I', 'N', 'D', 'E', 'X' };
+constexpr uint32_t CACHED_INDEX_VERSION = 3;
+
+// The block hashes, if any, follow the sorted blocks.
+struct CachedIndexHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t chunkSize;
+	uint64_t blockCount;
+	uint64_t blockHashCount;
+	uint64_t blocksHash;
+	char fileChecksum[32];
+};
+
+// FNV-1a over 64 bit words, cheap enough to validate multi GB indexes on load.
+// A trailing partial word is zero padded.
+static uint64_t HashBytes( const void* data, size_t size, uint64_t hash = 14695981039346656037U )
+{
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>( data );
+	for( size_t i = 0; i < size; i += sizeof( uint64_t ) )
+	{
+		uint64_t word = 0;
+		std::memcpy( &word, bytes + i, std::min( sizeof( word ), size - i ) );
+		hash ^= word;
+		hash *= 1099511628211U;
+	}
+	return hash;
+}
 
 
 namespace ResourceTools
 {
-ChunkIndex::ChunkIndex( std::filesystem::path fileToIndex, uint32_t chunkSize, const std::filesystem::path& indexFolder, StatusCallback statusCallback ) :
-	m_fileToIndex( fileToIndex ), m_chunkSize( chunkSize ), m_currentIndexFile( 0 ), m_indexFolder( indexFolder ), m_statusCallback( statusCallback )
+ChunkIndex::ChunkIndex( std::filesystem::path fileToIndex, uint32_t chunkSize, const std::filesystem::path& indexFolder, StatusCallback statusCallback, unsigned int threadCount, bool storeBlockHashes, size_t memoryBudget ) :
+	m_fileToIndex( fileToIndex ), m_chunkSize( chunkSize ), m_currentIndexFile( 0 ), m_indexFolder( indexFolder ), m_statusCallback( statusCallback ), m_threadCount( threadCount ), m_targetChunksResolved( false ), m_index( nullptr ), m_indexSize( 0 ), m_storeBlockHashes( storeBlockHashes ), m_blockHashes( nullptr ), m_blockHashCount( 0 ), m_memoryBudget( memoryBudget )
 {
 }
 
 ChunkIndex::~ChunkIndex()
 {
+	// The mapping must be released before the file can be removed on Windows.
+	m_mappedIndex.Close();
 	for( auto path : m_indexFiles )
 	{
 		if( std::filesystem::exists( path ) )
@@ -36,40 +87,26 @@ ChunkIndex::~ChunkIndex()
 	}
 }
 
-bool ChunkIndex::Flush( std::vector<std::pair<uint32_t, uint32_t>>& index )
+bool ChunkIndex::Flush( std::vector<ChunkIndexEntry>& index )
 {
 	if( index.empty() )
 	{
 		return true;
 	}
-	std::filesystem::path out = GenerateIndexPath();
-	++m_currentIndexFile;
-	std::filesystem::path directory = out.parent_path();
 
-	if( !m_currentIndexFile && directory != "" )
+	// Segments are flushed from several threads, only the bookkeeping needs to be serialised.
+	std::filesystem::path out;
 	{
-		try
-		{
-			if( !std::filesystem::exists( directory ) )
-			{
-				std::filesystem::create_directories( directory );
-			}
-
-			if( !std::filesystem::exists( directory ) )
-			{
-				return false;
-			}
-		}
-		catch( std::filesystem::filesystem_error& )
-		{
-			return false;
-		}
+		std::lock_guard<std::mutex> lock( m_mutex );
+		out = GenerateIndexPath();
+		++m_currentIndexFile;
 	}
 
 	std::ofstream streamOut;
 	streamOut.open( out, std::ios::out | std::ios::binary );
 	if( !streamOut )
 	{
+		std::lock_guard<std::mutex> lock( m_mutex );
 		if( m_statusCallback )
 		{
 			std::stringstream ss;
@@ -78,12 +115,14 @@ bool ChunkIndex::Flush( std::vector<std::pair<uint32_t, uint32_t>>& index )
 		}
 		return false;
 	}
-	m_indexFiles.push_back( out );
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_indexFiles.push_back( out );
+	}
 
-	std::sort( index.begin(), index.end() );
-	streamOut.write( reinterpret_cast<char*>( &index[0] ), sizeof( std::pair<uint32_t, uint32_t> ) * index.size() );
+	streamOut.write( reinterpret_cast<char*>( &index[0] ), sizeof( ChunkIndexEntry ) * index.size() );
 	index.clear();
-	return true;
+	return static_cast<bool>( streamOut );
 }
 
 std::filesystem::path ChunkIndex::GenerateIndexPath()
@@ -94,12 +133,14 @@ std::filesystem::path ChunkIndex::GenerateIndexPath()
 	return m_indexFolder / ( filename.string() + ss.str() + ".index" );
 }
 
-bool ChunkIndex::GenerateChecksumFilter( const std::filesystem::path& targetFile )
+bool GenerateTargetChunkChecksums( const std::filesystem::path& targetFile, uint32_t chunkSize, TargetChunkChecksums& targetChunkChecksums )
 {
-	FileDataStreamIn targetIn( m_chunkSize );
+	FileDataStreamIn targetIn( chunkSize );
 	targetIn.StartRead( targetFile );
 	size_t targetSize = std::filesystem::file_size( targetFile );
-	for( uintmax_t dataOffset = 0; dataOffset < targetSize; dataOffset += m_chunkSize )
+	targetChunkChecksums.filter.Reserve( targetSize / chunkSize + 1 );
+	targetChunkChecksums.checksums.clear();
+	for( uintmax_t dataOffset = 0; dataOffset < targetSize; dataOffset += chunkSize )
 	{
 		std::string nextFileData;
 		if( !targetIn.IsFinished() )
@@ -109,118 +150,241 @@ bool ChunkIndex::GenerateChecksumFilter( const std::filesystem::path& targetFile
 				return false;
 			}
 		}
-		auto nextFileDataSize = static_cast<uint32_t>( nextFileData.size() );
-		uint32_t checksum = ResourceTools::GenerateRollingAdlerChecksum( nextFileData, 0, nextFileDataSize ).checksum;
-		m_checksumFilter.insert( checksum );
+		auto nextFileDataBytes = reinterpret_cast<const uint8_t*>( nextFileData.data() );
+		uint32_t checksum = ResourceTools::GenerateRollingAdlerChecksum( nextFileDataBytes, nextFileData.size() ).checksum;
+		targetChunkChecksums.filter.Add( checksum );
+		targetChunkChecksums.checksums.push_back( checksum );
 	}
+	std::sort( targetChunkChecksums.checksums.begin(), targetChunkChecksums.checksums.end() );
+	targetChunkChecksums.checksums.erase( std::unique( targetChunkChecksums.checksums.begin(), targetChunkChecksums.checksums.end() ), targetChunkChecksums.checksums.end() );
 	return true;
 }
 
+bool ChunkIndex::GenerateChecksumFilter( const std::filesystem::path& targetFile )
+{
+	TargetChunkChecksums targetChunkChecksums;
+	bool generated = GenerateTargetChunkChecksums( targetFile, m_chunkSize, targetChunkChecksums );
+	m_checksumFilter = std::move( targetChunkChecksums.filter );
+	m_targetChecksums = std::move( targetChunkChecksums.checksums );
+	m_targetChunksResolved = false;
+	return generated;
+}
+
+void ChunkIndex::SetChecksumFilter( const TargetChunkChecksums& targetChunkChecksums )
+{
+	m_checksumFilter = targetChunkChecksums.filter;
+	m_targetChecksums = targetChunkChecksums.checksums;
+	m_targetChunksResolved = false;
+}
+
 bool ChunkIndex::IsRelevant( uint32_t checksum )
 {
-	if( m_checksumFilter.empty() )
+	if( m_checksumFilter.IsEmpty() )
 	{
 		return true;
 	}
-	return m_checksumFilter.find( checksum ) != m_checksumFilter.end();
+	return m_checksumFilter.MayContain( checksum );
 }
 
-bool ChunkIndex::Generate()
+bool ChunkIndex::GenerateSegment( uint64_t firstWindow, uint64_t windowCount, size_t runBlocks, std::vector<ChunkIndexEntry>& index, std::atomic<uint64_t>& scannedBytes, bool reportProgress )
 {
-	size_t result{ 0 };
-	FileDataStreamIn streamIn( m_chunkSize );
-	if( !streamIn.StartRead( m_fileToIndex ) )
+	if( windowCount == 0 )
 	{
-		return result;
+		return true;
 	}
 
-	if( !std::filesystem::exists( m_indexFolder ) )
+	FileDataStreamIn streamIn( std::max( static_cast<size_t>( m_chunkSize ), ROLLING_CHECKSUM_SCAN_READ_SIZE ) );
+	if( !streamIn.StartRead( m_fileToIndex ) )
 	{
-		if( !std::filesystem::create_directories( m_indexFolder ) )
-		{
-			if( m_statusCallback )
-			{
-				m_statusCallback( 0, "Failed to create index directory: " + m_indexFolder.string() );
-			}
-			return false;
-		}
+		return false;
 	}
+	streamIn.Seek( firstWindow );
 
-	size_t fileSize = std::filesystem::file_size( m_fileToIndex );
-	size_t indexFileCount = fileSize / BLOCKS_PER_FILE;
-	size_t currentIndexFile{ 0 };
+	uint64_t fileSize = streamIn.Size();
+	uint64_t remaining = windowCount + m_chunkSize - 1;
+	size_t readSize = std::max( static_cast<size_t>( m_chunkSize ), ROLLING_CHECKSUM_SCAN_READ_SIZE );
 
 	std::string fileData;
-	std::string backlog;
+	RollingChecksumScanner scanner( m_chunkSize );
+
+	// Aligned blocks are hashed by the segment their first window belongs to.
+	BlockHashStream blockHashStream;
+	uint64_t nextBlock = ( firstWindow + m_chunkSize - 1 ) / m_chunkSize;
+	uint64_t bufferStart = firstWindow;
 
-	uint32_t backlogOffset{ 0 };
-	uint64_t fileOffset{ 0 };
-	RollingChecksum checksum;
+	unsigned int lastReportedPercentage{ 0 };
 
-	std::vector<std::pair<uint32_t, uint32_t>> chunkToOffsets;
-	chunkToOffsets.reserve( BLOCKS_PER_FILE );
-	size_t cachedChunks{ 0 };
+	auto isRelevant = [this]( uint32_t checksum ) {
+		return IsRelevant( checksum );
+	};
 
-	size_t onePercentOfFileSize = fileSize / 100;
+	index.reserve( static_cast<size_t>( std::min<uint64_t>( runBlocks, windowCount ) ) );
 
-	while( streamIn >> fileData )
+	auto addToIndex = [&]( uint64_t windowOffset, uint32_t checksum ) {
+		index.emplace_back( checksum, firstWindow + windowOffset );
+		if( index.size() >= runBlocks )
+		{
+			std::sort( index.begin(), index.end() );
+			if( !Flush( index ) )
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	while( remaining > 0 )
 	{
-		backlog += fileData;
-		while( backlogOffset + m_chunkSize <= backlog.size() )
+		size_t bytesToRead = static_cast<size_t>( std::min<uint64_t>( readSize, remaining ) );
+		if( !streamIn.ReadBytes( bytesToRead, fileData ) )
+		{
+			return false;
+		}
+		remaining -= bytesToRead;
+		auto bytes = reinterpret_cast<const uint8_t*>( fileData.data() );
+		if( !scanner.Scan( bytes, fileData.size(), isRelevant, addToIndex ) )
+		{
+			return false;
+		}
+		uint64_t bufferEnd = bufferStart + bytesToRead;
+		while( nextBlock < m_inMemoryBlockHashes.size() && nextBlock * m_chunkSize < firstWindow + windowCount )
 		{
-			if( backlogOffset == 0 )
+			uint64_t blockStart = std::max( nextBlock * m_chunkSize, bufferStart );
+			uint64_t blockEnd = ( nextBlock + 1 ) * m_chunkSize;
+			if( blockStart >= bufferEnd )
 			{
-				checksum = GenerateRollingAdlerChecksum( backlog, 0, m_chunkSize );
+				break;
 			}
-			else
+			blockHashStream.Update( bytes + ( blockStart - bufferStart ), static_cast<size_t>( std::min( blockEnd, bufferEnd ) - blockStart ) );
+			if( blockEnd > bufferEnd )
 			{
-				checksum = GenerateRollingAdlerChecksum( backlog, backlogOffset, backlogOffset + m_chunkSize, checksum );
+				break;
 			}
-			if( m_statusCallback && !( ( backlogOffset + fileOffset ) % onePercentOfFileSize ) )
+			m_inMemoryBlockHashes[nextBlock++] = blockHashStream.Finish();
+		}
+		bufferStart = bufferEnd;
+		uint64_t scanned = scannedBytes += bytesToRead;
+		if( reportProgress && m_statusCallback && fileSize )
+		{
+			auto percentage = static_cast<unsigned int>( std::min<uint64_t>( scanned * 100 / fileSize, 100 ) );
+			if( percentage != lastReportedPercentage )
 			{
+				std::lock_guard<std::mutex> lock( m_mutex );
 				std::stringstream ss;
-				ss << "Generating index: " << GenerateIndexPath();
-				auto percentage = static_cast<unsigned int>( ( backlogOffset + fileOffset ) * 100 / fileSize );
+				ss << "Generating index: " << m_fileToIndex;
 				m_statusCallback( percentage, ss.str() );
+				lastReportedPercentage = percentage;
 			}
-			if( !IsRelevant( checksum.checksum ) )
-			{
-				++backlogOffset;
-				continue;
-			}
-			auto offset = static_cast<uint32_t>( backlogOffset + fileOffset - m_currentIndexFile * BLOCKS_PER_FILE );
-			chunkToOffsets.emplace_back( std::pair<uint32_t, uint32_t>( checksum.checksum, offset ) );
-			++cachedChunks;
-			++backlogOffset;
-			if( cachedChunks >= BLOCKS_PER_FILE )
+		}
+	}
+
+	// Leave the remainder sorted so the caller only has to merge.
+	std::sort( index.begin(), index.end() );
+	return true;
+}
+
+bool ChunkIndex::Generate()
+{
+	m_targetChunksResolved = false;
+
+	if( !std::filesystem::exists( m_fileToIndex ) )
+	{
+		return false;
+	}
+
+	if( !std::filesystem::exists( m_indexFolder ) )
+	{
+		if( !std::filesystem::create_directories( m_indexFolder ) )
+		{
+			if( m_statusCallback )
 			{
-				if( m_statusCallback )
-				{
-					std::filesystem::path filePath = GenerateIndexPath();
-					std::stringstream ss;
-					ss << "Generating index (" << currentIndexFile + 1 << "/" << indexFileCount << "): " << filePath;
-					auto percentage = static_cast<unsigned int>( 100 * currentIndexFile / indexFileCount );
-					m_statusCallback( percentage, ss.str() );
-				}
-				Flush( chunkToOffsets );
-				++currentIndexFile;
-				cachedChunks = 0;
+				m_statusCallback( 0, "Failed to create index directory: " + m_indexFolder.string() );
 			}
+			return false;
 		}
-		// Shrink fileData every now and then, but beware, we need to access start-1 for the rolling checksum.
-		if( backlogOffset > m_chunkSize + 1 )
+	}
+
+	uint64_t fileSize = std::filesystem::file_size( m_fileToIndex );
+	uint64_t windowCount = fileSize >= m_chunkSize ? fileSize - m_chunkSize + 1 : 0;
+
+	// Each segment hashes its own range of windows, reading chunkSize - 1 bytes past its end
+	// so the windows straddling the boundary are covered exactly once.
+	unsigned int threadCount = m_threadCount ? m_threadCount : std::max( std::thread::hardware_concurrency(), 1U );
+	uint64_t segmentCount = std::max<uint64_t>( std::min<uint64_t>( threadCount, windowCount / MIN_SEGMENT_WINDOWS ), 1 );
+	uint64_t windowsPerSegment = ( windowCount + segmentCount - 1 ) / segmentCount;
+
+	// The in flight runs of all segments share the memory budget, anything more is sorted externally.
+	size_t budgetBlocks = m_memoryBudget / CHUNK_BLOCK_SIZE;
+	size_t runBlocks = std::max( static_cast<size_t>( budgetBlocks / segmentCount ), MIN_RUN_BLOCKS );
+
+	// Every segment writes the hashes of its own blocks.
+	m_inMemoryBlockHashes.clear();
+	if( m_storeBlockHashes )
+	{
+		m_inMemoryBlockHashes.resize( static_cast<size_t>( fileSize / m_chunkSize ) );
+	}
+	m_blockHashes = m_inMemoryBlockHashes.data();
+	m_blockHashCount = m_inMemoryBlockHashes.size();
+
+	std::vector<std::vector<ChunkIndexEntry>> segmentIndexes( segmentCount );
+	std::unique_ptr<bool[]> segmentResults( new bool[segmentCount] );
+	std::atomic<uint64_t> scannedBytes{ 0 };
+
+	auto generateSegment = [&]( uint64_t segment ) {
+		uint64_t firstWindow = std::min( segment * windowsPerSegment, windowCount );
+		uint64_t segmentWindows = std::min( windowsPerSegment, windowCount - firstWindow );
+		segmentResults[segment] = GenerateSegment( firstWindow, segmentWindows, runBlocks, segmentIndexes[segment], scannedBytes, segment == 0 );
+	};
+
+	// The calling thread takes the first segment, so progress is always reported from it.
+	std::vector<std::thread> workers;
+	for( uint64_t segment = 1; segment < segmentCount; ++segment )
+	{
+		workers.emplace_back( generateSegment, segment );
+	}
+	generateSegment( 0 );
+	for( auto& worker : workers )
+	{
+		worker.join();
+	}
+
+	if( !std::all_of( segmentResults.get(), segmentResults.get() + segmentCount, []( bool result ) { return result; } ) )
+	{
+		return false;
+	}
+
+	size_t remainingBlocks{ 0 };
+	for( auto& segmentIndex : segmentIndexes )
+	{
+		remainingBlocks += segmentIndex.size();
+	}
+
+	if( m_indexFiles.empty() && remainingBlocks <= std::min( IN_MEMORY_INDEX_BLOCKS, budgetBlocks ) )
+	{
+		// Small enough to not bother with the disk at all, the segments are already sorted.
+		m_inMemoryIndex.reserve( remainingBlocks );
+		for( auto& segmentIndex : segmentIndexes )
 		{
-			backlogOffset -= m_chunkSize;
-			fileOffset += m_chunkSize;
-			backlog = backlog.substr( m_chunkSize );
+			auto middle = m_inMemoryIndex.insert( m_inMemoryIndex.end(), segmentIndex.begin(), segmentIndex.end() );
+			std::inplace_merge( m_inMemoryIndex.begin(), middle, m_inMemoryIndex.end() );
 		}
+		m_index = m_inMemoryIndex.data();
+		m_indexSize = m_inMemoryIndex.size();
 	}
-	if( m_statusCallback && indexFileCount > 0 )
+	else
 	{
-		auto percentage = static_cast<unsigned int>( currentIndexFile / indexFileCount );
-		m_statusCallback( percentage, "Generating index" );
+		for( auto& segmentIndex : segmentIndexes )
+		{
+			if( !Flush( segmentIndex ) )
+			{
+				return false;
+			}
+		}
+		if( !MergeIndexFiles() || ( !m_indexFiles.empty() && !MapIndexFile( m_indexFiles.front(), 0 ) ) )
+		{
+			return false;
+		}
 	}
-	Flush( chunkToOffsets );
 	if( m_statusCallback )
 	{
 		m_statusCallback( 100, "Index generated" );
@@ -228,174 +392,392 @@ bool ChunkIndex::Generate()
 	return true;
 }
 
-bool FindMatchingChunksInFile( uint32_t chunk, const std::filesystem::path& path, size_t baseOffset, std::vector<size_t>& offsets )
+bool ChunkIndex::MergeIndexFiles()
 {
-	size_t fileSize = std::filesystem::file_size( path );
-	std::ifstream chunkFile;
-	chunkFile.open( path, std::ifstream::binary );
-	if( !chunkFile )
+	if( m_indexFiles.size() < 2 )
+	{
+		// A single index file is already sorted.
+		return true;
+	}
+
+	if( m_statusCallback )
+	{
+		m_statusCallback( 0, "Merging index files" );
+	}
+
+	std::vector<std::unique_ptr<MemoryMappedFile>> runs;
+	using Cursor = std::pair<const ChunkIndexEntry*, const ChunkIndexEntry*>;
+	std::vector<Cursor> cursors;
+	for( auto& path : m_indexFiles )
+	{
+		auto run = std::make_unique<MemoryMappedFile>();
+		if( !run->Open( path ) )
+		{
+			return false;
+		}
+		auto begin = reinterpret_cast<const ChunkIndexEntry*>( run->GetData() );
+		cursors.emplace_back( begin, begin + run->GetSize() / CHUNK_BLOCK_SIZE );
+		runs.push_back( std::move( run ) );
+	}
+
+	using HeapEntry = std::pair<ChunkIndexEntry, size_t>;
+	std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap;
+	for( size_t run = 0; run < cursors.size(); ++run )
+	{
+		if( cursors[run].first != cursors[run].second )
+		{
+			heap.emplace( *cursors[run].first, run );
+		}
+	}
+
+	std::filesystem::path mergedPath = m_indexFolder / ( m_fileToIndex.filename().string() + ".index" );
+	std::ofstream streamOut( mergedPath, std::ios::out | std::ios::binary );
+	if( !streamOut )
+	{
+		if( m_statusCallback )
+		{
+			std::stringstream ss;
+			ss << "Index merge failed. Failed to open path for writing: " << mergedPath;
+			m_statusCallback( 0, ss.str() );
+		}
+		return false;
+	}
+
+	std::vector<ChunkIndexEntry> buffer;
+	buffer.reserve( MERGE_WRITE_BLOCKS );
+	while( !heap.empty() )
+	{
+		auto [entry, run] = heap.top();
+		heap.pop();
+		buffer.push_back( entry );
+		if( ++cursors[run].first != cursors[run].second )
+		{
+			heap.emplace( *cursors[run].first, run );
+		}
+		if( buffer.size() == MERGE_WRITE_BLOCKS || heap.empty() )
+		{
+			streamOut.write( reinterpret_cast<const char*>( buffer.data() ), sizeof( ChunkIndexEntry ) * buffer.size() );
+			buffer.clear();
+		}
+	}
+	streamOut.close();
+	if( !streamOut )
 	{
 		return false;
 	}
-	size_t chunkCount = fileSize / CHUNK_BLOCK_SIZE;
 
-	size_t beginning = 0;
-	size_t end = chunkCount;
-	uint32_t current;
-	while( beginning <= end )
+	runs.clear();
+	for( auto& path : m_indexFiles )
 	{
-		size_t pos = ( beginning + end ) / 2;
-		chunkFile.seekg( CHUNK_BLOCK_SIZE * pos );
-		chunkFile.read( reinterpret_cast<char*>( &current ), sizeof( current ) );
-		if( current > chunk )
+		std::filesystem::remove( path );
+	}
+	m_indexFiles = { mergedPath };
+
+	return true;
+}
+
+bool ChunkIndex::MapIndexFile( const std::filesystem::path& path, size_t headerSize )
+{
+	if( !m_mappedIndex.Open( path ) || m_mappedIndex.GetSize() < headerSize )
+	{
+		if( m_statusCallback )
 		{
-			if( beginning == end )
-			{
-				return true;
-			}
-			end = pos;
+			std::stringstream ss;
+			ss << "Failed to map index file: " << path;
+			m_statusCallback( 0, ss.str() );
 		}
-		else if( current < chunk )
+		m_mappedIndex.Close();
+		return false;
+	}
+	m_index = reinterpret_cast<const ChunkIndexEntry*>( m_mappedIndex.GetData() + headerSize );
+	m_indexSize = ( m_mappedIndex.GetSize() - headerSize ) / CHUNK_BLOCK_SIZE;
+	return true;
+}
+
+bool ChunkIndex::Generate( ChunkIndexCache& cache, const std::string& fileChecksum )
+{
+	std::stringstream ss;
+	ss << fileChecksum << "_" << m_chunkSize;
+	if( m_storeBlockHashes )
+	{
+		ss << "_hashed";
+	}
+	std::string key = ss.str();
+
+	if( cache.Touch( key ) )
+	{
+		if( LoadCachedIndex( cache.GetEntryPath( key ) ) )
 		{
-			if( beginning == end )
-			{
-				return true;
-			}
-			if( beginning == pos )
-			{
-				beginning = pos + 1;
-			}
-			else
+			if( m_statusCallback )
 			{
-				beginning = pos;
+				m_statusCallback( 100, "Using cached index: " + cache.GetEntryPath( key ).string() );
 			}
+			return true;
 		}
-		else
+		// Corrupt or stale, regenerate it.
+		cache.Remove( key );
+	}
+
+	// The cached index has to serve any target file, so it can't be filtered.
+	ChecksumFilter checksumFilter;
+	std::swap( checksumFilter, m_checksumFilter );
+	bool generated = Generate();
+	std::swap( checksumFilter, m_checksumFilter );
+	if( !generated )
+	{
+		return false;
+	}
+
+	// Failing to cache the index is not fatal, the generated one is still usable.
+	std::filesystem::path temporaryPath = cache.GetTemporaryPath( key );
+	if( WriteCachedIndex( temporaryPath, fileChecksum ) && cache.Add( key, temporaryPath ) )
+	{
+		// Switch to the cached copy so the generated index files can be released.
+		m_mappedIndex.Close();
+		m_inMemoryIndex.clear();
+		m_inMemoryIndex.shrink_to_fit();
+		m_index = nullptr;
+		m_indexSize = 0;
+		m_inMemoryBlockHashes.clear();
+		m_inMemoryBlockHashes.shrink_to_fit();
+		m_blockHashes = nullptr;
+		m_blockHashCount = 0;
+		for( auto path : m_indexFiles )
 		{
-			// It's a match!
-			uint32_t relative{ 0 };
-			chunkFile.read( reinterpret_cast<char*>( &relative ), sizeof( relative ) );
-			offsets.push_back( baseOffset + relative );
+			std::filesystem::remove( path );
+		}
+		m_indexFiles.clear();
+		return LoadCachedIndex( cache.GetEntryPath( key ) );
+	}
+	return true;
+}
 
-			if( pos )
-			{
-				size_t previous = pos - 1;
-				while( true )
-				{
-					chunkFile.seekg( CHUNK_BLOCK_SIZE * previous );
-					chunkFile.read( reinterpret_cast<char*>( &current ), sizeof( current ) );
-					if( current == chunk )
-					{
-						uint32_t relative{ 0 };
-						chunkFile.read( reinterpret_cast<char*>( &relative ), sizeof( relative ) );
-						offsets.push_back( baseOffset + relative );
-					}
-					else
-					{
-						break;
-					}
-					if( !previous )
-					{
-						break;
-					}
-					--previous;
-				}
-			}
+bool ChunkIndex::WriteCachedIndex( const std::filesystem::path& path, const std::string& fileChecksum )
+{
+	CachedIndexHeader header{};
+	std::memcpy( header.magic, CACHED_INDEX_MAGIC, sizeof( header.magic ) );
+	header.version = CACHED_INDEX_VERSION;
+	header.chunkSize = m_chunkSize;
+	header.blockCount = m_indexSize;
+	header.blockHashCount = m_blockHashCount;
+	header.blocksHash = HashBytes( m_blockHashes, m_blockHashCount * sizeof( BlockHash ), HashBytes( m_index, m_indexSize * CHUNK_BLOCK_SIZE ) );
+	std::memcpy( header.fileChecksum, fileChecksum.data(), std::min( fileChecksum.size(), sizeof( header.fileChecksum ) ) );
+
+	std::error_code ec;
+	std::filesystem::create_directories( path.parent_path(), ec );
+	std::ofstream streamOut( path, std::ios::out | std::ios::binary );
+	if( !streamOut )
+	{
+		return false;
+	}
+	streamOut.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+	if( m_indexSize )
+	{
+		streamOut.write( reinterpret_cast<const char*>( m_index ), CHUNK_BLOCK_SIZE * m_indexSize );
+	}
+	if( m_blockHashCount )
+	{
+		streamOut.write( reinterpret_cast<const char*>( m_blockHashes ), sizeof( BlockHash ) * m_blockHashCount );
+	}
+	streamOut.close();
+	if( !streamOut )
+	{
+		std::filesystem::remove( path, ec );
+		return false;
+	}
+	return true;
+}
 
-			size_t next = pos + 1;
-			while( next <= chunkCount )
-			{
-				chunkFile.seekg( CHUNK_BLOCK_SIZE * next );
-				chunkFile.read( reinterpret_cast<char*>( &current ), sizeof( current ) );
-				if( current == chunk )
-				{
-					uint32_t relative;
-					chunkFile.read( reinterpret_cast<char*>( &relative ), sizeof( relative ) );
-					offsets.push_back( baseOffset + relative );
-				}
-				else
-				{
-					break;
-				}
-				++next;
-			}
+bool ChunkIndex::LoadCachedIndex( const std::filesystem::path& path )
+{
+	m_targetChunksResolved = false;
 
-			return true;
+	if( !MapIndexFile( path, sizeof( CachedIndexHeader ) ) )
+	{
+		return false;
+	}
+
+	CachedIndexHeader header;
+	std::memcpy( &header, m_mappedIndex.GetData(), sizeof( header ) );
+	size_t mappedSize = m_mappedIndex.GetSize();
+	bool valid = std::memcmp( header.magic, CACHED_INDEX_MAGIC, sizeof( header.magic ) ) == 0 &&
+		header.version == CACHED_INDEX_VERSION &&
+		header.chunkSize == m_chunkSize &&
+		header.blockCount <= mappedSize / CHUNK_BLOCK_SIZE &&
+		header.blockHashCount <= mappedSize / sizeof( BlockHash ) &&
+		mappedSize == sizeof( header ) + CHUNK_BLOCK_SIZE * header.blockCount + sizeof( BlockHash ) * header.blockHashCount;
+	if( valid )
+	{
+		m_indexSize = static_cast<size_t>( header.blockCount );
+		m_blockHashes = reinterpret_cast<const BlockHash*>( m_mappedIndex.GetData() + sizeof( header ) + CHUNK_BLOCK_SIZE * m_indexSize );
+		m_blockHashCount = static_cast<size_t>( header.blockHashCount );
+		valid = header.blocksHash == HashBytes( m_blockHashes, m_blockHashCount * sizeof( BlockHash ), HashBytes( m_index, m_indexSize * CHUNK_BLOCK_SIZE ) );
+	}
+	if( !valid )
+	{
+		if( m_statusCallback )
+		{
+			std::stringstream ss;
+			ss << "Cached index failed validation: " << path;
+			m_statusCallback( 0, ss.str() );
 		}
+		m_mappedIndex.Close();
+		m_index = nullptr;
+		m_indexSize = 0;
+		m_blockHashes = nullptr;
+		m_blockHashCount = 0;
+		return false;
 	}
 	return true;
 }
 
 bool ChunkIndex::FindChunkOffsets( uint32_t chunk, std::vector<size_t>& offsets )
 {
-	size_t baseOffset{ 0 };
-	for( auto path : m_indexFiles )
+	const ChunkIndexEntry* end = m_index + m_indexSize;
+	auto first = std::lower_bound( m_index, end, chunk, []( const ChunkIndexEntry& entry, uint32_t checksum ) {
+		return entry.checksum < checksum;
+	} );
+	for( auto entry = first; entry != end && entry->checksum == chunk; ++entry )
+	{
+		offsets.push_back( entry->GetOffset() );
+	}
+	return true;
+}
+
+bool ChunkIndex::FindChunkOffsets( const std::vector<uint32_t>& checksums, std::vector<std::vector<size_t>>& offsets )
+{
+	// Visit the checksums in index order so the index is only ever walked forward.
+	std::vector<size_t> order( checksums.size() );
+	for( size_t i = 0; i < order.size(); ++i )
+	{
+		order[i] = i;
+	}
+	std::stable_sort( order.begin(), order.end(), [&checksums]( size_t a, size_t b ) {
+		return checksums[a] < checksums[b];
+	} );
+
+	offsets.assign( checksums.size(), {} );
+	const ChunkIndexEntry* cursor = m_index;
+	const ChunkIndexEntry* end = m_index + m_indexSize;
+	auto isBefore = []( const ChunkIndexEntry& entry, uint32_t checksum ) {
+		return entry.checksum < checksum;
+	};
+	for( size_t position = 0; position < order.size(); ++position )
 	{
-		if( !FindMatchingChunksInFile( chunk, path, baseOffset, offsets ) )
+		size_t i = order[position];
+		if( position > 0 && checksums[order[position - 1]] == checksums[i] )
 		{
-			return false;
+			offsets[i] = offsets[order[position - 1]];
+			continue;
+		}
+
+		// Gallop ahead so sparse lookups into a large index don't read all of it.
+		size_t step = 1;
+		while( static_cast<size_t>( end - cursor ) > step && cursor[step].checksum < checksums[i] )
+		{
+			cursor += step;
+			step *= 2;
+		}
+		cursor = std::lower_bound( cursor, std::min( cursor + step + 1, end ), checksums[i], isBefore );
+
+		for( auto entry = cursor; entry != end && entry->checksum == checksums[i]; ++entry )
+		{
+			offsets[i].push_back( entry->GetOffset() );
 		}
-		baseOffset += BLOCKS_PER_FILE;
 	}
 	return true;
 }
 
+const std::vector<size_t>* ChunkIndex::FindTargetChunkOffsets( uint32_t checksum )
+{
+	if( m_targetChecksums.empty() )
+	{
+		return nullptr;
+	}
+	if( !m_targetChunksResolved )
+	{
+		FindChunkOffsets( m_targetChecksums, m_targetOffsets );
+		m_targetChunksResolved = true;
+	}
+	auto target = std::lower_bound( m_targetChecksums.begin(), m_targetChecksums.end(), checksum );
+	if( target == m_targetChecksums.end() || *target != checksum )
+	{
+		return nullptr;
+	}
+	return &m_targetOffsets[target - m_targetChecksums.begin()];
+}
+
 bool ChunkIndex::FindMatchingChunk( const std::string& chunk, size_t& chunkOffset )
 {
-	std::string sourceMD5;
-	bool sourceChecksumGenerated{ false };
+	auto chunkBytes = reinterpret_cast<const uint8_t*>( chunk.data() );
+	RollingChecksum rollingChecksum = ResourceTools::GenerateRollingAdlerChecksum( chunkBytes, chunk.size() );
 
-	size_t baseOffset{ 0 };
-	std::vector<size_t> offsets;
+	// Chunks of the target file were all looked up in one pass, anything else is looked up on its own.
+	std::vector<size_t> chunkOffsets;
+	const std::vector<size_t>* candidates = FindTargetChunkOffsets( rollingChecksum.checksum );
+	if( !candidates )
+	{
+		if( !FindChunkOffsets( rollingChecksum.checksum, chunkOffsets ) )
+		{
+			return false;
+		}
+		candidates = &chunkOffsets;
+	}
+	const std::vector<size_t>& offsets = *candidates;
+	if( offsets.empty() )
+	{
+		return false;
+	}
 
-	auto end = static_cast<uint32_t>( chunk.size() );
-	RollingChecksum rollingChecksum = ResourceTools::GenerateRollingAdlerChecksum( chunk, 0, end );
+	// Candidates on an aligned block are verified against its stored hash, the chunk itself is hashed at most once.
+	bool canUseBlockHashes = m_blockHashCount > 0 && chunk.size() == m_chunkSize;
+	bool chunkHashed{ false };
+	BlockHash chunkHash;
 
-	for( auto path : m_indexFiles )
+	std::ifstream chunkFile;
+	std::string fileData;
+	for( size_t offset : offsets )
 	{
-		if( !FindMatchingChunksInFile( rollingChecksum.checksum, path, baseOffset, offsets ) )
+		if( canUseBlockHashes && offset % m_chunkSize == 0 && offset / m_chunkSize < m_blockHashCount )
 		{
-			return false;
+			if( !chunkHashed )
+			{
+				BlockHashStream blockHashStream;
+				blockHashStream.Update( chunkBytes, chunk.size() );
+				chunkHash = blockHashStream.Finish();
+				chunkHashed = true;
+			}
+			if( m_blockHashes[offset / m_chunkSize] == chunkHash )
+			{
+				chunkOffset = offset;
+				return true;
+			}
+			continue;
 		}
-		if( !offsets.empty() )
+
+		if( !chunkFile.is_open() )
 		{
-			std::ifstream chunkFile;
 			chunkFile.open( m_fileToIndex, std::ifstream::binary );
 			if( !chunkFile )
 			{
 				return false;
 			}
-
-			for( size_t offset : offsets )
-			{
-				std::string fileData;
-				fileData.resize( chunk.size() );
-				chunkFile.seekg( static_cast<std::streamoff>( offset ) );
-				chunkFile.read( fileData.data(), fileData.size() );
-				if( !sourceChecksumGenerated )
-				{
-					if( !ResourceTools::GenerateMd5Checksum( fileData, sourceMD5 ) )
-					{
-						return false;
-					}
-					sourceChecksumGenerated = true;
-				}
-
-				std::string matchingChunkMD5;
-				if( !ResourceTools::GenerateMd5Checksum( chunk, matchingChunkMD5 ) )
-				{
-					return false;
-				}
-				if( sourceMD5 == matchingChunkMD5 )
-				{
-					// It's legit!
-					chunkOffset = offset;
-					return true;
-				}
-			}
+			fileData.resize( chunk.size() );
+		}
+		chunkFile.clear();
+		chunkFile.seekg( static_cast<std::streamoff>( offset ) );
+		if( !chunkFile.read( fileData.data(), fileData.size() ) )
+		{
+			continue;
+		}
+		if( fileData == chunk )
+		{
+			// It's legit!
+			chunkOffset = offset;
+			return true;
 		}
 	}
 	return false;
 }
 
-}
\ No newline at end of file
+}
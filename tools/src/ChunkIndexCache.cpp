@@ -0,0 +1,134 @@
+// Copyright © 2025 CCP ehf.
+
+#include "ChunkIndexCache.h"
+
+#include <algorithm>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#if WIN32
+#include <windows.h> // for GetCurrentProcessId
+#else
+#include <unistd.h> // for getpid
+#endif
+
+namespace ResourceTools
+{
+ChunkIndexCache::ChunkIndexCache( const std::filesystem::path& cacheFolder, uintmax_t maxSize, StatusCallback statusCallback, const std::string& entryExtension ) :
+	m_cacheFolder( cacheFolder ), m_maxSize( maxSize ), m_statusCallback( statusCallback ), m_entryExtension( entryExtension )
+{
+}
+
+std::filesystem::path ChunkIndexCache::GetEntryPath( const std::string& key ) const
+{
+	return m_cacheFolder / ( key + m_entryExtension );
+}
+
+std::filesystem::path ChunkIndexCache::GetTemporaryPath( const std::string& key ) const
+{
+	// Unique per process and thread, so concurrent writers of the same key never share a file,
+	// even when several processes share the cache folder.
+#if WIN32
+	unsigned long processId = GetCurrentProcessId();
+#else
+	long processId = static_cast<long>( getpid() );
+#endif
+	std::stringstream ss;
+	ss << key << "." << processId << "." << std::this_thread::get_id() << ".tmp";
+	return m_cacheFolder / ss.str();
+}
+
+bool ChunkIndexCache::Touch( const std::string& key )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	std::error_code ec;
+	std::filesystem::path entryPath = GetEntryPath( key );
+	if( !std::filesystem::is_regular_file( entryPath, ec ) )
+	{
+		return false;
+	}
+	// The modification time doubles as the last use time for eviction.
+	std::filesystem::last_write_time( entryPath, std::filesystem::file_time_type::clock::now(), ec );
+	return true;
+}
+
+bool ChunkIndexCache::Add( const std::string& key, const std::filesystem::path& indexFile )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	std::error_code ec;
+	std::filesystem::path entryPath = GetEntryPath( key );
+	std::filesystem::create_directories( m_cacheFolder, ec );
+	std::filesystem::rename( indexFile, entryPath, ec );
+	if( ec )
+	{
+		if( m_statusCallback )
+		{
+			std::stringstream ss;
+			ss << "Failed to add entry to cache: " << entryPath;
+			m_statusCallback( 0, ss.str() );
+		}
+		std::filesystem::remove( indexFile, ec );
+		return false;
+	}
+	Evict( entryPath );
+	return true;
+}
+
+void ChunkIndexCache::Remove( const std::string& key )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	std::error_code ec;
+	std::filesystem::remove( GetEntryPath( key ), ec );
+}
+
+void ChunkIndexCache::Evict( const std::filesystem::path& keep )
+{
+	struct Entry
+	{
+		std::filesystem::path path;
+		std::filesystem::file_time_type lastUsed;
+		uintmax_t size;
+	};
+	std::vector<Entry> entries;
+	uintmax_t totalSize{ 0 };
+
+	std::error_code ec;
+	for( auto& directoryEntry : std::filesystem::directory_iterator( m_cacheFolder, ec ) )
+	{
+		if( !directoryEntry.is_regular_file( ec ) || directoryEntry.path().extension() != m_entryExtension )
+		{
+			continue;
+		}
+		Entry entry{ directoryEntry.path(), directoryEntry.last_write_time( ec ), directoryEntry.file_size( ec ) };
+		totalSize += entry.size;
+		entries.push_back( entry );
+	}
+
+	std::sort( entries.begin(), entries.end(), []( const Entry& a, const Entry& b ) { return a.lastUsed < b.lastUsed; } );
+
+	for( auto& entry : entries )
+	{
+		if( totalSize <= m_maxSize )
+		{
+			break;
+		}
+		if( entry.path == keep )
+		{
+			continue;
+		}
+		// Removal fails if another process has the entry open, it will be evicted on a later run.
+		if( std::filesystem::remove( entry.path, ec ) )
+		{
+			totalSize -= entry.size;
+			if( m_statusCallback )
+			{
+				std::stringstream ss;
+				ss << "Evicted entry from cache: " << entry.path;
+				m_statusCallback( 0, ss.str() );
+			}
+		}
+	}
+}
+
+}
@@ -0,0 +1,122 @@
+// Copyright © 2025 CCP ehf.
+
+#include "ContentDefinedChunking.h"
+
+#include <algorithm>
+#include <array>
+
+#include "MemoryMappedFile.h"
+
+namespace ResourceTools
+{
+namespace
+{
+// Gear hash table, 256 fixed pseudo random values so boundaries are the same on every run and platform.
+constexpr std::array<uint64_t, 256> GenerateGearTable()
+{
+	std::array<uint64_t, 256> table{};
+	uint64_t state = 0x9E3779B97F4A7C15ull;
+	for( auto& value : table )
+	{
+		// splitmix64
+		state += 0x9E3779B97F4A7C15ull;
+		uint64_t z = state;
+		z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+		z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+		value = z ^ ( z >> 31 );
+	}
+	return table;
+}
+
+constexpr std::array<uint64_t, 256> GEAR_TABLE = GenerateGearTable();
+
+// Mask of the top bitCount bits, the top bits of the gear hash depend on the most bytes.
+uint64_t TopBitsMask( unsigned int bitCount )
+{
+	return bitCount == 0 ? 0 : ~uint64_t( 0 ) << ( 64 - std::min( bitCount, 64u ) );
+}
+
+unsigned int FloorLog2( size_t value )
+{
+	unsigned int log = 0;
+	while( value > 1 )
+	{
+		value >>= 1;
+		++log;
+	}
+	return log;
+}
+}
+
+ContentDefinedChunkSizes GetContentDefinedChunkSizes( size_t maximumSize )
+{
+	ContentDefinedChunkSizes sizes;
+	sizes.maximumSize = std::max<size_t>( maximumSize, 1 );
+	sizes.averageSize = std::max<size_t>( sizes.maximumSize / 4, 1 );
+	sizes.minimumSize = sizes.averageSize / 4;
+	return sizes;
+}
+
+size_t FindContentDefinedChunkEnd( const uint8_t* data, size_t length, const ContentDefinedChunkSizes& sizes )
+{
+	if( length <= sizes.minimumSize )
+	{
+		return length;
+	}
+	size_t end = std::min( length, sizes.maximumSize );
+	size_t normalEnd = std::min( end, sizes.averageSize );
+
+	// Normalised chunking, a boundary is harder to find before the average size and easier after it,
+	// which narrows the spread of chunk sizes.
+	unsigned int averageBits = FloorLog2( sizes.averageSize );
+	uint64_t smallMask = TopBitsMask( averageBits + 1 );
+	uint64_t largeMask = TopBitsMask( averageBits > 0 ? averageBits - 1 : 0 );
+
+	uint64_t hash = 0;
+	size_t i = sizes.minimumSize;
+	for( ; i < normalEnd; ++i )
+	{
+		hash = ( hash << 1 ) + GEAR_TABLE[data[i]];
+		if( !( hash & smallMask ) )
+		{
+			return i + 1;
+		}
+	}
+	for( ; i < end; ++i )
+	{
+		hash = ( hash << 1 ) + GEAR_TABLE[data[i]];
+		if( !( hash & largeMask ) )
+		{
+			return i + 1;
+		}
+	}
+	return end;
+}
+
+bool GenerateContentDefinedChunks( const std::filesystem::path& path, const ContentDefinedChunkSizes& sizes, std::vector<ContentDefinedChunk>& chunks )
+{
+	chunks.clear();
+
+	MemoryMappedFile file;
+	if( !file.Open( path ) )
+	{
+		return false;
+	}
+
+	const uint8_t* data = file.GetData();
+	size_t size = file.GetSize();
+
+	BlockHashStream hashStream;
+	chunks.reserve( size / sizes.averageSize + 1 );
+	for( size_t offset = 0; offset < size; )
+	{
+		size_t chunkSize = FindContentDefinedChunkEnd( data + offset, size - offset, sizes );
+		hashStream.Update( data + offset, chunkSize );
+		chunks.push_back( ContentDefinedChunk{ offset, chunkSize, hashStream.Finish() } );
+		offset += chunkSize;
+	}
+
+	return true;
+}
+
+}
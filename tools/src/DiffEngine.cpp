@@ -0,0 +1,143 @@
+// Copyright © 2025 CCP ehf.
+
+#include "DiffEngine.h"
+
+#include <memory>
+
+#include <zstd.h>
+
+#include "Patching.h"
+
+namespace ResourceTools
+{
+namespace
+{
+// The window has to span the previous data and the data being compressed for matches to reach the start of the previous data.
+int GetZstdWindowLog( size_t previousSize, size_t latestSize, ZSTD_bounds bounds )
+{
+	int windowLog = bounds.lowerBound;
+	while( windowLog < bounds.upperBound && ( size_t( 1 ) << windowLog ) < previousSize + latestSize )
+	{
+		windowLog++;
+	}
+	return windowLog;
+}
+}
+
+std::string BsdiffDiffEngine::GetName() const
+{
+	return DIFF_ENGINE_BSDIFF;
+}
+
+bool BsdiffDiffEngine::CreatePatch( const std::string& previousData, const std::string& latestData, std::string& patchData ) const
+{
+	return ResourceTools::CreatePatch( previousData, latestData, patchData );
+}
+
+bool BsdiffDiffEngine::ApplyPatch( const std::string& previousData, const std::string& patchData, std::string& out ) const
+{
+	return ResourceTools::ApplyPatch( previousData, patchData, out );
+}
+
+ZstdDiffEngine::ZstdDiffEngine( int compressionLevel /* = 19 */ ) :
+	m_compressionLevel( compressionLevel )
+{
+}
+
+std::string ZstdDiffEngine::GetName() const
+{
+	return DIFF_ENGINE_ZSTD;
+}
+
+bool ZstdDiffEngine::CreatePatch( const std::string& previousData, const std::string& latestData, std::string& patchData ) const
+{
+	std::unique_ptr<ZSTD_CCtx, decltype( &ZSTD_freeCCtx )> context( ZSTD_createCCtx(), ZSTD_freeCCtx );
+	if( !context )
+	{
+		return false;
+	}
+
+	int windowLog = GetZstdWindowLog( previousData.size(), latestData.size(), ZSTD_cParam_getBounds( ZSTD_c_windowLog ) );
+
+	if( ZSTD_isError( ZSTD_CCtx_setParameter( context.get(), ZSTD_c_compressionLevel, m_compressionLevel ) ) || ZSTD_isError( ZSTD_CCtx_setParameter( context.get(), ZSTD_c_enableLongDistanceMatching, 1 ) ) || ZSTD_isError( ZSTD_CCtx_setParameter( context.get(), ZSTD_c_windowLog, windowLog ) ) )
+	{
+		return false;
+	}
+
+	// The prefix is only referenced, it must outlive the compression
+	if( ZSTD_isError( ZSTD_CCtx_refPrefix( context.get(), previousData.data(), previousData.size() ) ) )
+	{
+		return false;
+	}
+
+	patchData.resize( ZSTD_compressBound( latestData.size() ) );
+
+	size_t patchSize = ZSTD_compress2( context.get(), patchData.data(), patchData.size(), latestData.data(), latestData.size() );
+	if( ZSTD_isError( patchSize ) )
+	{
+		patchData.clear();
+		return false;
+	}
+
+	patchData.resize( patchSize );
+
+	return true;
+}
+
+bool ZstdDiffEngine::ApplyPatch( const std::string& previousData, const std::string& patchData, std::string& out ) const
+{
+	// The size of the latest data is recorded in the frame header
+	unsigned long long latestSize = ZSTD_getFrameContentSize( patchData.data(), patchData.size() );
+	if( latestSize == ZSTD_CONTENTSIZE_UNKNOWN || latestSize == ZSTD_CONTENTSIZE_ERROR )
+	{
+		return false;
+	}
+
+	std::unique_ptr<ZSTD_DCtx, decltype( &ZSTD_freeDCtx )> context( ZSTD_createDCtx(), ZSTD_freeDCtx );
+	if( !context )
+	{
+		return false;
+	}
+
+	int windowLog = GetZstdWindowLog( previousData.size(), static_cast<size_t>( latestSize ), ZSTD_dParam_getBounds( ZSTD_d_windowLogMax ) );
+
+	if( ZSTD_isError( ZSTD_DCtx_setParameter( context.get(), ZSTD_d_windowLogMax, windowLog ) ) )
+	{
+		return false;
+	}
+
+	if( ZSTD_isError( ZSTD_DCtx_refPrefix( context.get(), previousData.data(), previousData.size() ) ) )
+	{
+		return false;
+	}
+
+	out.resize( static_cast<size_t>( latestSize ) );
+
+	size_t outSize = ZSTD_decompressDCtx( context.get(), out.data(), out.size(), patchData.data(), patchData.size() );
+	if( ZSTD_isError( outSize ) || outSize != latestSize )
+	{
+		return false;
+	}
+
+	return true;
+}
+
+const DiffEngine* GetDiffEngine( const std::string& name )
+{
+	static const BsdiffDiffEngine bsdiffDiffEngine;
+	static const ZstdDiffEngine zstdDiffEngine;
+
+	if( name == DIFF_ENGINE_BSDIFF )
+	{
+		return &bsdiffDiffEngine;
+	}
+
+	if( name == DIFF_ENGINE_ZSTD )
+	{
+		return &zstdDiffEngine;
+	}
+
+	return nullptr;
+}
+
+}
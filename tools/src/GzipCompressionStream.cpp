@@ -9,7 +9,8 @@ namespace ResourceTools
 
 GzipCompressionStream::GzipCompressionStream( std::string* out ) :
 	m_compressionInProgress( false ),
-	m_out( out )
+	m_out( out ),
+	m_compressedSize( 0 )
 {
 }
 
@@ -35,6 +36,8 @@ bool GzipCompressionStream::Start()
 		return false;
 	}
 
+	m_compressedSize = 0;
+
 	m_compressionInProgress = true;
 
 	return true;
@@ -62,7 +65,11 @@ bool GzipCompressionStream::ProcessBuffer( bool finish )
 		ret = deflate( &m_stream, flush );
 		uLong outBytes = m_stream.total_out - alreadyOut;
 		uLong inBytes = m_stream.total_in - alreadyIn;
-		m_out->append( std::string( reinterpret_cast<const char*>( outbuffer ), outBytes ) );
+		if( m_out )
+		{
+			m_out->append( reinterpret_cast<const char*>( outbuffer ), outBytes );
+		}
+		m_compressedSize += outBytes;
 		m_buffer = m_buffer.substr( inBytes );
 	}
 
@@ -99,4 +106,9 @@ bool GzipCompressionStream::Finish()
 
 	return deflateEnd( &m_stream ) == Z_OK;
 }
+
+uintmax_t GzipCompressionStream::GetCompressedSize() const
+{
+	return m_compressedSize;
+}
 }
\ No newline at end of file
@@ -0,0 +1,155 @@
+// Copyright © 2025 CCP ehf.
+
+#include "MemoryMappedFile.h"
+
+#if WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ResourceTools
+{
+
+MemoryMappedFile::MemoryMappedFile() :
+	m_open( false ),
+	m_data( nullptr ),
+	m_size( 0 ),
+#if WIN32
+	m_fileHandle( INVALID_HANDLE_VALUE ),
+	m_mappingHandle( nullptr )
+#else
+	m_fileDescriptor( -1 )
+#endif
+{
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+	Close();
+}
+
+bool MemoryMappedFile::Open( const std::filesystem::path& path )
+{
+	Close();
+
+#if WIN32
+	m_fileHandle = CreateFileW( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( m_fileHandle == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if( !GetFileSizeEx( m_fileHandle, &fileSize ) )
+	{
+		Close();
+		return false;
+	}
+	m_size = static_cast<size_t>( fileSize.QuadPart );
+
+	// Empty files cannot be mapped, but are valid.
+	if( m_size > 0 )
+	{
+		m_mappingHandle = CreateFileMappingW( m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		if( !m_mappingHandle )
+		{
+			Close();
+			return false;
+		}
+
+		m_data = static_cast<const uint8_t*>( MapViewOfFile( m_mappingHandle, FILE_MAP_READ, 0, 0, 0 ) );
+		if( !m_data )
+		{
+			Close();
+			return false;
+		}
+	}
+#else
+	m_fileDescriptor = open( path.c_str(), O_RDONLY );
+	if( m_fileDescriptor < 0 )
+	{
+		return false;
+	}
+
+	struct stat fileStat;
+	if( fstat( m_fileDescriptor, &fileStat ) != 0 )
+	{
+		Close();
+		return false;
+	}
+	m_size = static_cast<size_t>( fileStat.st_size );
+
+	// Empty files cannot be mapped, but are valid.
+	if( m_size > 0 )
+	{
+		void* mapping = mmap( nullptr, m_size, PROT_READ, MAP_SHARED, m_fileDescriptor, 0 );
+		if( mapping == MAP_FAILED )
+		{
+			Close();
+			return false;
+		}
+		m_data = static_cast<const uint8_t*>( mapping );
+	}
+#endif
+
+	m_open = true;
+
+	return true;
+}
+
+void MemoryMappedFile::Close()
+{
+#if WIN32
+	if( m_data )
+	{
+		UnmapViewOfFile( m_data );
+	}
+	if( m_mappingHandle )
+	{
+		CloseHandle( m_mappingHandle );
+		m_mappingHandle = nullptr;
+	}
+	if( m_fileHandle != INVALID_HANDLE_VALUE )
+	{
+		CloseHandle( m_fileHandle );
+		m_fileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if( m_data )
+	{
+		munmap( const_cast<uint8_t*>( m_data ), m_size );
+	}
+	if( m_fileDescriptor >= 0 )
+	{
+		close( m_fileDescriptor );
+		m_fileDescriptor = -1;
+	}
+#endif
+
+	m_data = nullptr;
+
+	m_size = 0;
+
+	m_open = false;
+}
+
+bool MemoryMappedFile::IsOpen() const
+{
+	return m_open;
+}
+
+const uint8_t* MemoryMappedFile::GetData() const
+{
+	return m_data;
+}
+
+size_t MemoryMappedFile::GetSize() const
+{
+	return m_size;
+}
+
+}
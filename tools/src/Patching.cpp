@@ -5,29 +5,356 @@
 #include <bsdiff.h>
 #include <bspatch.h>
 
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+
 #include "BundleStreamIn.h"
 #include "ResourceTools.h"
+#include "SuffixArray.h"
 
 const char* BSDIFF_HEADER_STR = "ENDSLEY/BSDIFF43";
 constexpr uint8_t BSDIFF_HEADER_TEXT_SIZE = 16;
 constexpr uint8_t BSDIFF_SIZE_ENCODING_SIZE = 8;
 constexpr uint8_t BSDIFF_HEADER_SIZE = BSDIFF_HEADER_TEXT_SIZE + BSDIFF_SIZE_ENCODING_SIZE;
 
+// Size of idle buffers kept for reuse by later patches, beyond it the smallest are released.
+constexpr size_t PATCH_BUFFER_POOL_MAX_SIZE{ 1024 * 1024 * 512 };
+
+namespace
+{
+// Patches are created chunk by chunk with buffers of much the same size each time, so the
+// large suffix array and output buffers are kept and handed out again rather than reallocated.
+class PatchBufferPool
+{
+public:
+	~PatchBufferPool()
+	{
+		Release();
+	}
+
+	void* Allocate( size_t size )
+	{
+		{
+			std::lock_guard<std::mutex> lock( m_mutex );
+
+			// Only reuse buffers not much larger than needed, so small requests do not hold large buffers
+			auto it = m_buffers.lower_bound( size );
+			if( it != m_buffers.end() && it->first / 2 <= size )
+			{
+				int8_t* buffer = it->second;
+				m_size -= it->first;
+				m_buffers.erase( it );
+				return buffer + HEADER_SIZE;
+			}
+		}
+
+		int8_t* buffer = new( std::nothrow ) int8_t[HEADER_SIZE + size];
+		if( !buffer )
+		{
+			return nullptr;
+		}
+		*reinterpret_cast<size_t*>( buffer ) = size;
+		return buffer + HEADER_SIZE;
+	}
+
+	void Free( void* ptr )
+	{
+		if( !ptr )
+		{
+			return;
+		}
+
+		int8_t* buffer = reinterpret_cast<int8_t*>( ptr ) - HEADER_SIZE;
+		size_t capacity = *reinterpret_cast<size_t*>( buffer );
+
+		std::lock_guard<std::mutex> lock( m_mutex );
+
+		m_buffers.emplace( capacity, buffer );
+		m_size += capacity;
+		while( m_size > PATCH_BUFFER_POOL_MAX_SIZE )
+		{
+			auto smallest = m_buffers.begin();
+			m_size -= smallest->first;
+			delete[] smallest->second;
+			m_buffers.erase( smallest );
+		}
+	}
+
+	void Release()
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+
+		for( auto& buffer : m_buffers )
+		{
+			delete[] buffer.second;
+		}
+		m_buffers.clear();
+		m_size = 0;
+	}
+
+private:
+	// Capacity is stored before each buffer, keeping the buffer 16 byte aligned
+	static constexpr size_t HEADER_SIZE = 16;
+
+	std::mutex m_mutex;
+
+	std::multimap<size_t, int8_t*> m_buffers;
+
+	size_t m_size = 0;
+};
+
+PatchBufferPool s_patchBufferPool;
+
+// bsdiff's offtout, sign and magnitude little endian
+void WriteOffset( int64_t x, uint8_t* buf )
+{
+	int64_t y = x < 0 ? -x : x;
+	for( int i = 0; i < 8; ++i )
+	{
+		buf[i] = static_cast<uint8_t>( y % 256 );
+		y /= 256;
+	}
+	if( x < 0 )
+	{
+		buf[7] |= 0x80;
+	}
+}
+
+int WriteData( bsdiff_stream* stream, const void* buffer, int64_t length, bsdiff_stream_type type )
+{
+	while( length > 0 )
+	{
+		auto size = static_cast<int>( std::min<int64_t>( length, INT_MAX ) );
+		if( stream->write( stream, buffer, size, type ) != 0 )
+		{
+			return -1;
+		}
+		length -= size;
+		buffer = reinterpret_cast<const uint8_t*>( buffer ) + size;
+	}
+	return 0;
+}
+
+int64_t MatchLength( const uint8_t* oldData, int64_t oldSize, const uint8_t* newData, int64_t newSize )
+{
+	int64_t i = 0;
+	while( i < oldSize && i < newSize && oldData[i] == newData[i] )
+	{
+		++i;
+	}
+	return i;
+}
+
+// Longest match of newData in oldData, found by binary search of the suffix array
+template <typename T>
+int64_t Search( const T* I, const uint8_t* oldData, int64_t oldSize, const uint8_t* newData, int64_t newSize, int64_t start, int64_t end, int64_t& pos )
+{
+	while( end - start >= 2 )
+	{
+		int64_t middle = start + ( end - start ) / 2;
+		if( memcmp( oldData + I[middle], newData, std::min( oldSize - I[middle], newSize ) ) < 0 )
+		{
+			start = middle;
+		}
+		else
+		{
+			end = middle;
+		}
+	}
+
+	int64_t x = MatchLength( oldData + I[start], oldSize - I[start], newData, newSize );
+	int64_t y = MatchLength( oldData + I[end], oldSize - I[end], newData, newSize );
+	if( x > y )
+	{
+		pos = I[start];
+		return x;
+	}
+	pos = I[end];
+	return y;
+}
+
+// The diff loop of bsdiff, run over a suffix array built by SA-IS instead of qsufsort.
+// Suffix arrays are unique, so the patch written is the same as bsdiff's.
+template <typename T>
+int DiffWithSuffixArray( const uint8_t* oldData, int64_t oldSize, const uint8_t* newData, int64_t newSize, bsdiff_stream* stream )
+{
+	T* I = reinterpret_cast<T*>( stream->malloc( ( oldSize + 1 ) * sizeof( T ) ) );
+	if( !I )
+	{
+		return -1;
+	}
+
+	uint8_t* buffer = reinterpret_cast<uint8_t*>( stream->malloc( newSize + 1 ) );
+	if( !buffer )
+	{
+		stream->free( I );
+		return -1;
+	}
+
+	ResourceTools::BuildSuffixArray( oldData, static_cast<T>( oldSize ), I );
+
+	int result = 0;
+	int64_t scan = 0;
+	int64_t len = 0;
+	int64_t pos = 0;
+	int64_t lastScan = 0;
+	int64_t lastPos = 0;
+	int64_t lastOffset = 0;
+	uint8_t buf[8 * 3];
+
+	while( scan < newSize )
+	{
+		int64_t oldScore = 0;
+		int64_t scsc;
+
+		for( scsc = scan += len; scan < newSize; scan++ )
+		{
+			len = Search( I, oldData, oldSize, newData + scan, newSize - scan, 0, oldSize, pos );
+
+			for( ; scsc < scan + len; scsc++ )
+			{
+				if( ( scsc + lastOffset < oldSize ) && ( oldData[scsc + lastOffset] == newData[scsc] ) )
+				{
+					oldScore++;
+				}
+			}
+
+			if( ( ( len == oldScore ) && ( len != 0 ) ) || ( len > oldScore + 8 ) )
+			{
+				break;
+			}
+
+			if( ( scan + lastOffset < oldSize ) && ( oldData[scan + lastOffset] == newData[scan] ) )
+			{
+				oldScore--;
+			}
+		}
+
+		if( ( len != oldScore ) || ( scan == newSize ) )
+		{
+			int64_t s = 0;
+			int64_t sf = 0;
+			int64_t lenf = 0;
+			for( int64_t i = 0; ( lastScan + i < scan ) && ( lastPos + i < oldSize ); )
+			{
+				if( oldData[lastPos + i] == newData[lastScan + i] )
+				{
+					s++;
+				}
+				i++;
+				if( s * 2 - i > sf * 2 - lenf )
+				{
+					sf = s;
+					lenf = i;
+				}
+			}
+
+			int64_t lenb = 0;
+			if( scan < newSize )
+			{
+				s = 0;
+				int64_t sb = 0;
+				for( int64_t i = 1; ( scan >= lastScan + i ) && ( pos >= i ); i++ )
+				{
+					if( oldData[pos - i] == newData[scan - i] )
+					{
+						s++;
+					}
+					if( s * 2 - i > sb * 2 - lenb )
+					{
+						sb = s;
+						lenb = i;
+					}
+				}
+			}
+
+			if( lastScan + lenf > scan - lenb )
+			{
+				int64_t overlap = ( lastScan + lenf ) - ( scan - lenb );
+				s = 0;
+				int64_t ss = 0;
+				int64_t lens = 0;
+				for( int64_t i = 0; i < overlap; i++ )
+				{
+					if( newData[lastScan + lenf - overlap + i] == oldData[lastPos + lenf - overlap + i] )
+					{
+						s++;
+					}
+					if( newData[scan - lenb + i] == oldData[pos - lenb + i] )
+					{
+						s--;
+					}
+					if( s > ss )
+					{
+						ss = s;
+						lens = i + 1;
+					}
+				}
+
+				lenf += lens - overlap;
+				lenb -= lens;
+			}
+
+			int64_t extraLength = ( scan - lenb ) - ( lastScan + lenf );
+
+			WriteOffset( lenf, buf );
+			WriteOffset( extraLength, buf + 8 );
+			WriteOffset( ( pos - lenb ) - ( lastPos + lenf ), buf + 16 );
+
+			if( WriteData( stream, buf, sizeof( buf ), BSDIFF_WRITECONTROL ) )
+			{
+				result = -1;
+				break;
+			}
+
+			for( int64_t i = 0; i < lenf; i++ )
+			{
+				buffer[i] = newData[lastScan + i] - oldData[lastPos + i];
+			}
+			if( WriteData( stream, buffer, lenf, BSDIFF_WRITEDIFF ) )
+			{
+				result = -1;
+				break;
+			}
+
+			if( WriteData( stream, newData + lastScan + lenf, extraLength, BSDIFF_WRITEEXTRA ) )
+			{
+				result = -1;
+				break;
+			}
+
+			lastScan = scan - lenb;
+			lastPos = pos - lenb;
+			lastOffset = pos - scan;
+		}
+	}
+
+	stream->free( buffer );
+	stream->free( I );
+
+	return result;
+}
+}
+
 void* bs_alloc( size_t size )
 {
-	return new int8_t[size];
+	return s_patchBufferPool.Allocate( size );
 }
 
 void bs_free( void* ptr )
 {
-	delete[] reinterpret_cast<int8_t*>( ptr );
+	s_patchBufferPool.Free( ptr );
 }
 
 int bs_write( struct bsdiff_stream* stream, const void* buffer, size_t size, enum bsdiff_stream_type type )
 {
-	std::string* strp = reinterpret_cast<std::string*>( stream->opaque );
-	strp->append( reinterpret_cast<const char*>( buffer ), size );
-	return 0;
+	auto write = reinterpret_cast<const std::function<bool( const char*, size_t )>*>( stream->opaque );
+	return ( *write )( reinterpret_cast<const char*>( buffer ), size ) ? 0 : -1;
 }
 
 int bs_read_chunked( const struct bspatch_stream* stream, void* buffer, size_t length, enum bspatch_stream_type type )
@@ -131,24 +458,53 @@ bool ApplyPatchChunked( const std::string& data, ResourceTools::BundleStreamIn&
 	return true;
 }
 
-bool CreatePatch( const std::string& previousData, const std::string& latestData, std::string& patchData )
+namespace
+{
+// Patch data is passed to write as it is created, the header first as the size of latestData is known up front
+bool CreatePatch( const std::string& previousData, const std::string& latestData, const std::function<bool( const char*, size_t )>& write, SuffixSortAlgorithm suffixSort )
 {
+	char header[BSDIFF_HEADER_SIZE];
+	uint64_t size = latestData.size();
+	memcpy( header, BSDIFF_HEADER_STR, BSDIFF_HEADER_TEXT_SIZE );
+	memcpy( header + BSDIFF_HEADER_TEXT_SIZE, &size, sizeof size );
+	if( !write( header, BSDIFF_HEADER_SIZE ) )
+	{
+		return false;
+	}
+
 	bsdiff_stream stream;
-	stream.opaque = &patchData;
+	stream.opaque = const_cast<std::function<bool( const char*, size_t )>*>( &write );
 	stream.malloc = bs_alloc;
 	stream.free = bs_free;
 	stream.write = bs_write;
-	int result = bsdiff( reinterpret_cast<const uint8_t*>( previousData.c_str() ), previousData.size(), reinterpret_cast<const uint8_t*>( latestData.c_str() ), latestData.size(), &stream );
-	if( result != 0 )
+	auto oldData = reinterpret_cast<const uint8_t*>( previousData.c_str() );
+	auto newData = reinterpret_cast<const uint8_t*>( latestData.c_str() );
+	int result;
+	if( suffixSort == SuffixSortAlgorithm::QSUFSORT )
 	{
-		return false;
+		result = bsdiff( oldData, previousData.size(), newData, latestData.size(), &stream );
 	}
-	char sizeEncodedInHeader[8];
-	uint64_t size = latestData.size();
-	memcpy( sizeEncodedInHeader, &size, sizeof size );
-	patchData = std::string( BSDIFF_HEADER_STR, 16 ) + std::string( sizeEncodedInHeader, 8 ) + patchData;
+	else if( previousData.size() < static_cast<size_t>( std::numeric_limits<int32_t>::max() ) )
+	{
+		// 32 bit suffix array, a quarter of the memory of qsufsort's two 64 bit arrays
+		result = DiffWithSuffixArray<int32_t>( oldData, previousData.size(), newData, latestData.size(), &stream );
+	}
+	else
+	{
+		result = DiffWithSuffixArray<int64_t>( oldData, previousData.size(), newData, latestData.size(), &stream );
+	}
+	return result == 0;
+}
+}
 
-	return true;
+bool CreatePatch( const std::string& previousData, const std::string& latestData, std::string& patchData, SuffixSortAlgorithm suffixSort )
+{
+	patchData.clear();
+	std::function<bool( const char*, size_t )> write = [&patchData]( const char* data, size_t size ) {
+		patchData.append( data, size );
+		return true;
+	};
+	return CreatePatch( previousData, latestData, write, suffixSort );
 }
 
 bool ApplyPatchFile( std::filesystem::path target, std::filesystem::path patch )
@@ -196,6 +552,11 @@ bool ApplyPatchFileChunked( std::filesystem::path target, BundleStreamIn& patch
 }
 
 
+void ReleasePatchBuffers()
+{
+	s_patchBufferPool.Release();
+}
+
 bool CreatePatchFile( std::filesystem::path before, std::filesystem::path after, std::filesystem::path patch )
 {
 	std::string beforeData;
@@ -8,6 +8,12 @@
 #if __APPLE__
 #include <sys/stat.h> // for lstat
 #endif
+#if WIN32
+#include <windows.h>
+#else
+#include <fcntl.h> // for open
+#include <unistd.h> // for fsync
+#endif
 #include <filesystem>
 #include <fstream>
 
@@ -17,6 +23,7 @@
 #include "Md5ChecksumStream.h"
 #include "FileDataStreamIn.h"
 #include "FileDataStreamOut.h"
+#include "GzipCompressionStream.h"
 #include "RollingChecksum.h"
 
 
@@ -204,63 +211,53 @@ bool FindMatchingChunk( const std::string& chunk, std::filesystem::path filePath
 	{
 		return false;
 	}
+	if( chunk.empty() )
+	{
+		chunkOffset = 0;
+		return true;
+	}
 	uint32_t chunkSize = static_cast<uint32_t>( chunk.size() );
-	FileDataStreamIn stream( chunkSize );
-	stream.StartRead( filePath );
-	std::string backlog;
-	std::string fileData;
-	RollingChecksum chunkChecksum = GenerateRollingAdlerChecksum( chunk, 0, chunkSize );
-	RollingChecksum lastChecksum;
-	uint64_t fileOffset{ 0 };
-	uint32_t backlogOffset{ 0 };
-	while( stream >> fileData )
-	{
-		backlog += fileData;
-		while( backlogOffset + chunkSize <= backlog.size() )
-		{
-			if( backlogOffset == 0 )
-			{
-				lastChecksum = GenerateRollingAdlerChecksum( backlog, 0, chunkSize );
-			}
-			else
-			{
-				lastChecksum = GenerateRollingAdlerChecksum( backlog, backlogOffset, backlogOffset + chunkSize, lastChecksum );
-			}
-			if( lastChecksum.checksum == chunkChecksum.checksum )
-			{
-				// We have a potential match. Time to verify
-				std::string sourceMD5;
-				if( !ResourceTools::GenerateMd5Checksum( chunk, sourceMD5 ) )
-				{
-					++backlogOffset;
-					continue;
-				}
-				std::string matchingChunkMD5;
-				std::string matchStr = backlog.substr( backlogOffset, chunkSize );
-				if( !ResourceTools::GenerateMd5Checksum( matchStr, matchingChunkMD5 ) )
-				{
-					++backlogOffset;
-					continue;
-				}
-				if( sourceMD5 == matchingChunkMD5 )
-				{
-					// It's legit!
-					chunkOffset = backlogOffset + fileOffset;
-					return true;
-				}
-			}
-			++backlogOffset;
-		}
+	FileDataStreamIn stream( std::max( static_cast<size_t>( chunkSize ), ROLLING_CHECKSUM_SCAN_READ_SIZE ) );
+	if( !stream.StartRead( filePath ) )
+	{
+		return false;
+	}
 
-		// Shrink fileData every now and then, but beware, we need to access start-1 for the rolling checksum.
-		if( backlogOffset > chunkSize + 1 )
+	// Candidates are read back from the file, as they may span two reads.
+	std::ifstream candidateStream( filePath, std::ifstream::binary );
+	if( !candidateStream )
+	{
+		return false;
+	}
+
+	uint32_t chunkChecksum = GenerateRollingAdlerChecksum( reinterpret_cast<const uint8_t*>( chunk.data() ), chunkSize ).checksum;
+	auto matchesChunkChecksum = [chunkChecksum]( uint32_t checksum ) {
+		return checksum == chunkChecksum;
+	};
+
+	bool found{ false };
+	std::string candidate( chunkSize, '\0' );
+	auto verifyCandidate = [&]( uint64_t offset, uint32_t ) {
+		// We have a potential match. Time to verify
+		candidateStream.clear();
+		candidateStream.seekg( static_cast<std::streamoff>( offset ) );
+		if( !candidateStream.read( candidate.data(), chunkSize ) || candidate != chunk )
 		{
-			backlogOffset -= chunkSize;
-			fileOffset += chunkSize;
-			backlog = backlog.substr( chunkSize );
+			return true;
 		}
+		// It's legit!
+		chunkOffset = offset;
+		found = true;
+		return false;
+	};
+
+	RollingChecksumScanner scanner( chunkSize );
+	std::string fileData;
+	while( !found && stream >> fileData )
+	{
+		scanner.Scan( reinterpret_cast<const uint8_t*>( fileData.data() ), fileData.size(), matchesChunkChecksum, verifyCandidate );
 	}
-	return false;
+	return found;
 }
 
 size_t CountMatchingChunks( const std::filesystem::path& fileA, size_t offsetA, std::filesystem::path fileB, size_t offsetB, size_t chunkSize )
@@ -369,6 +366,40 @@ bool GZipCompressData( const std::string& dataToCompress, std::string& compresse
 	return deflateEnd( &strm ) == Z_OK;
 }
 
+bool GZipCompressedSize( const std::string& dataToCompress, uintmax_t& compressedSize )
+{
+	// Fed in slices so the stream never buffers more than one of them
+	constexpr size_t SLICE_SIZE = 1048576;
+
+	GzipCompressionStream compressionStream( nullptr );
+
+	if( !compressionStream.Start() )
+	{
+		return false;
+	}
+
+	std::string slice;
+
+	for( size_t offset = 0; offset < dataToCompress.size(); offset += SLICE_SIZE )
+	{
+		slice.assign( dataToCompress, offset, SLICE_SIZE );
+
+		if( !( compressionStream << &slice ) )
+		{
+			return false;
+		}
+	}
+
+	if( !compressionStream.Finish() )
+	{
+		return false;
+	}
+
+	compressedSize = compressionStream.GetCompressedSize();
+
+	return true;
+}
+
 bool GZipUncompressData( const std::string& dataToUncompress, std::string& uncompressedData )
 {
 	z_stream strm;
@@ -425,6 +456,89 @@ bool SaveFile( const std::filesystem::path& path, const std::string& data )
 	}
 }
 
+bool MoveFileIntoPlace( const std::filesystem::path& source, const std::filesystem::path& destination )
+{
+	std::error_code ec;
+
+	std::filesystem::path directory = destination.parent_path();
+
+	if( !directory.empty() )
+	{
+		std::filesystem::create_directories( directory, ec );
+
+		if( ec )
+		{
+			return false;
+		}
+	}
+
+	std::filesystem::rename( source, destination, ec );
+
+	if( !ec )
+	{
+		return true;
+	}
+
+	// Rename fails across devices, copy next to the destination so it can still be replaced by a rename
+	std::filesystem::path copyPath = destination;
+
+	copyPath += ".copy";
+
+	ec.clear();
+
+	if( !std::filesystem::copy_file( source, copyPath, std::filesystem::copy_options::overwrite_existing, ec ) )
+	{
+		std::filesystem::remove( copyPath, ec );
+
+		return false;
+	}
+
+	std::filesystem::rename( copyPath, destination, ec );
+
+	if( ec )
+	{
+		std::filesystem::remove( copyPath, ec );
+
+		return false;
+	}
+
+	std::filesystem::remove( source, ec );
+
+	return true;
+}
+
+bool ApplyBinaryOperation( const std::filesystem::path& path, unsigned int binaryOperation )
+{
+	std::error_code ec;
+
+	std::filesystem::permissions( path, static_cast<std::filesystem::perms>( binaryOperation ) & std::filesystem::perms::mask, std::filesystem::perm_options::replace, ec );
+
+	return !ec;
+}
+
+bool SyncFile( const std::filesystem::path& path )
+{
+#if WIN32
+	HANDLE hFile = CreateFileW( path.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr );
+	if( hFile == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+	bool synced = FlushFileBuffers( hFile );
+	CloseHandle( hFile );
+	return synced;
+#else
+	int fd = open( path.c_str(), O_WRONLY );
+	if( fd < 0 )
+	{
+		return false;
+	}
+	bool synced = fsync( fd ) == 0;
+	close( fd );
+	return synced;
+#endif
+}
+
 #if __APPLE__
 unsigned int CalculateBinaryOperation( const std::filesystem::path& path )
 {
@@ -2,41 +2,174 @@
 
 #include "RollingChecksum.h"
 
-constexpr uint32_t ROLLING_CHECKSUM_MODULO{ 2 << 15 };
+#include <climits>
+
+// The vectorised kernels sign extend bytes, so they are only used where char is signed.
+#if CHAR_MIN == 0
+#elif defined( __SSE4_1__ )
+#include <smmintrin.h>
+#define ROLLING_CHECKSUM_SSE 1
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define ROLLING_CHECKSUM_SSE 1
+#elif defined( __ARM_NEON ) || defined( _M_ARM64 )
+#include <arm_neon.h>
+#define ROLLING_CHECKSUM_NEON 1
+#endif
+
+// Number of bytes consumed per iteration of the vectorised kernels.
+constexpr size_t ROLLING_CHECKSUM_BLOCK_SIZE{ 16 };
 
 namespace ResourceTools
 {
-RollingChecksum GenerateRollingAdlerChecksum( const std::string& input, uint32_t start, uint32_t end )
+namespace
+{
+// Both sums are only ever needed modulo 2^16, so the vectorised kernels accumulate
+// in wrapping 16 bit lanes. Bytes are read as char to match the std::string overloads.
+struct WindowSums
 {
 	uint32_t alpha = 0;
-	auto substring = input.substr( start, end - start );
-	for( auto c : substring )
+	uint32_t beta = 0;
+};
+
+void AccumulateScalar( const uint8_t* data, size_t begin, size_t length, WindowSums& sums )
+{
+	for( size_t i = begin; i < length; ++i )
 	{
-		alpha += c;
+		auto value = static_cast<char>( data[i] );
+		sums.alpha += value;
+		sums.beta += static_cast<uint32_t>( length - i ) * value;
 	}
-	alpha %= ROLLING_CHECKSUM_MODULO;
+}
 
-	uint32_t beta = 0;
-	for( uint32_t i = start; i < end; ++i )
+// Combine per lane column sums and the running prefix sum into alpha and beta for
+// the first blockCount * 16 bytes of a window of the given length.
+void CombineLanes( const int16_t columns[ROLLING_CHECKSUM_BLOCK_SIZE], const int16_t prefix[ROLLING_CHECKSUM_BLOCK_SIZE / 2], size_t blockCount, size_t length, WindowSums& sums )
+{
+	auto lastBlockWeight = static_cast<uint32_t>( length - ROLLING_CHECKSUM_BLOCK_SIZE * ( blockCount - 1 ) );
+	uint32_t prefixSum = 0;
+	for( size_t lane = 0; lane < ROLLING_CHECKSUM_BLOCK_SIZE / 2; ++lane )
 	{
-		beta += ( end - i ) * substring[i - start];
+		prefixSum += static_cast<uint16_t>( prefix[lane] );
 	}
-	beta %= ROLLING_CHECKSUM_MODULO;
+	sums.beta += ROLLING_CHECKSUM_BLOCK_SIZE * prefixSum;
+	for( size_t lane = 0; lane < ROLLING_CHECKSUM_BLOCK_SIZE; ++lane )
+	{
+		auto column = static_cast<uint16_t>( columns[lane] );
+		sums.alpha += column;
+		sums.beta += ( lastBlockWeight - static_cast<uint32_t>( lane ) ) * column;
+	}
+}
+
+#if defined( ROLLING_CHECKSUM_SSE )
+inline __m128i SignExtendLow( __m128i bytes )
+{
+#if defined( __SSE4_1__ )
+	return _mm_cvtepi8_epi16( bytes );
+#else
+	return _mm_srai_epi16( _mm_unpacklo_epi8( bytes, bytes ), 8 );
+#endif
+}
+
+inline __m128i SignExtendHigh( __m128i bytes )
+{
+#if defined( __SSE4_1__ )
+	return _mm_cvtepi8_epi16( _mm_srli_si128( bytes, 8 ) );
+#else
+	return _mm_srai_epi16( _mm_unpackhi_epi8( bytes, bytes ), 8 );
+#endif
+}
+
+size_t AccumulateVectorised( const uint8_t* data, size_t length, WindowSums& sums )
+{
+	size_t blockCount = length / ROLLING_CHECKSUM_BLOCK_SIZE;
+	if( blockCount == 0 )
+	{
+		return 0;
+	}
+
+	__m128i columnsLow = _mm_setzero_si128();
+	__m128i columnsHigh = _mm_setzero_si128();
+	__m128i prefix = _mm_setzero_si128();
+
+	for( size_t block = 0; block < blockCount; ++block )
+	{
+		__m128i bytes = _mm_loadu_si128( reinterpret_cast<const __m128i*>( data + block * ROLLING_CHECKSUM_BLOCK_SIZE ) );
+		prefix = _mm_add_epi16( prefix, _mm_add_epi16( columnsLow, columnsHigh ) );
+		columnsLow = _mm_add_epi16( columnsLow, SignExtendLow( bytes ) );
+		columnsHigh = _mm_add_epi16( columnsHigh, SignExtendHigh( bytes ) );
+	}
+
+	alignas( 16 ) int16_t columns[ROLLING_CHECKSUM_BLOCK_SIZE];
+	alignas( 16 ) int16_t prefixLanes[ROLLING_CHECKSUM_BLOCK_SIZE / 2];
+	_mm_store_si128( reinterpret_cast<__m128i*>( columns ), columnsLow );
+	_mm_store_si128( reinterpret_cast<__m128i*>( columns + ROLLING_CHECKSUM_BLOCK_SIZE / 2 ), columnsHigh );
+	_mm_store_si128( reinterpret_cast<__m128i*>( prefixLanes ), prefix );
+	CombineLanes( columns, prefixLanes, blockCount, length, sums );
+
+	return blockCount * ROLLING_CHECKSUM_BLOCK_SIZE;
+}
+#elif defined( ROLLING_CHECKSUM_NEON )
+size_t AccumulateVectorised( const uint8_t* data, size_t length, WindowSums& sums )
+{
+	size_t blockCount = length / ROLLING_CHECKSUM_BLOCK_SIZE;
+	if( blockCount == 0 )
+	{
+		return 0;
+	}
+
+	int16x8_t columnsLow = vdupq_n_s16( 0 );
+	int16x8_t columnsHigh = vdupq_n_s16( 0 );
+	int16x8_t prefix = vdupq_n_s16( 0 );
+
+	for( size_t block = 0; block < blockCount; ++block )
+	{
+		int8x16_t bytes = vld1q_s8( reinterpret_cast<const int8_t*>( data + block * ROLLING_CHECKSUM_BLOCK_SIZE ) );
+		prefix = vaddq_s16( prefix, vaddq_s16( columnsLow, columnsHigh ) );
+		columnsLow = vaddq_s16( columnsLow, vmovl_s8( vget_low_s8( bytes ) ) );
+		columnsHigh = vaddq_s16( columnsHigh, vmovl_s8( vget_high_s8( bytes ) ) );
+	}
+
+	int16_t columns[ROLLING_CHECKSUM_BLOCK_SIZE];
+	int16_t prefixLanes[ROLLING_CHECKSUM_BLOCK_SIZE / 2];
+	vst1q_s16( columns, columnsLow );
+	vst1q_s16( columns + ROLLING_CHECKSUM_BLOCK_SIZE / 2, columnsHigh );
+	vst1q_s16( prefixLanes, prefix );
+	CombineLanes( columns, prefixLanes, blockCount, length, sums );
+
+	return blockCount * ROLLING_CHECKSUM_BLOCK_SIZE;
+}
+#else
+size_t AccumulateVectorised( const uint8_t*, size_t, WindowSums& )
+{
+	return 0;
+}
+#endif
+}
+
+RollingChecksum GenerateRollingAdlerChecksum( const uint8_t* data, size_t length )
+{
+	WindowSums sums;
+	size_t processed = AccumulateVectorised( data, length, sums );
+	AccumulateScalar( data, processed, length, sums );
 
 	RollingChecksum rc;
-	rc.alpha = alpha;
-	rc.beta = beta;
-	rc.checksum = alpha + ( beta * ROLLING_CHECKSUM_MODULO );
+	rc.alpha = sums.alpha % ROLLING_CHECKSUM_MODULO;
+	rc.beta = sums.beta % ROLLING_CHECKSUM_MODULO;
+	rc.checksum = rc.alpha + ( rc.beta * ROLLING_CHECKSUM_MODULO );
 
 	return rc;
 }
 
-RollingChecksum GenerateRollingAdlerChecksum( const std::string& input, uint32_t start, uint32_t end, RollingChecksum previous )
+RollingChecksum GenerateRollingAdlerChecksum( const uint8_t* data, size_t length, RollingChecksum previous )
 {
-	uint32_t alpha = previous.alpha - input[start - 1] + input[end - 1];
+	auto outgoing = static_cast<char>( data[-1] );
+	auto incoming = static_cast<char>( data[length - 1] );
+
+	uint32_t alpha = previous.alpha - outgoing + incoming;
 	alpha %= ROLLING_CHECKSUM_MODULO;
 
-	uint32_t beta = previous.beta + alpha - ( end - start ) * input[start - 1];
+	uint32_t beta = previous.beta + alpha - static_cast<uint32_t>( length ) * outgoing;
 	beta %= ROLLING_CHECKSUM_MODULO;
 
 	RollingChecksum rc;
@@ -47,5 +180,59 @@ RollingChecksum GenerateRollingAdlerChecksum( const std::string& input, uint32_t
 	return rc;
 }
 
+RollingChecksum GenerateRollingAdlerChecksum( const std::string& input, uint32_t start, uint32_t end )
+{
+	return GenerateRollingAdlerChecksum( reinterpret_cast<const uint8_t*>( input.data() ) + start, end - start );
+}
+
+RollingChecksum GenerateRollingAdlerChecksum( const std::string& input, uint32_t start, uint32_t end, RollingChecksum previous )
+{
+	return GenerateRollingAdlerChecksum( reinterpret_cast<const uint8_t*>( input.data() ) + start, end - start, previous );
+}
 
-}
\ No newline at end of file
+RollingChecksumScanner::RollingChecksumScanner( uint32_t windowSize ) :
+	m_windowSize( windowSize ),
+	m_streamSize( 0 ),
+	m_nextWindow( 0 ),
+	m_stopped( false ),
+	m_checksum{ 0, 0, 0 }
+{
+	m_carry.reserve( windowSize );
+}
+
+uint64_t RollingChecksumScanner::GetStreamSize() const
+{
+	return m_streamSize;
+}
+
+RollingChecksum RollingChecksumScanner::GenerateFirstWindowChecksum( const uint8_t* data ) const
+{
+	// The carry holds the whole stream so far, the first window may start in it.
+	size_t carrySize = m_carry.size();
+	size_t dataSize = m_windowSize - carrySize;
+	RollingChecksum carryChecksum = GenerateRollingAdlerChecksum( m_carry.data(), carrySize );
+	RollingChecksum dataChecksum = GenerateRollingAdlerChecksum( data, dataSize );
+
+	// Bytes in the carry are weighted by an additional dataSize.
+	RollingChecksum rc;
+	rc.alpha = ( carryChecksum.alpha + dataChecksum.alpha ) % ROLLING_CHECKSUM_MODULO;
+	rc.beta = ( carryChecksum.beta + static_cast<uint32_t>( dataSize ) * carryChecksum.alpha + dataChecksum.beta ) % ROLLING_CHECKSUM_MODULO;
+	rc.checksum = rc.alpha + ( rc.beta * ROLLING_CHECKSUM_MODULO );
+
+	return rc;
+}
+
+void RollingChecksumScanner::UpdateCarry( const uint8_t* data, size_t length )
+{
+	if( length >= m_windowSize )
+	{
+		m_carry.assign( data + length - m_windowSize, data + length );
+		return;
+	}
+
+	size_t keep = std::min( m_carry.size(), static_cast<size_t>( m_windowSize - length ) );
+	m_carry.erase( m_carry.begin(), m_carry.end() - keep );
+	m_carry.insert( m_carry.end(), data, data + length );
+}
+
+}
@@ -0,0 +1,269 @@
+// Copyright © 2025 CCP ehf.
+
+#include "SuffixArray.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace ResourceTools
+{
+namespace
+{
+// SA-IS, Nong, Zhang and Chan, "Two Efficient Algorithms for Linear Time Suffix Array Construction".
+// The text is followed by a virtual sentinel smaller than every character, which is not stored.
+// The reduced problem is built and solved in the unused part of suffixArray.
+template <typename T, typename C>
+class SuffixSorter
+{
+public:
+	SuffixSorter( const C* text, T size, T alphabetSize, T* suffixArray ) :
+		m_text( text ),
+		m_size( size ),
+		m_alphabetSize( alphabetSize ),
+		m_suffixArray( suffixArray ),
+		m_isSType( size ),
+		m_buckets( alphabetSize )
+	{
+	}
+
+	void Sort();
+
+private:
+	bool IsLms( T i ) const
+	{
+		return i > 0 && m_isSType[i] && !m_isSType[i - 1];
+	}
+
+	void GetBucketStarts();
+
+	void GetBucketEnds();
+
+	void Induce();
+
+	bool LmsSubstringsEqual( T a, T b ) const;
+
+	const C* m_text;
+
+	T m_size;
+
+	T m_alphabetSize;
+
+	T* m_suffixArray;
+
+	std::vector<bool> m_isSType;
+
+	std::vector<T> m_buckets;
+};
+
+template <typename T, typename C>
+void SuffixSorter<T, C>::GetBucketStarts()
+{
+	std::fill( m_buckets.begin(), m_buckets.end(), T( 0 ) );
+	for( T i = 0; i < m_size; ++i )
+	{
+		++m_buckets[m_text[i]];
+	}
+	T sum = 0;
+	for( T c = 0; c < m_alphabetSize; ++c )
+	{
+		T count = m_buckets[c];
+		m_buckets[c] = sum;
+		sum += count;
+	}
+}
+
+template <typename T, typename C>
+void SuffixSorter<T, C>::GetBucketEnds()
+{
+	std::fill( m_buckets.begin(), m_buckets.end(), T( 0 ) );
+	for( T i = 0; i < m_size; ++i )
+	{
+		++m_buckets[m_text[i]];
+	}
+	T sum = 0;
+	for( T c = 0; c < m_alphabetSize; ++c )
+	{
+		sum += m_buckets[c];
+		m_buckets[c] = sum;
+	}
+}
+
+// Sort L then S type suffixes from the LMS suffixes already placed at the ends of their buckets.
+template <typename T, typename C>
+void SuffixSorter<T, C>::Induce()
+{
+	T* sa = m_suffixArray;
+
+	GetBucketStarts();
+
+	// The suffix before the sentinel is the smallest L type suffix
+	sa[m_buckets[m_text[m_size - 1]]++] = m_size - 1;
+	for( T i = 0; i < m_size; ++i )
+	{
+		T j = sa[i] - 1;
+		if( sa[i] > 0 && !m_isSType[j] )
+		{
+			sa[m_buckets[m_text[j]]++] = j;
+		}
+	}
+
+	GetBucketEnds();
+
+	for( T i = m_size; i-- > 0; )
+	{
+		T j = sa[i] - 1;
+		if( sa[i] > 0 && m_isSType[j] )
+		{
+			sa[--m_buckets[m_text[j]]] = j;
+		}
+	}
+}
+
+template <typename T, typename C>
+bool SuffixSorter<T, C>::LmsSubstringsEqual( T a, T b ) const
+{
+	for( T d = 0;; ++d )
+	{
+		// Only one substring can reach the sentinel
+		if( a + d == m_size || b + d == m_size )
+		{
+			return false;
+		}
+		if( m_text[a + d] != m_text[b + d] || m_isSType[a + d] != m_isSType[b + d] )
+		{
+			return false;
+		}
+		if( d > 0 && ( IsLms( a + d ) || IsLms( b + d ) ) )
+		{
+			return IsLms( a + d ) && IsLms( b + d );
+		}
+	}
+}
+
+template <typename T, typename C>
+void SuffixSorter<T, C>::Sort()
+{
+	T* sa = m_suffixArray;
+	T n = m_size;
+
+	if( n == 0 )
+	{
+		return;
+	}
+	if( n == 1 )
+	{
+		sa[0] = 0;
+		return;
+	}
+
+	// The last character is followed by the sentinel, so it is L type
+	m_isSType[n - 1] = false;
+	for( T i = n - 1; i-- > 0; )
+	{
+		m_isSType[i] = m_text[i] < m_text[i + 1] || ( m_text[i] == m_text[i + 1] && m_isSType[i + 1] );
+	}
+
+	// Sort the LMS substrings
+	std::fill( sa, sa + n, T( -1 ) );
+	GetBucketEnds();
+	for( T i = n - 1; i > 0; --i )
+	{
+		if( IsLms( i ) )
+		{
+			sa[--m_buckets[m_text[i]]] = i;
+		}
+	}
+	Induce();
+
+	// Gather the sorted LMS substrings at the start
+	T lmsCount = 0;
+	for( T i = 0; i < n; ++i )
+	{
+		if( IsLms( sa[i] ) )
+		{
+			sa[lmsCount++] = sa[i];
+		}
+	}
+
+	// Name them, LMS positions are at least two apart so position / 2 is a free slot past lmsCount
+	std::fill( sa + lmsCount, sa + n, T( -1 ) );
+	T nameCount = 0;
+	T previous = -1;
+	for( T i = 0; i < lmsCount; ++i )
+	{
+		T position = sa[i];
+		if( previous < 0 || !LmsSubstringsEqual( position, previous ) )
+		{
+			++nameCount;
+			previous = position;
+		}
+		sa[lmsCount + position / 2] = nameCount - 1;
+	}
+
+	// Reduced text, the names in text order, at the end of the array
+	T* reducedText = sa + n - lmsCount;
+	for( T i = n, j = n; i-- > lmsCount; )
+	{
+		if( sa[i] >= 0 )
+		{
+			sa[--j] = sa[i];
+		}
+	}
+
+	// Sort the LMS suffixes, recursing when their substrings are not all distinct
+	if( nameCount < lmsCount )
+	{
+		SuffixSorter<T, T>( reducedText, lmsCount, nameCount, sa ).Sort();
+	}
+	else
+	{
+		for( T i = 0; i < lmsCount; ++i )
+		{
+			sa[reducedText[i]] = i;
+		}
+	}
+
+	// Map the reduced suffixes back to text positions
+	for( T i = n, j = lmsCount; i-- > 1; )
+	{
+		if( IsLms( i ) )
+		{
+			reducedText[--j] = i;
+		}
+	}
+	for( T i = 0; i < lmsCount; ++i )
+	{
+		sa[i] = reducedText[sa[i]];
+	}
+
+	// Place the sorted LMS suffixes at the ends of their buckets and induce the rest
+	std::fill( sa + lmsCount, sa + n, T( -1 ) );
+	GetBucketEnds();
+	for( T i = lmsCount; i-- > 0; )
+	{
+		T position = sa[i];
+		sa[i] = -1;
+		sa[--m_buckets[m_text[position]]] = position;
+	}
+	Induce();
+}
+
+template <typename T>
+void BuildSuffixArrayImpl( const uint8_t* data, T size, T* suffixArray )
+{
+	suffixArray[0] = size;
+	SuffixSorter<T, uint8_t>( data, size, 256, suffixArray + 1 ).Sort();
+}
+}
+
+void BuildSuffixArray( const uint8_t* data, int32_t size, int32_t* suffixArray )
+{
+	BuildSuffixArrayImpl( data, size, suffixArray );
+}
+
+void BuildSuffixArray( const uint8_t* data, int64_t size, int64_t* suffixArray )
+{
+	BuildSuffixArrayImpl( data, size, suffixArray );
+}
+
+}